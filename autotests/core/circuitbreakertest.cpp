@@ -0,0 +1,228 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QPointer>
+#include <QSignalSpy>
+#include <QTest>
+
+#include "circuitbreaker.h"
+
+using namespace KMGraph2;
+
+class CircuitBreakerTest: public QObject
+{
+    Q_OBJECT
+
+private:
+    CircuitBreaker::Settings settings()
+    {
+        CircuitBreaker::Settings settings;
+        settings.failureRate = 0.5;
+        settings.minimumRequests = 4;
+        settings.windowSize = 10;
+        settings.openDuration = 50;
+        settings.maxProbes = 1;
+        return settings;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        qRegisterMetaType<KMGraph2::CircuitBreaker::State>();
+    }
+
+    void testStaysClosed()
+    {
+        CircuitBreaker breaker(settings());
+
+        // Not enough requests to judge
+        breaker.recordFailure();
+        breaker.recordFailure();
+        breaker.recordFailure();
+        QCOMPARE(breaker.state(), CircuitBreaker::Closed);
+
+        // Below the failure rate
+        breaker.reset();
+        for (int i = 0; i < 7; ++i) {
+            breaker.recordSuccess();
+        }
+        for (int i = 0; i < 3; ++i) {
+            breaker.recordFailure();
+        }
+        QCOMPARE(breaker.state(), CircuitBreaker::Closed);
+        QVERIFY(breaker.allowRequest());
+        QCOMPARE(breaker.retryAfter(), 0);
+    }
+
+    void testOpens()
+    {
+        CircuitBreaker breaker(settings());
+        QSignalSpy spy(&breaker, &CircuitBreaker::stateChanged);
+
+        breaker.recordSuccess();
+        breaker.recordSuccess();
+        breaker.recordFailure();
+        QCOMPARE(breaker.state(), CircuitBreaker::Closed);
+        breaker.recordFailure();
+        QCOMPARE(breaker.state(), CircuitBreaker::Open);
+        QCOMPARE(spy.count(), 1);
+
+        QVERIFY(!breaker.allowRequest());
+        QVERIFY(breaker.retryAfter() > 0);
+        QVERIFY(breaker.retryAfter() <= 50);
+    }
+
+    void testWindow()
+    {
+        CircuitBreaker breaker(settings());
+
+        // The rate is computed from the last 10 requests only
+        for (int i = 0; i < 10; ++i) {
+            breaker.recordSuccess();
+        }
+        for (int i = 0; i < 4; ++i) {
+            breaker.recordFailure();
+        }
+        QCOMPARE(breaker.state(), CircuitBreaker::Closed);
+        breaker.recordFailure();
+        QCOMPARE(breaker.state(), CircuitBreaker::Open);
+    }
+
+    void testRecovery()
+    {
+        CircuitBreaker breaker(settings());
+        for (int i = 0; i < 4; ++i) {
+            breaker.recordFailure();
+        }
+        QCOMPARE(breaker.state(), CircuitBreaker::Open);
+
+        QTRY_COMPARE(breaker.state(), CircuitBreaker::HalfOpen);
+
+        // Only a single probe at a time
+        quint64 probe = 0;
+        QVERIFY(breaker.allowRequest(&probe));
+        QVERIFY(probe != 0);
+        quint64 other = 0;
+        QVERIFY(!breaker.allowRequest(&other));
+        QCOMPARE(other, quint64(0));
+        // Callers that can't report a probe have to wait until closed
+        QVERIFY(!breaker.allowRequest());
+
+        // Failed probe opens the circuit again
+        breaker.recordFailure(probe);
+        QCOMPARE(breaker.state(), CircuitBreaker::Open);
+
+        QTRY_COMPARE(breaker.state(), CircuitBreaker::HalfOpen);
+        QVERIFY(breaker.allowRequest(&probe));
+        breaker.recordSuccess(probe);
+        QCOMPARE(breaker.state(), CircuitBreaker::Closed);
+        QVERIFY(breaker.allowRequest(&probe));
+        QCOMPARE(probe, quint64(0));
+        QVERIFY(breaker.allowRequest());
+    }
+
+    void testLateRepliesIgnored()
+    {
+        CircuitBreaker breaker(settings());
+        for (int i = 0; i < 4; ++i) {
+            breaker.recordFailure();
+        }
+        QTRY_COMPARE(breaker.state(), CircuitBreaker::HalfOpen);
+
+        quint64 probe = 0;
+        QVERIFY(breaker.allowRequest(&probe));
+
+        // Requests sent while closed don't decide
+        breaker.recordSuccess();
+        QCOMPARE(breaker.state(), CircuitBreaker::HalfOpen);
+        breaker.recordFailure();
+        QCOMPARE(breaker.state(), CircuitBreaker::HalfOpen);
+        // Neither do unknown probes
+        breaker.recordFailure(probe + 1);
+        QCOMPARE(breaker.state(), CircuitBreaker::HalfOpen);
+
+        breaker.recordSuccess(probe);
+        QCOMPARE(breaker.state(), CircuitBreaker::Closed);
+    }
+
+    void testProbeReleased()
+    {
+        CircuitBreaker breaker(settings());
+        for (int i = 0; i < 4; ++i) {
+            breaker.recordFailure();
+        }
+        QTRY_COMPARE(breaker.state(), CircuitBreaker::HalfOpen);
+
+        quint64 probe = 0;
+        QVERIFY(breaker.allowRequest(&probe));
+        quint64 other = 0;
+        QVERIFY(!breaker.allowRequest(&other));
+        QVERIFY(breaker.retryAfter() > 0);
+
+        // A cancelled probe frees its slot without deciding
+        breaker.releaseProbe(probe);
+        QCOMPARE(breaker.state(), CircuitBreaker::HalfOpen);
+        QCOMPARE(breaker.retryAfter(), 0);
+        QVERIFY(breaker.allowRequest(&other));
+        QVERIFY(other != probe);
+
+        // So does one that was never reported, after a while
+        QTRY_VERIFY(breaker.allowRequest(&probe));
+        QVERIFY(probe != other);
+    }
+
+    void testInstance()
+    {
+        CircuitBreaker *breaker = CircuitBreaker::instance(QStringLiteral("user@example.com"), "KMGraph2::OneDrive::FileFetchJob");
+        QCOMPARE(CircuitBreaker::instance(QStringLiteral("user@example.com"), "KMGraph2::OneDrive::FileFetchJob"), breaker);
+        QVERIFY(CircuitBreaker::instance(QStringLiteral("other@example.com"), "KMGraph2::OneDrive::FileFetchJob") != breaker);
+        QVERIFY(CircuitBreaker::instance(QStringLiteral("user@example.com"), "KMGraph2::OneDrive::AboutFetchJob") != breaker);
+    }
+
+    void testInstancesBounded()
+    {
+        const QByteArray endpoint("KMGraph2::OneDrive::FileFetchJob");
+        const QPointer<CircuitBreaker> unused = CircuitBreaker::instance(QStringLiteral("unused"), endpoint);
+        const QPointer<CircuitBreaker> used = CircuitBreaker::instance(QStringLiteral("used"), endpoint);
+        const QPointer<CircuitBreaker> open = CircuitBreaker::instance(QStringLiteral("open"), endpoint);
+        for (int i = 0; i < CircuitBreaker::defaultSettings().minimumRequests; ++i) {
+            open->recordFailure();
+        }
+        QCOMPARE(open->state(), CircuitBreaker::Open);
+
+        for (int i = 0; i < 100; ++i) {
+            CircuitBreaker::instance(QStringLiteral("account%1").arg(i), endpoint);
+            // Keeps it among the recently used ones
+            QCOMPARE(CircuitBreaker::instance(QStringLiteral("used"), endpoint), used.data());
+        }
+
+        // Least recently used closed breakers are deleted, open ones stay
+        QVERIFY(unused.isNull());
+        QVERIFY(!used.isNull());
+        QVERIFY(!open.isNull());
+        QCOMPARE(CircuitBreaker::instance(QStringLiteral("open"), endpoint), open.data());
+    }
+};
+
+QTEST_GUILESS_MAIN(CircuitBreakerTest)
+
+#include "circuitbreakertest.moc"
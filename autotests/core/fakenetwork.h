@@ -0,0 +1,310 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KMGRAPH2_FAKENETWORK_H
+#define KMGRAPH2_FAKENETWORK_H
+
+#include <QIODevice>
+#include <QList>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QPointer>
+#include <QStringList>
+#include <QTest>
+#include <QTimer>
+
+#include "account.h"
+#include "job.h"
+#include "replyfactory.h"
+#include "retrypolicy.h"
+
+#include <functional>
+
+namespace {
+
+// Stands in for a reply from the server, the test decides what it receives
+class FakeReply : public QNetworkReply
+{
+  public:
+    FakeReply(QNetworkAccessManager::Operation op, const QNetworkRequest &request, const QByteArray &body):
+        mBody(body)
+    {
+        setRequest(request);
+        setUrl(request.url());
+        setOperation(op);
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+
+    explicit FakeReply(const QNetworkRequest &request):
+        FakeReply(QNetworkAccessManager::GetOperation, request, QByteArray())
+    {
+    }
+
+    // Data sent with the request
+    QByteArray body() const
+    {
+        return mBody;
+    }
+
+    // Announces status and headers, the reply keeps going
+    void respondHeaders(int status, const QList<RawHeaderPair> &headers = QList<RawHeaderPair>())
+    {
+        setAttribute(QNetworkRequest::HttpStatusCodeAttribute, status);
+        setRawHeader("Content-Type", "application/json");
+        for (const RawHeaderPair &header : headers) {
+            setRawHeader(header.first, header.second);
+        }
+        mHeadersSent = true;
+        Q_EMIT metaDataChanged();
+    }
+
+    // Delivers part of the content, the reply keeps going
+    void deliver(const QByteArray &data)
+    {
+        mData += data;
+        Q_EMIT readyRead();
+        Q_EMIT downloadProgress(mData.size(), -1);
+    }
+
+    void respond(int status, const QByteArray &data = QByteArray(),
+                 const QList<RawHeaderPair> &headers = QList<RawHeaderPair>())
+    {
+        if (!mHeadersSent) {
+            respondHeaders(status, headers);
+        }
+        if (!data.isEmpty()) {
+            mData += data;
+            Q_EMIT readyRead();
+        }
+        setFinished(true);
+        Q_EMIT finished();
+    }
+
+    void fail(QNetworkReply::NetworkError error)
+    {
+        setError(error, QStringLiteral("Fake network error"));
+        setFinished(true);
+        Q_EMIT finished();
+    }
+
+    // Like QNetworkReply, an aborted reply finishes right away
+    void abort() override
+    {
+        if (isFinished()) {
+            return;
+        }
+        aborted = true;
+        fail(QNetworkReply::OperationCanceledError);
+    }
+
+    qint64 bytesAvailable() const override
+    {
+        return mData.size() + QNetworkReply::bytesAvailable();
+    }
+
+    bool aborted = false;
+
+  protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        const int size = int(qMin<qint64>(maxSize, mData.size()));
+        memcpy(data, mData.constData(), size);
+        mData.remove(0, size);
+        return size;
+    }
+
+  private:
+    QByteArray mBody;
+    QByteArray mData;
+    bool mHeadersSent = false;
+};
+
+// Answers requests of all jobs in this thread for as long as it exists
+class FakeNetwork
+{
+  public:
+    typedef std::function<void(FakeReply *reply)> Responder;
+
+    FakeNetwork()
+    {
+        KMGraph2::ReplyFactory::setFactory([this](QNetworkAccessManager::Operation op,
+                                                  const QNetworkRequest &request,
+                                                  QIODevice *outgoingData) {
+            FakeReply *reply = new FakeReply(op, request, outgoingData ? outgoingData->readAll() : QByteArray());
+            mReplies << reply;
+            mUrls << request.url();
+            if (mResponder) {
+                // The job does not know about the reply before this returns
+                const Responder responder = mResponder;
+                QTimer::singleShot(0, reply, [responder, reply]() { responder(reply); });
+            }
+            return reply;
+        });
+    }
+
+    ~FakeNetwork()
+    {
+        KMGraph2::ReplyFactory::setFactory(KMGraph2::ReplyFactory::Factory());
+        // Replies finished by the request coalescer are deleted by it
+        for (const QPointer<FakeReply> &reply : qAsConst(mReplies)) {
+            delete reply.data();
+        }
+    }
+
+    // Called for every new request, requests stay pending when there is none
+    void setResponder(const Responder &responder)
+    {
+        mResponder = responder;
+    }
+
+    int count() const
+    {
+        return mReplies.count();
+    }
+
+    FakeReply *reply(int index) const
+    {
+        return mReplies.at(index).data();
+    }
+
+    // Every request sent so far, including those of finished replies
+    QList<QUrl> urls() const
+    {
+        return mUrls;
+    }
+
+  private:
+    QList<QPointer<FakeReply> > mReplies;
+    QList<QUrl> mUrls;
+    Responder mResponder;
+};
+
+inline QUrl pageUrl(int page)
+{
+    return QUrl(QStringLiteral("https://graph.example/me/drive/items?page=%1").arg(page));
+}
+
+// Every test gets its own account, and so its own circuit breaker
+inline QString testAccountName()
+{
+    QString name = QString::fromLatin1(QTest::currentTestFunction());
+    if (QTest::currentDataTag()) {
+        name += QLatin1Char('/') + QString::fromLatin1(QTest::currentDataTag());
+    }
+    return name;
+}
+
+// Retries without making the test wait
+inline KMGraph2::RetryPolicy fastPolicy(int maxAttempts = 4)
+{
+    KMGraph2::RetryPolicy policy;
+    policy.setMaxAttempts(maxAttempts);
+    policy.setInitialDelay(10);
+    policy.setJitter(0.0);
+    return policy;
+}
+
+// Fetches, or posts to, pages 1 to pageCount with up to parallel requests
+// on the way. Sends the account's access token, when it has one.
+class PagingJob : public KMGraph2::Job
+{
+  public:
+    explicit PagingJob(int pageCount = 1, int parallel = 1):
+        PagingJob(KMGraph2::AccountPtr(new KMGraph2::Account(testAccountName())), pageCount, parallel)
+    {
+    }
+
+    PagingJob(const KMGraph2::AccountPtr &account, int pageCount = 1, int parallel = 1):
+        Job(account),
+        mPageCount(pageCount),
+        mParallel(parallel)
+    {
+        setRetryPolicy(fastPolicy());
+    }
+
+    bool post = false;          // POST "{}" instead of GET
+    bool sendRequests = true;   // like a subclass that decides not to send anything
+
+    QStringList pages;          // content of the received pages
+    QByteArray content;         // of the last received page
+    int dispatched = 0;
+    int dispatchedInStart = -1;
+
+  protected:
+    void start() override
+    {
+        pages.clear();
+        mNext = 0;
+        while (mNext < qMin(mParallel, mPageCount)) {
+            enqueuePage(++mNext);
+        }
+        dispatchedInStart = dispatched;
+    }
+
+    void dispatchRequest(QNetworkAccessManager *accessManager, const QNetworkRequest &request,
+                         const QByteArray &data, const QString &contentType) override
+    {
+        Q_UNUSED(contentType)
+
+        ++dispatched;
+        if (!sendRequests) {
+            return;
+        }
+        if (post) {
+            accessManager->post(request, data);
+        } else {
+            accessManager->get(request);
+        }
+    }
+
+    void handleReply(const QNetworkReply *reply, const QByteArray &rawData) override
+    {
+        Q_UNUSED(reply)
+
+        content = rawData;
+        pages << QString::fromUtf8(rawData);
+        if (mNext < mPageCount) {
+            enqueuePage(++mNext);
+        }
+    }
+
+  private:
+    void enqueuePage(int page)
+    {
+        QNetworkRequest request(pageUrl(page));
+        const QString token = account()->accessToken();
+        if (!token.isEmpty()) {
+            request.setRawHeader("Authorization", "Bearer " + token.toLatin1());
+        }
+        if (post) {
+            enqueueRequest(request, QByteArray("{}"), QStringLiteral("application/json"));
+        } else {
+            enqueueRequest(request);
+        }
+    }
+
+    int mPageCount;
+    int mParallel;
+    int mNext = 0;
+};
+
+}
+
+#endif // KMGRAPH2_FAKENETWORK_H
@@ -0,0 +1,220 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QSignalSpy>
+#include <QTest>
+
+#include "account.h"
+#include "fetchjob.h"
+#include "object.h"
+#include "retrypolicy.h"
+
+#include "fakenetwork.h"
+
+using namespace KMGraph2;
+
+namespace {
+
+// Like PagingJob, but a FetchJob with an object for each page, to see what
+// happens to the items received before the abort
+class PagingFetchJob : public FetchJob
+{
+  public:
+    explicit PagingFetchJob(int pageCount, int parallel = 1):
+        FetchJob(AccountPtr(new Account(testAccountName()))),
+        mPageCount(pageCount),
+        mParallel(parallel)
+    {
+    }
+
+    int received = 0;
+    int abortedCount = 0;
+
+  protected:
+    void start() override
+    {
+        received = 0;
+        mNext = 0;
+        while (mNext < qMin(mParallel, mPageCount)) {
+            enqueueRequest(QNetworkRequest(pageUrl(++mNext)));
+        }
+    }
+
+    void aboutToAbort() override
+    {
+        ++abortedCount;
+
+        FetchJob::aboutToAbort();
+    }
+
+    ObjectsList handleReplyWithItems(const QNetworkReply *reply, const QByteArray &rawData) override
+    {
+        Q_UNUSED(reply)
+
+        ObjectPtr object(new Object);
+        object->setEtag(QString::fromUtf8(rawData));
+        ++received;
+        if (mNext < mPageCount) {
+            enqueueRequest(QNetworkRequest(pageUrl(++mNext)));
+        }
+        return ObjectsList() << object;
+    }
+
+  private:
+    int mPageCount;
+    int mParallel;
+    int mNext = 0;
+};
+
+}
+
+class JobAbortTest: public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testNotRunning()
+    {
+        FakeNetwork network;
+        network.setResponder([](FakeReply *reply) { reply->respond(200, "page"); });
+
+        PagingFetchJob job(1);
+        QSignalSpy spy(&job, &Job::finished);
+
+        // Ignored, the job runs as usual
+        job.abort();
+        QVERIFY(!job.isRunning());
+        QTRY_COMPARE(spy.count(), 1);
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(job.abortedCount, 0);
+        QCOMPARE(job.items().count(), 1);
+
+        // Finished jobs can't be aborted either
+        job.abort();
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(job.abortedCount, 0);
+    }
+
+    void testPendingReply()
+    {
+        // Replies are sent by the test
+        FakeNetwork network;
+
+        PagingFetchJob job(1);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(network.count(), 1);
+        QVERIFY(job.isRunning());
+
+        job.abort();
+        QVERIFY(!job.isRunning());
+        QVERIFY(network.reply(0)->aborted);
+        QCOMPARE(job.abortedCount, 1);
+
+        QTRY_COMPARE(spy.count(), 1);
+        QCOMPARE(job.error(), KMGraph2::Cancelled);
+        QVERIFY(!job.errorString().isEmpty());
+        QCOMPARE(job.received, 0);
+    }
+
+    void testPartialResultsDropped()
+    {
+        // Replies are sent by the test
+        FakeNetwork network;
+
+        PagingFetchJob job(3);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(network.count(), 1);
+        network.reply(0)->respond(200, "page 1");
+        QTRY_COMPARE(network.count(), 2);
+        QCOMPARE(job.received, 1);
+
+        job.abort();
+        QVERIFY(network.reply(1)->aborted);
+        QTRY_COMPARE(spy.count(), 1);
+        QCOMPARE(job.error(), KMGraph2::Cancelled);
+        QVERIFY(job.items().isEmpty());
+
+        // Nothing else is requested
+        QTest::qWait(50);
+        QCOMPARE(network.count(), 2);
+    }
+
+    void testFailureAbortsOtherReplies()
+    {
+        // Replies are sent by the test
+        FakeNetwork network;
+
+        PagingFetchJob job(2, 2);
+        RetryPolicy policy;
+        policy.setMaxAttempts(1);
+        job.setRetryPolicy(policy);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(network.count(), 2);
+
+        // The other download is of no use once the job has failed
+        network.reply(0)->respond(403, "{ \"error\": { \"message\": \"Forbidden\" } }");
+        QVERIFY(!job.isRunning());
+        QVERIFY(network.reply(1)->aborted);
+        QTRY_COMPARE(spy.count(), 1);
+        QCOMPARE(job.error(), KMGraph2::Forbidden);
+        QCOMPARE(job.abortedCount, 0);
+
+        // Nothing of the previous run ends up in the next one
+        job.restart();
+        QTRY_COMPARE(network.count(), 4);
+        network.reply(2)->respond(200, "page 1");
+        QTest::qWait(20);
+        QVERIFY(job.isRunning());
+        network.reply(3)->respond(200, "page 2");
+        QTRY_COMPARE(spy.count(), 2);
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(job.items().count(), 2);
+    }
+
+    void testPendingRetry()
+    {
+        FakeNetwork network;
+        network.setResponder([](FakeReply *reply) {
+            reply->respond(503, "{ \"error\": { \"message\": \"Unavailable\" } }");
+        });
+
+        PagingFetchJob job(1);
+        RetryPolicy policy;
+        policy.setMaxAttempts(2);
+        policy.setInitialDelay(100);
+        policy.setJitter(0.0);
+        job.setRetryPolicy(policy);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(network.count(), 1);
+
+        // The retry is not sent
+        job.abort();
+        QTRY_COMPARE(spy.count(), 1);
+        QCOMPARE(job.error(), KMGraph2::Cancelled);
+        QTest::qWait(200);
+        QCOMPARE(network.count(), 1);
+        QCOMPARE(spy.count(), 1);
+    }
+};
+
+QTEST_GUILESS_MAIN(JobAbortTest)
+
+#include "jobaborttest.moc"
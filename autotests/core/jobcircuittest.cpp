@@ -0,0 +1,204 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QSignalSpy>
+#include <QTest>
+
+#include "circuitbreaker.h"
+#include "job.h"
+#include "retrypolicy.h"
+
+#include "fakenetwork.h"
+
+using namespace KMGraph2;
+
+namespace {
+
+const int OpenDuration = 300;
+
+// Breaker shared by all jobs of the test
+CircuitBreaker *testBreaker()
+{
+    return CircuitBreaker::instance(testAccountName(), Job::staticMetaObject.className());
+}
+
+void openCircuit(CircuitBreaker *breaker)
+{
+    for (int i = 0; i < breaker->settings().minimumRequests; ++i) {
+        breaker->recordFailure();
+    }
+}
+
+}
+
+class JobCircuitTest: public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase()
+    {
+        qRegisterMetaType<KMGraph2::CircuitBreaker::State>();
+
+        CircuitBreaker::Settings settings;
+        settings.failureRate = 0.5;
+        settings.minimumRequests = 2;
+        settings.windowSize = 4;
+        settings.openDuration = OpenDuration;
+        settings.maxProbes = 1;
+        CircuitBreaker::setDefaultSettings(settings);
+    }
+
+    void testParksUntilClosed()
+    {
+        CircuitBreaker *breaker = testBreaker();
+        openCircuit(breaker);
+        QCOMPARE(breaker->state(), CircuitBreaker::Open);
+
+        FakeNetwork network;
+        network.setResponder([](FakeReply *reply) { reply->respond(200, "content"); });
+
+        PagingJob job;
+        QSignalSpy spy(&job, &Job::finished);
+        QTest::qWait(OpenDuration / 4);
+        QCOMPARE(network.count(), 0);
+        QVERIFY(job.isRunning());
+
+        // The request is the probe that closes the circuit
+        QTRY_COMPARE(spy.count(), 1);
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(job.content, QByteArray("content"));
+        QCOMPARE(network.count(), 1);
+        QCOMPARE(breaker->state(), CircuitBreaker::Closed);
+    }
+
+    void testWaitingJobsResume()
+    {
+        CircuitBreaker *breaker = testBreaker();
+        openCircuit(breaker);
+
+        // Replies are sent by the test
+        FakeNetwork network;
+
+        PagingJob first;
+        PagingJob second;
+        QSignalSpy firstSpy(&first, &Job::finished);
+        QSignalSpy secondSpy(&second, &Job::finished);
+
+        // A single probe while half-open
+        QTRY_COMPARE(network.count(), 1);
+        QTest::qWait(OpenDuration / 4);
+        QCOMPARE(network.count(), 1);
+        QCOMPARE(breaker->state(), CircuitBreaker::HalfOpen);
+
+        network.reply(0)->respond(200, "probe");
+        QCOMPARE(breaker->state(), CircuitBreaker::Closed);
+
+        // The other job was waiting for the circuit to close
+        QTRY_COMPARE(network.count(), 2);
+        network.reply(1)->respond(200, "after");
+        QTRY_COMPARE(firstSpy.count(), 1);
+        QTRY_COMPARE(secondSpy.count(), 1);
+        QCOMPARE(first.error(), KMGraph2::NoError);
+        QCOMPARE(second.error(), KMGraph2::NoError);
+    }
+
+    void testFailFast()
+    {
+        openCircuit(testBreaker());
+
+        FakeNetwork network;
+        network.setResponder([](FakeReply *reply) { reply->respond(200, "content"); });
+
+        PagingJob job;
+        job.setFailFast(true);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+        QCOMPARE(job.error(), KMGraph2::CircuitOpen);
+        QCOMPARE(network.count(), 0);
+    }
+
+    void testOnlyProbeDecides()
+    {
+        CircuitBreaker *breaker = testBreaker();
+
+        // Replies are sent by the test
+        FakeNetwork network;
+
+        // Sent while the circuit was still closed
+        PagingJob late;
+        QSignalSpy lateSpy(&late, &Job::finished);
+        QTRY_COMPARE(network.count(), 1);
+
+        openCircuit(breaker);
+        QTRY_COMPARE(breaker->state(), CircuitBreaker::HalfOpen);
+        network.reply(0)->respond(200, "late");
+        QTRY_COMPARE(lateSpy.count(), 1);
+        QCOMPARE(breaker->state(), CircuitBreaker::HalfOpen);
+
+        PagingJob probe;
+        // A retry would wait for the circuit again
+        probe.setRetryPolicy(fastPolicy(1));
+        QSignalSpy probeSpy(&probe, &Job::finished);
+        QTRY_COMPARE(network.count(), 2);
+
+        network.reply(1)->respond(503, "{ \"error\": { \"message\": \"Still down\" } }");
+        QCOMPARE(breaker->state(), CircuitBreaker::Open);
+        QTRY_COMPARE(probeSpy.count(), 1);
+        QVERIFY(probe.error() != KMGraph2::NoError);
+    }
+
+    void testAbortReleasesProbe()
+    {
+        CircuitBreaker *breaker = testBreaker();
+        openCircuit(breaker);
+        QTRY_COMPARE(breaker->state(), CircuitBreaker::HalfOpen);
+
+        // Replies are sent by the test
+        FakeNetwork network;
+
+        PagingJob aborted;
+        QTRY_COMPARE(network.count(), 1);
+        PagingJob next;
+        QSignalSpy spy(&next, &Job::finished);
+        QTest::qWait(OpenDuration / 4);
+        QCOMPARE(network.count(), 1);
+
+        // Another probe may be sent without waiting for this one to expire
+        aborted.abort();
+        QVERIFY(network.reply(0)->aborted);
+        QCOMPARE(breaker->state(), CircuitBreaker::HalfOpen);
+        quint64 probe = 0;
+        QVERIFY(breaker->allowRequest(&probe));
+        breaker->releaseProbe(probe);
+
+        QTRY_COMPARE(network.count(), 2);
+
+        network.reply(1)->respond(200, "content");
+        QCOMPARE(breaker->state(), CircuitBreaker::Closed);
+        QTRY_COMPARE(spy.count(), 1);
+        QCOMPARE(next.error(), KMGraph2::NoError);
+    }
+};
+
+QTEST_GUILESS_MAIN(JobCircuitTest)
+
+#include "jobcircuittest.moc"
@@ -0,0 +1,114 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QObject>
+#include <QTest>
+#include <QTimer>
+
+#include "job.h"
+
+#include "fakenetwork.h"
+
+using namespace KMGraph2;
+
+namespace {
+
+// Keeps the event loop busy like a GUI full of other work would
+class EventLoopLoad
+{
+  public:
+    explicit EventLoopLoad(int timers)
+    {
+        for (int i = 0; i < timers; ++i) {
+            QTimer *timer = new QTimer(&mParent);
+            QObject::connect(timer, &QTimer::timeout, []() {
+                QElapsedTimer spin;
+                spin.start();
+                while (spin.nsecsElapsed() < 20000) {
+                }
+            });
+            timer->start(0);
+        }
+    }
+
+  private:
+    QObject mParent;
+};
+
+// Runs the event loop until @p job finishes, gives up after @p timeout msecs
+bool waitForFinished(Job *job, int timeout = 5000)
+{
+    bool finished = false;
+    QEventLoop loop;
+    QObject::connect(job, &Job::finished, &loop, [&]() {
+        finished = true;
+        loop.quit();
+    });
+    QTimer::singleShot(timeout, &loop, &QEventLoop::quit);
+    loop.exec();
+    return finished;
+}
+
+}
+
+class JobDispatchBenchmark: public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testDirectDispatch()
+    {
+        // Nothing is sent, the job finishes without a reply to wait for
+        PagingJob job(3, 3);
+        job.sendRequests = false;
+        QVERIFY(waitForFinished(&job));
+
+        // No event loop round-trip between the queued requests
+        QCOMPARE(job.dispatchedInStart, 3);
+        QCOMPARE(job.dispatched, 3);
+        QCOMPARE(job.error(), KMGraph2::NoError);
+    }
+
+    void benchmarkTinyJob_data()
+    {
+        QTest::addColumn<int>("load");
+
+        QTest::newRow("idle") << 0;
+        QTest::newRow("loaded") << 50;
+    }
+
+    void benchmarkTinyJob()
+    {
+        QFETCH(int, load);
+
+        EventLoopLoad eventLoopLoad(load);
+        QBENCHMARK {
+            PagingJob job;
+            job.sendRequests = false;
+            QVERIFY(waitForFinished(&job));
+        }
+    }
+};
+
+QTEST_GUILESS_MAIN(JobDispatchBenchmark)
+
+#include "jobdispatchbenchmark.moc"
@@ -0,0 +1,234 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QNetworkRequest>
+#include <QPointer>
+#include <QTest>
+
+#include "account.h"
+#include "fetchjob.h"
+#include "jobfuture.h"
+#include "object.h"
+
+using namespace KMGraph2;
+
+namespace {
+
+class Apple : public Object
+{
+};
+
+class Pear : public Object
+{
+};
+
+typedef QSharedPointer<Apple> ApplePtr;
+
+// Finishes as soon as its only request is dispatched, unless told to hang
+class FakeFetchJob : public FetchJob
+{
+  public:
+    explicit FakeFetchJob(const ObjectsList &items, KMGraph2::Error error = KMGraph2::NoError):
+        FetchJob(AccountPtr(new Account(QStringLiteral("future@example.com")))),
+        mItems(items),
+        mError(error)
+    {
+    }
+
+    bool hang = false;
+
+    ObjectsList items() const override
+    {
+        return mItems;
+    }
+
+  protected:
+    void start() override
+    {
+        enqueueRequest(QNetworkRequest(QUrl(QStringLiteral("https://graph.example/me/drive/root/children"))));
+    }
+
+    void dispatchRequest(QNetworkAccessManager *accessManager, const QNetworkRequest &request,
+                         const QByteArray &data, const QString &contentType) override
+    {
+        Q_UNUSED(accessManager)
+        Q_UNUSED(request)
+        Q_UNUSED(data)
+        Q_UNUSED(contentType)
+
+        if (hang) {
+            return;
+        }
+        if (mError != KMGraph2::NoError) {
+            setError(mError);
+            setErrorString(QStringLiteral("Fake error"));
+        }
+        emitFinished();
+    }
+
+    ObjectsList handleReplyWithItems(const QNetworkReply *reply, const QByteArray &rawData) override
+    {
+        Q_UNUSED(reply)
+        Q_UNUSED(rawData)
+        return ObjectsList();
+    }
+
+  private:
+    ObjectsList mItems;
+    KMGraph2::Error mError;
+};
+
+ObjectsList fruits(int apples, int pears)
+{
+    ObjectsList list;
+    for (int i = 0; i < apples; ++i) {
+        list << ObjectPtr(new Apple);
+    }
+    for (int i = 0; i < pears; ++i) {
+        list << ObjectPtr(new Pear);
+    }
+    return list;
+}
+
+}
+
+class JobFutureTest: public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testResult()
+    {
+        QPointer<FakeFetchJob> job = new FakeFetchJob(fruits(2, 1));
+        auto future = toFuture(job.data(), [](FakeFetchJob *job) { return job->items().count(); });
+
+        QTRY_VERIFY(future.isFinished());
+        QVERIFY(!future.isCanceled());
+        QVERIFY(future.result().isOk());
+        QCOMPARE(future.result().value, 3);
+        // The future owns the job
+        QTRY_VERIFY(job.isNull());
+    }
+
+    void testItems()
+    {
+        auto future = itemsFuture<Apple>(new FakeFetchJob(fruits(2, 3)));
+
+        QTRY_VERIFY(future.isFinished());
+        const QList<ApplePtr> apples = future.result().value;
+        QCOMPARE(apples.count(), 2);
+        QVERIFY(!apples.contains(ApplePtr()));
+    }
+
+    void testError()
+    {
+        bool extracted = false;
+        auto future = toFuture(new FakeFetchJob(fruits(1, 0), KMGraph2::Forbidden),
+                               [&extracted](FakeFetchJob *job) { extracted = true; return job->items(); });
+
+        QTRY_VERIFY(future.isFinished());
+        QVERIFY(!future.isCanceled());
+        QVERIFY(!future.result().isOk());
+        QCOMPARE(future.result().error, KMGraph2::Forbidden);
+        QCOMPARE(future.result().errorString, QStringLiteral("Fake error"));
+        QVERIFY(future.result().value.isEmpty());
+        QVERIFY(!extracted);
+    }
+
+    void testCancel()
+    {
+        QPointer<FakeFetchJob> job = new FakeFetchJob(fruits(1, 0));
+        job->hang = true;
+        auto future = itemsFuture<Apple>(job.data());
+        QTRY_VERIFY(job->isRunning());
+
+        future.cancel();
+
+        // Cancelling the future aborts the job
+        QTRY_VERIFY(job.isNull());
+        QVERIFY(future.isFinished());
+        QVERIFY(future.isCanceled());
+    }
+
+    void testThen()
+    {
+        QObject context;
+        auto future = then(itemsFuture<Apple>(new FakeFetchJob(fruits(3, 1))), &context,
+                           [](const JobResult<QList<ApplePtr>> &apples) { return apples.value.count() * 10; });
+
+        QTRY_VERIFY(future.isFinished());
+        QCOMPARE(future.result(), 30);
+    }
+
+    void testThenContextDestroyed()
+    {
+        bool called = false;
+        QObject *context = new QObject;
+        auto future = then(itemsFuture<Apple>(new FakeFetchJob(fruits(1, 0))), context,
+                           [&called](const JobResult<QList<ApplePtr>> &) { called = true; });
+        delete context;
+
+        QVERIFY(future.isFinished());
+        QVERIFY(future.isCanceled());
+        QTest::qWait(50);
+        QVERIFY(!called);
+    }
+
+    void testFanOut()
+    {
+        QObject context;
+        auto future = then(itemsFuture<Apple>(new FakeFetchJob(fruits(4, 2))), &context,
+                           [](const JobResult<QList<ApplePtr>> &apples) {
+                               QList<QFuture<JobResult<QList<ApplePtr>>>> futures;
+                               for (int i = 0; i < apples.value.count(); ++i) {
+                                   futures << itemsFuture<Apple>(new FakeFetchJob(fruits(i, 1),
+                                                                 i == 2 ? KMGraph2::NotFound : KMGraph2::NoError));
+                               }
+                               return whenAll(futures);
+                           });
+
+        QTRY_VERIFY(future.isFinished());
+        QVERIFY(!future.isCanceled());
+        const QList<JobResult<QList<ApplePtr>>> results = future.result();
+        QCOMPARE(results.count(), 4);
+        for (int i = 0; i < results.count(); ++i) {
+            if (i == 2) {
+                // A failed job does not fail the others
+                QCOMPARE(results.at(i).error, KMGraph2::NotFound);
+            } else {
+                QVERIFY(results.at(i).isOk());
+                QCOMPARE(results.at(i).value.count(), i);
+            }
+        }
+    }
+
+    void testWhenAllEmpty()
+    {
+        auto future = whenAll(QList<QFuture<int>>());
+
+        QVERIFY(future.isFinished());
+        QVERIFY(future.result().isEmpty());
+    }
+};
+
+QTEST_GUILESS_MAIN(JobFutureTest)
+
+#include "jobfuturetest.moc"
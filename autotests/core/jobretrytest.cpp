@@ -0,0 +1,242 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QSignalSpy>
+#include <QTest>
+
+#include "job.h"
+#include "retrypolicy.h"
+
+#include "fakenetwork.h"
+
+using namespace KMGraph2;
+
+namespace {
+
+QByteArray pageContent(const QUrl &url)
+{
+    return "page " + url.query().section(QLatin1Char('='), 1).toLatin1();
+}
+
+}
+
+class JobRetryTest: public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testResumesAtFailedRequest()
+    {
+        FakeNetwork network;
+        QHash<QString, int> attempts;
+        network.setResponder([&attempts](FakeReply *reply) {
+            const int attempt = ++attempts[reply->url().toString()];
+            if (reply->url() == pageUrl(2) && attempt == 1) {
+                reply->respond(500, "{ \"error\": { \"message\": \"Hiccup\" } }");
+            } else {
+                reply->respond(200, pageContent(reply->url()));
+            }
+        });
+
+        PagingJob job(3);
+        job.setRetryPolicy(fastPolicy());
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        // Nothing fetched before the failure is fetched again
+        QCOMPARE(network.urls(), QList<QUrl>() << pageUrl(1) << pageUrl(2) << pageUrl(2) << pageUrl(3));
+        QCOMPARE(job.pages, QStringList() << QStringLiteral("page 1") << QStringLiteral("page 2")
+                                          << QStringLiteral("page 3"));
+    }
+
+    void testNetworkError()
+    {
+        FakeNetwork network;
+        network.setResponder([&network](FakeReply *reply) {
+            if (network.count() == 1) {
+                reply->fail(QNetworkReply::ConnectionRefusedError);
+            } else {
+                reply->respond(200, pageContent(reply->url()));
+            }
+        });
+
+        PagingJob job(1);
+        job.setRetryPolicy(fastPolicy());
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(network.count(), 2);
+        QCOMPARE(job.pages, QStringList() << QStringLiteral("page 1"));
+    }
+
+    void testCancelledElsewhere()
+    {
+        FakeNetwork network;
+        network.setResponder([&network](FakeReply *reply) {
+            // Not aborted by the job, e.g. the shared request went away
+            if (network.count() == 1) {
+                reply->fail(QNetworkReply::OperationCanceledError);
+            } else {
+                reply->respond(200, pageContent(reply->url()));
+            }
+        });
+
+        PagingJob job(1);
+        job.setRetryPolicy(fastPolicy());
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(network.count(), 2);
+        QCOMPARE(job.pages, QStringList() << QStringLiteral("page 1"));
+    }
+
+    void testRetryAfter()
+    {
+        FakeNetwork network;
+        QElapsedTimer elapsed;
+        QList<qint64> sent;
+        elapsed.start();
+        network.setResponder([&](FakeReply *reply) {
+            sent << elapsed.elapsed();
+            if (sent.count() == 1) {
+                reply->respond(503, QByteArray(), { { "Retry-After", "1" } });
+            } else {
+                reply->respond(200, pageContent(reply->url()));
+            }
+        });
+
+        PagingJob job(1);
+        job.setRetryPolicy(fastPolicy());
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(sent.count(), 2);
+        // The server asked for much more than the 10 msecs of the policy
+        QVERIFY(sent.at(1) - sent.at(0) >= 950);
+    }
+
+    void testGivesUp_data()
+    {
+        QTest::addColumn<int>("status");
+        QTest::addColumn<int>("error");
+
+        QTest::newRow("internal error") << 500 << int(KMGraph2::InternalError);
+        QTest::newRow("service unavailable") << 503 << int(KMGraph2::QuotaExceeded);
+        QTest::newRow("too many requests") << 429 << int(KMGraph2::QuotaExceeded);
+    }
+
+    void testGivesUp()
+    {
+        QFETCH(int, status);
+        QFETCH(int, error);
+
+        FakeNetwork network;
+        network.setResponder([status](FakeReply *reply) { reply->respond(status); });
+
+        PagingJob job(1);
+        job.setRetryPolicy(fastPolicy(3));
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(int(job.error()), error);
+        QCOMPARE(network.count(), 3);
+    }
+
+    void testMaxTimeout()
+    {
+        FakeNetwork network;
+        network.setResponder([](FakeReply *reply) {
+            reply->respond(503, QByteArray(), { { "Retry-After", "3600" } });
+        });
+
+        PagingJob job(1);
+        job.setRetryPolicy(fastPolicy());
+        job.setMaxTimeout(10);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(job.error(), KMGraph2::QuotaExceeded);
+        QCOMPARE(network.count(), 1);
+    }
+
+    void testPostNotRetried()
+    {
+        FakeNetwork network;
+        network.setResponder([](FakeReply *reply) { reply->respond(502); });
+
+        PagingJob job(1);
+        job.post = true;
+        job.setRetryPolicy(fastPolicy());
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        // The server may have created something already
+        QCOMPARE(network.count(), 1);
+        QCOMPARE(job.error(), KMGraph2::UnknownError);
+    }
+
+    void testPostRetried_data()
+    {
+        QTest::addColumn<int>("status");
+        QTest::addColumn<bool>("retryNonIdempotent");
+
+        QTest::newRow("opted in") << 502 << true;
+        QTest::newRow("throttled") << 429 << false;
+    }
+
+    void testPostRetried()
+    {
+        QFETCH(int, status);
+        QFETCH(bool, retryNonIdempotent);
+
+        FakeNetwork network;
+        network.setResponder([&network, status](FakeReply *reply) {
+            if (network.count() == 1) {
+                reply->respond(status);
+            } else {
+                reply->respond(201, reply->body());
+            }
+        });
+
+        RetryPolicy policy = fastPolicy();
+        policy.setRetryNonIdempotent(retryNonIdempotent);
+        PagingJob job(1);
+        job.post = true;
+        job.setRetryPolicy(policy);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(network.count(), 2);
+        // The body is sent again, too
+        QCOMPARE(job.pages, QStringList() << QStringLiteral("{}"));
+    }
+};
+
+QTEST_GUILESS_MAIN(JobRetryTest)
+
+#include "jobretrytest.moc"
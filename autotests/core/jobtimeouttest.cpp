@@ -0,0 +1,170 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QPointer>
+#include <QSignalSpy>
+#include <QTest>
+
+#include "job.h"
+#include "latencytracker.h"
+#include "retrypolicy.h"
+
+#include "fakenetwork.h"
+
+using namespace KMGraph2;
+
+class JobTimeoutTest: public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void cleanup()
+    {
+        // PagingJob has no meta object of its own
+        LatencyTracker::instance(Job::staticMetaObject.className())->clear();
+    }
+
+    void testTimeoutRetried()
+    {
+        FakeNetwork network;
+        network.setResponder([&network](FakeReply *reply) {
+            // The first request stalls
+            if (network.count() > 1) {
+                reply->respond(200, "content");
+            }
+        });
+
+        PagingJob job;
+        job.setRequestTimeout(100);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(network.count(), 2);
+        QCOMPARE(job.content, QByteArray("content"));
+    }
+
+    void testTimeoutFails()
+    {
+        FakeNetwork network;
+
+        PagingJob job;
+        job.setRequestTimeout(50);
+        RetryPolicy policy = job.retryPolicy();
+        policy.setMaxAttempts(2);
+        job.setRetryPolicy(policy);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(job.error(), KMGraph2::Timeout);
+        QCOMPARE(network.count(), 2);
+    }
+
+    void testPostNotRetried()
+    {
+        FakeNetwork network;
+
+        PagingJob job;
+        job.post = true;
+        job.setRequestTimeout(50);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        // The server may have received it anyway
+        QCOMPARE(job.error(), KMGraph2::Timeout);
+        QCOMPARE(network.count(), 1);
+        QVERIFY(network.reply(0)->aborted);
+    }
+
+    void testProgressKeepsRequestAlive()
+    {
+        FakeNetwork network;
+        network.setResponder([](FakeReply *reply) {
+            reply->respondHeaders(200);
+            // Much longer than the timeout, but never silent for long
+            for (int i = 1; i <= 10; ++i) {
+                QTimer::singleShot(i * 30, reply, [reply, i]() {
+                    if (i < 10) {
+                        reply->deliver("x");
+                    } else {
+                        reply->respond(200);
+                    }
+                });
+            }
+        });
+
+        PagingJob job;
+        job.setRequestTimeout(100);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(network.count(), 1);
+        QCOMPARE(job.content, QByteArray(9, 'x'));
+    }
+
+    void testHedging()
+    {
+        FakeNetwork network;
+        network.setResponder([&network](FakeReply *reply) {
+            // Only the hedged copy gets through
+            if (network.count() > 1) {
+                reply->respond(200, "content");
+            }
+        });
+
+        PagingJob job;
+        job.setHedgingEnabled(true);
+        LatencyTracker *tracker = LatencyTracker::instance(job.metaObject()->className());
+        for (int i = 0; i < 32; ++i) {
+            tracker->addSample(20);
+        }
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(network.count(), 2);
+        QCOMPARE(job.content, QByteArray("content"));
+        // The slow copy has been given up
+        QPointer<FakeReply> original = network.reply(0);
+        QTRY_VERIFY(original.isNull() || original->aborted);
+    }
+
+    void testHedgingNeedsStatistics()
+    {
+        FakeNetwork network;
+        network.setResponder([](FakeReply *reply) {
+            QTimer::singleShot(100, reply, [reply]() { reply->respond(200, "content"); });
+        });
+
+        PagingJob job;
+        job.setHedgingEnabled(true);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(network.count(), 1);
+    }
+};
+
+QTEST_GUILESS_MAIN(JobTimeoutTest)
+
+#include "jobtimeouttest.moc"
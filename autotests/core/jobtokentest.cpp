@@ -0,0 +1,218 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <QObject>
+#include <QSignalSpy>
+#include <QTest>
+
+#include "account.h"
+#include "job.h"
+#include "tokenprovider.h"
+
+#include "fakenetwork.h"
+
+using namespace KMGraph2;
+
+namespace {
+
+// Hands out tokens numbered by the refresh, synchronously or in the next
+// event loop iteration
+class TestTokenProvider : public TokenProvider
+{
+  public:
+    bool async = false;
+    bool success = true;
+    int expiresIn = 3600; // seconds
+    int refreshCount = 0;
+
+  protected:
+    void doRefreshTokens(const AccountPtr &account) override
+    {
+        ++refreshCount;
+        const auto finish = [this, account]() {
+            if (success) {
+                account->setAccessToken(QStringLiteral("token %1").arg(refreshCount));
+                account->setExpireDateTime(QDateTime::currentDateTimeUtc().addSecs(expiresIn));
+            }
+            finishRefresh(account, success);
+        };
+        if (async) {
+            QTimer::singleShot(0, this, finish);
+        } else {
+            finish();
+        }
+    }
+};
+
+// Every test gets its own account, and so its own circuit breaker
+AccountPtr testAccount(TestTokenProvider *provider, int expiresIn)
+{
+    const AccountPtr account(new Account(testAccountName(), QStringLiteral("old")));
+    account->setExpireDateTime(QDateTime::currentDateTimeUtc().addSecs(expiresIn));
+    account->setTokenProvider(provider);
+    return account;
+}
+
+}
+
+class JobTokenTest: public QObject
+{
+    Q_OBJECT
+private:
+    static void addProviderRows()
+    {
+        QTest::addColumn<bool>("async");
+
+        QTest::newRow("synchronous provider") << false;
+        QTest::newRow("asynchronous provider") << true;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        qRegisterMetaType<KMGraph2::AccountPtr>();
+    }
+
+    void testUnauthorizedReplayed_data()
+    {
+        addProviderRows();
+    }
+
+    void testUnauthorizedReplayed()
+    {
+        QFETCH(bool, async);
+
+        FakeNetwork network;
+        QList<QByteArray> tokens;
+        network.setResponder([&tokens](FakeReply *reply) {
+            tokens << reply->request().rawHeader("Authorization");
+            reply->respond(tokens.last() == "Bearer old" ? 401 : 200, "{}");
+        });
+
+        TestTokenProvider provider;
+        provider.async = async;
+        PagingJob job(testAccount(&provider, 3600), 1);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(provider.refreshCount, 1);
+        // The same request again, with the new token
+        QCOMPARE(network.urls(), QList<QUrl>() << pageUrl(1) << pageUrl(1));
+        QCOMPARE(tokens, QList<QByteArray>() << "Bearer old" << "Bearer token 1");
+        QCOMPARE(job.pages.count(), 1);
+    }
+
+    void testUnauthorizedTwice()
+    {
+        FakeNetwork network;
+        network.setResponder([](FakeReply *reply) { reply->respond(401, "{}"); });
+
+        TestTokenProvider provider;
+        PagingJob job(testAccount(&provider, 3600), 1);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        // Replayed only once
+        QCOMPARE(job.error(), KMGraph2::Unauthorized);
+        QCOMPARE(provider.refreshCount, 1);
+        QCOMPARE(network.count(), 2);
+    }
+
+    void testRefreshedAhead_data()
+    {
+        addProviderRows();
+    }
+
+    void testRefreshedAhead()
+    {
+        QFETCH(bool, async);
+
+        FakeNetwork network;
+        QList<QByteArray> tokens;
+        network.setResponder([&tokens](FakeReply *reply) {
+            tokens << reply->request().rawHeader("Authorization");
+            reply->respond(200, "{}");
+        });
+
+        TestTokenProvider provider;
+        provider.async = async;
+        // Expires before the requests would be done
+        PagingJob job(testAccount(&provider, 10), 3);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(provider.refreshCount, 1);
+        QCOMPARE(tokens, QList<QByteArray>() << "Bearer token 1" << "Bearer token 1" << "Bearer token 1");
+    }
+
+    void testShortLivedTokens_data()
+    {
+        addProviderRows();
+    }
+
+    void testShortLivedTokens()
+    {
+        QFETCH(bool, async);
+
+        FakeNetwork network;
+        QList<QByteArray> tokens;
+        network.setResponder([&tokens](FakeReply *reply) {
+            tokens << reply->request().rawHeader("Authorization");
+            reply->respond(200, "{}");
+        });
+
+        TestTokenProvider provider;
+        provider.async = async;
+        // Even new tokens expire within the margin, every request is sent
+        // after a single refresh anyway
+        provider.expiresIn = 10;
+        PagingJob job(testAccount(&provider, 10), 3);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(provider.refreshCount, 3);
+        QCOMPARE(tokens, QList<QByteArray>() << "Bearer token 1" << "Bearer token 2" << "Bearer token 3");
+    }
+
+    void testRefreshFails()
+    {
+        FakeNetwork network;
+        network.setResponder([](FakeReply *reply) { reply->respond(200, "{}"); });
+
+        TestTokenProvider provider;
+        provider.success = false;
+        PagingJob job(testAccount(&provider, 10), 1);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(job.error(), KMGraph2::Unauthorized);
+        QCOMPARE(provider.refreshCount, 1);
+        QCOMPARE(network.count(), 0);
+    }
+};
+
+QTEST_GUILESS_MAIN(JobTokenTest)
+
+#include "jobtokentest.moc"
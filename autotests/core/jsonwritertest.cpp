@@ -0,0 +1,204 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QTest>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QUrl>
+
+#include <limits>
+
+#include "jsonwriter.h"
+
+using namespace KMGraph2;
+
+class JsonWriterTest: public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testEmpty()
+    {
+        JsonWriter writer;
+        writer.beginObject();
+        writer.endObject();
+        QCOMPARE(writer.data(), QByteArray("{}"));
+
+        JsonWriter arrayWriter;
+        arrayWriter.beginArray();
+        arrayWriter.endArray();
+        QCOMPARE(arrayWriter.data(), QByteArray("[]"));
+    }
+
+    void testValues()
+    {
+        JsonWriter writer;
+        writer.beginObject();
+        writer.write("string", QStringLiteral("value"));
+        writer.write("latin1", QLatin1String("drive#file"));
+        writer.write("url", QUrl(QStringLiteral("https://example.com/a b")));
+        writer.write("true", true);
+        writer.write("false", false);
+        writer.write("int", -42);
+        writer.write("max", std::numeric_limits<qint64>::max());
+        writer.write("min", std::numeric_limits<qint64>::min());
+        writer.write("date", QDateTime(QDate(2013, 6, 14), QTime(9, 20, 40), Qt::UTC));
+        writer.endObject();
+
+        QCOMPARE(writer.data(),
+                 QByteArray("{\"string\":\"value\",\"latin1\":\"drive#file\","
+                            "\"url\":\"https://example.com/a%20b\",\"true\":true,\"false\":false,"
+                            "\"int\":-42,\"max\":9223372036854775807,\"min\":-9223372036854775808,"
+                            "\"date\":\"2013-06-14T09:20:40Z\"}"));
+    }
+
+    void testNesting()
+    {
+        JsonWriter writer;
+        writer.beginObject();
+        writer.beginObject("labels");
+        writer.write("starred", true);
+        writer.endObject();
+        writer.beginArray("parents");
+        writer.beginObject();
+        writer.write("id", QStringLiteral("a"));
+        writer.endObject();
+        writer.beginObject();
+        writer.endObject();
+        writer.endArray();
+        writer.beginArray("ownerNames");
+        writer.write(QStringLiteral("John"));
+        writer.write(QLatin1String("Jane"));
+        writer.endArray();
+        writer.write("last", 1);
+        writer.endObject();
+
+        QCOMPARE(writer.data(),
+                 QByteArray("{\"labels\":{\"starred\":true},\"parents\":[{\"id\":\"a\"},{}],"
+                            "\"ownerNames\":[\"John\",\"Jane\"],\"last\":1}"));
+    }
+
+    void testEscaping_data()
+    {
+        QTest::addColumn<QString>("value");
+
+        QTest::newRow("quotes") << QStringLiteral("say \"hello\"");
+        QTest::newRow("backslash") << QStringLiteral("C:\\Users\\file");
+        QTest::newRow("control") << QStringLiteral("tab\tnew\nline\r\b\f") + QChar(0x01) + QChar(0x1f);
+        QTest::newRow("slash") << QStringLiteral("a/b");
+        QTest::newRow("latin1") << QStringLiteral("Příliš žluťoučký kůň");
+        QTest::newRow("bmp") << QStringLiteral("日本語のファイル");
+        QTest::newRow("surrogates") << QString::fromUtf8("emoji \xF0\x9F\x98\x80 file");
+    }
+
+    void testEscaping()
+    {
+        QFETCH(QString, value);
+
+        JsonWriter writer;
+        writer.beginObject();
+        writer.write("title", value);
+        writer.endObject();
+
+        QJsonParseError error;
+        const QJsonDocument document = QJsonDocument::fromJson(writer.data(), &error);
+        QCOMPARE(error.error, QJsonParseError::NoError);
+        QCOMPARE(document.object().value(QStringLiteral("title")).toString(), value);
+    }
+
+    void testLatin1Escaping()
+    {
+        JsonWriter writer;
+        writer.beginArray();
+        writer.write(QLatin1String("caf\xe9 \"\\"));
+        writer.endArray();
+
+        QCOMPARE(writer.data(), QByteArray("[\"caf\xc3\xa9 \\\"\\\\\"]"));
+    }
+
+    void benchmarkSerialize_data()
+    {
+        QTest::addColumn<bool>("useWriter");
+
+        QTest::newRow("QJsonDocument") << false;
+        QTest::newRow("JsonWriter") << true;
+    }
+
+    void benchmarkSerialize()
+    {
+        QFETCH(bool, useWriter);
+
+        const QString title = QStringLiteral("Quarterly report (final).odt");
+        const QString mimeType = QStringLiteral("application/vnd.oasis.opendocument.text");
+        const QString date = QStringLiteral("2013-06-14T09:20:40Z");
+        const QString parent = QStringLiteral("0B6bJ2k9zL8zkZGFkMTE3ZjYtZjM5Mi00");
+
+        QByteArray json;
+        if (useWriter) {
+            QBENCHMARK {
+                JsonWriter writer;
+                writer.beginObject();
+                writer.write("kind", QLatin1String("drive#file"));
+                writer.write("title", title);
+                writer.write("mimeType", mimeType);
+                writer.write("modifiedDate", date);
+                writer.write("fileSize", qint64(123456));
+                writer.beginObject("labels");
+                writer.write("starred", true);
+                writer.write("trashed", false);
+                writer.endObject();
+                writer.beginArray("parents");
+                writer.beginObject();
+                writer.write("id", parent);
+                writer.endObject();
+                writer.endArray();
+                writer.endObject();
+                json = writer.data();
+            }
+        } else {
+            QBENCHMARK {
+                QVariantMap map;
+                map[QStringLiteral("kind")] = QLatin1String("drive#file");
+                map[QStringLiteral("title")] = title;
+                map[QStringLiteral("mimeType")] = mimeType;
+                map[QStringLiteral("modifiedDate")] = date;
+                map[QStringLiteral("fileSize")] = qint64(123456);
+                QVariantMap labels;
+                labels[QStringLiteral("starred")] = true;
+                labels[QStringLiteral("trashed")] = false;
+                map[QStringLiteral("labels")] = labels;
+                QVariantMap parentMap;
+                parentMap[QStringLiteral("id")] = parent;
+                map[QStringLiteral("parents")] = QVariantList{ parentMap };
+                json = QJsonDocument::fromVariant(map).toJson(QJsonDocument::Compact);
+            }
+        }
+
+        const QVariantMap result = QJsonDocument::fromJson(json).toVariant().toMap();
+        QCOMPARE(result[QStringLiteral("title")].toString(), title);
+        QCOMPARE(result[QStringLiteral("fileSize")].toLongLong(), qint64(123456));
+    }
+};
+
+QTEST_GUILESS_MAIN(JsonWriterTest)
+
+#include "jsonwritertest.moc"
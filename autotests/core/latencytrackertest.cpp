@@ -0,0 +1,98 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QTest>
+
+#include "latencytracker.h"
+
+using namespace KMGraph2;
+
+class LatencyTrackerTest: public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testEmpty()
+    {
+        LatencyTracker tracker;
+        QCOMPARE(tracker.sampleCount(), 0);
+        QCOMPARE(tracker.percentile(95), -1);
+    }
+
+    void testPercentile_data()
+    {
+        QTest::addColumn<int>("percentile");
+        QTest::addColumn<int>("expected");
+
+        QTest::newRow("min") << 0 << 1;
+        QTest::newRow("median") << 50 << 50;
+        QTest::newRow("p95") << 95 << 95;
+        QTest::newRow("p99") << 99 << 99;
+        QTest::newRow("max") << 100 << 100;
+        QTest::newRow("out of range") << 150 << 100;
+    }
+
+    void testPercentile()
+    {
+        QFETCH(int, percentile);
+        QFETCH(int, expected);
+
+        LatencyTracker tracker;
+        // Insert in reverse order, so that the result does not depend on it
+        for (int i = 100; i >= 1; --i) {
+            tracker.addSample(i);
+        }
+
+        QCOMPARE(tracker.sampleCount(), 100);
+        QCOMPARE(tracker.percentile(percentile), expected);
+    }
+
+    void testWindow()
+    {
+        LatencyTracker tracker(10);
+        for (int i = 0; i < 10; ++i) {
+            tracker.addSample(1000);
+        }
+        QCOMPARE(tracker.percentile(50), 1000);
+
+        // Newer samples replace the oldest ones
+        for (int i = 0; i < 10; ++i) {
+            tracker.addSample(10);
+        }
+        QCOMPARE(tracker.sampleCount(), 10);
+        QCOMPARE(tracker.capacity(), 10);
+        QCOMPARE(tracker.percentile(100), 10);
+
+        tracker.clear();
+        QCOMPARE(tracker.sampleCount(), 0);
+    }
+
+    void testInstance()
+    {
+        LatencyTracker *tracker = LatencyTracker::instance("KMGraph2::OneDrive::FileFetchJob");
+        QCOMPARE(LatencyTracker::instance("KMGraph2::OneDrive::FileFetchJob"), tracker);
+        QVERIFY(LatencyTracker::instance("KMGraph2::OneDrive::FileFetchContentJob") != tracker);
+    }
+};
+
+QTEST_GUILESS_MAIN(LatencyTrackerTest)
+
+#include "latencytrackertest.moc"
@@ -0,0 +1,115 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QTest>
+#include <QCryptographicHash>
+
+#include "multibuffermd5.h"
+
+using namespace KMGraph2;
+
+Q_DECLARE_METATYPE(KMGraph2::MultiBufferMd5::Engine)
+
+class MultiBufferMd5Benchmark: public QObject
+{
+    Q_OBJECT
+private:
+    static QVector<QByteArray> generateBuffers(int count, int size)
+    {
+        QVector<QByteArray> buffers;
+        buffers.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            QByteArray buffer(size, Qt::Uninitialized);
+            for (int j = 0; j < size; ++j) {
+                buffer[j] = char((i * 31 + j * 7) & 0xff);
+            }
+            buffers.append(buffer);
+        }
+        return buffers;
+    }
+
+    static void addEngineRows()
+    {
+        QTest::addColumn<MultiBufferMd5::Engine>("engine");
+
+        QTest::newRow("scalar") << MultiBufferMd5::Scalar;
+        if (MultiBufferMd5::isSupported(MultiBufferMd5::SSE2)) {
+            QTest::newRow("sse2") << MultiBufferMd5::SSE2;
+        }
+        if (MultiBufferMd5::isSupported(MultiBufferMd5::AVX2)) {
+            QTest::newRow("avx2") << MultiBufferMd5::AVX2;
+        }
+    }
+
+private Q_SLOTS:
+    void testDigests_data()
+    {
+        addEngineRows();
+    }
+
+    void testDigests()
+    {
+        QFETCH(MultiBufferMd5::Engine, engine);
+
+        // Covers empty input, both padding cases and the lane refill
+        QVector<QByteArray> buffers;
+        for (int size = 0; size <= 300; ++size) {
+            buffers.append(generateBuffers(1, size).first());
+        }
+        buffers.append(QByteArray(100000, 'a'));
+
+        const QVector<QByteArray> digests = MultiBufferMd5::hash(buffers, engine);
+        QCOMPARE(digests.size(), buffers.size());
+        for (int i = 0; i < buffers.size(); ++i) {
+            QCOMPARE(digests[i], QCryptographicHash::hash(buffers[i], QCryptographicHash::Md5));
+        }
+    }
+
+    void benchmarkSmallBuffers_data()
+    {
+        addEngineRows();
+    }
+
+    void benchmarkSmallBuffers()
+    {
+        QFETCH(MultiBufferMd5::Engine, engine);
+
+        const QVector<QByteArray> buffers = generateBuffers(4096, 4096);
+        QBENCHMARK {
+            MultiBufferMd5::hash(buffers, engine);
+        }
+    }
+
+    void benchmarkSmallBuffersQCryptographicHash()
+    {
+        const QVector<QByteArray> buffers = generateBuffers(4096, 4096);
+        QBENCHMARK {
+            for (const QByteArray &buffer : buffers) {
+                QCryptographicHash::hash(buffer, QCryptographicHash::Md5);
+            }
+        }
+    }
+};
+
+QTEST_GUILESS_MAIN(MultiBufferMd5Benchmark)
+
+#include "multibuffermd5benchmark.moc"
@@ -0,0 +1,210 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QPointer>
+#include <QSignalSpy>
+#include <QTest>
+
+#include "requestcoalescer.h"
+
+#include "fakenetwork.h"
+
+using namespace KMGraph2;
+
+namespace {
+
+QNetworkRequest request(const QString &url, const QByteArray &token = "token")
+{
+    QNetworkRequest request((QUrl(url)));
+    request.setRawHeader("Authorization", "Bearer " + token);
+    return request;
+}
+
+}
+
+class RequestCoalescerTest: public QObject
+{
+    Q_OBJECT
+
+private:
+    RequestCoalescer::Sender sender(const QNetworkRequest &request)
+    {
+        return [this, request]() {
+            FakeReply *reply = new FakeReply(request);
+            mSent << reply;
+            return reply;
+        };
+    }
+
+    // Replies finished by the coalescer are deleted by it
+    QList<QPointer<FakeReply> > mSent;
+
+private Q_SLOTS:
+    void cleanup()
+    {
+        for (const QPointer<FakeReply> &reply : qAsConst(mSent)) {
+            delete reply.data();
+        }
+        mSent.clear();
+    }
+
+    void testIdenticalRequests()
+    {
+        RequestCoalescer coalescer;
+        const QNetworkRequest about = request(QStringLiteral("https://graph.example/me/drive"));
+
+        QScopedPointer<QNetworkReply> first(coalescer.get(about, sender(about), nullptr));
+        QScopedPointer<QNetworkReply> second(coalescer.get(about, sender(about), nullptr));
+        QCOMPARE(mSent.count(), 1);
+        QCOMPARE(coalescer.inFlightCount(), 1);
+
+        QSignalSpy firstFinished(first.data(), &QNetworkReply::finished);
+        QSignalSpy secondFinished(second.data(), &QNetworkReply::finished);
+        mSent.first()->respond(200, "{\"id\":\"drive\"}");
+
+        QCOMPARE(firstFinished.count(), 1);
+        QCOMPARE(secondFinished.count(), 1);
+        QCOMPARE(coalescer.inFlightCount(), 0);
+        for (QNetworkReply *reply : { first.data(), second.data() }) {
+            QVERIFY(reply->isFinished());
+            QCOMPARE(reply->error(), QNetworkReply::NoError);
+            QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 200);
+            QCOMPARE(reply->rawHeader("Content-Type"), QByteArray("application/json"));
+            QCOMPARE(reply->readAll(), QByteArray("{\"id\":\"drive\"}"));
+        }
+    }
+
+    void testDifferentRequests()
+    {
+        RequestCoalescer coalescer;
+        const QNetworkRequest file = request(QStringLiteral("https://graph.example/items/1"));
+        const QNetworkRequest otherFile = request(QStringLiteral("https://graph.example/items/2"));
+        const QNetworkRequest otherAccount = request(QStringLiteral("https://graph.example/items/1"), "other");
+
+        QScopedPointer<QNetworkReply> first(coalescer.get(file, sender(file), nullptr));
+        QScopedPointer<QNetworkReply> second(coalescer.get(otherFile, sender(otherFile), nullptr));
+        QScopedPointer<QNetworkReply> third(coalescer.get(otherAccount, sender(otherAccount), nullptr));
+        QCOMPARE(mSent.count(), 3);
+    }
+
+    void testLateRequest()
+    {
+        RequestCoalescer coalescer;
+        const QNetworkRequest file = request(QStringLiteral("https://graph.example/items/1"));
+
+        QScopedPointer<QNetworkReply> first(coalescer.get(file, sender(file), nullptr));
+        // The response has started arriving, so the data are already gone
+        connect(first.data(), &QNetworkReply::metaDataChanged, this, [&]() {
+            QScopedPointer<QNetworkReply> late(coalescer.get(file, sender(file), nullptr));
+            QCOMPARE(mSent.count(), 2);
+        });
+        mSent.first()->respond(200, "{}");
+        QCOMPARE(mSent.count(), 2);
+    }
+
+    void testAbort()
+    {
+        RequestCoalescer coalescer;
+        const QNetworkRequest file = request(QStringLiteral("https://graph.example/items/1"));
+
+        QScopedPointer<QNetworkReply> first(coalescer.get(file, sender(file), nullptr));
+        QScopedPointer<QNetworkReply> second(coalescer.get(file, sender(file), nullptr));
+
+        // Aborting one requester does not affect the other one
+        first->abort();
+        QVERIFY(first->isFinished());
+        QCOMPARE(first->error(), QNetworkReply::OperationCanceledError);
+        QVERIFY(!mSent.first()->aborted);
+
+        second->abort();
+        QVERIFY(mSent.first()->aborted);
+        QCOMPARE(coalescer.inFlightCount(), 0);
+    }
+
+    void testRequesterGoesAway()
+    {
+        RequestCoalescer coalescer;
+        const QNetworkRequest file = request(QStringLiteral("https://graph.example/items/1"));
+
+        // Like a job with its access manager
+        QObject *firstOwner = new QObject;
+        QObject secondOwner;
+        const auto sendOwned = [this, file, firstOwner]() {
+            FakeReply *reply = new FakeReply(file);
+            reply->setParent(firstOwner);
+            mSent << reply;
+            return reply;
+        };
+        coalescer.get(file, sendOwned, firstOwner);
+        QNetworkReply *second = coalescer.get(file, sender(file), &secondOwner);
+        QCOMPARE(mSent.count(), 1);
+
+        // The shared request must not go away with whoever sent it
+        delete firstOwner;
+        QVERIFY(!mSent.first().isNull());
+        QVERIFY(!mSent.first()->aborted);
+
+        mSent.first()->respond(200, "{}");
+        QVERIFY(second->isFinished());
+        QCOMPARE(second->error(), QNetworkReply::NoError);
+        QCOMPARE(second->readAll(), QByteArray("{}"));
+    }
+
+    void testDuplicate()
+    {
+        RequestCoalescer coalescer;
+        const QNetworkRequest file = request(QStringLiteral("https://graph.example/items/1"));
+
+        QScopedPointer<QNetworkReply> first(coalescer.get(file, sender(file), nullptr));
+        QScopedPointer<QNetworkReply> second(coalescer.get(file, sender(file), nullptr));
+        QScopedPointer<QNetworkReply> third(coalescer.get(file, sender(file), nullptr));
+        mSent.first()->respond(500, "{}");
+
+        // The server has seen one request, so it counts once
+        int originals = 0;
+        for (QNetworkReply *reply : { first.data(), second.data(), third.data() }) {
+            if (!RequestCoalescer::isDuplicate(reply)) {
+                ++originals;
+            }
+        }
+        QCOMPARE(originals, 1);
+        QVERIFY(!RequestCoalescer::isDuplicate(mSent.first()));
+    }
+
+    void testDisabled()
+    {
+        RequestCoalescer coalescer;
+        coalescer.setEnabled(false);
+        const QNetworkRequest file = request(QStringLiteral("https://graph.example/items/1"));
+
+        QScopedPointer<QNetworkReply> first(coalescer.get(file, sender(file), nullptr));
+        QScopedPointer<QNetworkReply> second(coalescer.get(file, sender(file), nullptr));
+        QCOMPARE(mSent.count(), 2);
+        QCOMPARE(first.data(), static_cast<QNetworkReply*>(mSent.at(0).data()));
+    }
+};
+
+QTEST_GUILESS_MAIN(RequestCoalescerTest)
+
+#include "requestcoalescertest.moc"
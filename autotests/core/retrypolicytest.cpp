@@ -0,0 +1,132 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QTest>
+
+#include "retrypolicy.h"
+
+using namespace KMGraph2;
+
+class RetryPolicyTest: public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testDefaults()
+    {
+        RetryPolicy policy;
+        QCOMPARE(policy.maxAttempts(), 4);
+        QVERIFY(policy.canRetry(1));
+        QVERIFY(policy.canRetry(3));
+        QVERIFY(!policy.canRetry(4));
+        QVERIFY(policy.retryNetworkErrors());
+        QVERIFY(!policy.retryNonIdempotent());
+
+        QVERIFY(!RetryPolicy::noRetry().canRetry(1));
+    }
+
+    void testIsRetryable_data()
+    {
+        QTest::addColumn<int>("statusCode");
+        QTest::addColumn<int>("error");
+        QTest::addColumn<bool>("expected");
+
+        QTest::newRow("ok") << 200 << int(QNetworkReply::NoError) << false;
+        QTest::newRow("not found") << 404 << int(QNetworkReply::ContentNotFoundError) << false;
+        QTest::newRow("too many requests") << 429 << int(QNetworkReply::UnknownContentError) << true;
+        QTest::newRow("internal error") << 500 << int(QNetworkReply::InternalServerError) << true;
+        QTest::newRow("bad gateway") << 502 << int(QNetworkReply::UnknownServerError) << true;
+        QTest::newRow("service unavailable") << 503 << int(QNetworkReply::ServiceUnavailableError) << true;
+        QTest::newRow("gateway timeout") << 504 << int(QNetworkReply::UnknownServerError) << true;
+        QTest::newRow("connection refused") << 0 << int(QNetworkReply::ConnectionRefusedError) << true;
+        QTest::newRow("connection closed") << 0 << int(QNetworkReply::RemoteHostClosedError) << true;
+        QTest::newRow("no status, no error") << 0 << int(QNetworkReply::NoError) << false;
+        QTest::newRow("cancelled") << 0 << int(QNetworkReply::OperationCanceledError) << false;
+        QTest::newRow("ssl") << 0 << int(QNetworkReply::SslHandshakeFailedError) << false;
+    }
+
+    void testIsRetryable()
+    {
+        QFETCH(int, statusCode);
+        QFETCH(int, error);
+        QFETCH(bool, expected);
+
+        RetryPolicy policy;
+        QCOMPARE(policy.isRetryable(statusCode, QNetworkReply::NetworkError(error)), expected);
+    }
+
+    void testCustomStatusCodes()
+    {
+        RetryPolicy policy;
+        policy.setRetryableStatusCodes({ 503 });
+        policy.setRetryNetworkErrors(false);
+
+        QVERIFY(policy.isRetryable(503, QNetworkReply::ServiceUnavailableError));
+        QVERIFY(!policy.isRetryable(500, QNetworkReply::InternalServerError));
+        QVERIFY(!policy.isRetryable(0, QNetworkReply::ConnectionRefusedError));
+    }
+
+    void testBackoff()
+    {
+        RetryPolicy policy;
+        policy.setJitter(0.0);
+        policy.setInitialDelay(100);
+        policy.setBackoffMultiplier(3.0);
+        policy.setMaxDelay(1000);
+
+        QCOMPARE(policy.delay(1), 100);
+        QCOMPARE(policy.delay(2), 300);
+        QCOMPARE(policy.delay(3), 900);
+        QCOMPARE(policy.delay(4), 1000);
+        QCOMPARE(policy.delay(20), 1000);
+    }
+
+    void testJitter()
+    {
+        RetryPolicy policy;
+        policy.setInitialDelay(1000);
+        policy.setJitter(0.5);
+
+        bool varies = false;
+        const int first = policy.delay(1);
+        for (int i = 0; i < 100; ++i) {
+            const int delay = policy.delay(1);
+            QVERIFY(delay >= 500);
+            QVERIFY(delay <= 1000);
+            varies |= (delay != first);
+        }
+        QVERIFY(varies);
+    }
+
+    void testImplicitSharing()
+    {
+        RetryPolicy policy;
+        RetryPolicy copy = policy;
+        copy.setMaxAttempts(10);
+
+        QCOMPARE(policy.maxAttempts(), 4);
+        QCOMPARE(copy.maxAttempts(), 10);
+    }
+};
+
+QTEST_GUILESS_MAIN(RetryPolicyTest)
+
+#include "retrypolicytest.moc"
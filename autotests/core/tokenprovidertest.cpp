@@ -0,0 +1,133 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QSignalSpy>
+#include <QTest>
+
+#include "account.h"
+#include "tokenprovider.h"
+
+using namespace KMGraph2;
+
+namespace {
+
+// Finishes refreshes only when the test says so
+class FakeTokenProvider : public TokenProvider
+{
+  public:
+    void finish(const QString &accessToken, bool success = true)
+    {
+        mPending->setAccessToken(accessToken);
+        finishRefresh(mPending, success);
+    }
+
+    int refreshCount = 0;
+
+  protected:
+    void doRefreshTokens(const AccountPtr &account) override
+    {
+        ++refreshCount;
+        mPending = account;
+    }
+
+  private:
+    AccountPtr mPending;
+};
+
+}
+
+class TokenProviderTest: public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase()
+    {
+        qRegisterMetaType<KMGraph2::AccountPtr>();
+    }
+
+    void testSingleFlight()
+    {
+        FakeTokenProvider provider;
+        QSignalSpy spy(&provider, &TokenProvider::tokensRefreshed);
+
+        // Different instances of the same account, as held by separate jobs
+        const AccountPtr first(new Account(QStringLiteral("user@example.com"), QStringLiteral("old")));
+        const AccountPtr second(new Account(*first));
+        const AccountPtr other(new Account(QStringLiteral("other@example.com"), QStringLiteral("old")));
+
+        provider.refreshTokens(first);
+        provider.refreshTokens(second);
+        provider.refreshTokens(first);
+        QCOMPARE(provider.refreshCount, 1);
+        QVERIFY(provider.isRefreshing(second));
+        QVERIFY(!provider.isRefreshing(other));
+
+        provider.finish(QStringLiteral("new"));
+        QCOMPARE(spy.count(), 1);
+        QVERIFY(spy.at(0).at(1).toBool());
+        QVERIFY(!provider.isRefreshing(first));
+        QCOMPARE(first->accessToken(), QStringLiteral("new"));
+        QCOMPARE(second->accessToken(), QStringLiteral("new"));
+        QCOMPARE(other->accessToken(), QStringLiteral("old"));
+
+        // A finished refresh does not block the next one
+        provider.refreshTokens(second);
+        QCOMPARE(provider.refreshCount, 2);
+    }
+
+    void testFailure()
+    {
+        FakeTokenProvider provider;
+        QSignalSpy spy(&provider, &TokenProvider::tokensRefreshed);
+
+        const AccountPtr first(new Account(QStringLiteral("user@example.com"), QStringLiteral("old")));
+        const AccountPtr second(new Account(*first));
+
+        provider.refreshTokens(first);
+        provider.refreshTokens(second);
+        provider.finish(QStringLiteral("garbage"), false);
+
+        QCOMPARE(spy.count(), 1);
+        QVERIFY(!spy.at(0).at(1).toBool());
+        QCOMPARE(second->accessToken(), QStringLiteral("old"));
+    }
+
+    void testAccountProvider()
+    {
+        Account account(QStringLiteral("user@example.com"));
+        QVERIFY(!account.tokenProvider());
+
+        {
+            FakeTokenProvider provider;
+            account.setTokenProvider(&provider);
+            QCOMPARE(account.tokenProvider(), &provider);
+            QCOMPARE(Account(account).tokenProvider(), &provider);
+        }
+
+        // The account does not keep a dangling pointer
+        QVERIFY(!account.tokenProvider());
+    }
+};
+
+QTEST_GUILESS_MAIN(TokenProviderTest)
+
+#include "tokenprovidertest.moc"
@@ -0,0 +1,139 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QTest>
+#include <QDateTime>
+
+#include "utils.h"
+
+class UtilsTest: public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testRfc3339DateFromString_data()
+    {
+        QTest::addColumn<QString>("string");
+        QTest::addColumn<QDateTime>("expected");
+
+        QTest::newRow("utc")
+            << QStringLiteral("2013-06-14T09:20:40Z")
+            << QDateTime(QDate(2013, 6, 14), QTime(9, 20, 40), Qt::UTC);
+        QTest::newRow("msecs")
+            << QStringLiteral("2013-06-14T09:20:40.123Z")
+            << QDateTime(QDate(2013, 6, 14), QTime(9, 20, 40, 123), Qt::UTC);
+        QTest::newRow("short fraction")
+            << QStringLiteral("2013-06-14T09:20:40.5Z")
+            << QDateTime(QDate(2013, 6, 14), QTime(9, 20, 40, 500), Qt::UTC);
+        QTest::newRow("long fraction")
+            << QStringLiteral("2013-06-14T09:20:40.123456789Z")
+            << QDateTime(QDate(2013, 6, 14), QTime(9, 20, 40, 123), Qt::UTC);
+        QTest::newRow("positive offset")
+            << QStringLiteral("2013-06-14T11:20:40+02:00")
+            << QDateTime(QDate(2013, 6, 14), QTime(9, 20, 40), Qt::UTC);
+        QTest::newRow("negative offset")
+            << QStringLiteral("2013-06-14T04:50:40.000-04:30")
+            << QDateTime(QDate(2013, 6, 14), QTime(9, 20, 40), Qt::UTC);
+        QTest::newRow("offset crossing day")
+            << QStringLiteral("2000-01-01T00:30:00+01:00")
+            << QDateTime(QDate(1999, 12, 31), QTime(23, 30, 0), Qt::UTC);
+        QTest::newRow("leap day")
+            << QStringLiteral("2016-02-29T23:59:59Z")
+            << QDateTime(QDate(2016, 2, 29), QTime(23, 59, 59), Qt::UTC);
+        QTest::newRow("before epoch")
+            << QStringLiteral("1969-07-20T20:17:40Z")
+            << QDateTime(QDate(1969, 7, 20), QTime(20, 17, 40), Qt::UTC);
+        QTest::newRow("lowercase")
+            << QStringLiteral("2013-06-14t09:20:40z")
+            << QDateTime(QDate(2013, 6, 14), QTime(9, 20, 40), Qt::UTC);
+        QTest::newRow("empty")
+            << QString()
+            << QDateTime();
+        QTest::newRow("invalid day")
+            << QStringLiteral("2015-02-29T10:00:00Z")
+            << QDateTime();
+        QTest::newRow("invalid hour")
+            << QStringLiteral("2015-02-01T25:00:00Z")
+            << QDateTime();
+        QTest::newRow("garbage")
+            << QStringLiteral("yesterday at noon")
+            << QDateTime();
+    }
+
+    void testRfc3339DateFromString()
+    {
+        QFETCH(QString, string);
+        QFETCH(QDateTime, expected);
+
+        const QDateTime dt = Utils::rfc3339DateFromString(string);
+        QCOMPARE(dt.isValid(), expected.isValid());
+        if (expected.isValid()) {
+            QCOMPARE(dt.toMSecsSinceEpoch(), expected.toMSecsSinceEpoch());
+            // Must be the same instant QDateTime itself would give us
+            QCOMPARE(dt, QDateTime::fromString(string.toUpper(), Qt::ISODate));
+        }
+    }
+
+    void testRfc3339RoundTrip()
+    {
+        const QDateTime dt(QDate(2013, 6, 14), QTime(9, 20, 40), Qt::UTC);
+        QCOMPARE(Utils::rfc3339DateFromString(Utils::rfc3339DateToString(dt)), dt);
+    }
+
+    void benchmarkRfc3339DateFromString_data()
+    {
+        QTest::addColumn<bool>("useQt");
+
+        QTest::newRow("QDateTime::fromString") << true;
+        QTest::newRow("Utils::rfc3339DateFromString") << false;
+    }
+
+    void benchmarkRfc3339DateFromString()
+    {
+        QFETCH(bool, useQt);
+
+        QStringList strings;
+        for (int i = 0; i < 1000; ++i) {
+            strings << QDateTime::fromMSecsSinceEpoch(1371201640000LL + i * 3600123LL, Qt::UTC)
+                           .toString(QStringLiteral("yyyy-MM-ddThh:mm:ss.zzzZ"));
+        }
+
+        qint64 sum = 0;
+        if (useQt) {
+            QBENCHMARK {
+                for (const QString &string : qAsConst(strings)) {
+                    sum += QDateTime::fromString(string, Qt::ISODate).toMSecsSinceEpoch();
+                }
+            }
+        } else {
+            QBENCHMARK {
+                for (const QString &string : qAsConst(strings)) {
+                    sum += Utils::rfc3339DateFromString(string).toMSecsSinceEpoch();
+                }
+            }
+        }
+        QVERIFY(sum != 0);
+    }
+};
+
+QTEST_GUILESS_MAIN(UtilsTest)
+
+#include "utilstest.moc"
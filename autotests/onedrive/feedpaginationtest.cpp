@@ -0,0 +1,342 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QObject>
+#include <QSignalSpy>
+#include <QTest>
+#include <QUrlQuery>
+
+#include "account.h"
+#include "change.h"
+#include "changefetchjob.h"
+#include "feedfetchjob.h"
+#include "object.h"
+#include "permission.h"
+#include "permissionfetchjob.h"
+#include "revision.h"
+#include "revisionfetchjob.h"
+
+#include "../core/fakenetwork.h"
+
+using namespace KMGraph2;
+using namespace KMGraph2::OneDrive;
+
+namespace {
+
+// Lists a feed of objects whose etags are "0", "1", "2" and so on
+class FeedJob : public FeedFetchJob
+{
+  public:
+    explicit FeedJob(const AccountPtr &account, bool wholePages = false):
+        FeedFetchJob(account)
+    {
+        setWholePages(wholePages);
+    }
+
+  protected:
+    void start() override
+    {
+        enqueueFeedRequest(QUrl(QStringLiteral("https://graph.example/feed")));
+    }
+
+    ObjectsList handleFeedReply(const QNetworkReply *reply, const QByteArray &rawData,
+                                FeedData &feedData) override
+    {
+        Q_UNUSED(reply)
+
+        const QJsonObject page = QJsonDocument::fromJson(rawData).object();
+        feedData.nextPageUrl = QUrl(page.value(QStringLiteral("nextLink")).toString());
+        ObjectsList items;
+        for (const QJsonValue &etag : page.value(QStringLiteral("etags")).toArray()) {
+            ObjectPtr object(new Object);
+            object->setEtag(etag.toString());
+            items << object;
+        }
+        return items;
+    }
+};
+
+int pageSize(const QUrl &url)
+{
+    return QUrlQuery(url).queryItemValue(QStringLiteral("maxResults")).toInt();
+}
+
+// Serves pages of a feed of @p total objects, starting at the offset in the
+// page token. Like Microsoft Graph, next links repeat the page size of the
+// request. A server that ignores the page size always sends @p defaultSize
+// objects.
+FakeNetwork::Responder feedServer(int total, int defaultSize, bool ignorePageSize = false)
+{
+    return [=](FakeReply *reply) {
+        const QUrlQuery query(reply->url());
+        const int offset = query.queryItemValue(QStringLiteral("pageToken")).toInt();
+        const int requested = pageSize(reply->url());
+        const int size = requested > 0 && !ignorePageSize ? requested : defaultSize;
+
+        QJsonArray etags;
+        for (int i = offset; i < qMin(offset + size, total); ++i) {
+            etags.append(QString::number(i));
+        }
+        QJsonObject page;
+        page.insert(QStringLiteral("etags"), etags);
+        if (offset + size < total) {
+            QUrl next(QStringLiteral("https://graph.example/feed"));
+            QUrlQuery nextQuery;
+            nextQuery.addQueryItem(QStringLiteral("pageToken"), QString::number(offset + size));
+            if (requested > 0) {
+                nextQuery.addQueryItem(QStringLiteral("maxResults"), QString::number(requested));
+            }
+            next.setQuery(nextQuery);
+            page.insert(QStringLiteral("nextLink"), next.toString());
+        }
+        reply->respond(200, QJsonDocument(page).toJson());
+    };
+}
+
+QStringList etags(const ObjectsList &objects)
+{
+    QStringList result;
+    for (const ObjectPtr &object : objects) {
+        result << object->etag();
+    }
+    return result;
+}
+
+QStringList range(int first, int last)
+{
+    QStringList result;
+    for (int i = first; i <= last; ++i) {
+        result << QString::number(i);
+    }
+    return result;
+}
+
+QList<int> pageSizes(const QList<QUrl> &urls)
+{
+    QList<int> result;
+    for (const QUrl &url : urls) {
+        result << pageSize(url);
+    }
+    return result;
+}
+
+// Every test gets its own account, and so its own circuit breaker
+AccountPtr testAccount()
+{
+    return AccountPtr(new Account(QString::fromLatin1(QTest::currentTestFunction()) + QLatin1Char('/')
+                                      + QString::fromLatin1(QTest::currentDataTag()),
+                                  QStringLiteral("token")));
+}
+
+}
+
+class FeedPaginationTest: public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testPermissionFeed()
+    {
+        const QByteArray json = "{\"kind\": \"drive#permissionList\","
+                                " \"nextLink\": \"https://graph.example/files/1/permissions?pageToken=2\","
+                                " \"items\": [{\"kind\": \"drive#permission\", \"id\": \"p1\", \"role\": \"reader\"},"
+                                "             {\"kind\": \"drive#permission\", \"id\": \"p2\", \"role\": \"writer\"}]}";
+
+        FeedData feedData;
+        const PermissionsList permissions = Permission::fromJSONFeed(json, feedData);
+        QCOMPARE(permissions.count(), 2);
+        QCOMPARE(feedData.nextPageUrl, QUrl(QStringLiteral("https://graph.example/files/1/permissions?pageToken=2")));
+
+        // The last page has no link
+        FeedData lastPage;
+        QCOMPARE(Permission::fromJSONFeed("{\"kind\": \"drive#permissionList\", \"items\": []}", lastPage).count(), 0);
+        QVERIFY(!lastPage.nextPageUrl.isValid());
+    }
+
+    void testRevisionFeed()
+    {
+        const QByteArray json = "{\"kind\": \"drive#revisionList\","
+                                " \"nextLink\": \"https://graph.example/files/1/revisions?pageToken=2\","
+                                " \"items\": [{\"kind\": \"drive#revision\", \"id\": \"r1\"}]}";
+
+        FeedData feedData;
+        const RevisionsList revisions = Revision::fromJSONFeed(json, feedData);
+        QCOMPARE(revisions.count(), 1);
+        QCOMPARE(feedData.nextPageUrl, QUrl(QStringLiteral("https://graph.example/files/1/revisions?pageToken=2")));
+    }
+
+    void testJobProperties()
+    {
+        const AccountPtr account(new Account(QStringLiteral("test"), QStringLiteral("token")));
+
+        PermissionFetchJob permissionJob(QStringLiteral("file"), account);
+        QCOMPARE(permissionJob.pageSize(), 0);
+        QCOMPARE(permissionJob.maxItems(), 0);
+        QCOMPARE(permissionJob.fetchedItemsCount(), 0);
+        QVERIFY(permissionJob.setProperty("pageSize", 50));
+        QVERIFY(permissionJob.setProperty("maxItems", 120));
+        QCOMPARE(permissionJob.pageSize(), 50);
+        QCOMPARE(permissionJob.maxItems(), 120);
+
+        RevisionFetchJob revisionJob(QStringLiteral("file"), account);
+        revisionJob.setPageSize(10);
+        QCOMPARE(revisionJob.property("pageSize").toInt(), 10);
+    }
+
+    void testWholeFeed()
+    {
+        FakeNetwork network;
+        network.setResponder(feedServer(7, 3));
+
+        FeedJob job(testAccount());
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(etags(job.items()), range(0, 6));
+        QCOMPARE(network.count(), 3);
+    }
+
+    void testMaxItems()
+    {
+        FakeNetwork network;
+        network.setResponder(feedServer(20, 3));
+
+        FeedJob job(testAccount());
+        job.setPageSize(3);
+        job.setMaxItems(7);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(etags(job.items()), range(0, 6));
+        QCOMPARE(job.fetchedItemsCount(), 7);
+        // The next link of the last page is shrunk to what is still missing
+        QCOMPARE(pageSizes(network.urls()), QList<int>({ 3, 3, 1 }));
+    }
+
+    void testMaxItemsPageSize()
+    {
+        FakeNetwork network;
+        network.setResponder(feedServer(20, 10));
+
+        // Without a page size, the limit is used as one
+        FeedJob job(testAccount());
+        job.setMaxItems(4);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(etags(job.items()), range(0, 3));
+        QCOMPARE(pageSizes(network.urls()), QList<int>({ 4 }));
+    }
+
+    void testMaxItemsPageIgnored_data()
+    {
+        QTest::addColumn<bool>("wholePages");
+        QTest::addColumn<QStringList>("expected");
+
+        QTest::newRow("items dropped") << false << range(0, 3);
+        QTest::newRow("whole pages") << true << range(0, 5);
+    }
+
+    void testMaxItemsPageIgnored()
+    {
+        QFETCH(bool, wholePages);
+        QFETCH(QStringList, expected);
+
+        FakeNetwork network;
+        network.setResponder(feedServer(20, 3, true));
+
+        FeedJob job(testAccount(), wholePages);
+        job.setPageSize(3);
+        job.setMaxItems(4);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(etags(job.items()), expected);
+        QCOMPARE(pageSizes(network.urls()), QList<int>({ 3, 1 }));
+    }
+
+    void testStopCondition_data()
+    {
+        QTest::addColumn<bool>("wholePages");
+        QTest::addColumn<QStringList>("expected");
+
+        // The matching item is kept, the rest of the page depends on the job
+        QTest::newRow("items dropped") << false << range(0, 4);
+        QTest::newRow("whole pages") << true << range(0, 5);
+    }
+
+    void testStopCondition()
+    {
+        QFETCH(bool, wholePages);
+        QFETCH(QStringList, expected);
+
+        FakeNetwork network;
+        network.setResponder(feedServer(20, 3));
+
+        FeedJob job(testAccount(), wholePages);
+        job.setPageSize(3);
+        job.setStopCondition([](const ObjectPtr &object) {
+            return object->etag() == QLatin1String("4");
+        });
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(etags(job.items()), expected);
+        QCOMPARE(network.count(), 2);
+    }
+
+    void testChangeFeedWholePages()
+    {
+        FakeNetwork network;
+        network.setResponder([](FakeReply *reply) {
+            // Ignores the page size
+            reply->respond(200, "{\"kind\": \"drive#changeList\","
+                                " \"nextLink\": \"https://graph.example/changes?pageToken=2\","
+                                " \"items\": [{\"kind\": \"drive#change\", \"id\": \"11\", \"fileId\": \"a\"},"
+                                "             {\"kind\": \"drive#change\", \"id\": \"12\", \"fileId\": \"b\"},"
+                                "             {\"kind\": \"drive#change\", \"id\": \"13\", \"fileId\": \"c\"}]}");
+        });
+
+        ChangeFetchJob job(testAccount());
+        job.setStartChangeId(11);
+        job.setMaxItems(2);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        // Resuming from change 14 must not skip change 13
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(network.count(), 1);
+        QCOMPARE(pageSize(network.urls().at(0)), 2);
+        const ObjectsList items = job.items();
+        QCOMPARE(items.count(), 3);
+        QCOMPARE(items.last().dynamicCast<Change>()->id(), 13LL);
+    }
+};
+
+QTEST_GUILESS_MAIN(FeedPaginationTest)
+
+#include "feedpaginationtest.moc"
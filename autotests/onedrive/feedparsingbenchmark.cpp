@@ -0,0 +1,422 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QTest>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "file.h"
+#include "user.h"
+#include "userregistry.h"
+#include "objectpool.h"
+#include "stringinterner.h"
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include <cstdlib>
+#include <new>
+
+// Count all allocations done through the global operator new, including
+// those made by the library, to see how many of them the pool saves. Every
+// replaceable form is replaced, so that nothing is freed by a different
+// allocator than the one it came from.
+static QBasicAtomicInteger<quint64> s_newCalls = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+static void *countedMalloc(std::size_t size) noexcept
+{
+    s_newCalls.fetchAndAddRelaxed(1);
+    return std::malloc(size ? size : 1);
+}
+
+void *operator new(std::size_t size)
+{
+    void *ptr = countedMalloc(size);
+    if (!ptr) {
+        qBadAlloc();
+    }
+    return ptr;
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return countedMalloc(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return countedMalloc(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+#if defined(__cpp_sized_deallocation)
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+#endif
+
+#if defined(__cpp_aligned_new)
+static void *countedAlignedMalloc(std::size_t size, std::align_val_t alignment) noexcept
+{
+    s_newCalls.fetchAndAddRelaxed(1);
+#if defined(Q_OS_WIN)
+    return _aligned_malloc(size ? size : 1, std::size_t(alignment));
+#else
+    void *ptr = nullptr;
+    if (posix_memalign(&ptr, qMax(std::size_t(alignment), sizeof(void *)), size ? size : 1) != 0) {
+        return nullptr;
+    }
+    return ptr;
+#endif
+}
+
+static void alignedFree(void *ptr) noexcept
+{
+#if defined(Q_OS_WIN)
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    void *ptr = countedAlignedMalloc(size, alignment);
+    if (!ptr) {
+        qBadAlloc();
+    }
+    return ptr;
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return countedAlignedMalloc(size, alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return countedAlignedMalloc(size, alignment);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept
+{
+    alignedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept
+{
+    alignedFree(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    alignedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    alignedFree(ptr);
+}
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept
+{
+    alignedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept
+{
+    alignedFree(ptr);
+}
+#endif
+
+using namespace KMGraph2;
+using namespace KMGraph2::OneDrive;
+
+namespace {
+
+// A synthetic feed that resembles listing of a large organization drive:
+// many files, but only few distinct MIME types, owners and folders.
+QByteArray generateFeed(int files)
+{
+    static const char *mimeTypes[] = {
+        "text/plain", "image/png", "image/jpeg", "application/pdf",
+        "application/vnd.google-apps.document", "application/vnd.google-apps.spreadsheet",
+        "application/vnd.google-apps.folder", "application/zip"
+    };
+
+    QJsonArray items;
+    for (int i = 0; i < files; ++i) {
+        const QString user = QStringLiteral("User Name %1").arg(i % 200);
+        const QString parent = QStringLiteral("0BxParentFolderId%1").arg(i % 500);
+
+        QJsonObject owner;
+        owner[QStringLiteral("kind")] = QStringLiteral("drive#user");
+        owner[QStringLiteral("displayName")] = user;
+        owner[QStringLiteral("permissionId")] = QStringLiteral("%1").arg(1000000 + i % 200);
+        owner[QStringLiteral("picture")] = QJsonObject({ { QStringLiteral("url"), QStringLiteral("https://example.com/photo/%1.jpg").arg(i % 200) } });
+
+        QJsonObject parentRef;
+        parentRef[QStringLiteral("kind")] = QStringLiteral("drive#parentReference");
+        parentRef[QStringLiteral("id")] = parent;
+        parentRef[QStringLiteral("parentLink")] = QStringLiteral("https://www.googleapis.com/drive/v2/files/%1").arg(parent);
+
+        QJsonObject file;
+        file[QStringLiteral("kind")] = QStringLiteral("drive#file");
+        file[QStringLiteral("id")] = QStringLiteral("0BxFileId%1").arg(i);
+        file[QStringLiteral("etag")] = QStringLiteral("\"etag%1\"").arg(i);
+        file[QStringLiteral("title")] = QStringLiteral("Document %1.txt").arg(i);
+        file[QStringLiteral("mimeType")] = QLatin1String(mimeTypes[i % 8]);
+        file[QStringLiteral("createdDate")] = QStringLiteral("2019-05-12T10:15:%1.000Z").arg(i % 60, 2, 10, QLatin1Char('0'));
+        file[QStringLiteral("modifiedDate")] = QStringLiteral("2020-02-03T08:45:%1.123Z").arg(i % 60, 2, 10, QLatin1Char('0'));
+        file[QStringLiteral("fileSize")] = QString::number(1024 + i);
+        file[QStringLiteral("md5Checksum")] = QStringLiteral("%1").arg(i, 32, 16, QLatin1Char('0'));
+        file[QStringLiteral("ownerNames")] = QJsonArray({ user });
+        file[QStringLiteral("lastModifyingUserName")] = user;
+        file[QStringLiteral("owners")] = QJsonArray({ owner });
+        file[QStringLiteral("lastModifyingUser")] = owner;
+        file[QStringLiteral("parents")] = QJsonArray({ parentRef });
+        file[QStringLiteral("labels")] = QJsonObject({ { QStringLiteral("starred"), i % 7 == 0 } });
+        items.append(file);
+    }
+
+    QJsonObject feed;
+    feed[QStringLiteral("kind")] = QStringLiteral("drive#fileList");
+    feed[QStringLiteral("items")] = items;
+    return QJsonDocument(feed).toJson(QJsonDocument::Compact);
+}
+
+qint64 heapUsage()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return qint64(mallinfo2().uordblks);
+#else
+    return -1;
+#endif
+}
+
+}
+
+class FeedParsingBenchmark: public QObject
+{
+    Q_OBJECT
+private:
+    QByteArray mFeed;
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        mFeed = generateFeed(20000);
+    }
+
+    void cleanupTestCase()
+    {
+        StringInterner::global()->setEnabled(true);
+    }
+
+    void testSharedValues()
+    {
+        StringInterner::global()->setEnabled(true);
+
+        FeedData feedData;
+        const FilesList files = File::fromJSONFeed(mFeed, feedData);
+        QCOMPARE(files.size(), 20000);
+
+        // Files 0 and 8 have the same MIME type, owner and parent
+        QCOMPARE(files[0]->mimeType(), files[8]->mimeType());
+        QCOMPARE(files[0]->mimeType().constData(), files[8]->mimeType().constData());
+        QCOMPARE(files[0]->lastModifyingUserName().constData(), files[1000]->lastModifyingUserName().constData());
+        QCOMPARE(files[0]->parents().first()->id().constData(), files[1000]->parents().first()->id().constData());
+
+        const StringInterner::Stats stats = StringInterner::global()->stats();
+        QVERIFY(stats.hits > 0);
+        QVERIFY(stats.hits <= stats.lookups);
+    }
+
+    void measureSharedValues()
+    {
+        StringInterner::global()->setEnabled(true);
+        StringInterner::global()->clear();
+        const StringInterner::Stats before = StringInterner::global()->stats();
+
+        FeedData feedData;
+        const FilesList files = File::fromJSONFeed(mFeed, feedData);
+        QCOMPARE(files.size(), 20000);
+
+        // Values that did not need a string of their own
+        const StringInterner::Stats after = StringInterner::global()->stats();
+        QTest::setBenchmarkResult(qreal(after.hits - before.hits), QTest::Events);
+    }
+
+    void testSharedUsers()
+    {
+        UserRegistry registry;
+        FilesList files;
+        {
+            const UserRegistry::Scope scope(&registry);
+            FeedData feedData;
+            files = File::fromJSONFeed(mFeed, feedData);
+        }
+
+        // 200 distinct users, each referenced as owner and last modifying user
+        QCOMPARE(registry.size(), 200);
+        QCOMPARE(files[0]->owners().first().data(), files[1000]->owners().first().data());
+        QCOMPARE(files[0]->owners().first().data(), files[0]->lastModifyingUser().data());
+
+        // Without a scope every file gets its own users
+        FeedData feedData;
+        const FilesList unshared = File::fromJSONFeed(mFeed, feedData);
+        QVERIFY(unshared[0]->owners().first().data() != unshared[1000]->owners().first().data());
+    }
+
+    void measureMemory_data()
+    {
+        QTest::addColumn<bool>("interning");
+
+        QTest::newRow("plain") << false;
+        QTest::newRow("interned") << true;
+    }
+
+    void measureMemory()
+    {
+        QFETCH(bool, interning);
+
+        if (heapUsage() < 0) {
+            QSKIP("Heap usage can't be measured on this platform");
+        }
+
+        StringInterner::global()->setEnabled(interning);
+        StringInterner::global()->clear();
+
+        const qint64 before = heapUsage();
+        FeedData feedData;
+        const FilesList files = File::fromJSONFeed(mFeed, feedData);
+        const qint64 after = heapUsage();
+        QCOMPARE(files.size(), 20000);
+
+        // Heap retained by the parsed files
+        QTest::setBenchmarkResult(qreal(after - before), QTest::BytesAllocated);
+    }
+
+    // Both rows are counted in the same run, so the pool is in use for each.
+    // The onedrive-feedparsingbenchmark-nopool test runs this again with
+    // KMGRAPH_NO_OBJECT_POOL set, for the operator new calls without the pool.
+    void measureAllocations_data()
+    {
+        QTest::addColumn<bool>("pooled");
+
+        QTest::newRow("operator new calls") << false;
+        QTest::newRow("pooled allocations") << true;
+    }
+
+    void measureAllocations()
+    {
+        QFETCH(bool, pooled);
+
+        StringInterner::global()->setEnabled(true);
+
+        const QByteArray feed = generateFeed(10000);
+        const ObjectPool::Stats poolBefore = ObjectPool::stats();
+        const quint64 newCallsBefore = s_newCalls.load();
+
+        FeedData feedData;
+        const FilesList files = File::fromJSONFeed(feed, feedData);
+        QCOMPARE(files.size(), 10000);
+
+        const quint64 newCalls = s_newCalls.load() - newCallsBefore;
+        const quint64 poolAllocations = ObjectPool::stats().allocations - poolBefore.allocations;
+        if (ObjectPool::isEnabled()) {
+            QVERIFY(poolAllocations > 0);
+        }
+
+        // Allocations per parsed file
+        const quint64 count = pooled ? poolAllocations : newCalls;
+        QTest::setBenchmarkResult(qreal(count) / files.size(), QTest::Events);
+    }
+
+    void benchmarkParse_data()
+    {
+        measureMemory_data();
+    }
+
+    void benchmarkParse()
+    {
+        QFETCH(bool, interning);
+
+        StringInterner::global()->setEnabled(interning);
+        QBENCHMARK {
+            FeedData feedData;
+            File::fromJSONFeed(mFeed, feedData);
+        }
+    }
+
+    void benchmarkParse10k()
+    {
+        StringInterner::global()->setEnabled(true);
+
+        const QByteArray feed = generateFeed(10000);
+        QBENCHMARK {
+            FeedData feedData;
+            File::fromJSONFeed(feed, feedData);
+        }
+    }
+};
+
+QTEST_GUILESS_MAIN(FeedParsingBenchmark)
+
+#include "feedparsingbenchmark.moc"
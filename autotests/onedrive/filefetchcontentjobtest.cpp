@@ -0,0 +1,165 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QObject>
+#include <QSignalSpy>
+#include <QTest>
+
+#include "account.h"
+#include "file.h"
+#include "filefetchcontentjob.h"
+
+#include "../core/fakenetwork.h"
+
+using namespace KMGraph2;
+using namespace KMGraph2::OneDrive;
+
+namespace {
+
+const QByteArray Content("The quick brown fox jumps over the lazy dog");
+
+QUrl downloadUrl()
+{
+    return QUrl(QStringLiteral("https://graph.example/files/1/content"));
+}
+
+QString md5(const QByteArray &data)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex());
+}
+
+// Every test gets its own account, and so its own circuit breaker
+AccountPtr testAccount()
+{
+    return AccountPtr(new Account(QString::fromLatin1(QTest::currentTestFunction()) + QLatin1Char('/')
+                                      + QString::fromLatin1(QTest::currentDataTag()),
+                                  QStringLiteral("token")));
+}
+
+}
+
+class FileFetchContentJobTest: public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testChecksum_data()
+    {
+        QTest::addColumn<QByteArray>("received");
+        QTest::addColumn<QString>("expectedChecksum");
+        QTest::addColumn<int>("error");
+
+        QTest::newRow("intact") << Content << md5(Content) << int(KMGraph2::NoError);
+        QTest::newRow("upper case checksum") << Content << md5(Content).toUpper() << int(KMGraph2::NoError);
+        QByteArray corrupted = Content;
+        corrupted[10] = 'X';
+        QTest::newRow("corrupted") << corrupted << md5(Content) << int(KMGraph2::ChecksumMismatch);
+        QTest::newRow("truncated") << Content.left(20) << md5(Content) << int(KMGraph2::ChecksumMismatch);
+        QTest::newRow("not verified") << corrupted << QString() << int(KMGraph2::NoError);
+    }
+
+    void testChecksum()
+    {
+        QFETCH(QByteArray, received);
+        QFETCH(QString, expectedChecksum);
+        QFETCH(int, error);
+
+        FakeNetwork network;
+        network.setResponder([received](FakeReply *reply) { reply->respond(200, received); });
+
+        FileFetchContentJob job(downloadUrl(), testAccount());
+        job.setExpectedMd5Checksum(expectedChecksum);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(int(job.error()), error);
+        QCOMPARE(job.md5Checksum(), md5(received));
+        if (error == KMGraph2::NoError) {
+            QCOMPARE(job.data(), received);
+        } else {
+            QVERIFY(!job.errorString().isEmpty());
+        }
+    }
+
+    void testChecksumStreamed_data()
+    {
+        QTest::addColumn<QByteArray>("lastChunk");
+        QTest::addColumn<int>("error");
+
+        QTest::newRow("intact") << Content.mid(20) << int(KMGraph2::NoError);
+        QTest::newRow("corrupted") << QByteArray(Content.size() - 20, 'X') << int(KMGraph2::ChecksumMismatch);
+    }
+
+    void testChecksumStreamed()
+    {
+        QFETCH(QByteArray, lastChunk);
+        QFETCH(int, error);
+
+        // Replies are sent by the test
+        FakeNetwork network;
+
+        FileFetchContentJob job(downloadUrl(), testAccount());
+        job.setExpectedMd5Checksum(md5(Content));
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(network.count(), 1);
+
+        // The checksum is only decided once the whole content is there
+        FakeReply *reply = network.reply(0);
+        reply->respondHeaders(200);
+        reply->deliver(Content.left(10));
+        reply->deliver(Content.mid(10, 10));
+        QCOMPARE(spy.count(), 0);
+        reply->deliver(lastChunk);
+        QCOMPARE(spy.count(), 0);
+        reply->respond(200);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(int(job.error()), error);
+        QCOMPARE(job.md5Checksum(), md5(Content.left(20) + lastChunk));
+    }
+
+    void testChecksumFromFile()
+    {
+        QVariantMap map;
+        map[QStringLiteral("kind")] = QStringLiteral("drive#file");
+        map[QStringLiteral("id")] = QStringLiteral("1");
+        map[QStringLiteral("downloadUrl")] = downloadUrl();
+        map[QStringLiteral("md5Checksum")] = md5(Content);
+        const FilePtr file = File::fromJSON(QJsonDocument::fromVariant(map).toJson());
+
+        FakeNetwork network;
+        network.setResponder([](FakeReply *reply) { reply->respond(200, Content.left(20)); });
+
+        FileFetchContentJob job(file, testAccount());
+        QCOMPARE(job.expectedMd5Checksum(), md5(Content));
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(network.urls(), QList<QUrl>() << downloadUrl());
+        QCOMPARE(job.error(), KMGraph2::ChecksumMismatch);
+    }
+};
+
+QTEST_GUILESS_MAIN(FileFetchContentJobTest)
+
+#include "filefetchcontentjobtest.moc"
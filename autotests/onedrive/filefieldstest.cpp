@@ -0,0 +1,128 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QTest>
+#include <QJsonDocument>
+
+#include "filefields_p.h"
+#include "filefetchjob.h"
+#include "file.h"
+#include "parentreference.h"
+
+using namespace KMGraph2;
+using namespace KMGraph2::OneDrive;
+
+class FileFieldsTest: public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testFromName()
+    {
+        for (int i = 0; i < FileFields::FieldCount; ++i) {
+            const FileFields::Field field = static_cast<FileFields::Field>(i);
+            const QString name = QString::fromLatin1(FileFields::name(field));
+            QCOMPARE(name.size(), FileFields::descriptor(field).nameSize);
+            QCOMPARE(FileFields::fromName(name), field);
+        }
+
+        QCOMPARE(FileFields::fromName(QString()), FileFields::Unknown);
+        QCOMPARE(FileFields::fromName(QStringLiteral("teamDriveId")), FileFields::Unknown);
+        QCOMPARE(FileFields::fromName(QStringLiteral("Title")), FileFields::Unknown);
+        QCOMPARE(FileFields::fromName(QStringLiteral("titles")), FileFields::Unknown);
+    }
+
+    void testFetchFields()
+    {
+        // Every FileFetchJob::Fields flag maps to exactly one field
+        qulonglong seen = 0;
+        for (int i = 0; i < FileFields::FieldCount; ++i) {
+            const qulonglong fetchField = FileFields::descriptor(static_cast<FileFields::Field>(i)).fetchField;
+            QVERIFY(!(seen & fetchField));
+            seen |= fetchField;
+        }
+        QCOMPARE(seen, (qulonglong(FileFetchJob::Permissions) << 1) - 1);
+    }
+
+    void testProjection()
+    {
+        QCOMPARE(FileFields::projection(FileFetchJob::AllFields), QString());
+        QCOMPARE(FileFields::projection(FileFetchJob::Id | FileFetchJob::Title | FileFetchJob::OriginalFilename),
+                 QStringLiteral("kind,id,title,originalFilename"));
+        QCOMPARE(FileFields::projection(FileFetchJob::BasicFields),
+                 QStringLiteral("kind,id,title,mimeType,createdDate,modifiedDate,downloadUrl,fileSize,permissions"));
+        // Served from the cache the second time
+        QCOMPARE(FileFields::projection(FileFetchJob::BasicFields),
+                 QStringLiteral("kind,id,title,mimeType,createdDate,modifiedDate,downloadUrl,fileSize,permissions"));
+    }
+
+    void testRoundTrip()
+    {
+        const QByteArray json = QByteArrayLiteral(R"({
+            "kind": "drive#file", "id": "abc", "etag": "\"etag\"", "title": "report.odt",
+            "mimeType": "application/vnd.oasis.opendocument.text", "description": "Quarterly report",
+            "labels": { "starred": true, "trashed": false },
+            "createdDate": "2020-01-02T10:00:00.000Z", "modifiedDate": "2020-01-03T10:00:00.000Z",
+            "fileSize": "1234", "originalFilename": "report-final.odt", "editable": true,
+            "ownerNames": [ "John", "Jane" ], "unknownProperty": 42,
+            "parents": [ { "kind": "drive#parentReference", "id": "root", "isRoot": true } ]
+        })");
+
+        const FilePtr file = File::fromJSON(json);
+        QVERIFY(file);
+        QCOMPARE(file->id(), QStringLiteral("abc"));
+        QCOMPARE(file->etag(), QStringLiteral("\"etag\""));
+        QCOMPARE(file->title(), QStringLiteral("report.odt"));
+        QCOMPARE(file->description(), QStringLiteral("Quarterly report"));
+        QVERIFY(file->labels()->starred());
+        QCOMPARE(file->fileSize(), 1234LL);
+        QCOMPARE(file->originalFileName(), QStringLiteral("report-final.odt"));
+        QVERIFY(file->editable());
+        QCOMPARE(file->ownerNames(), QStringList({ QStringLiteral("John"), QStringLiteral("Jane") }));
+        QCOMPARE(file->parents().count(), 1);
+        QVERIFY(file->parents().first()->isRoot());
+        // Missing properties are still available
+        QVERIFY(file->thumbnail());
+        QVERIFY(file->imageMediaMetadata());
+
+        const QVariantMap map = QJsonDocument::fromJson(File::toJSON(file)).toVariant().toMap();
+        QCOMPARE(map[QStringLiteral("kind")].toString(), QStringLiteral("drive#file"));
+        QCOMPARE(map[QStringLiteral("title")].toString(), file->title());
+        QCOMPARE(map[QStringLiteral("originalFilename")].toString(), file->originalFileName());
+        QCOMPARE(map[QStringLiteral("createdDate")].toString(), QStringLiteral("2020-01-02T10:00:00Z"));
+        QCOMPARE(map[QStringLiteral("fileSize")].toLongLong(), 1234LL);
+        QVERIFY(map[QStringLiteral("labels")].toMap()[QStringLiteral("starred")].toBool());
+        QVERIFY(!map.contains(QStringLiteral("editable")));
+
+        const FilePtr copy = File::fromJSON(File::toJSON(file));
+        QVERIFY(copy);
+        QCOMPARE(copy->id(), file->id());
+        QCOMPARE(copy->modifiedDate(), file->modifiedDate());
+        QCOMPARE(copy->ownerNames(), file->ownerNames());
+        QCOMPARE(copy->parents().first()->id(), QStringLiteral("root"));
+
+        QVERIFY(!File::toJSON(file, File::ExcludeCreationDate).contains("createdDate"));
+    }
+};
+
+QTEST_GUILESS_MAIN(FileFieldsTest)
+
+#include "filefieldstest.moc"
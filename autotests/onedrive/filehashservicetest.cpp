@@ -0,0 +1,209 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFile>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "filehashservice.h"
+
+using namespace KMGraph2;
+using namespace KMGraph2::OneDrive;
+
+class FileHashServiceTest: public QObject
+{
+    Q_OBJECT
+private:
+    static QString md5(const QByteArray &data)
+    {
+        return QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex());
+    }
+
+    static bool writeFile(const QString &path, const QByteArray &data)
+    {
+        QFile file(path);
+        return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+    }
+
+private Q_SLOTS:
+    void testHitAndMiss()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString path = dir.filePath(QStringLiteral("file"));
+        QVERIFY(writeFile(path, "content"));
+
+        FileHashService service(QString());
+        QVERIFY(!service.isCached(path));
+        QCOMPARE(service.md5Checksum(path), md5("content"));
+        QVERIFY(service.isCached(path));
+        QCOMPARE(service.cacheSize(), 1);
+
+        // Served from the cache
+        QCOMPARE(service.md5Checksum(path), md5("content"));
+        QCOMPARE(service.cacheSize(), 1);
+
+        const QString missing = dir.filePath(QStringLiteral("missing"));
+        QVERIFY(service.md5Checksum(missing).isEmpty());
+        QVERIFY(!service.isCached(missing));
+    }
+
+    void testBatch()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        // Small files are hashed in batches, large ones one by one
+        QStringList paths;
+        QHash<QString, QString> expected;
+        for (int i = 0; i < 10; ++i) {
+            const QByteArray data = QByteArray(i * 20000, char('a' + i));
+            const QString path = dir.filePath(QString::number(i));
+            QVERIFY(writeFile(path, data));
+            paths << path;
+            expected.insert(path, md5(data));
+        }
+
+        FileHashService service(QString());
+        service.setMaxThreadCount(2);
+        QCOMPARE(service.md5Checksums(paths), expected);
+        QCOMPARE(service.cacheSize(), 10);
+    }
+
+    void testInvalidation()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString path = dir.filePath(QStringLiteral("file"));
+        QVERIFY(writeFile(path, "old"));
+
+        FileHashService service(QString());
+        QCOMPARE(service.md5Checksum(path), md5("old"));
+
+        QVERIFY(writeFile(path, "new content"));
+        QVERIFY(!service.isCached(path));
+        QCOMPARE(service.md5Checksum(path), md5("new content"));
+        // The checksum of the old version is gone
+        QCOMPARE(service.cacheSize(), 1);
+    }
+
+    void testRemoveStale()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString kept = dir.filePath(QStringLiteral("kept"));
+        const QString deleted = dir.filePath(QStringLiteral("deleted"));
+        QVERIFY(writeFile(kept, "kept"));
+        QVERIFY(writeFile(deleted, "deleted"));
+
+        FileHashService service(QString());
+        QCOMPARE(service.md5Checksums(QStringList() << kept << deleted).size(), 2);
+        QCOMPARE(service.cacheSize(), 2);
+
+        QVERIFY(QFile::remove(deleted));
+        QCOMPARE(service.removeStale(), 1);
+        QCOMPARE(service.cacheSize(), 1);
+        QVERIFY(service.isCached(kept));
+    }
+
+    void testMaxCacheSize()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        FileHashService service(QString());
+        service.setMaxCacheSize(10);
+        for (int i = 0; i < 10; ++i) {
+            const QString path = dir.filePath(QString::number(i));
+            QVERIFY(writeFile(path, QByteArray::number(i)));
+            QVERIFY(!service.md5Checksum(path).isEmpty());
+            QTest::qWait(5);
+        }
+        QCOMPARE(service.cacheSize(), 10);
+
+        // The oldest checksum is in use
+        QVERIFY(!service.md5Checksum(dir.filePath(QStringLiteral("0"))).isEmpty());
+        QTest::qWait(5);
+
+        // Makes room for more than one checksum at once
+        const QString path = dir.filePath(QStringLiteral("10"));
+        QVERIFY(writeFile(path, "10"));
+        QVERIFY(!service.md5Checksum(path).isEmpty());
+        QCOMPARE(service.cacheSize(), 9);
+        QVERIFY(service.isCached(dir.filePath(QStringLiteral("0"))));
+        QVERIFY(!service.isCached(dir.filePath(QStringLiteral("1"))));
+        QVERIFY(!service.isCached(dir.filePath(QStringLiteral("2"))));
+        QVERIFY(service.isCached(path));
+    }
+
+    void testPersistence()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString path = dir.filePath(QStringLiteral("file"));
+        const QString cachePath = dir.filePath(QStringLiteral("cache/md5cache"));
+        QVERIFY(writeFile(path, "content"));
+
+        {
+            FileHashService service(cachePath);
+            QCOMPARE(service.md5Checksum(path), md5("content"));
+            // Saved when destroyed
+        }
+
+        FileHashService service(cachePath);
+        QVERIFY(service.isCached(path));
+        QCOMPARE(service.md5Checksum(path), md5("content"));
+
+        // Dropped versions don't come back from disk
+        QVERIFY(writeFile(path, "changed content"));
+        QCOMPARE(service.md5Checksum(path), md5("changed content"));
+        QVERIFY(service.save());
+        QVERIFY(service.load());
+        QCOMPARE(service.cacheSize(), 1);
+    }
+
+    void testCorruptedCount()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString cachePath = dir.filePath(QStringLiteral("md5cache"));
+
+        {
+            QFile file(cachePath);
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            QDataStream stream(&file);
+            // Valid header, but claims far more entries than follow
+            stream << quint32(0x4b4d4835) << quint32(2) << quint32(0xffffffff);
+        }
+
+        FileHashService service(cachePath);
+        QCOMPARE(service.cacheSize(), 0);
+        QVERIFY(!service.load());
+    }
+};
+
+QTEST_GUILESS_MAIN(FileHashServiceTest)
+
+#include "filehashservicetest.moc"
@@ -21,6 +21,7 @@
 #include <QObject>
 #include <QTest>
 
+#include "file.h"
 #include "filesearchquery.h"
 
 using namespace KMGraph2;
@@ -89,6 +90,60 @@ private Q_SLOTS:
         const QString serialized = query.serialize();
         QCOMPARE(serialized, expected);
     }
+
+    void testMatches()
+    {
+        const FilePtr file = File::fromJSON(QByteArrayLiteral(R"({
+            "kind": "drive#file", "id": "a", "title": "Quarterly Report.pdf",
+            "mimeType": "application/pdf", "description": "Numbers for Q3",
+            "modifiedDate": "2014-07-28T17:05:30.000Z",
+            "sharedWithMeDate": "2014-07-29T08:00:00.000Z",
+            "labels": { "starred": true, "trashed": false },
+            "parents": [ { "kind": "drive#parentReference", "id": "folder1" } ],
+            "ownerNames": [ "John Doe" ]
+        })"));
+        QVERIFY(file);
+
+        const auto single = [](FileSearchQuery::Field field, FileSearchQuery::CompareOperator op, const QVariant &value) {
+            FileSearchQuery query;
+            query.addQuery(field, op, value);
+            return query;
+        };
+        const QDateTime modified(QDate(2014, 7, 28), QTime(17, 5, 30), Qt::UTC);
+
+        QVERIFY(FileSearchQuery().matches(file));
+        QVERIFY(single(FileSearchQuery::Title, FileSearchQuery::Contains, QStringLiteral("report")).matches(file));
+        QVERIFY(!single(FileSearchQuery::Title, FileSearchQuery::Equals, QStringLiteral("quarterly report.pdf")).matches(file));
+        QVERIFY(single(FileSearchQuery::FullText, FileSearchQuery::Contains, QStringLiteral("q3")).matches(file));
+        QVERIFY(single(FileSearchQuery::MimeType, FileSearchQuery::Equals, QStringLiteral("application/pdf")).matches(file));
+        QVERIFY(single(FileSearchQuery::MimeType, FileSearchQuery::NotEquals, QStringLiteral("text/plain")).matches(file));
+        QVERIFY(single(FileSearchQuery::ModifiedDate, FileSearchQuery::Equals, modified).matches(file));
+        QVERIFY(single(FileSearchQuery::ModifiedDate, FileSearchQuery::Greater, modified.addDays(-1)).matches(file));
+        QVERIFY(!single(FileSearchQuery::ModifiedDate, FileSearchQuery::Less, modified).matches(file));
+        QVERIFY(!single(FileSearchQuery::LastViewedByMeDate, FileSearchQuery::Less, modified).matches(file));
+        QVERIFY(single(FileSearchQuery::Starred, FileSearchQuery::Equals, true).matches(file));
+        QVERIFY(single(FileSearchQuery::Trashed, FileSearchQuery::NotEquals, true).matches(file));
+        QVERIFY(single(FileSearchQuery::SharedWithMe, FileSearchQuery::Equals, true).matches(file));
+        QVERIFY(single(FileSearchQuery::Parents, FileSearchQuery::In, QStringLiteral("folder1")).matches(file));
+        QVERIFY(!single(FileSearchQuery::Parents, FileSearchQuery::In, QStringLiteral("root")).matches(file));
+        QVERIFY(single(FileSearchQuery::Owners, FileSearchQuery::In, QStringLiteral("John Doe")).matches(file));
+
+        FileSearchQuery either(FileSearchQuery::Or);
+        either.addQuery(FileSearchQuery::Title, FileSearchQuery::Contains, QStringLiteral("invoice"));
+        either.addQuery(single(FileSearchQuery::Starred, FileSearchQuery::Equals, true));
+        QVERIFY(either.matches(file));
+
+        FileSearchQuery both;
+        both.addQuery(FileSearchQuery::Title, FileSearchQuery::Contains, QStringLiteral("invoice"));
+        both.addQuery(FileSearchQuery::Starred, FileSearchQuery::Equals, true);
+        QVERIFY(!both.matches(file));
+        QVERIFY(both.canMatchLocally());
+
+        // Writers and readers are not known locally
+        const FileSearchQuery writers = single(FileSearchQuery::Writers, FileSearchQuery::In, QStringLiteral("user@example.com"));
+        QVERIFY(!writers.canMatchLocally());
+        QVERIFY(!writers.matches(file));
+    }
 };
 
 QTEST_GUILESS_MAIN(FileSearchQueryTest)
@@ -0,0 +1,450 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QTest>
+
+#include "filetable.h"
+#include "file.h"
+#include "filesearchquery.h"
+
+using namespace KMGraph2;
+using namespace KMGraph2::OneDrive;
+
+Q_DECLARE_METATYPE(KMGraph2::OneDrive::FileSearchQuery)
+Q_DECLARE_METATYPE(KMGraph2::OneDrive::FileSearchQuery::Field)
+
+class FileTableTest: public QObject
+{
+    Q_OBJECT
+private:
+    static QByteArray fileList()
+    {
+        return QByteArrayLiteral(R"({
+            "kind": "drive#fileList",
+            "nextLink": "https://example.com/next",
+            "items": [
+                { "kind": "drive#file", "id": "a", "title": "beta.txt", "mimeType": "text/plain",
+                  "fileSize": "300", "modifiedDate": "2020-01-02T10:00:00.000Z",
+                  "parents": [ { "kind": "drive#parentReference", "id": "root" } ],
+                  "labels": { "starred": true } },
+                { "kind": "drive#file", "id": "b", "title": "Alpha", "mimeType": "application/vnd.google-apps.folder",
+                  "modifiedDate": "2020-01-01T10:00:00.000Z",
+                  "parents": [ { "kind": "drive#parentReference", "id": "root" } ] },
+                { "kind": "drive#file", "id": "c", "title": "gamma.txt", "mimeType": "text/plain",
+                  "fileSize": "100", "modifiedDate": "2020-01-03T10:00:00.000Z",
+                  "parents": [ { "kind": "drive#parentReference", "id": "b" } ],
+                  "labels": { "trashed": true } }
+            ]
+        })");
+    }
+
+private Q_SLOTS:
+    void testInsertJSON()
+    {
+        FileTable table;
+        FeedData feedData;
+        QCOMPARE(table.insertJSON(fileList(), feedData), 3);
+        QCOMPARE(table.rowCount(), 3);
+        QCOMPARE(feedData.nextPageUrl, QUrl(QStringLiteral("https://example.com/next")));
+
+        const int row = table.row(QStringLiteral("a"));
+        QVERIFY(row >= 0);
+        QCOMPARE(table.title(row), QStringLiteral("beta.txt"));
+        QCOMPARE(table.fileSize(row), qint64(300));
+        QCOMPARE(table.parentId(row), QStringLiteral("root"));
+        QCOMPARE(table.modifiedDate(row), QDateTime(QDate(2020, 1, 2), QTime(10, 0), Qt::UTC));
+        QCOMPARE(table.flags(row), FileTable::Flags(FileTable::Starred));
+        QVERIFY(table.flags(table.row(QStringLiteral("b"))) & FileTable::Folder);
+
+        // Identical strings are stored only once
+        QCOMPARE(table.mimeTypeColumn()[row], table.mimeTypeColumn()[table.row(QStringLiteral("c"))]);
+
+        const FilePtr file = table.file(row);
+        QCOMPARE(file->id(), QStringLiteral("a"));
+        QCOMPARE(file->title(), QStringLiteral("beta.txt"));
+        QVERIFY(file->labels()->starred());
+    }
+
+    void testInsertFile()
+    {
+        const QByteArray json = QByteArrayLiteral(R"({
+            "kind": "drive#file", "id": "a", "title": "beta.txt", "mimeType": "text/plain",
+            "labels": { "starred": true, "hidden": true, "viewed": true },
+            "shared": true, "editable": true
+        })");
+
+        FileTable jsonTable;
+        FeedData feedData;
+        QCOMPARE(jsonTable.insertJSON(json, feedData), 1);
+
+        FileTable fileTable;
+        const int row = fileTable.insert(File::fromJSON(json));
+        QVERIFY(row >= 0);
+
+        // Both ways of filling the table store the same flags
+        QVERIFY(fileTable.flags(row) & FileTable::Hidden);
+        QCOMPARE(fileTable.flags(row), jsonTable.flags(jsonTable.row(QStringLiteral("a"))));
+    }
+
+    void testChanges()
+    {
+        FileTable table;
+        FeedData feedData;
+        table.insertJSON(fileList(), feedData);
+
+        const QByteArray changes = QByteArrayLiteral(R"({
+            "kind": "drive#changeList",
+            "items": [
+                { "kind": "drive#change", "fileId": "a", "deleted": true },
+                { "kind": "drive#change", "fileId": "c", "deleted": false,
+                  "file": { "kind": "drive#file", "id": "c", "title": "renamed.txt", "mimeType": "text/plain" } },
+                { "kind": "drive#change", "fileId": "d", "deleted": false,
+                  "file": { "kind": "drive#file", "id": "d", "title": "new.txt", "mimeType": "text/plain" } }
+            ]
+        })");
+        QCOMPARE(table.insertJSON(changes, feedData), 3);
+        QCOMPARE(table.rowCount(), 3);
+        QCOMPARE(table.row(QStringLiteral("a")), -1);
+        QCOMPARE(table.title(table.row(QStringLiteral("c"))), QStringLiteral("renamed.txt"));
+        QCOMPARE(table.id(table.row(QStringLiteral("d"))), QStringLiteral("d"));
+    }
+
+    void testSelect()
+    {
+        FileTable table;
+        FeedData feedData;
+        table.insertJSON(fileList(), feedData);
+
+        const auto ids = [&table](const QVector<int> &rows) {
+            QStringList result;
+            for (int row : rows) {
+                result << table.id(row);
+            }
+            return result;
+        };
+
+        QCOMPARE(ids(table.selectByMimeType(QStringLiteral("text/plain"))), QStringList({ QStringLiteral("a"), QStringLiteral("c") }));
+        QCOMPARE(ids(table.selectByMimeType(QStringLiteral("image/png"))), QStringList());
+        QCOMPARE(ids(table.selectByParent(QStringLiteral("root"))), QStringList({ QStringLiteral("a"), QStringLiteral("b") }));
+        QCOMPARE(ids(table.selectByFlags(FileTable::Flags(), FileTable::Trashed | FileTable::Folder)), QStringList({ QStringLiteral("a") }));
+        QCOMPARE(ids(table.selectBySize(200, 1000)), QStringList({ QStringLiteral("a") }));
+        QCOMPARE(ids(table.selectModifiedBetween(QDateTime(QDate(2020, 1, 2), QTime(0, 0), Qt::UTC), QDateTime())),
+                 QStringList({ QStringLiteral("a"), QStringLiteral("c") }));
+        QCOMPARE(ids(FileTable::intersect(table.selectByParent(QStringLiteral("root")),
+                                          table.selectByMimeType(QStringLiteral("text/plain")))),
+                 QStringList({ QStringLiteral("a") }));
+    }
+
+    void testSelectQuery_data()
+    {
+        QTest::addColumn<FileSearchQuery>("query");
+        QTest::addColumn<QStringList>("expected");
+
+        {
+            FileSearchQuery query;
+            query.addQuery(FileSearchQuery::MimeType, FileSearchQuery::Equals, QStringLiteral("text/plain"));
+            query.addQuery(FileSearchQuery::Parents, FileSearchQuery::In, QStringLiteral("root"));
+            QTest::newRow("indexed") << query << QStringList({ QStringLiteral("a") });
+        }
+        {
+            FileSearchQuery query;
+            query.addQuery(FileSearchQuery::Title, FileSearchQuery::Contains, QStringLiteral("TXT"));
+            QTest::newRow("title contains") << query << QStringList({ QStringLiteral("a"), QStringLiteral("c") });
+        }
+        {
+            FileSearchQuery query;
+            query.addQuery(FileSearchQuery::ModifiedDate, FileSearchQuery::GreaterOrEqual,
+                           QDateTime(QDate(2020, 1, 2), QTime(10, 0), Qt::UTC));
+            query.addQuery(FileSearchQuery::Trashed, FileSearchQuery::Equals, false);
+            QTest::newRow("date range and flag") << query << QStringList({ QStringLiteral("a") });
+        }
+        {
+            FileSearchQuery query;
+            query.addQuery(FileSearchQuery::ModifiedDate, FileSearchQuery::Less,
+                           QDateTime(QDate(2020, 1, 3), QTime(10, 0), Qt::UTC));
+            QTest::newRow("date less") << query << QStringList({ QStringLiteral("a"), QStringLiteral("b") });
+        }
+        {
+            FileSearchQuery query(FileSearchQuery::Or);
+            query.addQuery(FileSearchQuery::Starred, FileSearchQuery::Equals, true);
+            query.addQuery(FileSearchQuery::Parents, FileSearchQuery::In, QStringLiteral("b"));
+            QTest::newRow("or") << query << QStringList({ QStringLiteral("a"), QStringLiteral("c") });
+        }
+        {
+            FileSearchQuery query;
+            query.addQuery(FileSearchQuery::MimeType, FileSearchQuery::NotEquals, QStringLiteral("text/plain"));
+            FileSearchQuery subquery(FileSearchQuery::Or);
+            subquery.addQuery(FileSearchQuery::Title, FileSearchQuery::Equals, QStringLiteral("Alpha"));
+            subquery.addQuery(FileSearchQuery::Title, FileSearchQuery::Equals, QStringLiteral("beta.txt"));
+            query.addQuery(subquery);
+            QTest::newRow("nested") << query << QStringList({ QStringLiteral("b") });
+        }
+        {
+            QTest::newRow("empty") << FileSearchQuery() << QStringList({ QStringLiteral("a"), QStringLiteral("b"), QStringLiteral("c") });
+        }
+    }
+
+    void testSelectQuery()
+    {
+        QFETCH(FileSearchQuery, query);
+        QFETCH(QStringList, expected);
+
+        FileTable table;
+        FeedData feedData;
+        table.insertJSON(fileList(), feedData);
+
+        QVERIFY(FileTable::canSelect(query));
+        const QVector<int> rows = table.select(query);
+        QStringList ids;
+        for (int row : rows) {
+            ids << table.id(row);
+        }
+        ids.sort();
+        QCOMPARE(ids, expected);
+
+        // The table and File objects must give the same answers
+        FeedData fileFeedData;
+        const FilesList files = File::fromJSONFeed(fileList(), fileFeedData);
+        for (const FilePtr &file : files) {
+            QCOMPARE(query.matches(file), rows.contains(table.row(file->id())));
+        }
+
+        // Indexes are updated after modification
+        table.remove(QStringLiteral("a"));
+        expected.removeAll(QStringLiteral("a"));
+        ids.clear();
+        for (int row : table.select(query)) {
+            ids << table.id(row);
+        }
+        ids.sort();
+        QCOMPARE(ids, expected);
+    }
+
+    void testParentsAndOwners_data()
+    {
+        QTest::addColumn<FileSearchQuery::Field>("field");
+        QTest::addColumn<QString>("value");
+        QTest::addColumn<QStringList>("expected");
+
+        QTest::newRow("first parent") << FileSearchQuery::Parents << QStringLiteral("root") << QStringList({ QStringLiteral("a"), QStringLiteral("b") });
+        QTest::newRow("second parent") << FileSearchQuery::Parents << QStringLiteral("shared") << QStringList({ QStringLiteral("a") });
+        QTest::newRow("no parent") << FileSearchQuery::Parents << QString() << QStringList();
+        QTest::newRow("owner name") << FileSearchQuery::Owners << QStringLiteral("Jane") << QStringList({ QStringLiteral("a") });
+        QTest::newRow("second owner name") << FileSearchQuery::Owners << QStringLiteral("John") << QStringList({ QStringLiteral("a"), QStringLiteral("b") });
+        QTest::newRow("permission ID") << FileSearchQuery::Owners << QStringLiteral("1234") << QStringList({ QStringLiteral("a") });
+        QTest::newRow("display name") << FileSearchQuery::Owners << QStringLiteral("Jane Doe") << QStringList({ QStringLiteral("a") });
+        QTest::newRow("unknown owner") << FileSearchQuery::Owners << QStringLiteral("root") << QStringList();
+    }
+
+    void testParentsAndOwners()
+    {
+        QFETCH(FileSearchQuery::Field, field);
+        QFETCH(QString, value);
+        QFETCH(QStringList, expected);
+
+        const QByteArray json = QByteArrayLiteral(R"({
+            "kind": "drive#fileList",
+            "items": [
+                { "kind": "drive#file", "id": "a", "title": "a",
+                  "parents": [ { "kind": "drive#parentReference", "id": "root" },
+                               { "kind": "drive#parentReference", "id": "shared" } ],
+                  "ownerNames": [ "Jane", "John" ],
+                  "owners": [ { "kind": "drive#user", "permissionId": "1234", "displayName": "Jane Doe" } ] },
+                { "kind": "drive#file", "id": "b", "title": "b",
+                  "parents": [ { "kind": "drive#parentReference", "id": "root" } ],
+                  "ownerNames": [ "John" ] },
+                { "kind": "drive#file", "id": "c", "title": "c" }
+            ]
+        })");
+
+        FileTable table;
+        FeedData feedData;
+        table.insertJSON(json, feedData);
+
+        FileSearchQuery query;
+        query.addQuery(field, FileSearchQuery::In, value);
+        // Once answered from the index, once by checking every row
+        FileSearchQuery checked;
+        checked.addQuery(FileSearchQuery::Title, FileSearchQuery::NotEquals, QStringLiteral("x"));
+        checked.addQuery(query);
+
+        const QVector<int> rows = table.select(query);
+        QCOMPARE(table.select(checked), rows);
+        QStringList ids;
+        for (int row : rows) {
+            ids << table.id(row);
+        }
+        ids.sort();
+        QCOMPARE(ids, expected);
+
+        const FilesList files = File::fromJSONFeed(json, feedData);
+        for (const FilePtr &file : files) {
+            QCOMPARE(query.matches(file), rows.contains(table.row(file->id())));
+        }
+
+        // Inserting File objects stores the same values
+        for (const FilePtr &file : files) {
+            table.insert(file);
+        }
+        QCOMPARE(table.rowCount(), 3);
+        QCOMPARE(table.select(query), rows);
+    }
+
+    void testIndexesUpdated()
+    {
+        FileTable table;
+        FeedData feedData;
+        table.insertJSON(fileList(), feedData);
+
+        FileSearchQuery byParent;
+        byParent.addQuery(FileSearchQuery::Parents, FileSearchQuery::In, QStringLiteral("root"));
+        FileSearchQuery byMimeType;
+        byMimeType.addQuery(FileSearchQuery::MimeType, FileSearchQuery::Equals, QStringLiteral("text/plain"));
+        FileSearchQuery byDate;
+        byDate.addQuery(FileSearchQuery::ModifiedDate, FileSearchQuery::Greater,
+                        QDateTime(QDate(2020, 1, 1), QTime(12, 0), Qt::UTC));
+        const QList<FileSearchQuery> queries = { byParent, byMimeType, byDate };
+
+        const auto verify = [&table, &queries]() {
+            for (const FileSearchQuery &query : queries) {
+                QVector<int> expected;
+                for (int row = 0; row < table.rowCount(); ++row) {
+                    if (query.matches(table.file(row))) {
+                        expected.append(row);
+                    }
+                }
+                if (table.select(query) != expected) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        // Builds the indexes
+        QVERIFY(verify());
+
+        const QByteArray changes = QByteArrayLiteral(R"({
+            "kind": "drive#changeList",
+            "items": [
+                { "kind": "drive#change", "fileId": "b", "deleted": false,
+                  "file": { "kind": "drive#file", "id": "b", "title": "Alpha", "mimeType": "text/plain",
+                            "modifiedDate": "2020-01-05T10:00:00.000Z",
+                            "parents": [ { "kind": "drive#parentReference", "id": "c" } ] } },
+                { "kind": "drive#change", "fileId": "d", "deleted": false,
+                  "file": { "kind": "drive#file", "id": "d", "title": "delta", "mimeType": "text/plain",
+                            "modifiedDate": "2020-01-02T10:00:00.000Z",
+                            "parents": [ { "kind": "drive#parentReference", "id": "root" } ] } }
+            ]
+        })");
+        QCOMPARE(table.insertJSON(changes, feedData), 2);
+        QVERIFY(verify());
+
+        // Moves the last row
+        QVERIFY(table.remove(QStringLiteral("a")));
+        QVERIFY(verify());
+        QVERIFY(table.remove(QStringLiteral("d")));
+        QVERIFY(verify());
+        QCOMPARE(table.rowCount(), 2);
+    }
+
+    void testStringPool()
+    {
+        FileTable table;
+        FeedData feedData;
+        table.insertJSON(fileList(), feedData);
+
+        const int row = table.row(QStringLiteral("c"));
+        const quint32 title = table.titleColumn()[row];
+        const auto rename = [&table, &feedData](int i) {
+            const QByteArray change = QStringLiteral(R"({ "kind": "drive#change", "fileId": "c", "deleted": false,
+                "file": { "kind": "drive#file", "id": "c", "title": "title %1", "etag": "etag %1", "mimeType": "text/plain" } })")
+                    .arg(i).toUtf8();
+            return table.insertJSON(change, feedData);
+        };
+
+        QCOMPARE(rename(0), 1);
+        QCOMPARE(table.stringIndex(QStringLiteral("gamma.txt")), FileTable::NoString);
+        QVERIFY(table.string(title).isEmpty());
+        // Still used by the other rows
+        QVERIFY(table.stringIndex(QStringLiteral("text/plain")) != FileTable::NoString);
+        QVERIFY(table.stringIndex(QStringLiteral("root")) != FileTable::NoString);
+
+        // Replaced strings don't make the pool grow
+        quint32 maxIndex = 0;
+        for (int i = 1; i < 100; ++i) {
+            QCOMPARE(rename(i), 1);
+            maxIndex = qMax(maxIndex, table.titleColumn()[row]);
+        }
+        QCOMPARE(table.title(row), QStringLiteral("title 99"));
+        QCOMPARE(table.etag(row), QStringLiteral("etag 99"));
+        QVERIFY(maxIndex < 20);
+        QCOMPARE(table.stringIndex(QStringLiteral("title 98")), FileTable::NoString);
+
+        // Removing a row releases all of its strings
+        QVERIFY(table.remove(QStringLiteral("c")));
+        QCOMPARE(table.stringIndex(QStringLiteral("title 99")), FileTable::NoString);
+        QCOMPARE(table.stringIndex(QStringLiteral("c")), FileTable::NoString);
+        QVERIFY(table.stringIndex(QStringLiteral("b")) != FileTable::NoString);
+        QCOMPARE(table.title(table.row(QStringLiteral("a"))), QStringLiteral("beta.txt"));
+    }
+
+    void testCanSelect()
+    {
+        FileSearchQuery query;
+        query.addQuery(FileSearchQuery::Title, FileSearchQuery::Contains, QStringLiteral("a"));
+        QVERIFY(FileTable::canSelect(query));
+        query.addQuery(FileSearchQuery::Writers, FileSearchQuery::In, QStringLiteral("user@example.com"));
+        QVERIFY(!FileTable::canSelect(query));
+    }
+
+    void testSort()
+    {
+        FileTable table;
+        FeedData feedData;
+        table.insertJSON(fileList(), feedData);
+
+        QStringList titles;
+        for (int row : table.sorted(FileTable::TitleColumn)) {
+            titles << table.title(row);
+        }
+        QCOMPARE(titles, QStringList({ QStringLiteral("Alpha"), QStringLiteral("beta.txt"), QStringLiteral("gamma.txt") }));
+
+        QStringList ids;
+        for (int row : table.sorted(FileTable::ModifiedDateColumn, Qt::DescendingOrder)) {
+            ids << table.id(row);
+        }
+        QCOMPARE(ids, QStringList({ QStringLiteral("c"), QStringLiteral("a"), QStringLiteral("b") }));
+
+        // Only some of the rows
+        QVector<int> rows = table.selectByMimeType(QStringLiteral("text/plain"));
+        table.sort(rows, FileTable::TitleColumn, Qt::DescendingOrder);
+        titles.clear();
+        for (int row : qAsConst(rows)) {
+            titles << table.title(row);
+        }
+        QCOMPARE(titles, QStringList({ QStringLiteral("gamma.txt"), QStringLiteral("beta.txt") }));
+    }
+};
+
+QTEST_GUILESS_MAIN(FileTableTest)
+
+#include "filetabletest.moc"
@@ -0,0 +1,156 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QTest>
+
+#include "change.h"
+#include "filetitleindex.h"
+
+using namespace KMGraph2;
+using namespace KMGraph2::OneDrive;
+
+class FileTitleIndexTest: public QObject
+{
+    Q_OBJECT
+private:
+    static void fill(FileTitleIndex &index)
+    {
+        index.insert(QStringLiteral("1"), QStringLiteral("Quarterly Report.pdf"));
+        index.insert(QStringLiteral("2"), QStringLiteral("report-draft.docx"));
+        index.insert(QStringLiteral("3"), QStringLiteral("Holiday photos"));
+        index.insert(QStringLiteral("4"), QStringLiteral("Unreported expenses.xlsx"));
+    }
+
+private Q_SLOTS:
+    void testSearch_data()
+    {
+        QTest::addColumn<QString>("text");
+        QTest::addColumn<int>("mode");
+        QTest::addColumn<QStringList>("expected");
+
+        QTest::newRow("contains") << QStringLiteral("REPORT") << int(FileTitleIndex::Contains)
+                                  << QStringList({ QStringLiteral("1"), QStringLiteral("2"), QStringLiteral("4") });
+        QTest::newRow("word prefix") << QStringLiteral("report") << int(FileTitleIndex::WordPrefix)
+                                     << QStringList({ QStringLiteral("1"), QStringLiteral("2") });
+        QTest::newRow("short word prefix") << QStringLiteral("dr") << int(FileTitleIndex::WordPrefix)
+                                           << QStringList({ QStringLiteral("2") });
+        QTest::newRow("single character") << QStringLiteral("x") << int(FileTitleIndex::Contains)
+                                          << QStringList({ QStringLiteral("2"), QStringLiteral("4") });
+        QTest::newRow("punctuation") << QStringLiteral("rt.pdf") << int(FileTitleIndex::Contains)
+                                     << QStringList({ QStringLiteral("1") });
+        // Found through the index, but the separator differs
+        QTest::newRow("other separator") << QStringLiteral("report pdf") << int(FileTitleIndex::Contains)
+                                         << QStringList();
+        QTest::newRow("missing") << QStringLiteral("invoice") << int(FileTitleIndex::Contains)
+                                 << QStringList();
+    }
+
+    void testSearch()
+    {
+        QFETCH(QString, text);
+        QFETCH(int, mode);
+        QFETCH(QStringList, expected);
+
+        FileTitleIndex index;
+        fill(index);
+        QCOMPARE(index.count(), 4);
+        QCOMPARE(index.search(text, FileTitleIndex::MatchMode(mode)), expected);
+    }
+
+    void testLimit()
+    {
+        FileTitleIndex index;
+        fill(index);
+        QCOMPARE(index.search(QStringLiteral("report"), FileTitleIndex::Contains, 2),
+                 QStringList({ QStringLiteral("1"), QStringLiteral("2") }));
+        QVERIFY(index.search(QStringLiteral("report"), FileTitleIndex::Contains, 0).isEmpty());
+    }
+
+    void testUpdates()
+    {
+        FileTitleIndex index;
+        fill(index);
+
+        index.insert(QStringLiteral("1"), QStringLiteral("Annual summary"));
+        QCOMPARE(index.count(), 4);
+        QCOMPARE(index.search(QStringLiteral("report"), FileTitleIndex::WordPrefix), QStringList({ QStringLiteral("2") }));
+        QCOMPARE(index.search(QStringLiteral("summ")), QStringList({ QStringLiteral("1") }));
+
+        QVERIFY(index.remove(QStringLiteral("2")));
+        QVERIFY(!index.remove(QStringLiteral("2")));
+        QVERIFY(!index.contains(QStringLiteral("2")));
+        QCOMPARE(index.search(QStringLiteral("draft")), QStringList());
+
+        FeedData feedData;
+        const ChangesList changes = Change::fromJSONFeed(QByteArrayLiteral(R"({
+            "kind": "drive#changeList",
+            "items": [
+                { "kind": "drive#change", "fileId": "3", "deleted": true },
+                { "kind": "drive#change", "fileId": "5", "deleted": false,
+                  "file": { "kind": "drive#file", "id": "5", "title": "Report 2024" } }
+            ]
+        })"), feedData);
+        index.applyChanges(changes);
+        QVERIFY(!index.contains(QStringLiteral("3")));
+        QCOMPARE(index.search(QStringLiteral("report"), FileTitleIndex::WordPrefix), QStringList({ QStringLiteral("5") }));
+    }
+
+    void testCompaction()
+    {
+        FileTitleIndex index;
+        for (int i = 0; i < 5000; ++i) {
+            index.insert(QString::number(i), QStringLiteral("file %1").arg(i));
+        }
+        for (int i = 0; i < 4000; ++i) {
+            index.remove(QString::number(i));
+        }
+        QCOMPARE(index.count(), 1000);
+        QCOMPARE(index.search(QStringLiteral("file 4999")), QStringList({ QStringLiteral("4999") }));
+        QCOMPARE(index.search(QStringLiteral("file 3999")), QStringList());
+    }
+
+    void benchmarkSearch()
+    {
+        static const char *const words[] = {
+            "report", "budget", "photo", "holiday", "invoice", "draft", "final", "meeting",
+            "notes", "project", "summary", "contract", "plan", "review", "design", "backup"
+        };
+        const int wordCount = sizeof(words) / sizeof(words[0]);
+
+        FileTitleIndex index;
+        for (int i = 0; i < 200000; ++i) {
+            index.insert(QString::number(i), QStringLiteral("%1 %2 %3.txt").arg(QLatin1String(words[i % wordCount]),
+                                                                            QLatin1String(words[(i / wordCount) % wordCount]),
+                                                                            QString::number(i)));
+        }
+
+        QStringList result;
+        QBENCHMARK {
+            result = index.search(QStringLiteral("meeting notes 12"), FileTitleIndex::Contains, 20);
+        }
+        QVERIFY(!result.isEmpty());
+    }
+};
+
+QTEST_GUILESS_MAIN(FileTitleIndexTest)
+
+#include "filetitleindextest.moc"
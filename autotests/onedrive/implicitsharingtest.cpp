@@ -0,0 +1,109 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QTest>
+
+#include "file.h"
+#include "permission.h"
+#include "revision.h"
+
+using namespace KMGraph2;
+using namespace KMGraph2::OneDrive;
+
+class ImplicitSharingTest: public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testFile()
+    {
+        File file;
+        file.setEtag(QStringLiteral("etag"));
+        file.setTitle(QStringLiteral("title"));
+        file.setMimeType(QStringLiteral("text/plain"));
+
+        File copy(file);
+        QCOMPARE(copy.title(), QStringLiteral("title"));
+        QCOMPARE(copy.etag(), QStringLiteral("etag"));
+
+        // Modifying the copy must not change the original and vice versa
+        copy.setTitle(QStringLiteral("other"));
+        copy.setEtag(QStringLiteral("other etag"));
+        QCOMPARE(file.title(), QStringLiteral("title"));
+        QCOMPARE(file.etag(), QStringLiteral("etag"));
+        QCOMPARE(copy.mimeType(), QStringLiteral("text/plain"));
+
+        file.setMimeType(QStringLiteral("image/png"));
+        QCOMPARE(copy.mimeType(), QStringLiteral("text/plain"));
+
+        File assigned;
+        assigned = file;
+        QCOMPARE(assigned.title(), QStringLiteral("title"));
+        QCOMPARE(assigned.etag(), QStringLiteral("etag"));
+        assigned.setTitle(QStringLiteral("assigned"));
+        QCOMPARE(file.title(), QStringLiteral("title"));
+    }
+
+    void testPermission()
+    {
+        Permission permission;
+        permission.setRole(Permission::WriterRole);
+        permission.setValue(QStringLiteral("john@example.com"));
+
+        Permission copy(permission);
+        copy.setRole(Permission::ReaderRole);
+        QCOMPARE(permission.role(), Permission::WriterRole);
+        QCOMPARE(copy.role(), Permission::ReaderRole);
+        QCOMPARE(copy.value(), QStringLiteral("john@example.com"));
+    }
+
+    void testRevision()
+    {
+        Revision revision;
+        revision.setPinned(true);
+
+        Revision copy(revision);
+        copy.setPinned(false);
+        QVERIFY(revision.pinned());
+        QVERIFY(!copy.pinned());
+    }
+
+    void benchmarkCopy()
+    {
+        const FilePtr file = File::fromJSON(QByteArrayLiteral(R"({
+            "kind": "drive#file", "id": "abc", "title": "report.odt",
+            "mimeType": "application/vnd.oasis.opendocument.text",
+            "createdDate": "2020-01-02T10:00:00.000Z", "modifiedDate": "2020-01-03T10:00:00.000Z",
+            "ownerNames": [ "John" ], "labels": { "starred": true },
+            "parents": [ { "kind": "drive#parentReference", "id": "root" } ]
+        })"));
+        QVERIFY(file);
+
+        QBENCHMARK {
+            const File copy(*file);
+            Q_UNUSED(copy);
+        }
+    }
+};
+
+QTEST_GUILESS_MAIN(ImplicitSharingTest)
+
+#include "implicitsharingtest.moc"
@@ -0,0 +1,221 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QTest>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "change.h"
+#include "file.h"
+#include "jsonparser.h"
+
+using namespace KMGraph2;
+using namespace KMGraph2::OneDrive;
+
+Q_DECLARE_METATYPE(KMGraph2::JsonParser::Backend)
+
+namespace {
+
+// A page of a file listing, as returned by the server with the default page size
+QJsonObject fileObject(int i)
+{
+    const QString user = QStringLiteral("User Name %1").arg(i % 50);
+    const QString parent = QStringLiteral("0BxParentFolderId%1").arg(i % 20);
+
+    QJsonObject owner;
+    owner[QStringLiteral("kind")] = QStringLiteral("drive#user");
+    owner[QStringLiteral("displayName")] = user;
+    owner[QStringLiteral("permissionId")] = QString::number(1000000 + i % 50);
+    owner[QStringLiteral("isAuthenticatedUser")] = i % 50 == 0;
+
+    QJsonObject parentRef;
+    parentRef[QStringLiteral("kind")] = QStringLiteral("drive#parentReference");
+    parentRef[QStringLiteral("id")] = parent;
+    parentRef[QStringLiteral("parentLink")] = QStringLiteral("https://www.googleapis.com/drive/v2/files/%1").arg(parent);
+    parentRef[QStringLiteral("isRoot")] = false;
+
+    QJsonObject file;
+    file[QStringLiteral("kind")] = QStringLiteral("drive#file");
+    file[QStringLiteral("id")] = QStringLiteral("0BxFileId%1").arg(i);
+    file[QStringLiteral("etag")] = QStringLiteral("\"etag/%1\"").arg(i);
+    file[QStringLiteral("selfLink")] = QStringLiteral("https://www.googleapis.com/drive/v2/files/0BxFileId%1").arg(i);
+    file[QStringLiteral("title")] = QStringLiteral("Dokument č. %1 – \"final\".odt").arg(i);
+    file[QStringLiteral("mimeType")] = QStringLiteral("application/vnd.oasis.opendocument.text");
+    file[QStringLiteral("createdDate")] = QStringLiteral("2019-05-12T10:15:%1.000Z").arg(i % 60, 2, 10, QLatin1Char('0'));
+    file[QStringLiteral("modifiedDate")] = QStringLiteral("2020-02-03T08:45:%1.123Z").arg(i % 60, 2, 10, QLatin1Char('0'));
+    file[QStringLiteral("fileSize")] = QString::number(1024 + i);
+    file[QStringLiteral("quotaBytesUsed")] = QString::number(1024 + i);
+    file[QStringLiteral("md5Checksum")] = QStringLiteral("%1").arg(i, 32, 16, QLatin1Char('0'));
+    file[QStringLiteral("editable")] = true;
+    file[QStringLiteral("shared")] = i % 3 == 0;
+    file[QStringLiteral("version")] = QString::number(100 + i);
+    file[QStringLiteral("ownerNames")] = QJsonArray({ user });
+    file[QStringLiteral("lastModifyingUserName")] = user;
+    file[QStringLiteral("owners")] = QJsonArray({ owner });
+    file[QStringLiteral("lastModifyingUser")] = owner;
+    file[QStringLiteral("parents")] = QJsonArray({ parentRef });
+    file[QStringLiteral("labels")] = QJsonObject({
+        { QStringLiteral("starred"), i % 7 == 0 }, { QStringLiteral("hidden"), false },
+        { QStringLiteral("trashed"), false }, { QStringLiteral("restricted"), false },
+        { QStringLiteral("viewed"), true } });
+    file[QStringLiteral("imageMediaMetadata")] = QJsonObject({
+        { QStringLiteral("width"), 1920 }, { QStringLiteral("height"), 1080 },
+        { QStringLiteral("exposureTime"), 0.008 } });
+    return file;
+}
+
+QByteArray filePage(int count)
+{
+    QJsonArray items;
+    for (int i = 0; i < count; ++i) {
+        items.append(fileObject(i));
+    }
+
+    QJsonObject page;
+    page[QStringLiteral("kind")] = QStringLiteral("drive#fileList");
+    page[QStringLiteral("etag")] = QStringLiteral("\"listEtag\"");
+    page[QStringLiteral("nextPageToken")] = QStringLiteral("token");
+    page[QStringLiteral("nextLink")] = QStringLiteral("https://www.googleapis.com/drive/v2/files?pageToken=token");
+    page[QStringLiteral("items")] = items;
+    return QJsonDocument(page).toJson(QJsonDocument::Compact);
+}
+
+QByteArray changePage(int count)
+{
+    QJsonArray items;
+    for (int i = 0; i < count; ++i) {
+        QJsonObject change;
+        change[QStringLiteral("kind")] = QStringLiteral("drive#change");
+        change[QStringLiteral("id")] = QString::number(5000 + i);
+        change[QStringLiteral("fileId")] = QStringLiteral("0BxFileId%1").arg(i);
+        change[QStringLiteral("selfLink")] = QStringLiteral("https://www.googleapis.com/drive/v2/changes/%1").arg(5000 + i);
+        change[QStringLiteral("deleted")] = i % 10 == 0;
+        if (i % 10 != 0) {
+            change[QStringLiteral("file")] = fileObject(i);
+        }
+        items.append(change);
+    }
+
+    QJsonObject page;
+    page[QStringLiteral("kind")] = QStringLiteral("drive#changeList");
+    page[QStringLiteral("largestChangeId")] = QString::number(5000 + count);
+    page[QStringLiteral("nextLink")] = QStringLiteral("https://www.googleapis.com/drive/v2/changes?pageToken=token");
+    page[QStringLiteral("items")] = items;
+    return QJsonDocument(page).toJson(QJsonDocument::Compact);
+}
+
+}
+
+class JsonFeedBenchmark: public QObject
+{
+    Q_OBJECT
+private:
+    static void addRows()
+    {
+        QTest::addColumn<JsonParser::Backend>("backend");
+        QTest::addColumn<QByteArray>("page");
+
+        const QByteArray files = filePage(1000);
+        const QByteArray changes = changePage(1000);
+
+        QTest::newRow("files qtjson") << JsonParser::QtJson << files;
+        QTest::newRow("changes qtjson") << JsonParser::QtJson << changes;
+        if (JsonParser::isSupported(JsonParser::SimdJson)) {
+            QTest::newRow("files simdjson") << JsonParser::SimdJson << files;
+            QTest::newRow("changes simdjson") << JsonParser::SimdJson << changes;
+        }
+    }
+
+private Q_SLOTS:
+    void testInvalid()
+    {
+        for (JsonParser::Backend backend : { JsonParser::QtJson, JsonParser::SimdJson }) {
+            if (!JsonParser::isSupported(backend)) {
+                continue;
+            }
+            bool ok = true;
+            QVERIFY(JsonParser::parseObject(QByteArray(), backend, &ok).isEmpty());
+            QVERIFY(!ok);
+            QVERIFY(JsonParser::parseObject("[1, 2]", backend, &ok).isEmpty());
+            QVERIFY(!ok);
+            QVERIFY(JsonParser::parseObject("{\"kind\": \"drive#file\"", backend, &ok).isEmpty());
+            QVERIFY(!ok);
+            QVERIFY(JsonParser::parseObject("{\"a\": 1} {}", backend, &ok).isEmpty());
+            QVERIFY(!ok);
+            QCOMPARE(JsonParser::parseObject("{\"a\": \"\\u00e9\\n\"}", backend, &ok),
+                     QVariantMap({ { QStringLiteral("a"), QStringLiteral("é\n") } }));
+            QVERIFY(ok);
+        }
+    }
+
+    void testBackendsAgree_data()
+    {
+        addRows();
+    }
+
+    void testBackendsAgree()
+    {
+        QFETCH(JsonParser::Backend, backend);
+        QFETCH(QByteArray, page);
+
+        bool ok = false;
+        const QVariantMap map = JsonParser::parseObject(page, backend, &ok);
+        QVERIFY(ok);
+        QCOMPARE(map, JsonParser::parseObject(page, JsonParser::QtJson));
+    }
+
+    void benchmarkParseObject_data()
+    {
+        addRows();
+    }
+
+    void benchmarkParseObject()
+    {
+        QFETCH(JsonParser::Backend, backend);
+        QFETCH(QByteArray, page);
+
+        QVariantMap map;
+        QBENCHMARK {
+            map = JsonParser::parseObject(page, backend);
+        }
+        QCOMPARE(map[QStringLiteral("items")].toList().count(), 1000);
+    }
+
+    void benchmarkFromJSONFeed()
+    {
+        const QByteArray files = filePage(1000);
+        const QByteArray changes = changePage(1000);
+
+        int count = 0;
+        QBENCHMARK {
+            FeedData feedData;
+            count = File::fromJSONFeed(files, feedData).count();
+            count += Change::fromJSONFeed(changes, feedData).count();
+        }
+        QCOMPARE(count, 2000);
+    }
+};
+
+QTEST_GUILESS_MAIN(JsonFeedBenchmark)
+
+#include "jsonfeedbenchmark.moc"
@@ -0,0 +1,183 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QObject>
+#include <QTest>
+#include <QBuffer>
+#include <QDir>
+#include <QJsonDocument>
+#include <QTemporaryDir>
+
+#include "thumbnailcache.h"
+#include "file.h"
+
+using namespace KMGraph2;
+using namespace KMGraph2::OneDrive;
+
+class ThumbnailCacheTest: public QObject
+{
+    Q_OBJECT
+private:
+    static QByteArray encodedImage(int size, const QColor &color)
+    {
+        QImage image(size, size, QImage::Format_RGB32);
+        image.fill(color);
+
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        image.save(&buffer, "PNG");
+        return data;
+    }
+
+private Q_SLOTS:
+    void testMemory()
+    {
+        ThumbnailCache cache(QString());
+        QVERIFY(!cache.contains(QStringLiteral("file"), QStringLiteral("etag1")));
+
+        const QImage inserted = cache.insert(QStringLiteral("file"), QStringLiteral("etag1"),
+                                             encodedImage(16, Qt::red));
+        QCOMPARE(inserted.size(), QSize(16, 16));
+        QVERIFY(cache.contains(QStringLiteral("file"), QStringLiteral("etag1")));
+        QCOMPARE(cache.image(QStringLiteral("file"), QStringLiteral("etag1")), inserted);
+
+        // A modified file must not get the old thumbnail
+        QVERIFY(!cache.contains(QStringLiteral("file"), QStringLiteral("etag2")));
+        QVERIFY(cache.image(QStringLiteral("file"), QStringLiteral("etag2")).isNull());
+
+        QVERIFY(cache.insert(QStringLiteral("broken"), QStringLiteral("etag"), "not an image").isNull());
+        QVERIFY(!cache.contains(QStringLiteral("broken"), QStringLiteral("etag")));
+    }
+
+    void testDisk()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        {
+            ThumbnailCache cache(dir.path());
+            cache.insert(QStringLiteral("file"), QStringLiteral("etag"), encodedImage(16, Qt::blue));
+        }
+
+        ThumbnailCache cache(dir.path());
+        QVERIFY(cache.contains(QStringLiteral("file"), QStringLiteral("etag")));
+        QCOMPARE(cache.image(QStringLiteral("file"), QStringLiteral("etag")).pixelColor(0, 0), QColor(Qt::blue));
+
+        cache.clear();
+        QVERIFY(!cache.contains(QStringLiteral("file"), QStringLiteral("etag")));
+    }
+
+    void testDiskLimit()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        const QByteArray data = encodedImage(64, Qt::green);
+        ThumbnailCache cache(dir.path());
+        cache.setMaxDiskSize(data.size() * 5);
+        cache.setMaxMemoryCost(0);
+
+        for (int i = 0; i < 20; ++i) {
+            cache.insert(QString::number(i), QStringLiteral("etag"), data);
+        }
+
+        qint64 diskUsage = 0;
+        const QFileInfoList entries = QDir(dir.path()).entryInfoList(QDir::Files);
+        for (const QFileInfo &entry : entries) {
+            diskUsage += entry.size();
+        }
+        QVERIFY(diskUsage <= cache.maxDiskSize());
+        QVERIFY(!entries.isEmpty());
+    }
+
+    void testDiskLeastRecentlyUsed()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        const QByteArray data = encodedImage(64, Qt::green);
+        ThumbnailCache cache(dir.path());
+        cache.setMaxDiskSize(data.size() * 5);
+        // Every hit is read from disk
+        cache.setMaxMemoryCost(0);
+
+        for (int i = 0; i < 5; ++i) {
+            cache.insert(QString::number(i), QStringLiteral("etag"), data);
+            QTest::qWait(5);
+        }
+        // The oldest thumbnail is in use
+        QVERIFY(!cache.image(QStringLiteral("0"), QStringLiteral("etag")).isNull());
+        QTest::qWait(5);
+
+        // Makes room for more than one thumbnail at once
+        cache.insert(QStringLiteral("5"), QStringLiteral("etag"), data);
+        QVERIFY(cache.contains(QStringLiteral("0"), QStringLiteral("etag")));
+        QVERIFY(!cache.contains(QStringLiteral("1"), QStringLiteral("etag")));
+        QVERIFY(!cache.contains(QStringLiteral("2"), QStringLiteral("etag")));
+        for (int i = 3; i <= 5; ++i) {
+            QVERIFY(cache.contains(QString::number(i), QStringLiteral("etag")));
+        }
+    }
+
+    void testLazyThumbnail()
+    {
+        const QByteArray data = encodedImage(8, Qt::yellow);
+        QVariantMap thumbnail;
+        thumbnail[QStringLiteral("image")] = data.toBase64();
+        thumbnail[QStringLiteral("mimeType")] = QStringLiteral("image/png");
+        QVariantMap map;
+        map[QStringLiteral("kind")] = QStringLiteral("drive#file");
+        map[QStringLiteral("id")] = QStringLiteral("file");
+        map[QStringLiteral("thumbnail")] = thumbnail;
+
+        const FilePtr file = File::fromJSON(QJsonDocument::fromVariant(map).toJson());
+        QVERIFY(file);
+        QCOMPARE(file->thumbnail()->imageData(), data);
+        QCOMPARE(file->thumbnail()->image().size(), QSize(8, 8));
+
+        // Still the received bytes after decoding, not the image encoded again
+        QCOMPARE(file->thumbnail()->imageData(), data);
+        QCOMPARE(file->thumbnail()->image().pixelColor(0, 0), QColor(Qt::yellow));
+    }
+
+    void testUndecodableThumbnail()
+    {
+        // Qt may not be able to read the format, the data is kept anyway
+        const QByteArray data("<svg xmlns=\"http://www.w3.org/2000/svg\"/>");
+        QVariantMap thumbnail;
+        thumbnail[QStringLiteral("image")] = data.toBase64();
+        thumbnail[QStringLiteral("mimeType")] = QStringLiteral("image/svg+xml");
+        QVariantMap map;
+        map[QStringLiteral("kind")] = QStringLiteral("drive#file");
+        map[QStringLiteral("id")] = QStringLiteral("file");
+        map[QStringLiteral("thumbnail")] = thumbnail;
+
+        const FilePtr file = File::fromJSON(QJsonDocument::fromVariant(map).toJson());
+        QVERIFY(file);
+        file->thumbnail()->image();
+        QCOMPARE(file->thumbnail()->imageData(), data);
+    }
+};
+
+QTEST_GUILESS_MAIN(ThumbnailCacheTest)
+
+#include "thumbnailcachetest.moc"
@@ -0,0 +1,163 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <QBuffer>
+#include <QJsonDocument>
+#include <QObject>
+#include <QSignalSpy>
+#include <QTest>
+
+#include "account.h"
+#include "file.h"
+#include "thumbnailcache.h"
+#include "thumbnailfetchjob.h"
+
+#include "../core/fakenetwork.h"
+
+using namespace KMGraph2;
+using namespace KMGraph2::OneDrive;
+
+namespace {
+
+QByteArray encodedImage(const QColor &color)
+{
+    QImage image(8, 8, QImage::Format_RGB32);
+    image.fill(color);
+
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "PNG");
+    return data;
+}
+
+QUrl thumbnailLink(int file)
+{
+    return QUrl(QStringLiteral("https://graph.example/thumbnails/%1").arg(file));
+}
+
+// Files 1 to count, each with a link to its thumbnail
+FilesList files(int count)
+{
+    FilesList result;
+    for (int i = 1; i <= count; ++i) {
+        QVariantMap map;
+        map[QStringLiteral("kind")] = QStringLiteral("drive#file");
+        map[QStringLiteral("id")] = QString::number(i);
+        map[QStringLiteral("etag")] = QStringLiteral("etag");
+        map[QStringLiteral("thumbnailLink")] = thumbnailLink(i);
+        result << File::fromJSON(QJsonDocument::fromVariant(map).toJson());
+    }
+    return result;
+}
+
+// Every test gets its own account, and so its own circuit breaker
+AccountPtr testAccount()
+{
+    return AccountPtr(new Account(QString::fromLatin1(QTest::currentTestFunction()), QStringLiteral("token")));
+}
+
+}
+
+class ThumbnailFetchJobTest: public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testFailuresSkipped()
+    {
+        FakeNetwork network;
+        network.setResponder([](FakeReply *reply) {
+            if (reply->url() == thumbnailLink(2)) {
+                reply->respond(403, "{ \"error\": { \"message\": \"Forbidden\" } }");
+            } else if (reply->url() == thumbnailLink(3)) {
+                reply->respond(404, "{ \"error\": { \"message\": \"Not found\" } }");
+            } else if (reply->url() == thumbnailLink(4)) {
+                reply->fail(QNetworkReply::HostNotFoundError);
+            } else {
+                reply->respond(200, encodedImage(Qt::red));
+            }
+        });
+
+        ThumbnailFetchJob job(files(6), testAccount());
+        job.setCache(ThumbnailCachePtr(new ThumbnailCache(QString())));
+        job.setMaxConcurrentRequests(2);
+        RetryPolicy policy;
+        policy.setMaxAttempts(1);
+        job.setRetryPolicy(policy);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        // Only the failed thumbnails are missing
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(network.count(), 6);
+        QStringList ids = job.thumbnails().keys();
+        ids.sort();
+        QCOMPARE(ids, QStringList() << QStringLiteral("1") << QStringLiteral("5") << QStringLiteral("6"));
+        QCOMPARE(job.thumbnail(QStringLiteral("5")).pixelColor(0, 0), QColor(Qt::red));
+    }
+
+    void testWaitsForPendingReplies()
+    {
+        // Replies are sent by the test
+        FakeNetwork network;
+
+        ThumbnailFetchJob job(files(3), testAccount());
+        job.setCache(ThumbnailCachePtr(new ThumbnailCache(QString())));
+        job.setMaxConcurrentRequests(3);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(network.count(), 3);
+
+        // The queue is empty, but the job must not finish before the replies came
+        network.reply(2)->respond(200, encodedImage(Qt::green));
+        network.reply(0)->respond(200, encodedImage(Qt::green));
+        QTest::qWait(50);
+        QCOMPARE(spy.count(), 0);
+        QCOMPARE(job.thumbnails().count(), 2);
+
+        network.reply(1)->respond(200, encodedImage(Qt::blue));
+        QTRY_COMPARE(spy.count(), 1);
+        QCOMPARE(job.error(), KMGraph2::NoError);
+        QCOMPARE(job.thumbnail(QStringLiteral("2")).pixelColor(0, 0), QColor(Qt::blue));
+    }
+
+    void testCacheUsed()
+    {
+        FakeNetwork network;
+        network.setResponder([](FakeReply *reply) { reply->respond(200, encodedImage(Qt::red)); });
+
+        const ThumbnailCachePtr cache(new ThumbnailCache(QString()));
+        cache->insert(QStringLiteral("1"), QStringLiteral("etag"), encodedImage(Qt::yellow));
+
+        ThumbnailFetchJob job(files(2), testAccount());
+        job.setCache(cache);
+        QSignalSpy spy(&job, &Job::finished);
+        QTRY_COMPARE(spy.count(), 1);
+
+        QCOMPARE(network.urls(), QList<QUrl>() << thumbnailLink(2));
+        QCOMPARE(job.thumbnail(QStringLiteral("1")).pixelColor(0, 0), QColor(Qt::yellow));
+        QVERIFY(cache->contains(QStringLiteral("2"), QStringLiteral("etag")));
+    }
+};
+
+QTEST_GUILESS_MAIN(ThumbnailFetchJobTest)
+
+#include "thumbnailfetchjobtest.moc"
@@ -19,8 +19,10 @@
 */
 
 #include "account.h"
+#include "tokenprovider.h"
 
 #include <QDateTime>
+#include <QPointer>
 
 using namespace KMGraph2;
 
@@ -35,6 +37,7 @@ class Q_DECL_HIDDEN Account::Private
     QString refreshToken;
     QDateTime expireDateTime;
     QList< QUrl > scopes;
+    QPointer<TokenProvider> tokenProvider;
 };
 
 Account::Private::Private()
@@ -47,7 +50,8 @@ Account::Private::Private(const Private& other):
     accessToken(other.accessToken),
     refreshToken(other.refreshToken),
     expireDateTime(other.expireDateTime),
-    scopes(other.scopes)
+    scopes(other.scopes),
+    tokenProvider(other.tokenProvider)
 { }
 
 
@@ -127,3 +131,13 @@ void Account::setExpireDateTime(const QDateTime &expire)
 {
     d->expireDateTime = expire;
 }
+
+TokenProvider *Account::tokenProvider() const
+{
+    return d->tokenProvider;
+}
+
+void Account::setTokenProvider(TokenProvider *provider)
+{
+    d->tokenProvider = provider;
+}
@@ -32,6 +32,8 @@
 namespace KMGraph2
 {
 
+class TokenProvider;
+
 /**
  * @headerfile Account
  * @brief A Microsoft account
@@ -143,6 +145,19 @@ class KMGRAPHCORE_EXPORT Account
      */
     void setExpireDateTime(const QDateTime &expire);
 
+    /**
+     * Returns provider used to obtain new tokens when the access token
+     * expires, or a null pointer when the tokens can't be refreshed.
+     */
+    TokenProvider *tokenProvider() const;
+
+    /**
+     * Sets provider used to obtain new tokens when the access token
+     * expires. The account does not take ownership of the @p provider.
+     * @see TokenProvider
+     */
+    void setTokenProvider(TokenProvider *provider);
+
 private:
     class Private;
     Private * const d;
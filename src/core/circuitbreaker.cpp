@@ -0,0 +1,325 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "circuitbreaker.h"
+#include "../debug.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPair>
+#include <QThreadStorage>
+#include <QTimer>
+#include <QVector>
+
+#include <algorithm>
+
+using namespace KMGraph2;
+
+namespace {
+
+CircuitBreaker::Settings sDefaultSettings;
+
+// Breakers kept per thread before closed ones are dropped
+const int MaxInstances = 64;
+
+struct Registry
+{
+    struct Entry {
+        CircuitBreaker *breaker = nullptr;
+        quint64 lastUse = 0;
+    };
+
+    ~Registry()
+    {
+        for (const Entry &entry : qAsConst(entries)) {
+            delete entry.breaker;
+        }
+    }
+
+    QHash<QString, Entry> entries;
+    quint64 uses = 0;
+};
+
+}
+
+class Q_DECL_HIDDEN CircuitBreaker::Private
+{
+  public:
+    Private(CircuitBreaker *parent);
+
+    void record(bool failed, quint64 probe);
+    void setState(State newState);
+    void clearWindow();
+    void expireProbes();
+
+    Settings settings;
+    State state;
+
+    // Outcomes of recent requests, true for failures
+    QVector<bool> window;
+    int next;
+    int failures;
+
+    QTimer *openTimer;
+    // Probes sent while half-open and when they were sent
+    QHash<quint64, qint64> probes;
+    quint64 nextProbe;
+    QElapsedTimer clock;
+
+  private:
+    CircuitBreaker * const q;
+};
+
+CircuitBreaker::Private::Private(CircuitBreaker *parent):
+    state(Closed),
+    next(0),
+    failures(0),
+    openTimer(nullptr),
+    nextProbe(0),
+    q(parent)
+{
+    clock.start();
+}
+
+void CircuitBreaker::Private::record(bool failed, quint64 probe)
+{
+    if (state == HalfOpen) {
+        // Only probes tell whether the service has recovered, not late
+        // replies to requests sent before the circuit opened
+        if (probe != 0 && probes.remove(probe) > 0) {
+            setState(failed ? Open : Closed);
+        }
+        return;
+    }
+
+    // Late replies to requests sent before the circuit opened
+    if (state == Open) {
+        return;
+    }
+
+    const int windowSize = qMax(1, settings.windowSize);
+    if (window.size() < windowSize) {
+        window.append(failed);
+    } else {
+        failures -= window.at(next) ? 1 : 0;
+        window[next] = failed;
+    }
+    next = (next + 1) % windowSize;
+    failures += failed ? 1 : 0;
+
+    if (window.size() >= settings.minimumRequests
+            && failures >= settings.failureRate * window.size()) {
+        qCWarning(KMGraphDebug) << q->objectName() << ":" << failures << "of" << window.size()
+                                << "recent requests failed, opening circuit";
+        setState(Open);
+    }
+}
+
+void CircuitBreaker::Private::setState(State newState)
+{
+    if (state == newState) {
+        if (newState == Open) {
+            openTimer->start(settings.openDuration);
+        }
+        return;
+    }
+
+    state = newState;
+    clearWindow();
+    probes.clear();
+
+    if (state == Open) {
+        openTimer->start(settings.openDuration);
+    } else {
+        openTimer->stop();
+    }
+
+    qCDebug(KMGraphDebug) << q->objectName() << "circuit is now" << state;
+    Q_EMIT q->stateChanged(state);
+}
+
+void CircuitBreaker::Private::clearWindow()
+{
+    window.clear();
+    next = 0;
+    failures = 0;
+}
+
+void CircuitBreaker::Private::expireProbes()
+{
+    // A probe whose outcome was never reported must not block the circuit forever
+    const qint64 now = clock.elapsed();
+    for (auto it = probes.begin(); it != probes.end();) {
+        if (now - it.value() > settings.openDuration) {
+            it = probes.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+CircuitBreaker::CircuitBreaker(const Settings &settings, QObject *parent):
+    QObject(parent),
+    d(new Private(this))
+{
+    d->settings = settings;
+    d->openTimer = new QTimer(this);
+    d->openTimer->setSingleShot(true);
+    connect(d->openTimer, &QTimer::timeout,
+            this, [this]() { d->setState(HalfOpen); });
+}
+
+CircuitBreaker::~CircuitBreaker()
+{
+    delete d;
+}
+
+CircuitBreaker *CircuitBreaker::instance(const QString &accountName, const QByteArray &endpointClass)
+{
+    static QThreadStorage<Registry> registries;
+
+    const QString key = accountName + QLatin1Char('/') + QLatin1String(endpointClass);
+    Registry &registry = registries.localData();
+    Registry::Entry &entry = registry.entries[key];
+    entry.lastUse = ++registry.uses;
+    if (entry.breaker) {
+        return entry.breaker;
+    }
+
+    CircuitBreaker *breaker = new CircuitBreaker;
+    breaker->setObjectName(key);
+    entry.breaker = breaker;
+    if (registry.entries.size() <= MaxInstances) {
+        return breaker;
+    }
+
+    // A closed breaker has nothing to remember but a few recent outcomes,
+    // breakers of accounts and jobs that are no longer used are dropped
+    QVector<QPair<quint64, QString> > closed;
+    for (auto it = registry.entries.constBegin(), end = registry.entries.constEnd(); it != end; ++it) {
+        if (it->breaker != breaker && it->breaker->state() == Closed) {
+            closed.append(qMakePair(it->lastUse, it.key()));
+        }
+    }
+    std::sort(closed.begin(), closed.end());
+    const int excess = qMin(registry.entries.size() - MaxInstances, closed.size());
+    for (int i = 0; i < excess; ++i) {
+        delete registry.entries.take(closed.at(i).second).breaker;
+    }
+    return breaker;
+}
+
+void CircuitBreaker::setDefaultSettings(const Settings &settings)
+{
+    sDefaultSettings = settings;
+}
+
+CircuitBreaker::Settings CircuitBreaker::defaultSettings()
+{
+    return sDefaultSettings;
+}
+
+void CircuitBreaker::setSettings(const Settings &settings)
+{
+    d->settings = settings;
+    d->clearWindow();
+}
+
+CircuitBreaker::Settings CircuitBreaker::settings() const
+{
+    return d->settings;
+}
+
+CircuitBreaker::State CircuitBreaker::state() const
+{
+    return d->state;
+}
+
+bool CircuitBreaker::allowRequest(quint64 *probe)
+{
+    if (probe) {
+        *probe = 0;
+    }
+
+    switch (d->state) {
+    case Closed:
+        return true;
+    case Open:
+        return false;
+    case HalfOpen:
+        if (!probe) {
+            return false;
+        }
+        d->expireProbes();
+        if (d->probes.size() < d->settings.maxProbes) {
+            *probe = ++d->nextProbe;
+            d->probes.insert(*probe, d->clock.elapsed());
+            return true;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+int CircuitBreaker::retryAfter() const
+{
+    switch (d->state) {
+    case Closed:
+        return 0;
+    case Open:
+        return qMax(0, d->openTimer->remainingTime());
+    case HalfOpen: {
+        if (d->probes.size() < d->settings.maxProbes) {
+            return 0;
+        }
+        // A slot frees up when the oldest probe expires at the latest
+        qint64 oldest = d->clock.elapsed();
+        for (const qint64 sent : qAsConst(d->probes)) {
+            oldest = qMin(oldest, sent);
+        }
+        return int(qMax<qint64>(0, d->settings.openDuration - (d->clock.elapsed() - oldest)));
+    }
+    }
+
+    return 0;
+}
+
+void CircuitBreaker::recordSuccess(quint64 probe)
+{
+    d->record(false, probe);
+}
+
+void CircuitBreaker::recordFailure(quint64 probe)
+{
+    d->record(true, probe);
+}
+
+void CircuitBreaker::releaseProbe(quint64 probe)
+{
+    d->probes.remove(probe);
+}
+
+void CircuitBreaker::reset()
+{
+    d->setState(Closed);
+    d->clearWindow();
+}
@@ -0,0 +1,139 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBKMGRAPH2_CIRCUITBREAKER_H
+#define LIBKMGRAPH2_CIRCUITBREAKER_H
+
+#include "kmgraphcore_export.h"
+
+#include <QObject>
+
+namespace KMGraph2
+{
+
+/**
+ * @headerfile CircuitBreaker
+ * @brief Stops sending requests to an endpoint that keeps failing
+ *
+ * Jobs report the outcome of every request to the breaker of their account
+ * and endpoint class, which is the type of the job. When too many of the
+ * recent requests have failed (server errors, throttling, network failures
+ * or timeouts), the circuit opens: jobs stop sending requests and wait until
+ * it closes again, or fail with KMGraph2::CircuitOpen when Job::failFast is
+ * set. After Settings::openDuration the circuit becomes half-open and lets
+ * a limited number of probe requests through. A successful probe closes the
+ * circuit, a failed one opens it again. Outcomes of other requests, sent
+ * before the circuit opened, are ignored until then.
+ *
+ * Every thread has its own set of breakers.
+ */
+class KMGRAPHCORE_EXPORT CircuitBreaker : public QObject
+{
+    Q_OBJECT
+
+  public:
+    enum State {
+        Closed,    ///< Requests are sent normally
+        Open,      ///< Requests are not sent
+        HalfOpen   ///< Only probe requests are sent
+    };
+    Q_ENUM(State)
+
+    struct Settings {
+        qreal failureRate = 0.5;      ///< Fraction of failed requests that opens the circuit
+        int minimumRequests = 10;     ///< Requests in window before the rate is considered
+        int windowSize = 20;          ///< Number of recent requests the rate is computed from
+        int openDuration = 30 * 1000; ///< How long (in msecs) the circuit stays open
+        int maxProbes = 1;            ///< Concurrent requests allowed when half-open
+    };
+
+    explicit CircuitBreaker(const Settings &settings = defaultSettings(), QObject *parent = nullptr);
+    ~CircuitBreaker() override;
+
+    /**
+     * @brief Returns the breaker for requests of @p endpointClass sent on behalf
+     *        of @p accountName, created with defaultSettings().
+     *
+     * The breakers are owned by the thread and deleted when it finishes. Once
+     * a thread has more than 64 of them, the least recently used closed ones
+     * are deleted, so hold the returned pointer in a QPointer and ask again
+     * when it has been cleared.
+     */
+    static CircuitBreaker *instance(const QString &accountName, const QByteArray &endpointClass);
+
+    /**
+     * @brief Sets settings of breakers created from now on.
+     */
+    static void setDefaultSettings(const Settings &settings);
+    static Settings defaultSettings();
+
+    void setSettings(const Settings &settings);
+    Settings settings() const;
+
+    State state() const;
+
+    /**
+     * @brief Returns whether a request may be sent now
+     *
+     * When half-open, a successful call takes one of the probe slots and
+     * stores its ID in @p probe. The caller must pass the ID to
+     * recordSuccess() or recordFailure() with the outcome, or to
+     * releaseProbe() when the request is cancelled. Callers that do not
+     * ask for a @p probe are only let through while closed.
+     */
+    bool allowRequest(quint64 *probe = nullptr);
+
+    /**
+     * @brief Returns in how many milliseconds allowRequest() may succeed again.
+     */
+    int retryAfter() const;
+
+    /**
+     * @brief Records outcome of a request
+     *
+     * @p probe is the ID returned by allowRequest(), or 0 for requests sent
+     * while the circuit was closed.
+     */
+    void recordSuccess(quint64 probe = 0);
+    void recordFailure(quint64 probe = 0);
+
+    /**
+     * @brief Frees slot of a probe whose outcome will never be known.
+     */
+    void releaseProbe(quint64 probe);
+
+    /**
+     * @brief Closes the circuit and forgets all recorded outcomes.
+     */
+    void reset();
+
+  Q_SIGNALS:
+    void stateChanged(KMGraph2::CircuitBreaker::State state);
+
+  private:
+    class Private;
+    Private * const d;
+    friend class Private;
+};
+
+} // namespace KMGraph2
+
+#endif // LIBKMGRAPH2_CIRCUITBREAKER_H
@@ -0,0 +1,228 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "feedfetchjob.h"
+#include "account.h"
+#include "../debug.h"
+
+#include <QNetworkRequest>
+#include <QUrlQuery>
+
+using namespace KMGraph2;
+
+// Largest page the server is willing to return
+static const int MaxPageSize = 1000;
+
+class Q_DECL_HIDDEN FeedFetchJob::Private
+{
+  public:
+    Private();
+
+    QUrl pageUrl(const QUrl &url) const;
+
+    int pageSize;
+    int maxItems;
+    int fetchedItemsCount;
+    bool wholePages;
+    StopCondition stopCondition;
+};
+
+FeedFetchJob::Private::Private():
+    pageSize(0),
+    maxItems(0),
+    fetchedItemsCount(0),
+    wholePages(false)
+{
+}
+
+QUrl FeedFetchJob::Private::pageUrl(const QUrl &url) const
+{
+    int size = pageSize;
+    if (maxItems > 0) {
+        const int remaining = maxItems - fetchedItemsCount;
+        if (size <= 0 || remaining < size) {
+            size = qMin(remaining, MaxPageSize);
+        }
+    }
+    if (size <= 0) {
+        return url;
+    }
+
+    // Next links repeat the page size of the previous request, so the last
+    // page has to be shrunk explicitly
+    QUrlQuery query(url);
+    const int currentSize = query.queryItemValue(QStringLiteral("maxResults")).toInt();
+    if (currentSize > 0 && currentSize <= size) {
+        return url;
+    }
+
+    query.removeAllQueryItems(QStringLiteral("maxResults"));
+    query.addQueryItem(QStringLiteral("maxResults"), QString::number(size));
+
+    QUrl result(url);
+    result.setQuery(query);
+    return result;
+}
+
+FeedFetchJob::FeedFetchJob(const AccountPtr &account, QObject *parent):
+    FetchJob(account, parent),
+    d(new Private)
+{
+}
+
+FeedFetchJob::~FeedFetchJob()
+{
+    delete d;
+}
+
+int FeedFetchJob::pageSize() const
+{
+    return d->pageSize;
+}
+
+void FeedFetchJob::setPageSize(int pageSize)
+{
+    if (isRunning()) {
+        qCWarning(KMGraphDebug) << "Can't modify pageSize property when job is running";
+        return;
+    }
+
+    d->pageSize = pageSize;
+}
+
+int FeedFetchJob::maxItems() const
+{
+    return d->maxItems;
+}
+
+void FeedFetchJob::setMaxItems(int maxItems)
+{
+    if (isRunning()) {
+        qCWarning(KMGraphDebug) << "Can't modify maxItems property when job is running";
+        return;
+    }
+
+    d->maxItems = maxItems;
+}
+
+void FeedFetchJob::setStopCondition(const StopCondition &condition)
+{
+    if (isRunning()) {
+        qCWarning(KMGraphDebug) << "Can't modify stopCondition property when job is running";
+        return;
+    }
+
+    d->stopCondition = condition;
+}
+
+FeedFetchJob::StopCondition FeedFetchJob::stopCondition() const
+{
+    return d->stopCondition;
+}
+
+int FeedFetchJob::fetchedItemsCount() const
+{
+    return d->fetchedItemsCount;
+}
+
+void FeedFetchJob::addFetchedItemsCount(int count)
+{
+    d->fetchedItemsCount += count;
+}
+
+void FeedFetchJob::setWholePages(bool wholePages)
+{
+    d->wholePages = wholePages;
+}
+
+bool FeedFetchJob::wholePages() const
+{
+    return d->wholePages;
+}
+
+QNetworkRequest FeedFetchJob::createRequest(const QUrl &url) const
+{
+    QNetworkRequest request(url);
+    request.setRawHeader("Authorization", "Bearer " + account()->accessToken().toLatin1());
+
+    return request;
+}
+
+void FeedFetchJob::enqueueFeedRequest(const QUrl &url)
+{
+    enqueueRequest(createRequest(d->pageUrl(url)));
+}
+
+void FeedFetchJob::aboutToStart()
+{
+    d->fetchedItemsCount = 0;
+
+    FetchJob::aboutToStart();
+}
+
+ObjectsList FeedFetchJob::handleReplyWithItems(const QNetworkReply *reply,
+                                               const QByteArray &rawData)
+{
+    FeedData feedData;
+    ObjectsList items = handleFeedReply(reply, rawData, feedData);
+
+    bool stop = false;
+    if (d->stopCondition) {
+        for (int i = 0; i < items.count(); ++i) {
+            if (d->stopCondition(items.at(i))) {
+                if (!d->wholePages) {
+                    items = items.mid(0, i + 1);
+                }
+                stop = true;
+                break;
+            }
+        }
+    }
+    if (d->maxItems > 0) {
+        const int remaining = qMax(0, d->maxItems - d->fetchedItemsCount);
+        if (items.count() > remaining) {
+            if (d->wholePages) {
+                // Callers resume after the last item they got, so dropping
+                // items from the middle of the feed would lose them for good
+                qCDebug(KMGraphDebug) << "Page has" << items.count() - remaining
+                                      << "items over the limit, keeping the whole page";
+            } else {
+                items = items.mid(0, remaining);
+            }
+        }
+    }
+    d->fetchedItemsCount += items.count();
+    if (d->maxItems > 0 && d->fetchedItemsCount >= d->maxItems) {
+        stop = true;
+    }
+
+    // The reply handler might have terminated the job
+    if (!isRunning() || !feedData.nextPageUrl.isValid()) {
+        return items;
+    }
+
+    if (stop) {
+        qCDebug(KMGraphDebug) << "Received" << d->fetchedItemsCount << "items, not fetching next page";
+    } else {
+        enqueueRequest(createRequest(d->pageUrl(feedData.nextPageUrl)));
+    }
+
+    return items;
+}
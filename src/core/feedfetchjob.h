@@ -0,0 +1,195 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBKMGRAPH2_FEEDFETCHJOB_H
+#define LIBKMGRAPH2_FEEDFETCHJOB_H
+
+#include "fetchjob.h"
+#include "kmgraphcore_export.h"
+
+#include <functional>
+
+namespace KMGraph2 {
+
+/**
+ * @headerfile FeedFetchJob
+ * @brief Abstract superclass for jobs that list resources in paginated feeds
+ *
+ * Microsoft Graph returns long listings in pages, each one linking to the
+ * next. FeedFetchJob follows these links until the feed is exhausted, so
+ * subclasses only have to parse a single page. The number of items per
+ * page can be tuned with pageSize, trading the number of round-trips for
+ * size of the replies. maxItems and stopCondition stop fetching early once
+ * the caller has enough items, which saves bandwidth and latency when only
+ * the first few results are shown, e.g. in a type-ahead search.
+ */
+class KMGRAPHCORE_EXPORT FeedFetchJob : public KMGraph2::FetchJob
+{
+    Q_OBJECT
+
+    /**
+     * Maximum number of items the server should return in a single page.
+     *
+     * Default value is 0, i.e. the page size is chosen by the server.
+     *
+     * This property can be modified only when the job is not running.
+     */
+    Q_PROPERTY(int pageSize
+               READ pageSize
+               WRITE setPageSize)
+
+    /**
+     * Maximum number of items to fetch.
+     *
+     * Once the limit is reached, no further pages are requested and the
+     * remaining items of the current page are dropped. The page size of the
+     * last request is reduced so that the server does not send more items
+     * than needed. Jobs that only stop at page boundaries, like
+     * OneDrive::ChangeFetchJob, keep the whole page instead, so they may
+     * return a few more items when the server ignores the page size.
+     *
+     * Default value is 0, i.e. the whole feed is fetched.
+     *
+     * This property can be modified only when the job is not running.
+     */
+    Q_PROPERTY(int maxItems
+               READ maxItems
+               WRITE setMaxItems)
+
+  public:
+    /**
+     * @brief A predicate that is called for every received item
+     *
+     * Return true to stop the job after the item.
+     */
+    typedef std::function<bool(const ObjectPtr &)> StopCondition;
+
+    /**
+     * @brief Destructor
+     */
+    ~FeedFetchJob() override;
+
+    int pageSize() const;
+    void setPageSize(int pageSize);
+
+    int maxItems() const;
+    void setMaxItems(int maxItems);
+
+    /**
+     * @brief Sets a predicate that stops the job
+     *
+     * When @p condition returns true for an item, the item is still
+     * returned, but items that follow it are dropped and no further pages
+     * are requested. Jobs that only stop at page boundaries return the rest
+     * of the page as well. Items stored elsewhere than in items(), e.g. in
+     * a FileTable, are not passed to the predicate.
+     *
+     * Can be modified only when the job is not running.
+     */
+    void setStopCondition(const StopCondition &condition);
+    StopCondition stopCondition() const;
+
+    /**
+     * @brief Returns number of items received so far.
+     */
+    int fetchedItemsCount() const;
+
+  protected:
+    /**
+     * @brief Constructor
+     *
+     * @param account Account to use to authenticate the requests sent by this job
+     * @param parent
+     */
+    explicit FeedFetchJob(const KMGraph2::AccountPtr &account, QObject *parent = nullptr);
+
+    /**
+     * @brief Returns an authenticated GET request for @p url
+     */
+    QNetworkRequest createRequest(const QUrl &url) const;
+
+    /**
+     * @brief Enqueues request for the first page of a feed at @p url
+     *
+     * Adds the page size to @p url, reduced to maxItems when that is lower.
+     * Subclasses call this from their start() implementation.
+     */
+    void enqueueFeedRequest(const QUrl &url);
+
+    /**
+     * @brief Adds @p count to number of received items
+     *
+     * Items returned from handleFeedReply() are counted automatically. This
+     * is only needed by subclasses that store what they receive elsewhere,
+     * instead of returning it as items.
+     */
+    void addFetchedItemsCount(int count);
+
+    /**
+     * @brief Sets whether the job only stops at page boundaries
+     *
+     * maxItems and stopCondition normally drop the rest of the page they
+     * stop in. Feeds that are resumed from their last item, like a list of
+     * changes, must not lose items in the middle, so subclasses listing
+     * those enable this to always return whole pages.
+     *
+     * Default is false.
+     */
+    void setWholePages(bool wholePages);
+    bool wholePages() const;
+
+    /**
+     * @brief KMGraph::Job::aboutToStart implementation
+     */
+    void aboutToStart() override;
+
+    /**
+     * @brief KMGraph::FetchJob::handleReplyWithItems implementation
+     *
+     * Calls handleFeedReply() and enqueues request for the next page,
+     * unless the feed has ended, maxItems has been reached or stopCondition
+     * has matched.
+     */
+    ObjectsList handleReplyWithItems(const QNetworkReply *reply,
+                                     const QByteArray &rawData) override;
+
+    /**
+     * @brief Parses a single page of the feed
+     *
+     * @param reply A QNetworkReply received from the Microsoft Graph server
+     * @param rawData Content of body of the @p reply
+     * @param feedData Implementations store link to the next page here.
+     *        Leave it empty when @p reply does not contain a feed.
+     *
+     * @return Items parsed from @p rawData
+     */
+    virtual ObjectsList handleFeedReply(const QNetworkReply *reply,
+                                        const QByteArray &rawData,
+                                        FeedData &feedData) = 0;
+
+  private:
+    class Private;
+    Private * const d;
+    friend class Private;
+
+};
+} // namespace KMGraph2
+
+#endif // LIBKMGRAPH2_FEEDFETCHJOB_H
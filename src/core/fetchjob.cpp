@@ -83,6 +83,13 @@ void FetchJob::aboutToStart()
     Job::aboutToStart();
 }
 
+void FetchJob::aboutToAbort()
+{
+    d->items.clear();
+
+    Job::aboutToAbort();
+}
+
 ObjectsList FetchJob::handleReplyWithItems(const QNetworkReply* reply, const QByteArray& rawData)
 {
     Q_UNUSED(reply)
@@ -98,6 +98,11 @@ class KMGRAPHCORE_EXPORT FetchJob : public KMGraph2::Job
      */
     void aboutToStart() override;
 
+    /**
+     * @brief KMGraph::Job::aboutToAbort implementation
+     */
+    void aboutToAbort() override;
+
     /**
      * @brief A reply handler that returns items parsed from \@ rawData
      *
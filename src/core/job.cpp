@@ -23,6 +23,11 @@
 #include "job.h"
 #include "job_p.h"
 #include "account.h"
+#include "circuitbreaker.h"
+#include "latencytracker.h"
+#include "replyfactory.h"
+#include "requestcoalescer.h"
+#include "tokenprovider.h"
 
 #include "../debug.h"
 
@@ -31,12 +36,98 @@
 
 using namespace KMGraph2;
 
+namespace {
+
+// Failures that tell something about the health of the service, as opposed
+// to errors caused by the request itself
+bool isServiceFailure(const QNetworkReply *reply)
+{
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status != 0) {
+        return status >= 500 || status == 429;
+    }
+    return reply->error() != QNetworkReply::NoError
+        && reply->error() != QNetworkReply::OperationCanceledError;
+}
+
+// Requests that have the same effect no matter how often they are sent
+bool isIdempotent(QNetworkAccessManager::Operation op, const QNetworkRequest &request)
+{
+    switch (op) {
+    case QNetworkAccessManager::GetOperation:
+    case QNetworkAccessManager::HeadOperation:
+    case QNetworkAccessManager::PutOperation:
+    case QNetworkAccessManager::DeleteOperation:
+        return true;
+    case QNetworkAccessManager::CustomOperation: {
+        const QByteArray verb = request.attribute(QNetworkRequest::CustomVerbAttribute).toByteArray().toUpper();
+        return verb == "GET" || verb == "HEAD" || verb == "PUT" || verb == "DELETE";
+    }
+    default:
+        return false;
+    }
+}
+
+// The server has turned the request down without carrying it out
+bool isRejected(int statusCode)
+{
+    return statusCode == 429 || statusCode == KMGraph2::QuotaExceeded;
+}
+
+}
+
+
+JobAccessManager::JobAccessManager(QObject *parent):
+    KIO::Integration::AccessManager(parent),
+    mCoalescingEnabled(true)
+{
+}
+
+void JobAccessManager::setCoalescingEnabled(bool enabled)
+{
+    mCoalescingEnabled = enabled;
+}
+
+QNetworkReply *JobAccessManager::createRequest(Operation op, const QNetworkRequest &request,
+                                               QIODevice *outgoingData)
+{
+    const auto send = [&]() -> QNetworkReply* {
+        const ReplyFactory::Factory factory = ReplyFactory::factory();
+        if (factory) {
+            return factory(op, request, outgoingData);
+        }
+        return KIO::Integration::AccessManager::createRequest(op, request, outgoingData);
+    };
+
+    QNetworkReply *reply;
+    if (op == GetOperation && !outgoingData && mCoalescingEnabled) {
+        reply = RequestCoalescer::instance()->get(request, send, this);
+    } else {
+        reply = send();
+    }
+
+    Q_EMIT requestCreated(reply, op, request);
+    return reply;
+}
+
 
 Job::Private::Private(Job *parent):
     isRunning(false),
     error(KMGraph2::NoError),
     accessManager(nullptr),
     maxTimeout(0),
+    pendingReplies(0),
+    requestTimeout(DefaultRequestTimeout),
+    hedgingEnabled(false),
+    hedgingPercentile(95),
+    latencyTracker(nullptr),
+    hedgedReply(nullptr),
+    waitingForTokens(false),
+    tokensRefreshedAhead(false),
+    failFast(false),
+    currentProbe(0),
+    parkedOnCircuit(false),
+    circuitTimer(nullptr),
     q(parent)
 {
 }
@@ -45,13 +136,22 @@ void Job::Private::init()
 {
     QTimer::singleShot(0, q, [this]() { _k_doStart(); });
 
-    accessManager = new KIO::Integration::AccessManager(q);
+    accessManager = new JobAccessManager(q);
+    connect(accessManager, &JobAccessManager::requestCreated,
+            q, [this](QNetworkReply *reply, QNetworkAccessManager::Operation op, const QNetworkRequest &request) {
+                _k_requestCreated(reply, op, request);
+            });
     connect(accessManager, &KIO::AccessManager::finished,
             q, [this](QNetworkReply *reply) { _k_replyReceived(reply); });
 
     dispatchTimer = new QTimer(q);
     connect(dispatchTimer, &QTimer::timeout,
             q, [this]() { _k_dispatchTimeout(); });
+
+    circuitTimer = new QTimer(q);
+    circuitTimer->setSingleShot(true);
+    connect(circuitTimer, &QTimer::timeout,
+            q, [this]() { _k_circuitChanged(); });
 }
 
 QString Job::Private::parseErrorMessage(const QByteArray &json)
@@ -80,6 +180,15 @@ QString Job::Private::parseErrorMessage(const QByteArray &json)
 
 void Job::Private::_k_doStart()
 {
+    // Subclasses of the same type share their latency statistics
+    if (!latencyTracker) {
+        latencyTracker = LatencyTracker::instance(q->metaObject()->className());
+    }
+
+    // The account may have changed since the last run
+    circuitBreaker = CircuitBreaker::instance(account ? account->accountName() : QString(),
+                                              q->metaObject()->className());
+
     isRunning = true;
     q->aboutToStart();
     q->start();
@@ -92,6 +201,37 @@ void Job::Private::_k_doEmitFinished()
 
 void Job::Private::_k_replyReceived(QNetworkReply* reply)
 {
+    // Replies aborted by the job have already been accounted for
+    if (abandonedReplies.remove(reply)) {
+        return;
+    }
+
+    // A reply that did not announce its headers still wins over its hedged twin
+    _k_replyResponded(reply);
+    const InFlightRequest info = releaseReply(reply);
+    Request request = info.request;
+    if (request.request.url().isEmpty()) {
+        request.request = reply->request();
+    }
+
+    pendingReplies = qMax(0, pendingReplies - 1);
+
+    // Every job sharing a request gets its reply, but the service has only seen one
+    if (!RequestCoalescer::isDuplicate(reply)) {
+        if (isServiceFailure(reply)) {
+            breaker()->recordFailure(info.probe);
+        } else {
+            breaker()->recordSuccess(info.probe);
+        }
+    } else if (info.probe) {
+        breaker()->releaseProbe(info.probe);
+    }
+
+    // A reply to a request that was sent before the job has finished
+    if (!isRunning) {
+        return;
+    }
+
     int replyCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
     if (replyCode == 0) {
 
@@ -110,6 +250,33 @@ void Job::Private::_k_replyReceived(QNetworkReply* reply)
     qCDebug(KMGraphDebug) << "Status code: " << replyCode;
     qCDebug(KMGraphRaw) << rawData;
 
+    QNetworkReply::NetworkError networkError = reply->error();
+    if (networkError == QNetworkReply::OperationCanceledError) {
+        // Replies aborted by the job never get here, somebody else has cancelled
+        // the request, e.g. the job that sent a shared request has gone away
+        networkError = QNetworkReply::TemporaryNetworkFailureError;
+    }
+
+    if (retryPolicy.isRetryable(replyCode, networkError)) {
+        // Honour the server's wish, if it has any
+        const int retryAfter = reply->rawHeader("Retry-After").toInt() * 1000;
+        const bool waitTooLong = maxTimeout > 0 && retryAfter > maxTimeout * 1000;
+        if (!waitTooLong && mayRetry(info, replyCode) && scheduleRetry(request, retryAfter)) {
+            qCWarning(KMGraphDebug) << "Transient failure" << replyCode << reply->errorString()
+                                    << "- retrying request to" << request.request.url();
+            return;
+        }
+    }
+
+    // Without a status there is no reply to handle
+    if (replyCode == 0 && networkError != QNetworkReply::NoError) {
+        qCWarning(KMGraphDebug) << "Network error" << reply->error() << reply->errorString();
+        q->setError(KMGraph2::NetworkError);
+        q->setErrorString(tr("Network error: %1").arg(reply->errorString()));
+        failRequest(reply);
+        return;
+    }
+
     switch (replyCode) {
         case KMGraph2::NoError:
         case KMGraph2::OK:           /** << OK status (fetched, updated, removed) */
@@ -129,10 +296,19 @@ void Job::Private::_k_replyReceived(QNetworkReply* reply)
             qCWarning(KMGraphDebug) << "Bad request, Microsoft Graph replied '" << rawData << "'";
             q->setError(KMGraph2::BadRequest);
             q->setErrorString(tr("Bad request."));
-            q->emitFinished();
+            failRequest(reply);
             return;
 
         case KMGraph2::Unauthorized: /** << Unauthorized - Access token has expired, request a new token */
+            if (!request.authReplayed && account && account->tokenProvider()) {
+                qCDebug(KMGraphDebug) << "Access token rejected, replaying request with new tokens.";
+                Request replay = request;
+                replay.authReplayed = true;
+                requestQueue.prepend(replay);
+                waitForTokens();
+                return;
+            }
+
             qCWarning(KMGraphDebug) << "Unauthorized. Access token has expired or is invalid.";
             q->setError(KMGraph2::Unauthorized);
             q->setErrorString(tr("Invalid authentication."));
@@ -145,7 +321,7 @@ void Job::Private::_k_replyReceived(QNetworkReply* reply)
             const QString msg = parseErrorMessage(rawData);
             q->setError(KMGraph2::Forbidden);
             q->setErrorString(tr("Requested resource is forbidden.\n\nMicrosoft Graph replied '%1'").arg(msg));
-            q->emitFinished();
+            failRequest(reply);
             return;
         }
 
@@ -159,7 +335,7 @@ void Job::Private::_k_replyReceived(QNetworkReply* reply)
             // in that case 404 is not fatal. Let subclass decide whether to terminate or not.
             q->handleReply(reply, rawData);
 
-            if (requestQueue.isEmpty()) {
+            if (q->isRunning() && isIdle()) {
                 q->emitFinished();
             }
             return;
@@ -171,7 +347,7 @@ void Job::Private::_k_replyReceived(QNetworkReply* reply)
             const QString msg = parseErrorMessage(rawData);
             q->setError(KMGraph2::Conflict);
             q->setErrorString(tr("Conflict. Remote resource is newer than local.\n\nMicrosoft Graph replied '%1'").arg(msg));
-            q->emitFinished();
+            failRequest(reply);
             return;
         }
 
@@ -181,7 +357,7 @@ void Job::Private::_k_replyReceived(QNetworkReply* reply)
             const QString msg = parseErrorMessage(rawData);
             q->setError(KMGraph2::Gone);
             q->setErrorString(tr("Requested resource does not exist anymore.\n\nMicrosoft Graph replied '%1'").arg(msg));
-            q->emitFinished();
+            failRequest(reply);
             return;
         }
 
@@ -191,37 +367,19 @@ void Job::Private::_k_replyReceived(QNetworkReply* reply)
             const QString msg = parseErrorMessage(rawData);
             q->setError(KMGraph2::InternalError);
             q->setErrorString(tr("Internal server error. Try again later.\n\nMicrosoft Graph replied '%1'").arg(msg));
-            q->emitFinished();
+            failRequest(reply);
             return;
         }
 
+        case KMGraph2::TooManyRequests:
         case KMGraph2::QuotaExceeded: {
+            // Retries are exhausted, or the server wants us to wait too long
             qCWarning(KMGraphDebug) << "User quota exceeded.";
             qCDebug(KMGraphRaw) << rawData;
-
-            // Extend the interval (if possible) and enqueue the request again
-            int interval = dispatchTimer->interval() / 1000;
-            if (interval == 0) {
-                interval = 1;
-            } else if (interval == 1) {
-                interval = 2;
-            } else if ((interval > maxTimeout) && (maxTimeout > 0)) {
-                const QString msg = parseErrorMessage(rawData);
-                q->setError(KMGraph2::QuotaExceeded);
-                q->setErrorString(tr("Maximum quota exceeded. Try again later.\n\nMicrosoft Graph replied '%1'").arg(msg));
-                q->emitFinished();
-                return;
-            } else {
-                interval = interval ^ 2;
-            }
-            qCDebug(KMGraphDebug) << "Increasing dispatch interval to" << interval * 1000 << "msecs";
-            dispatchTimer->setInterval(interval * 1000);
-
-            const QNetworkRequest request = reply->request();
-            q->enqueueRequest(request);
-            if (!dispatchTimer->isActive()) {
-                dispatchTimer->start();
-            }
+            const QString msg = parseErrorMessage(rawData);
+            q->setError(KMGraph2::QuotaExceeded);
+            q->setErrorString(tr("Maximum quota exceeded. Try again later.\n\nMicrosoft Graph replied '%1'").arg(msg));
+            q->emitFinished();
             return;
         }
 
@@ -231,7 +389,7 @@ void Job::Private::_k_replyReceived(QNetworkReply* reply)
             const QString msg = parseErrorMessage(rawData);
             q->setError(KMGraph2::UnknownError);
             q->setErrorString(tr("Unknown error.\n\nMicrosoft Graph replied '%1'").arg(msg));
-            q->emitFinished();
+            failRequest(reply);
             return;
         }
     }
@@ -245,13 +403,14 @@ void Job::Private::_k_replyReceived(QNetworkReply* reply)
 
     qCDebug(KMGraphDebug) << requestQueue.length() << "requests in requestQueue.";
     if (requestQueue.isEmpty()) {
-        q->emitFinished();
+        // Don't finish while there are still other requests on the way
+        if (isIdle()) {
+            q->emitFinished();
+        }
         return;
     }
 
-    if (!dispatchTimer->isActive()) {
-        dispatchTimer->start();
-    }
+    scheduleDispatch();
 }
 
 void Job::Private::_k_dispatchTimeout()
@@ -261,17 +420,450 @@ void Job::Private::_k_dispatchTimeout()
         return;
     }
 
-    const Request r = requestQueue.dequeue();
+    if (waitingForTokens) {
+        dispatchTimer->stop();
+        return;
+    }
+
+    // Better refresh ahead of time than waste a request on a 401. Only once,
+    // the provider may keep handing out tokens that expire soon.
+    if (tokensExpiring()) {
+        tokensRefreshedAhead = true;
+        if (waitForTokens()) {
+            return;
+        }
+    }
+
+    if (parkedOnCircuit) {
+        dispatchTimer->stop();
+        return;
+    }
+
+    // Don't add to the load of a service that is failing anyway
+    quint64 probe = 0;
+    if (!breaker()->allowRequest(&probe)) {
+        if (failFast) {
+            qCWarning(KMGraphDebug) << "Circuit" << breaker()->objectName() << "is open, giving up";
+            q->setError(KMGraph2::CircuitOpen);
+            q->setErrorString(tr("Too many requests to the service have failed recently. Try again later."));
+            q->emitFinished();
+            return;
+        }
+        parkOnCircuit();
+        return;
+    }
+
+    Request r = requestQueue.dequeue();
+    tokensRefreshedAhead = false;
+    // The request may have been created before the tokens were refreshed
+    if (account && r.request.rawHeader("Authorization").startsWith("Bearer ")) {
+        r.request.setRawHeader("Authorization", "Bearer " + account->accessToken().toLatin1());
+    }
     currentRequest = r;
 
     qCDebug(KMGraphDebug) << q << "Dispatching request to" << r.request.url();
     qCDebug(KMGraphRaw) << r.rawData;
 
+    // A retried request must not join the same stalled or failing request again
+    accessManager->setCoalescingEnabled(r.attempt == 0);
+    currentProbe = probe;
+    const int pendingBefore = pendingReplies;
     q->dispatchRequest(accessManager, r.request, r.rawData, r.contentType);
+    // The subclass did not send anything after all
+    if (currentProbe) {
+        breaker()->releaseProbe(currentProbe);
+        currentProbe = 0;
+    }
 
     if (requestQueue.isEmpty()) {
         dispatchTimer->stop();
     }
+
+    // No reply is coming that would finish the job
+    if (pendingReplies == pendingBefore && isRunning && isIdle()) {
+        q->emitFinished();
+    }
+}
+
+void Job::Private::_k_requestCreated(QNetworkReply *reply, QNetworkAccessManager::Operation op,
+                                     const QNetworkRequest &request)
+{
+    InFlightRequest info;
+    info.request = currentRequest;
+    info.elapsed.start();
+    info.isGet = (op == QNetworkAccessManager::GetOperation);
+    info.idempotent = isIdempotent(op, request);
+    info.probe = currentProbe;
+    currentProbe = 0;
+    // Counted only once sent, subclasses may decide not to send anything
+    ++pendingReplies;
+
+    if (hedgedReply) {
+        info.hedge = true;
+        info.twin = hedgedReply;
+        inFlight[hedgedReply].twin = reply;
+    }
+
+    if (requestTimeout > 0) {
+        info.deadline = new QTimer(reply);
+        info.deadline->setSingleShot(true);
+        info.deadline->setInterval(requestTimeout);
+        connect(info.deadline, &QTimer::timeout,
+                q, [this, reply]() { _k_requestTimedOut(reply); });
+        info.deadline->start();
+    }
+
+    connect(reply, &QNetworkReply::metaDataChanged,
+            q, [this, reply]() { _k_replyResponded(reply); });
+    connect(reply, &QNetworkReply::readyRead,
+            q, [this, reply]() { _k_replyResponded(reply); });
+    connect(reply, &QNetworkReply::downloadProgress,
+            q, [this, reply]() { _k_replyProgressed(reply); });
+    connect(reply, &QNetworkReply::uploadProgress,
+            q, [this, reply]() { _k_replyProgressed(reply); });
+
+    // Only idempotent requests can be sent twice, and only once we know
+    // what a slow reply looks like
+    if (hedgingEnabled && info.isGet && !info.hedge
+            && latencyTracker && latencyTracker->sampleCount() >= MinLatencySamples) {
+        const int delay = latencyTracker->percentile(hedgingPercentile);
+        QTimer::singleShot(delay, reply, [this, reply]() { _k_sendHedgedRequest(reply); });
+    }
+
+    inFlight.insert(reply, info);
+}
+
+void Job::Private::_k_replyResponded(QNetworkReply *reply)
+{
+    const auto it = inFlight.find(reply);
+    if (it == inFlight.end()) {
+        return;
+    }
+
+    if (it->deadline) {
+        it->deadline->start();
+    }
+    if (it->responded) {
+        return;
+    }
+    it->responded = true;
+
+    QNetworkReply *twin = it->twin;
+    if (it->isGet && !it->hedge) {
+        latencyTracker->addSample(int(it->elapsed.elapsed()));
+    }
+
+    // First reply wins, the other copy would only deliver the same data again
+    if (twin) {
+        const auto twinIt = inFlight.constFind(twin);
+        if (twinIt != inFlight.constEnd() && twinIt->isGet && !twinIt->hedge) {
+            // Keeps the statistics honest, the original was at least this slow
+            latencyTracker->addSample(int(twinIt->elapsed.elapsed()));
+        }
+        qCDebug(KMGraphDebug) << "Hedged request to" << reply->url() << "won, aborting the other one";
+        abandonReply(twin);
+    }
+}
+
+void Job::Private::_k_replyProgressed(QNetworkReply *reply)
+{
+    const auto it = inFlight.constFind(reply);
+    if (it != inFlight.constEnd() && it->deadline) {
+        it->deadline->start();
+    }
+}
+
+void Job::Private::_k_requestTimedOut(QNetworkReply *reply)
+{
+    const auto it = inFlight.constFind(reply);
+    if (it == inFlight.constEnd()) {
+        return;
+    }
+
+    const InFlightRequest info = it.value();
+
+    qCWarning(KMGraphDebug) << "Request to" << info.request.request.url() << "timed out after"
+                            << requestTimeout << "msecs";
+    breaker()->recordFailure(info.probe);
+    abandonReply(reply);
+
+    // The hedged copy of the request may still make it
+    if (info.twin) {
+        return;
+    }
+
+    if (mayRetry(info, 0) && scheduleRetry(info.request)) {
+        return;
+    }
+
+    q->setError(KMGraph2::Timeout);
+    q->setErrorString(tr("Request timed out."));
+    failRequest(reply);
+}
+
+void Job::Private::_k_sendHedgedRequest(QNetworkReply *reply)
+{
+    const auto it = inFlight.constFind(reply);
+    if (!isRunning || it == inFlight.constEnd() || it->responded || it->twin) {
+        return;
+    }
+    // Probes of a recovering service are limited, and a failing service is slow anyway
+    if (breaker()->state() != CircuitBreaker::Closed) {
+        return;
+    }
+
+    const Request request = it->request;
+    qCDebug(KMGraphDebug) << q << "No reply after" << it->elapsed.elapsed()
+                          << "msecs, sending hedged request to" << request.request.url();
+
+    currentRequest = request;
+    hedgedReply = reply;
+    // Joining the slow request would defeat the purpose
+    accessManager->setCoalescingEnabled(false);
+    q->dispatchRequest(accessManager, request.request, request.rawData, request.contentType);
+    hedgedReply = nullptr;
+}
+
+void Job::Private::_k_tokensRefreshed(const AccountPtr &refreshed, bool success)
+{
+    if (!waitingForTokens || !account || refreshed->accountName() != account->accountName()) {
+        return;
+    }
+
+    disconnect(tokenConnection);
+    waitingForTokens = false;
+
+    if (!isRunning) {
+        return;
+    }
+
+    if (!success) {
+        q->setError(KMGraph2::Unauthorized);
+        q->setErrorString(tr("Invalid authentication."));
+        q->emitFinished();
+        return;
+    }
+
+    scheduleDispatch();
+}
+
+void Job::Private::_k_circuitChanged()
+{
+    unparkFromCircuit();
+    if (isRunning) {
+        scheduleDispatch();
+    }
+}
+
+CircuitBreaker *Job::Private::breaker()
+{
+    // The registry drops closed breakers that have not been used for a while
+    if (!circuitBreaker) {
+        circuitBreaker = CircuitBreaker::instance(account ? account->accountName() : QString(),
+                                                  q->metaObject()->className());
+    }
+    return circuitBreaker;
+}
+
+void Job::Private::parkOnCircuit()
+{
+    dispatchTimer->stop();
+    if (parkedOnCircuit) {
+        return;
+    }
+
+    qCDebug(KMGraphDebug) << q << "Circuit" << breaker()->objectName() << "is open, waiting"
+                          << breaker()->retryAfter() << "msecs";
+    parkedOnCircuit = true;
+    // Wake up when the circuit closes, or when a probe may be sent
+    circuitConnection = connect(breaker(), &CircuitBreaker::stateChanged,
+                                q, [this]() { _k_circuitChanged(); });
+    circuitTimer->start(qMax(100, breaker()->retryAfter()));
+}
+
+void Job::Private::unparkFromCircuit()
+{
+    if (!parkedOnCircuit) {
+        return;
+    }
+
+    parkedOnCircuit = false;
+    circuitTimer->stop();
+    disconnect(circuitConnection);
+}
+
+bool Job::Private::tokensExpiring() const
+{
+    if (!account || !account->tokenProvider() || tokensRefreshedAhead) {
+        return false;
+    }
+
+    const QDateTime expire = account->expireDateTime();
+    if (!expire.isValid()) {
+        return false;
+    }
+
+    return QDateTime::currentDateTimeUtc().secsTo(expire) < TokenExpiryMargin;
+}
+
+bool Job::Private::waitForTokens()
+{
+    TokenProvider *provider = account ? account->tokenProvider() : nullptr;
+    if (!provider) {
+        return false;
+    }
+
+    dispatchTimer->stop();
+    if (waitingForTokens) {
+        return true;
+    }
+
+    waitingForTokens = true;
+    tokenConnection = connect(provider, &TokenProvider::tokensRefreshed,
+                              q, [this](const AccountPtr &refreshed, bool success) {
+                                  _k_tokensRefreshed(refreshed, success);
+                              });
+    // May finish right away
+    provider->refreshTokens(account);
+    return true;
+}
+
+bool Job::Private::mayRetry(const InFlightRequest &info, int statusCode) const
+{
+    // The server may have carried out a request whose reply got lost
+    return info.idempotent || retryPolicy.retryNonIdempotent() || isRejected(statusCode);
+}
+
+bool Job::Private::scheduleRetry(const Request &request, int minDelay)
+{
+    // Request::attempt counts the retries, the policy counts all attempts
+    if (!retryPolicy.canRetry(request.attempt + 1)) {
+        return false;
+    }
+
+    Request retry = request;
+    ++retry.attempt;
+    const int delay = qMax(retryPolicy.delay(retry.attempt), minDelay);
+    qCDebug(KMGraphDebug) << "Retrying request to" << retry.request.url() << "in" << delay
+                          << "msecs, attempt" << retry.attempt + 1 << "of" << retryPolicy.maxAttempts();
+
+    QTimer *timer = new QTimer(q);
+    timer->setSingleShot(true);
+    connect(timer, &QTimer::timeout,
+            q, [this, timer, retry]() {
+                retryTimers.removeOne(timer);
+                timer->deleteLater();
+
+                // Resume exactly at the failed request
+                requestQueue.prepend(retry);
+                scheduleDispatch();
+            });
+    retryTimers << timer;
+    timer->start(delay);
+    return true;
+}
+
+bool Job::Private::canDispatchDirectly() const
+{
+    // Anything that may hold the request back is left to _k_dispatchTimeout()
+    return !waitingForTokens && !parkedOnCircuit && !tokensExpiring()
+           && circuitBreaker && circuitBreaker->state() == CircuitBreaker::Closed;
+}
+
+void Job::Private::scheduleDispatch()
+{
+    if (requestQueue.isEmpty()) {
+        return;
+    }
+
+    // The timer is only needed to wait for something
+    if (!isRunning || !canDispatchDirectly()) {
+        if (!dispatchTimer->isActive()) {
+            dispatchTimer->start();
+        }
+        return;
+    }
+
+    dispatchTimer->stop();
+    while (isRunning && !requestQueue.isEmpty() && canDispatchDirectly()) {
+        _k_dispatchTimeout();
+    }
+
+    // Let _k_dispatchTimeout() decide what to do with the rest
+    if (isRunning && !requestQueue.isEmpty() && !dispatchTimer->isActive()) {
+        dispatchTimer->start();
+    }
+}
+
+void Job::Private::failRequest(const QNetworkReply *reply)
+{
+    if (!q->skipFailedRequest(reply)) {
+        q->emitFinished();
+        return;
+    }
+
+    // The job may have been finished meanwhile
+    if (!q->isRunning()) {
+        return;
+    }
+
+    qCDebug(KMGraphDebug) << q << "Skipping failed request to" << reply->url();
+    q->setError(KMGraph2::NoError);
+    q->setErrorString(QString());
+    if (isIdle()) {
+        q->emitFinished();
+    } else {
+        scheduleDispatch();
+    }
+}
+
+bool Job::Private::isIdle() const
+{
+    return requestQueue.isEmpty() && pendingReplies == 0 && retryTimers.isEmpty();
+}
+
+InFlightRequest Job::Private::releaseReply(QNetworkReply *reply)
+{
+    const InFlightRequest info = inFlight.take(reply);
+    if (info.deadline) {
+        info.deadline->stop();
+        info.deadline->deleteLater();
+    }
+    if (info.twin) {
+        const auto twinIt = inFlight.find(info.twin);
+        if (twinIt != inFlight.end()) {
+            twinIt->twin = nullptr;
+        }
+    }
+    return info;
+}
+
+void Job::Private::abandonReply(QNetworkReply *reply)
+{
+    if (!inFlight.contains(reply)) {
+        return;
+    }
+
+    const InFlightRequest info = releaseReply(reply);
+    pendingReplies = qMax(0, pendingReplies - 1);
+    if (info.probe) {
+        breaker()->releaseProbe(info.probe);
+    }
+
+    // abort() may emit finished() right away, or never when the reply is deleted first
+    abandonedReplies.insert(reply);
+    connect(reply, &QObject::destroyed,
+            q, [this, reply]() { abandonedReplies.remove(reply); });
+    reply->abort();
+}
+
+void Job::Private::abandonInFlight()
+{
+    const QList<QNetworkReply*> replies = inFlight.keys();
+    for (QNetworkReply *reply : replies) {
+        abandonReply(reply);
+        reply->deleteLater();
+    }
 }
 
 /************************* PUBLIC **********************/
@@ -348,6 +940,81 @@ void Job::setMaxTimeout(int maxTimeout)
     d->maxTimeout = maxTimeout;
 }
 
+int Job::requestTimeout() const
+{
+    return d->requestTimeout;
+}
+
+void Job::setRequestTimeout(int msecs)
+{
+    if (isRunning()) {
+        qCWarning(KMGraphDebug) << "Called setRequestTimeout() on running job. Ignoring.";
+        return;
+    }
+
+    d->requestTimeout = qMax(0, msecs);
+}
+
+bool Job::hedgingEnabled() const
+{
+    return d->hedgingEnabled;
+}
+
+void Job::setHedgingEnabled(bool enabled)
+{
+    if (isRunning()) {
+        qCWarning(KMGraphDebug) << "Called setHedgingEnabled() on running job. Ignoring.";
+        return;
+    }
+
+    d->hedgingEnabled = enabled;
+}
+
+int Job::hedgingPercentile() const
+{
+    return d->hedgingPercentile;
+}
+
+void Job::setHedgingPercentile(int percentile)
+{
+    if (isRunning()) {
+        qCWarning(KMGraphDebug) << "Called setHedgingPercentile() on running job. Ignoring.";
+        return;
+    }
+
+    d->hedgingPercentile = qBound(1, percentile, 100);
+}
+
+RetryPolicy Job::retryPolicy() const
+{
+    return d->retryPolicy;
+}
+
+void Job::setRetryPolicy(const RetryPolicy &policy)
+{
+    if (isRunning()) {
+        qCWarning(KMGraphDebug) << "Called setRetryPolicy() on running job. Ignoring.";
+        return;
+    }
+
+    d->retryPolicy = policy;
+}
+
+bool Job::failFast() const
+{
+    return d->failFast;
+}
+
+void Job::setFailFast(bool failFast)
+{
+    if (isRunning()) {
+        qCWarning(KMGraphDebug) << "Called setFailFast() on running job. Ignoring.";
+        return;
+    }
+
+    d->failFast = failFast;
+}
+
 AccountPtr Job::account() const
 {
     return d->account;
@@ -373,6 +1040,25 @@ void Job::restart()
     QTimer::singleShot(0, this, [this]() { d->_k_doStart();});
 }
 
+void Job::abort()
+{
+    if (!d->isRunning) {
+        qCWarning(KMGraphDebug) << "Called abort() on job that is not running. Ignoring.";
+        return;
+    }
+
+    qCDebug(KMGraphDebug) << "Aborting" << this << "with" << d->pendingReplies << "replies on the way and"
+                          << d->requestQueue.count() << "queued requests";
+
+    d->abandonInFlight();
+
+    aboutToAbort();
+
+    setError(KMGraph2::Cancelled);
+    setErrorString(tr("Job has been cancelled."));
+    emitFinished();
+}
+
 void Job::emitFinished()
 {
     qCDebug(KMGraphDebug);
@@ -381,6 +1067,19 @@ void Job::emitFinished()
     d->isRunning = false;
     d->dispatchTimer->stop();
     d->requestQueue.clear();
+    // Replies still on the way would only use bandwidth, and could end up
+    // in the next run after restart()
+    d->abandonInFlight();
+    for (QTimer *timer : qAsConst(d->retryTimers)) {
+        timer->stop();
+        timer->deleteLater();
+    }
+    d->retryTimers.clear();
+    if (d->waitingForTokens) {
+        disconnect(d->tokenConnection);
+        d->waitingForTokens = false;
+    }
+    d->unparkFromCircuit();
 
     // Emit in next event loop iteration so that the method caller can finish
     // before user is notified
@@ -409,15 +1108,24 @@ void Job::enqueueRequest(const QNetworkRequest& request, const QByteArray& data,
 
     d->requestQueue.enqueue(r_);
 
-    if (!d->dispatchTimer->isActive()) {
-        d->dispatchTimer->start();
-    }
+    d->scheduleDispatch();
 }
 
 void Job::aboutToFinish()
 {
 }
 
+void Job::aboutToAbort()
+{
+}
+
+bool Job::skipFailedRequest(const QNetworkReply *reply)
+{
+    Q_UNUSED(reply)
+
+    return false;
+}
+
 void Job::aboutToStart()
 {
     d->error = KMGraph2::NoError;
@@ -425,7 +1133,9 @@ void Job::aboutToStart()
     d->currentRequest.contentType.clear();
     d->currentRequest.rawData.clear();
     d->currentRequest.request = QNetworkRequest();
-    d->dispatchTimer->setInterval(0);
+    d->currentRequest.attempt = 0;
+    d->pendingReplies = 0;
+    d->tokensRefreshedAhead = false;
 }
 
 #include "moc_job.cpp"
@@ -24,6 +24,7 @@
 #define LIBKMGRAPH2_JOB_H
 
 #include "types.h"
+#include "retrypolicy.h"
 #include "kmgraphcore_export.h"
 
 #include <QObject>
@@ -68,6 +69,51 @@ class KMGRAPHCORE_EXPORT Job : public QObject
      */
     Q_PROPERTY(int maxTimeout READ maxTimeout WRITE setMaxTimeout)
 
+    /**
+     * @brief Maximum time a request may stall
+     *
+     * When no data are sent or received for a request for @p requestTimeout
+     * milliseconds, the request is aborted and sent again as permitted by
+     * Job::retryPolicy. When it stalls even then, the job fails with
+     * KMGraph2::Timeout. The default is two minutes, @p 0 disables the timeout.
+     *
+     * @see Job::requestTimeout, Job::setRequestTimeout
+     */
+    Q_PROPERTY(int requestTimeout READ requestTimeout WRITE setRequestTimeout)
+
+    /**
+     * @brief Whether slow GET requests are hedged
+     *
+     * When enabled, a GET request that has not received a reply within
+     * @p hedgingPercentile of the latencies seen by jobs of the same type
+     * is sent once more. Whichever copy replies first is used, the other
+     * one is aborted. This trades a few extra requests for a much shorter
+     * tail latency. Disabled by default, unless the job type enables it.
+     *
+     * @see Job::hedgingEnabled, Job::setHedgingEnabled
+     */
+    Q_PROPERTY(bool hedgingEnabled READ hedgingEnabled WRITE setHedgingEnabled)
+
+    /**
+     * @brief Latency percentile after which a hedged request is sent
+     *
+     * Defaults to @p 95, i.e. roughly one request in twenty is hedged.
+     *
+     * @see Job::hedgingPercentile, Job::setHedgingPercentile
+     */
+    Q_PROPERTY(int hedgingPercentile READ hedgingPercentile WRITE setHedgingPercentile)
+
+    /**
+     * @brief Whether to fail when the service is known to be failing
+     *
+     * Jobs stop sending requests while the CircuitBreaker of their account
+     * and type is open. By default they wait until it closes again, with
+     * @p failFast they finish with KMGraph2::CircuitOpen right away instead.
+     *
+     * @see Job::failFast, Job::setFailFast
+     */
+    Q_PROPERTY(bool failFast READ failFast WRITE setFailFast)
+
     /**
      * @brief Whether the job is running
      *
@@ -131,8 +177,9 @@ class KMGRAPHCORE_EXPORT Job : public QObject
      * Sets maximum interval for which the job should wait before trying to submit
      * a request that has previously failed due to exceeded quota.
      *
-     * Default timeout is 1 seconds, then after every failed request the timeout
-     * is increased exponentially until reaching @p maxTimeout.
+     * Throttled requests are retried according to retryPolicy(). When the
+     * server asks (through the Retry-After header) to wait longer than
+     * @p maxTimeout, the job fails with KMGraph2::QuotaExceeded right away.
      *
      * @param maxTimeout Maximum timeout (in seconds), or @p -1 for no timeout
      */
@@ -146,6 +193,49 @@ class KMGRAPHCORE_EXPORT Job : public QObject
      */
     int maxTimeout() const;
 
+    /**
+     * @brief Sets maximum time (in milliseconds) a request may stall before
+     *        it is aborted, or @p 0 to wait forever.
+     *
+     * A GET, HEAD, PUT or DELETE request that timed out is sent again
+     * according to retryPolicy(). Once retries are exhausted, or for other
+     * requests right away, the job fails with KMGraph2::Timeout.
+     */
+    void setRequestTimeout(int msecs);
+    int requestTimeout() const;
+
+    /**
+     * @brief Sets policy for retrying requests that failed for a transient reason
+     *
+     * When retries are exhausted, the job fails with the error of the last
+     * attempt. Use RetryPolicy::noRetry() to fail on the first error.
+     *
+     * Only GET, HEAD, PUT and DELETE requests are retried after a server or
+     * network failure, unless RetryPolicy::retryNonIdempotent() is enabled.
+     */
+    void setRetryPolicy(const RetryPolicy &policy);
+    RetryPolicy retryPolicy() const;
+
+    /**
+     * @brief Sets whether the job should fail instead of waiting while the
+     *        circuit of its service is open.
+     */
+    void setFailFast(bool failFast);
+    bool failFast() const;
+
+    /**
+     * @brief Sets whether slow GET requests should be sent a second time.
+     */
+    void setHedgingEnabled(bool enabled);
+    bool hedgingEnabled() const;
+
+    /**
+     * @brief Sets latency percentile (1 - 100) after which a slow GET request
+     *        is hedged.
+     */
+    void setHedgingPercentile(int percentile);
+    int hedgingPercentile() const;
+
     /**
      * @brief Whether job is running
      *
@@ -191,6 +281,22 @@ class KMGRAPHCORE_EXPORT Job : public QObject
      */
     void restart();
 
+    /**
+     * @brief Aborts this job
+     *
+     * All replies that are still on the way are aborted, so the job stops
+     * consuming bandwidth immediately, queued requests are dropped, and
+     * partial results are released. The job then finishes with
+     * KMGraph2::Cancelled error. Calling this method on a job that is not
+     * running does nothing.
+     *
+     * Deleting a running job aborts its replies as well, but does not
+     * emit Job::finished.
+     *
+     * @see Job::aboutToAbort
+     */
+    void abort();
+
   Q_SIGNALS:
 
     /**
@@ -256,6 +362,15 @@ class KMGRAPHCORE_EXPORT Job : public QObject
      */
     virtual void aboutToFinish();
 
+    /**
+     * @brief This method is invoked when the job is aborted, right before
+     *        Job::aboutToFinish
+     *
+     * Subclasses should release buffers with partial results here and call
+     * parent implementation.
+     */
+    virtual void aboutToAbort();
+
     /**
      * @brief Emit progress() signal
      *
@@ -308,12 +423,32 @@ class KMGRAPHCORE_EXPORT Job : public QObject
      */
     virtual void handleReply(const QNetworkReply *reply, const QByteArray &rawData) = 0;
 
+    /**
+     * @brief Called when a request has failed and won't be sent again.
+     *
+     * error() and errorString() describe the failure. Jobs that fetch
+     * independent items can return true to give up on the failed request
+     * only, the error is then cleared and the other requests go on.
+     * Errors that affect every request, like KMGraph2::Unauthorized or
+     * KMGraph2::QuotaExceeded, always finish the job.
+     *
+     * The default implementation returns false, so the job finishes with
+     * the error.
+     *
+     * @param reply The failed reply
+     */
+    virtual bool skipFailedRequest(const QNetworkReply *reply);
+
     /**
      * @brief Enqueues @p request in dispatcher queue
      *
      * Subclasses should call this method to enqueue the @p request in main job
      * queue. The request is automatically dispatched, and reply is handled.
      *
+     * Unless the job waits for new tokens or for the service to recover,
+     * the request is dispatched before this method returns,
+     * so subclasses must be ready for dispatchRequest() to be called right away.
+     *
      * @param request Request to enqueue
      * @param data Data to be sent in body of the request
      * @param contentType Content type of @p data
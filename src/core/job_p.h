@@ -24,8 +24,14 @@
 #define KMGRAPH_JOB_P_H
 
 #include "job.h"
+#include "retrypolicy.h"
 
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPointer>
 #include <QQueue>
+#include <QSet>
 #include <QTimer>
 #include <QNetworkReply>
 
@@ -33,11 +39,58 @@
 
 namespace KMGraph2 {
 
+class CircuitBreaker;
+class LatencyTracker;
+
 struct Request
 {
     QNetworkRequest request;
     QByteArray rawData;
     QString contentType;
+    int attempt = 0;
+    bool authReplayed = false;  // already sent again with refreshed tokens
+};
+
+struct InFlightRequest
+{
+    Request request;
+    QElapsedTimer elapsed;
+    QTimer *deadline = nullptr;
+    QNetworkReply *twin = nullptr;  // the other copy of a hedged request
+    bool isGet = false;
+    bool idempotent = false;  // may be sent again when the reply got lost
+    bool hedge = false;
+    bool responded = false;
+    quint64 probe = 0;  // see CircuitBreaker::allowRequest()
+};
+
+/**
+ * Tells the job about every reply created by the subclasses, so that
+ * it can watch their deadlines.
+ */
+class JobAccessManager : public KIO::Integration::AccessManager
+{
+    Q_OBJECT
+
+  public:
+    explicit JobAccessManager(QObject *parent);
+
+    /**
+     * Whether GET requests may share an identical request of another job,
+     * see RequestCoalescer.
+     */
+    void setCoalescingEnabled(bool enabled);
+
+  Q_SIGNALS:
+    void requestCreated(QNetworkReply *reply, QNetworkAccessManager::Operation op,
+                        const QNetworkRequest &request);
+
+  protected:
+    QNetworkReply *createRequest(Operation op, const QNetworkRequest &request,
+                                 QIODevice *outgoingData = nullptr) override;
+
+  private:
+    bool mCoalescingEnabled;
 };
 
 class Q_DECL_HIDDEN Job::Private
@@ -52,6 +105,36 @@ class Q_DECL_HIDDEN Job::Private
     void _k_doEmitFinished();
     void _k_replyReceived(QNetworkReply *reply);
     void _k_dispatchTimeout();
+    void _k_requestCreated(QNetworkReply *reply, QNetworkAccessManager::Operation op,
+                           const QNetworkRequest &request);
+    void _k_replyResponded(QNetworkReply *reply);
+    void _k_replyProgressed(QNetworkReply *reply);
+    void _k_requestTimedOut(QNetworkReply *reply);
+    void _k_sendHedgedRequest(QNetworkReply *reply);
+    void _k_tokensRefreshed(const AccountPtr &account, bool success);
+    void _k_circuitChanged();
+
+    CircuitBreaker *breaker();
+    void parkOnCircuit();
+    void unparkFromCircuit();
+
+    bool tokensExpiring() const;
+    bool waitForTokens();
+
+    bool canDispatchDirectly() const;
+    void scheduleDispatch();
+    bool mayRetry(const InFlightRequest &info, int statusCode) const;
+    bool scheduleRetry(const Request &request, int minDelay = 0);
+    bool isIdle() const;
+    void failRequest(const QNetworkReply *reply);
+
+    InFlightRequest releaseReply(QNetworkReply *reply);
+    void abandonReply(QNetworkReply *reply);
+    void abandonInFlight();
+
+    static const int DefaultRequestTimeout = 120 * 1000;
+    static const int MinLatencySamples = 16;
+    static const int TokenExpiryMargin = 60; // seconds
 
     bool isRunning;
 
@@ -59,10 +142,32 @@ class Q_DECL_HIDDEN Job::Private
     QString errorString;
 
     AccountPtr account;
-    KIO::Integration::AccessManager *accessManager;
+    JobAccessManager *accessManager;
     QQueue<Request> requestQueue;
     QTimer *dispatchTimer;
     int maxTimeout;
+    int pendingReplies;
+
+    int requestTimeout;
+    RetryPolicy retryPolicy;
+    QList<QTimer*> retryTimers;
+    bool hedgingEnabled;
+    int hedgingPercentile;
+    LatencyTracker *latencyTracker;
+    QHash<QNetworkReply*, InFlightRequest> inFlight;
+    QSet<QNetworkReply*> abandonedReplies;
+    QNetworkReply *hedgedReply;
+
+    bool waitingForTokens;
+    bool tokensRefreshedAhead;  // for the next request, refresh only once
+    QMetaObject::Connection tokenConnection;
+
+    bool failFast;
+    QPointer<CircuitBreaker> circuitBreaker;
+    quint64 currentProbe;
+    bool parkedOnCircuit;
+    QTimer *circuitTimer;
+    QMetaObject::Connection circuitConnection;
 
     Request currentRequest;
 
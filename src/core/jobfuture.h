@@ -0,0 +1,361 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBKMGRAPH2_JOBFUTURE_H
+#define LIBKMGRAPH2_JOBFUTURE_H
+
+#include "fetchjob.h"
+#include "job.h"
+#include "types.h"
+
+#include <QFuture>
+#include <QFutureInterface>
+#include <QFutureWatcher>
+#include <QList>
+#include <QSharedPointer>
+#include <QVector>
+
+#include <type_traits>
+#include <utility>
+
+namespace KMGraph2
+{
+
+/**
+ * @headerfile JobFuture
+ * @brief Result of a job run through toFuture()
+ *
+ * QFuture cannot carry an error, so the typed result travels together with
+ * the error of the job. The @p value is only set when the job succeeded.
+ */
+template<typename T>
+struct JobResult
+{
+    T value = T();
+    KMGraph2::Error error = KMGraph2::NoError;
+    QString errorString;
+
+    bool isOk() const
+    {
+        return error == KMGraph2::NoError;
+    }
+};
+
+/// @cond PRIVATE
+namespace JobFutureDetail
+{
+
+// Calls @p function with @p future once it has finished, or @p abandoned
+// when @p context is destroyed before that
+template<typename T, typename Function, typename Abandoned>
+void onFinished(const QFuture<T> &future, QObject *context, Function function, Abandoned abandoned)
+{
+    auto watcher = new QFutureWatcher<T>(context);
+    QSharedPointer<bool> done(new bool(false));
+    QObject::connect(watcher, &QFutureWatcherBase::finished,
+                     watcher, [watcher, done, function]() mutable {
+                         *done = true;
+                         watcher->deleteLater();
+                         function(watcher->future());
+                     });
+    QObject::connect(watcher, &QObject::destroyed,
+                     [done, abandoned]() mutable {
+                         if (!*done) {
+                             abandoned();
+                         }
+                     });
+    watcher->setFuture(future);
+}
+
+template<typename T>
+void cancel(QFutureInterface<T> &interface)
+{
+    interface.reportCanceled();
+    interface.reportFinished();
+}
+
+template<typename T>
+struct Forward
+{
+    static void run(QFutureInterface<T> &interface, const QFuture<T> &future)
+    {
+        if (future.isCanceled() || future.resultCount() == 0) {
+            cancel(interface);
+            return;
+        }
+        interface.reportResult(future.result());
+        interface.reportFinished();
+    }
+};
+
+template<>
+struct Forward<void>
+{
+    static void run(QFutureInterface<void> &interface, const QFuture<void> &future)
+    {
+        if (future.isCanceled()) {
+            interface.reportCanceled();
+        }
+        interface.reportFinished();
+    }
+};
+
+template<typename R>
+struct Continuation
+{
+    typedef R Result;
+
+    template<typename Function, typename Arg>
+    static void run(QFutureInterface<Result> &interface, QObject *context, Function &function, const Arg &arg)
+    {
+        Q_UNUSED(context)
+        interface.reportResult(function(arg));
+        interface.reportFinished();
+    }
+};
+
+template<>
+struct Continuation<void>
+{
+    typedef void Result;
+
+    template<typename Function, typename Arg>
+    static void run(QFutureInterface<Result> &interface, QObject *context, Function &function, const Arg &arg)
+    {
+        Q_UNUSED(context)
+        function(arg);
+        interface.reportFinished();
+    }
+};
+
+// A continuation that starts more work finishes together with that work
+template<typename U>
+struct Continuation<QFuture<U>>
+{
+    typedef U Result;
+
+    template<typename Function, typename Arg>
+    static void run(QFutureInterface<Result> &interface, QObject *context, Function &function, const Arg &arg)
+    {
+        QFutureInterface<Result> outer = interface;
+        onFinished(function(arg), context,
+                   [outer](const QFuture<Result> &inner) mutable { Forward<Result>::run(outer, inner); },
+                   [outer]() mutable { cancel(outer); });
+    }
+};
+
+template<typename Function, typename Arg>
+using ContinuationFor = Continuation<typename std::decay<decltype(std::declval<Function&>()(std::declval<const Arg&>()))>::type>;
+
+} // namespace JobFutureDetail
+/// @endcond
+
+/**
+ * @brief Returns a future that finishes together with @p job
+ *
+ * Once the job has finished, @p extractor is called with the job to obtain
+ * its typed result, e.g.
+ *
+ * @code
+ * auto future = toFuture(new AboutFetchJob(account),
+ *                        [](AboutFetchJob *job) { return job->aboutData(); });
+ * @endcode
+ *
+ * The extractor is not called when the job has failed, the error is stored
+ * in the JobResult instead. Cancelling the future aborts the job.
+ *
+ * The future takes ownership of @p job, the job is deleted once it has
+ * finished. Must be called from the thread the job lives in, before the
+ * control returns to the event loop.
+ *
+ * @see itemsFuture(), then(), whenAll()
+ */
+template<typename JobType, typename Extractor>
+QFuture<JobResult<typename std::decay<decltype(std::declval<Extractor&>()(std::declval<JobType*>()))>::type>>
+toFuture(JobType *job, Extractor extractor)
+{
+    typedef typename std::decay<decltype(extractor(job))>::type T;
+
+    QFutureInterface<JobResult<T>> interface;
+    interface.reportStarted();
+
+    auto watcher = new QFutureWatcher<JobResult<T>>(job);
+    QObject::connect(watcher, &QFutureWatcherBase::canceled,
+                     job, [job]() {
+                         if (job->isRunning()) {
+                             job->abort();
+                         }
+                     });
+    watcher->setFuture(interface.future());
+
+    QObject::connect(job, &Job::finished,
+                     job, [interface, extractor, job]() mutable {
+                         JobResult<T> result;
+                         result.error = job->error();
+                         result.errorString = job->errorString();
+                         if (result.isOk()) {
+                             result.value = extractor(job);
+                         }
+                         interface.reportResult(result);
+                         interface.reportFinished();
+                         job->deleteLater();
+                     });
+
+    return interface.future();
+}
+
+/**
+ * @brief Returns a future of the items fetched by @p job
+ *
+ * Convenience wrapper around toFuture() for fetch jobs. Items that are not
+ * of type @p T are skipped, so that
+ *
+ * @code
+ * QFuture<JobResult<FilesList>> future = itemsFuture<File>(new FileFetchJob(query, account));
+ * @endcode
+ *
+ * yields a FilesList right away.
+ */
+template<typename T>
+QFuture<JobResult<QList<QSharedPointer<T>>>> itemsFuture(FetchJob *job)
+{
+    return toFuture(job, [](FetchJob *job) {
+        const ObjectsList objects = job->items();
+        QList<QSharedPointer<T>> items;
+        items.reserve(objects.count());
+        for (const ObjectPtr &object : objects) {
+            const QSharedPointer<T> item = object.template dynamicCast<T>();
+            if (item) {
+                items << item;
+            }
+        }
+        return items;
+    });
+}
+
+/**
+ * @brief Calls @p function with the result of @p future once it is available
+ *
+ * Returns a future of whatever @p function returns. When @p function returns
+ * a QFuture itself, e.g. of whenAll(), the returned future finishes together
+ * with that one, so continuations can be chained without nesting.
+ *
+ * @p function is called in the thread of @p context, and not at all when
+ * @p future has been cancelled or @p context is destroyed before @p future
+ * finishes. The returned future is cancelled in that case.
+ */
+template<typename T, typename Function>
+QFuture<typename JobFutureDetail::ContinuationFor<Function, T>::Result>
+then(const QFuture<T> &future, QObject *context, Function function)
+{
+    typedef JobFutureDetail::ContinuationFor<Function, T> Continuation;
+    typedef typename Continuation::Result Result;
+
+    QFutureInterface<Result> interface;
+    interface.reportStarted();
+
+    JobFutureDetail::onFinished(future, context,
+        [interface, context, function](const QFuture<T> &finished) mutable {
+            if (finished.isCanceled() || finished.resultCount() == 0) {
+                JobFutureDetail::cancel(interface);
+                return;
+            }
+            Continuation::run(interface, context, function, finished.result());
+        },
+        [interface]() mutable { JobFutureDetail::cancel(interface); });
+
+    return interface.future();
+}
+
+/**
+ * @brief Returns a future of the results of all @p futures, in the same order
+ *
+ * The returned future finishes once all @p futures have finished. It is
+ * cancelled when any of them is cancelled. Failed jobs don't cancel it,
+ * their errors are reported in the respective JobResult.
+ *
+ * @code
+ * then(itemsFuture<File>(new FileFetchJob(query, account)), this,
+ *      [account](const JobResult<FilesList> &files) {
+ *          QList<QFuture<JobResult<PermissionsList>>> permissions;
+ *          for (const FilePtr &file : files.value) {
+ *              permissions << itemsFuture<Permission>(new PermissionFetchJob(file, account));
+ *          }
+ *          return whenAll(permissions);
+ *      });
+ * @endcode
+ */
+template<typename T>
+QFuture<QList<T>> whenAll(const QList<QFuture<T>> &futures)
+{
+    struct State
+    {
+        QFutureInterface<QList<T>> interface;
+        QVector<T> results;
+        int remaining;
+        bool canceled;
+    };
+
+    QSharedPointer<State> state(new State);
+    state->interface.reportStarted();
+    state->results.resize(futures.count());
+    state->remaining = futures.count();
+    state->canceled = false;
+
+    if (futures.isEmpty()) {
+        state->interface.reportResult(QList<T>());
+        state->interface.reportFinished();
+        return state->interface.future();
+    }
+
+    const auto finishOne = [state]() {
+        if (--state->remaining > 0) {
+            return;
+        }
+        if (state->canceled) {
+            JobFutureDetail::cancel(state->interface);
+        } else {
+            state->interface.reportResult(state->results.toList());
+            state->interface.reportFinished();
+        }
+    };
+
+    for (int i = 0; i < futures.count(); ++i) {
+        JobFutureDetail::onFinished(futures.at(i), nullptr,
+            [state, finishOne, i](const QFuture<T> &future) {
+                if (future.isCanceled() || future.resultCount() == 0) {
+                    state->canceled = true;
+                } else {
+                    state->results[i] = future.result();
+                }
+                finishOne();
+            },
+            [state, finishOne]() {
+                state->canceled = true;
+                finishOne();
+            });
+    }
+
+    return state->interface.future();
+}
+
+} // namespace KMGraph2
+
+#endif // LIBKMGRAPH2_JOBFUTURE_H
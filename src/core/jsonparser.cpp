@@ -0,0 +1,244 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "jsonparser.h"
+#include "../debug.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#ifdef KMGRAPH_HAVE_SIMDJSON
+#include <simdjson.h>
+#endif
+
+using namespace KMGraph2;
+
+#ifdef KMGRAPH_HAVE_SIMDJSON
+namespace {
+
+// The library is built without exceptions, so errors are reported through
+// error codes and the ok flag is cleared on the first failure.
+
+QVariantMap toVariantMap(simdjson::ondemand::object &object, bool &ok);
+
+QVariant toVariant(simdjson::ondemand::value &value, bool &ok)
+{
+    simdjson::ondemand::json_type type;
+    if (value.type().get(type)) {
+        ok = false;
+        return QVariant();
+    }
+
+    switch (type) {
+    case simdjson::ondemand::json_type::object: {
+        simdjson::ondemand::object object;
+        if (value.get_object().get(object)) {
+            ok = false;
+            return QVariant();
+        }
+        return toVariantMap(object, ok);
+    }
+    case simdjson::ondemand::json_type::array: {
+        simdjson::ondemand::array array;
+        if (value.get_array().get(array)) {
+            ok = false;
+            return QVariant();
+        }
+        QVariantList list;
+        for (auto element : array) {
+            simdjson::ondemand::value item;
+            if (element.get(item)) {
+                ok = false;
+                return QVariant();
+            }
+            list.append(toVariant(item, ok));
+            if (!ok) {
+                return QVariant();
+            }
+        }
+        return list;
+    }
+    case simdjson::ondemand::json_type::string: {
+        std::string_view string;
+        if (value.get_string().get(string)) {
+            ok = false;
+            return QVariant();
+        }
+        return QString::fromUtf8(string.data(), int(string.size()));
+    }
+    case simdjson::ondemand::json_type::number: {
+        simdjson::ondemand::number_type numberType;
+        if (value.get_number_type().get(numberType)) {
+            ok = false;
+            return QVariant();
+        }
+        if (numberType == simdjson::ondemand::number_type::signed_integer) {
+            int64_t number;
+            if (!value.get_int64().get(number)) {
+                return qint64(number);
+            }
+        } else if (numberType == simdjson::ondemand::number_type::unsigned_integer) {
+            uint64_t number;
+            if (!value.get_uint64().get(number)) {
+                return quint64(number);
+            }
+        }
+        double number;
+        if (value.get_double().get(number)) {
+            ok = false;
+            return QVariant();
+        }
+        return number;
+    }
+    case simdjson::ondemand::json_type::boolean: {
+        bool boolean;
+        if (value.get_bool().get(boolean)) {
+            ok = false;
+            return QVariant();
+        }
+        return boolean;
+    }
+    case simdjson::ondemand::json_type::null:
+        if (!value.is_null()) {
+            ok = false;
+        }
+        return QVariant();
+    }
+
+    ok = false;
+    return QVariant();
+}
+
+QVariantMap toVariantMap(simdjson::ondemand::object &object, bool &ok)
+{
+    QVariantMap map;
+    for (auto member : object) {
+        simdjson::ondemand::field field;
+        std::string_view key;
+        if (member.get(field) || field.unescaped_key().get(key)) {
+            ok = false;
+            return QVariantMap();
+        }
+        const QString name = QString::fromUtf8(key.data(), int(key.size()));
+        const QVariant value = toVariant(field.value(), ok);
+        if (!ok) {
+            return QVariantMap();
+        }
+        map.insert(name, value);
+    }
+    return map;
+}
+
+QVariantMap parseWithSimdJson(const QByteArray &json, bool &ok)
+{
+    // The parser keeps its buffers between calls, so reuse one per thread
+    thread_local simdjson::ondemand::parser parser;
+
+    // simdjson reads up to SIMDJSON_PADDING bytes past the end of the input,
+    // the spare capacity of the QByteArray can be used for that if there's enough.
+    simdjson::padded_string copy;
+    simdjson::ondemand::document document;
+    simdjson::error_code error;
+    if (json.capacity() - json.size() >= SIMDJSON_PADDING) {
+        error = parser.iterate(simdjson::padded_string_view(json.constData(), size_t(json.size()),
+                                                            size_t(json.capacity()))).get(document);
+    } else {
+        copy = simdjson::padded_string(json.constData(), size_t(json.size()));
+        error = parser.iterate(copy).get(document);
+    }
+
+    simdjson::ondemand::object object;
+    if (error || document.get_object().get(object)) {
+        ok = false;
+        return QVariantMap();
+    }
+
+    ok = true;
+    QVariantMap map = toVariantMap(object, ok);
+    if (ok && !document.at_end()) {
+        // Trailing content after the object
+        ok = false;
+    }
+    return ok ? map : QVariantMap();
+}
+
+}
+#endif
+
+JsonParser::Backend JsonParser::defaultBackend()
+{
+#ifdef KMGRAPH_HAVE_SIMDJSON
+    return SimdJson;
+#else
+    return QtJson;
+#endif
+}
+
+bool JsonParser::isSupported(Backend backend)
+{
+    switch (backend) {
+    case QtJson:
+        return true;
+    case SimdJson:
+#ifdef KMGRAPH_HAVE_SIMDJSON
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    return false;
+}
+
+QVariantMap JsonParser::parseObject(const QByteArray &json, bool *ok)
+{
+    return parseObject(json, defaultBackend(), ok);
+}
+
+QVariantMap JsonParser::parseObject(const QByteArray &json, Backend backend, bool *ok)
+{
+    bool parsed = false;
+    QVariantMap map;
+
+    switch (backend) {
+    case SimdJson:
+#ifdef KMGRAPH_HAVE_SIMDJSON
+        map = parseWithSimdJson(json, parsed);
+        break;
+#else
+        qCWarning(KMGraphDebug) << "simdjson backend is not available, using QJsonDocument";
+        Q_FALLTHROUGH();
+#endif
+    case QtJson: {
+        const QJsonDocument document = QJsonDocument::fromJson(json);
+        parsed = document.isObject();
+        if (parsed) {
+            map = document.object().toVariantMap();
+        }
+        break;
+    }
+    }
+
+    if (ok) {
+        *ok = parsed;
+    }
+    return map;
+}
@@ -0,0 +1,74 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBKMGRAPH2_JSONPARSER_H
+#define LIBKMGRAPH2_JSONPARSER_H
+
+#include "kmgraphcore_export.h"
+
+#include <QByteArray>
+#include <QVariantMap>
+
+namespace KMGraph2
+{
+
+/**
+ * @brief Parses JSON responses into QVariantMaps consumed by fromJSON()
+ *
+ * By default the response is parsed with QJsonDocument, which validates and
+ * builds a complete DOM that is then converted to QVariantMap. When the
+ * library is built with KMGRAPH_WITH_SIMDJSON, the response is instead
+ * walked with the on-demand API of simdjson and the QVariantMap is built
+ * directly from it, skipping the intermediate DOM entirely.
+ *
+ * @internal
+ */
+class KMGRAPHCORE_EXPORT JsonParser
+{
+  public:
+    enum Backend {
+        QtJson,   ///< QJsonDocument, always available
+        SimdJson  ///< simdjson, only available when enabled at build time
+    };
+
+    /**
+     * @brief Returns the backend used by parseObject()
+     */
+    static Backend defaultBackend();
+
+    /**
+     * @brief Returns whether @p backend is available in this build.
+     */
+    static bool isSupported(Backend backend);
+
+    /**
+     * @brief Parses @p json, which must contain a JSON object
+     *
+     * Returns an empty map and sets @p ok to false when @p json is not
+     * a valid JSON object.
+     */
+    static QVariantMap parseObject(const QByteArray &json, bool *ok = nullptr);
+    static QVariantMap parseObject(const QByteArray &json, Backend backend, bool *ok = nullptr);
+};
+
+} // namespace KMGraph2
+
+#endif // LIBKMGRAPH2_JSONPARSER_H
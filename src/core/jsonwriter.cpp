@@ -0,0 +1,272 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "jsonwriter.h"
+
+#include <QDateTime>
+#include <QString>
+#include <QUrl>
+
+using namespace KMGraph2;
+
+class Q_DECL_HIDDEN JsonWriter::Private
+{
+  public:
+    void writeSeparator();
+    void writeKey(const char *key);
+    void writeString(const QString &value);
+    void writeString(QLatin1String value);
+    void writeNumber(qint64 value);
+
+    QByteArray buffer;
+    // One bit per nesting level, set when the level already has an element
+    quint64 hasElements = 0;
+    int depth = 0;
+};
+
+void JsonWriter::Private::writeSeparator()
+{
+    const quint64 bit = quint64(1) << depth;
+    if (hasElements & bit) {
+        buffer.append(',');
+    } else {
+        hasElements |= bit;
+    }
+}
+
+void JsonWriter::Private::writeKey(const char *key)
+{
+    writeSeparator();
+    buffer.append('"');
+    buffer.append(key);
+    buffer.append("\":", 2);
+}
+
+namespace {
+
+inline void appendEscaped(QByteArray &buffer, ushort c)
+{
+    static const char hex[] = "0123456789abcdef";
+    switch (c) {
+    case '"':  buffer.append("\\\"", 2); return;
+    case '\\': buffer.append("\\\\", 2); return;
+    case '\b': buffer.append("\\b", 2); return;
+    case '\f': buffer.append("\\f", 2); return;
+    case '\n': buffer.append("\\n", 2); return;
+    case '\r': buffer.append("\\r", 2); return;
+    case '\t': buffer.append("\\t", 2); return;
+    default:
+        if (c < 0x20) {
+            const char escaped[] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf] };
+            buffer.append(escaped, sizeof(escaped));
+        } else {
+            buffer.append(char(c));
+        }
+    }
+}
+
+}
+
+void JsonWriter::Private::writeString(const QString &value)
+{
+    // Worst case is three bytes of UTF-8 per UTF-16 code unit
+    buffer.reserve(buffer.size() + value.size() * 3 + 2);
+    buffer.append('"');
+
+    const ushort *str = value.utf16();
+    const ushort *end = str + value.size();
+    while (str < end) {
+        const ushort c = *str++;
+        if (c < 0x80) {
+            appendEscaped(buffer, c);
+        } else if (c < 0x800) {
+            const char utf8[] = { char(0xc0 | (c >> 6)), char(0x80 | (c & 0x3f)) };
+            buffer.append(utf8, sizeof(utf8));
+        } else if (QChar::isHighSurrogate(c) && str < end && QChar::isLowSurrogate(*str)) {
+            const uint ucs4 = QChar::surrogateToUcs4(c, *str++);
+            const char utf8[] = { char(0xf0 | (ucs4 >> 18)), char(0x80 | ((ucs4 >> 12) & 0x3f)),
+                                  char(0x80 | ((ucs4 >> 6) & 0x3f)), char(0x80 | (ucs4 & 0x3f)) };
+            buffer.append(utf8, sizeof(utf8));
+        } else {
+            // Unpaired surrogates cannot be encoded, write U+FFFD like QString::toUtf8() does
+            const ushort u = QChar::isSurrogate(c) ? ushort(QChar::ReplacementCharacter) : c;
+            const char utf8[] = { char(0xe0 | (u >> 12)), char(0x80 | ((u >> 6) & 0x3f)),
+                                  char(0x80 | (u & 0x3f)) };
+            buffer.append(utf8, sizeof(utf8));
+        }
+    }
+
+    buffer.append('"');
+}
+
+void JsonWriter::Private::writeString(QLatin1String value)
+{
+    buffer.append('"');
+    const char *str = value.data();
+    for (int i = 0, size = value.size(); i < size; ++i) {
+        const uchar uc = uchar(str[i]);
+        if (uc < 0x80) {
+            appendEscaped(buffer, uc);
+        } else {
+            const char utf8[] = { char(0xc0 | (uc >> 6)), char(0x80 | (uc & 0x3f)) };
+            buffer.append(utf8, sizeof(utf8));
+        }
+    }
+    buffer.append('"');
+}
+
+void JsonWriter::Private::writeNumber(qint64 value)
+{
+    char digits[20];
+    char *pos = digits + sizeof(digits);
+    // Work with the negative value, so that minimum of qint64 does not overflow
+    const bool negative = value < 0;
+    qint64 v = negative ? value : -value;
+    do {
+        *--pos = char('0' - (v % 10));
+        v /= 10;
+    } while (v != 0);
+    if (negative) {
+        buffer.append('-');
+    }
+    buffer.append(pos, int(digits + sizeof(digits) - pos));
+}
+
+JsonWriter::JsonWriter(int reserve):
+    d(new Private)
+{
+    d->buffer.reserve(reserve);
+}
+
+JsonWriter::~JsonWriter()
+{
+    delete d;
+}
+
+void JsonWriter::beginObject()
+{
+    if (d->depth > 0) {
+        d->writeSeparator();
+    }
+    d->buffer.append('{');
+    d->hasElements &= ~(quint64(1) << ++d->depth);
+}
+
+void JsonWriter::beginObject(const char *key)
+{
+    d->writeKey(key);
+    d->buffer.append('{');
+    d->hasElements &= ~(quint64(1) << ++d->depth);
+}
+
+void JsonWriter::endObject()
+{
+    Q_ASSERT(d->depth > 0);
+    --d->depth;
+    d->buffer.append('}');
+}
+
+void JsonWriter::beginArray()
+{
+    if (d->depth > 0) {
+        d->writeSeparator();
+    }
+    d->buffer.append('[');
+    d->hasElements &= ~(quint64(1) << ++d->depth);
+}
+
+void JsonWriter::beginArray(const char *key)
+{
+    d->writeKey(key);
+    d->buffer.append('[');
+    d->hasElements &= ~(quint64(1) << ++d->depth);
+}
+
+void JsonWriter::endArray()
+{
+    Q_ASSERT(d->depth > 0);
+    --d->depth;
+    d->buffer.append(']');
+}
+
+void JsonWriter::write(const char *key, const QString &value)
+{
+    d->writeKey(key);
+    d->writeString(value);
+}
+
+void JsonWriter::write(const char *key, QLatin1String value)
+{
+    d->writeKey(key);
+    d->writeString(value);
+}
+
+void JsonWriter::write(const char *key, const QUrl &value)
+{
+    d->writeKey(key);
+    d->writeString(value.toString(QUrl::FullyEncoded));
+}
+
+void JsonWriter::write(const char *key, bool value)
+{
+    d->writeKey(key);
+    if (value) {
+        d->buffer.append("true", 4);
+    } else {
+        d->buffer.append("false", 5);
+    }
+}
+
+void JsonWriter::write(const char *key, int value)
+{
+    d->writeKey(key);
+    d->writeNumber(value);
+}
+
+void JsonWriter::write(const char *key, qint64 value)
+{
+    d->writeKey(key);
+    d->writeNumber(value);
+}
+
+void JsonWriter::write(const char *key, const QDateTime &value)
+{
+    d->writeKey(key);
+    d->writeString(value.toString(Qt::ISODate));
+}
+
+void JsonWriter::write(const QString &value)
+{
+    d->writeSeparator();
+    d->writeString(value);
+}
+
+void JsonWriter::write(QLatin1String value)
+{
+    d->writeSeparator();
+    d->writeString(value);
+}
+
+QByteArray JsonWriter::data() const
+{
+    Q_ASSERT(d->depth == 0);
+    return d->buffer;
+}
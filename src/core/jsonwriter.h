@@ -0,0 +1,113 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBKMGRAPH2_JSONWRITER_H
+#define LIBKMGRAPH2_JSONWRITER_H
+
+#include "kmgraphcore_export.h"
+
+#include <QByteArray>
+
+class QString;
+class QLatin1String;
+class QUrl;
+class QDateTime;
+
+namespace KMGraph2
+{
+
+/**
+ * @brief Writes compact JSON directly into a QByteArray
+ *
+ * Serializing objects through QVariantMap and QJsonDocument builds two
+ * complete intermediate representations of every object. JsonWriter instead
+ * appends the JSON text to a single preallocated buffer as the object is
+ * being walked.
+ *
+ * Keys are expected to be plain ASCII literals and are not escaped, string
+ * values are escaped as required by RFC 8259 and encoded as UTF-8.
+ *
+ * @code
+ * JsonWriter writer;
+ * writer.beginObject();
+ * writer.write("title", file->title());
+ * writer.beginArray("parents");
+ * ...
+ * writer.endArray();
+ * writer.endObject();
+ * return writer.data();
+ * @endcode
+ *
+ * @internal
+ */
+class KMGRAPHCORE_EXPORT JsonWriter
+{
+  public:
+    explicit JsonWriter(int reserve = 256);
+    ~JsonWriter();
+
+    /**
+     * @brief Starts an anonymous object, i.e. the top-level one or an array item
+     */
+    void beginObject();
+    void beginObject(const char *key);
+    void endObject();
+
+    /**
+     * @brief Starts an anonymous array, i.e. the top-level one or an array item
+     */
+    void beginArray();
+    void beginArray(const char *key);
+    void endArray();
+
+    void write(const char *key, const QString &value);
+    void write(const char *key, QLatin1String value);
+    void write(const char *key, const QUrl &value);
+    void write(const char *key, bool value);
+    void write(const char *key, int value);
+    void write(const char *key, qint64 value);
+
+    /**
+     * @brief Writes @p value in ISO 8601 format as understood by the server
+     */
+    void write(const char *key, const QDateTime &value);
+
+    /**
+     * @brief Array items
+     */
+    void write(const QString &value);
+    void write(QLatin1String value);
+
+    /**
+     * @brief Returns the JSON written so far
+     */
+    QByteArray data() const;
+
+  private:
+    Q_DISABLE_COPY(JsonWriter)
+
+    class Private;
+    Private * const d;
+};
+
+} // namespace KMGraph2
+
+#endif // LIBKMGRAPH2_JSONWRITER_H
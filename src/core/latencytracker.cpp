@@ -0,0 +1,116 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "latencytracker.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+
+#include <algorithm>
+
+using namespace KMGraph2;
+
+class Q_DECL_HIDDEN LatencyTracker::Private
+{
+  public:
+    int capacity;
+    int next;
+    QVector<int> samples;
+    mutable QMutex mutex;
+};
+
+LatencyTracker::LatencyTracker(int capacity):
+    d(new Private)
+{
+    d->capacity = qMax(1, capacity);
+    d->next = 0;
+    d->samples.reserve(d->capacity);
+}
+
+LatencyTracker::~LatencyTracker()
+{
+    delete d;
+}
+
+LatencyTracker *LatencyTracker::instance(const QByteArray &name)
+{
+    // Trackers live as long as the process, jobs only keep plain pointers
+    static QMutex mutex;
+    static QHash<QByteArray, LatencyTracker*> trackers;
+
+    QMutexLocker locker(&mutex);
+    LatencyTracker *&tracker = trackers[name];
+    if (!tracker) {
+        tracker = new LatencyTracker;
+    }
+    return tracker;
+}
+
+void LatencyTracker::addSample(int msecs)
+{
+    QMutexLocker locker(&d->mutex);
+    if (d->samples.size() < d->capacity) {
+        d->samples.append(qMax(0, msecs));
+    } else {
+        d->samples[d->next] = qMax(0, msecs);
+    }
+    d->next = (d->next + 1) % d->capacity;
+}
+
+int LatencyTracker::percentile(int percentile) const
+{
+    QVector<int> samples;
+    {
+        QMutexLocker locker(&d->mutex);
+        samples = d->samples;
+    }
+
+    if (samples.isEmpty()) {
+        return -1;
+    }
+
+    // Nearest-rank percentile
+    const int p = qBound(0, percentile, 100);
+    const int rank = qMax(1, (p * samples.size() + 99) / 100);
+    const auto nth = samples.begin() + (rank - 1);
+    std::nth_element(samples.begin(), nth, samples.end());
+    return *nth;
+}
+
+int LatencyTracker::sampleCount() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->samples.size();
+}
+
+int LatencyTracker::capacity() const
+{
+    return d->capacity;
+}
+
+void LatencyTracker::clear()
+{
+    QMutexLocker locker(&d->mutex);
+    d->samples.clear();
+    d->next = 0;
+}
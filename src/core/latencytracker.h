@@ -0,0 +1,77 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBKMGRAPH2_LATENCYTRACKER_H
+#define LIBKMGRAPH2_LATENCYTRACKER_H
+
+#include "kmgraphcore_export.h"
+
+#include <QByteArray>
+
+namespace KMGraph2
+{
+
+/**
+ * @brief Keeps a window of recent request latencies
+ *
+ * Job uses it to decide when a hedged request should be sent: the duplicate
+ * is only sent once the original request takes longer than a given
+ * percentile of the latencies observed by jobs of the same type.
+ *
+ * Only the last capacity() samples are kept, so the percentiles follow
+ * changes of network conditions. All methods are thread-safe.
+ *
+ * @internal
+ */
+class KMGRAPHCORE_EXPORT LatencyTracker
+{
+  public:
+    explicit LatencyTracker(int capacity = 128);
+    ~LatencyTracker();
+
+    /**
+     * @brief Returns the shared tracker for requests of @p name, which is
+     *        usually the class name of the job.
+     */
+    static LatencyTracker *instance(const QByteArray &name);
+
+    void addSample(int msecs);
+
+    /**
+     * @brief Returns the latency (in msecs) that @p percentile percent of
+     *        samples do not exceed, or -1 when there are no samples.
+     */
+    int percentile(int percentile) const;
+
+    int sampleCount() const;
+    int capacity() const;
+    void clear();
+
+  private:
+    Q_DISABLE_COPY(LatencyTracker)
+
+    class Private;
+    Private * const d;
+};
+
+} // namespace KMGraph2
+
+#endif // LIBKMGRAPH2_LATENCYTRACKER_H
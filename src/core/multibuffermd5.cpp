@@ -0,0 +1,128 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "multibuffermd5.h"
+#include "multibuffermd5_p.h"
+
+#if defined(KMGRAPH_HAVE_AVX2) && (defined(Q_CC_GNU) || defined(Q_CC_CLANG))
+#define KMGRAPH_DISPATCH_AVX2
+#endif
+
+using namespace KMGraph2;
+
+MultiBufferMd5::Engine MultiBufferMd5::bestEngine()
+{
+    static const Engine engine = isSupported(AVX2) ? AVX2 : isSupported(SSE2) ? SSE2 : Scalar;
+    return engine;
+}
+
+bool MultiBufferMd5::isSupported(Engine engine)
+{
+    switch (engine) {
+    case Scalar:
+        return true;
+    case SSE2:
+#if defined(__SSE2__)
+        return true;
+#else
+        return false;
+#endif
+    case AVX2:
+#if defined(KMGRAPH_DISPATCH_AVX2)
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+
+    return false;
+}
+
+int MultiBufferMd5::lanes(Engine engine)
+{
+    switch (engine) {
+    case Scalar:
+        return 1;
+    case SSE2:
+        return 4;
+    case AVX2:
+        return 8;
+    }
+
+    return 1;
+}
+
+QVector<QByteArray> MultiBufferMd5::hash(const QVector<Buffer> &buffers)
+{
+    return hash(buffers, bestEngine());
+}
+
+QVector<QByteArray> MultiBufferMd5::hash(const QVector<Buffer> &buffers, Engine engine)
+{
+    if (!isSupported(engine)) {
+        engine = bestEngine();
+    }
+
+    QByteArray digests(buffers.size() * 16, Qt::Uninitialized);
+    uchar *out = reinterpret_cast<uchar *>(digests.data());
+
+    switch (engine) {
+    case AVX2:
+#if defined(KMGRAPH_DISPATCH_AVX2)
+        Md5Private::hashAvx2(buffers.constData(), buffers.size(), out);
+        break;
+#else
+        Q_FALLTHROUGH();
+#endif
+    case SSE2:
+#if defined(__SSE2__)
+        md5HashBuffers<Sse2Ops>(buffers.constData(), buffers.size(), out);
+        break;
+#else
+        Q_FALLTHROUGH();
+#endif
+    case Scalar:
+        md5HashBuffers<ScalarOps>(buffers.constData(), buffers.size(), out);
+        break;
+    }
+
+    QVector<QByteArray> result;
+    result.reserve(buffers.size());
+    for (int i = 0; i < buffers.size(); ++i) {
+        result.append(digests.mid(i * 16, 16));
+    }
+    return result;
+}
+
+QVector<QByteArray> MultiBufferMd5::hash(const QVector<QByteArray> &buffers)
+{
+    return hash(buffers, bestEngine());
+}
+
+QVector<QByteArray> MultiBufferMd5::hash(const QVector<QByteArray> &buffers, Engine engine)
+{
+    QVector<Buffer> views;
+    views.reserve(buffers.size());
+    for (const QByteArray &buffer : buffers) {
+        views.append({ buffer.constData(), buffer.size() });
+    }
+    return hash(views, engine);
+}
@@ -0,0 +1,93 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBKMGRAPH2_MULTIBUFFERMD5_H
+#define LIBKMGRAPH2_MULTIBUFFERMD5_H
+
+#include "kmgraphcore_export.h"
+
+#include <QByteArray>
+#include <QVector>
+
+namespace KMGraph2
+{
+
+/**
+ * @brief Computes MD5 digests of many independent buffers at once
+ *
+ * MD5 itself cannot be parallelized, but the digests of independent buffers
+ * can be computed side by side, one buffer per SIMD lane. This is much faster
+ * than QCryptographicHash when verifying large amounts of small files.
+ *
+ * The best engine supported by the CPU is selected at runtime, with a
+ * portable scalar implementation as a fallback.
+ *
+ * @internal
+ */
+class KMGRAPHCORE_EXPORT MultiBufferMd5
+{
+  public:
+    enum Engine {
+        Scalar,  ///< One buffer at a time, portable C++.
+        SSE2,    ///< Four buffers at a time.
+        AVX2     ///< Eight buffers at a time.
+    };
+
+    /**
+     * @brief A buffer to hash. The data must stay valid until hash() returns.
+     */
+    struct Buffer {
+        const char *data;
+        qint64 size;
+    };
+
+    /**
+     * @brief Returns the fastest engine supported by this CPU.
+     */
+    static Engine bestEngine();
+
+    /**
+     * @brief Returns whether @p engine is supported by this build and CPU.
+     */
+    static bool isSupported(Engine engine);
+
+    /**
+     * @brief Returns number of buffers processed in parallel by @p engine.
+     */
+    static int lanes(Engine engine);
+
+    /**
+     * @brief Returns raw 16-byte MD5 digests of @p buffers, in the same order.
+     */
+    static QVector<QByteArray> hash(const QVector<Buffer> &buffers);
+    static QVector<QByteArray> hash(const QVector<Buffer> &buffers, Engine engine);
+
+    /**
+     * @brief Convenience overload of hash() for QByteArrays.
+     */
+    static QVector<QByteArray> hash(const QVector<QByteArray> &buffers);
+    static QVector<QByteArray> hash(const QVector<QByteArray> &buffers, Engine engine);
+};
+
+} // namespace KMGraph2
+
+Q_DECLARE_TYPEINFO(KMGraph2::MultiBufferMd5::Buffer, Q_PRIMITIVE_TYPE);
+
+#endif // LIBKMGRAPH2_MULTIBUFFERMD5_H
@@ -0,0 +1,33 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// This file is built with AVX2 code generation enabled. It must only be
+// entered after MultiBufferMd5::isSupported() has checked the CPU, and it
+// must not use any Qt or STL inline function or template, see
+// multibuffermd5_p.h. hashAvx2() should stay the only symbol this file
+// exports (check with nm).
+
+#include "multibuffermd5_p.h"
+
+void KMGraph2::Md5Private::hashAvx2(const MultiBufferMd5::Buffer *buffers, int count, uchar *digests)
+{
+    md5HashBuffers<Avx2Ops>(buffers, count, digests);
+}
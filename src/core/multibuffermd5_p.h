@@ -0,0 +1,373 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBKMGRAPH2_MULTIBUFFERMD5_P_H
+#define LIBKMGRAPH2_MULTIBUFFERMD5_P_H
+
+#include "multibuffermd5.h"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace KMGraph2
+{
+
+namespace Md5Private
+{
+
+// Implemented in multibuffermd5_avx2.cpp, which is built with AVX2 enabled
+Q_DECL_HIDDEN void hashAvx2(const MultiBufferMd5::Buffer *buffers, int count, uchar *digests);
+
+} // namespace Md5Private
+
+} // namespace KMGraph2
+
+// Everything below is instantiated separately in every translation unit
+// that includes this header, with whatever instruction set that translation
+// unit is built for. The anonymous namespace gives it internal linkage, so
+// the linker never merges an AVX2 instantiation into code that runs on CPUs
+// without AVX2.
+//
+// That only holds for code defined here. Inline functions and templates with
+// external linkage (qFromLittleEndian(), QVector, std::sort, ...) used from
+// the AVX2 translation unit are emitted there as weak symbols, and the linker
+// is free to keep that copy for every caller in the library. So the code
+// below must only use intrinsics, plain C functions and the helpers in this
+// namespace.
+namespace {
+
+inline quint32 loadLittleEndian32(const uchar *p)
+{
+    return quint32(p[0]) | (quint32(p[1]) << 8) | (quint32(p[2]) << 16) | (quint32(p[3]) << 24);
+}
+
+inline void storeLittleEndian32(quint32 v, uchar *p)
+{
+    p[0] = uchar(v);
+    p[1] = uchar(v >> 8);
+    p[2] = uchar(v >> 16);
+    p[3] = uchar(v >> 24);
+}
+
+inline void storeLittleEndian64(quint64 v, uchar *p)
+{
+    storeLittleEndian32(quint32(v), p);
+    storeLittleEndian32(quint32(v >> 32), p + 4);
+}
+
+struct ScalarOps
+{
+    typedef quint32 Vec;
+    enum { Lanes = 1 };
+
+    static inline Vec set1(quint32 v) { return v; }
+    static inline Vec load(const quint32 *v) { return *v; }
+    static inline void store(quint32 *out, Vec v) { *out = v; }
+    static inline Vec add(Vec a, Vec b) { return a + b; }
+    static inline Vec bitAnd(Vec a, Vec b) { return a & b; }
+    static inline Vec bitOr(Vec a, Vec b) { return a | b; }
+    static inline Vec bitXor(Vec a, Vec b) { return a ^ b; }
+    static inline Vec andNot(Vec a, Vec b) { return ~a & b; }
+    static inline Vec bitNot(Vec a) { return ~a; }
+    template<int S> static inline Vec rotl(Vec a) { return (a << S) | (a >> (32 - S)); }
+    static inline Vec word(const uchar *const *blocks, int i)
+    {
+        return loadLittleEndian32(blocks[0] + i * 4);
+    }
+};
+
+#if defined(__SSE2__)
+struct Sse2Ops
+{
+    typedef __m128i Vec;
+    enum { Lanes = 4 };
+
+    static inline Vec set1(quint32 v) { return _mm_set1_epi32(int(v)); }
+    static inline Vec load(const quint32 *v) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(v)); }
+    static inline void store(quint32 *out, Vec v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(out), v); }
+    static inline Vec add(Vec a, Vec b) { return _mm_add_epi32(a, b); }
+    static inline Vec bitAnd(Vec a, Vec b) { return _mm_and_si128(a, b); }
+    static inline Vec bitOr(Vec a, Vec b) { return _mm_or_si128(a, b); }
+    static inline Vec bitXor(Vec a, Vec b) { return _mm_xor_si128(a, b); }
+    static inline Vec andNot(Vec a, Vec b) { return _mm_andnot_si128(a, b); }
+    static inline Vec bitNot(Vec a) { return _mm_xor_si128(a, _mm_set1_epi32(-1)); }
+    template<int S> static inline Vec rotl(Vec a) { return _mm_or_si128(_mm_slli_epi32(a, S), _mm_srli_epi32(a, 32 - S)); }
+    static inline Vec word(const uchar *const *blocks, int i)
+    {
+        return _mm_set_epi32(int(loadLittleEndian32(blocks[3] + i * 4)),
+                             int(loadLittleEndian32(blocks[2] + i * 4)),
+                             int(loadLittleEndian32(blocks[1] + i * 4)),
+                             int(loadLittleEndian32(blocks[0] + i * 4)));
+    }
+};
+#endif
+
+#if defined(__AVX2__)
+struct Avx2Ops
+{
+    typedef __m256i Vec;
+    enum { Lanes = 8 };
+
+    static inline Vec set1(quint32 v) { return _mm256_set1_epi32(int(v)); }
+    static inline Vec load(const quint32 *v) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(v)); }
+    static inline void store(quint32 *out, Vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), v); }
+    static inline Vec add(Vec a, Vec b) { return _mm256_add_epi32(a, b); }
+    static inline Vec bitAnd(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+    static inline Vec bitOr(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+    static inline Vec bitXor(Vec a, Vec b) { return _mm256_xor_si256(a, b); }
+    static inline Vec andNot(Vec a, Vec b) { return _mm256_andnot_si256(a, b); }
+    static inline Vec bitNot(Vec a) { return _mm256_xor_si256(a, _mm256_set1_epi32(-1)); }
+    template<int S> static inline Vec rotl(Vec a) { return _mm256_or_si256(_mm256_slli_epi32(a, S), _mm256_srli_epi32(a, 32 - S)); }
+    static inline Vec word(const uchar *const *blocks, int i)
+    {
+        return _mm256_set_epi32(int(loadLittleEndian32(blocks[7] + i * 4)),
+                                int(loadLittleEndian32(blocks[6] + i * 4)),
+                                int(loadLittleEndian32(blocks[5] + i * 4)),
+                                int(loadLittleEndian32(blocks[4] + i * 4)),
+                                int(loadLittleEndian32(blocks[3] + i * 4)),
+                                int(loadLittleEndian32(blocks[2] + i * 4)),
+                                int(loadLittleEndian32(blocks[1] + i * 4)),
+                                int(loadLittleEndian32(blocks[0] + i * 4)));
+    }
+};
+#endif
+
+template<typename Ops>
+struct Md5Rounds
+{
+    typedef typename Ops::Vec Vec;
+
+    static inline Vec F(Vec x, Vec y, Vec z) { return Ops::bitOr(Ops::bitAnd(x, y), Ops::andNot(x, z)); }
+    static inline Vec G(Vec x, Vec y, Vec z) { return Ops::bitOr(Ops::bitAnd(x, z), Ops::andNot(z, y)); }
+    static inline Vec H(Vec x, Vec y, Vec z) { return Ops::bitXor(Ops::bitXor(x, y), z); }
+    static inline Vec I(Vec x, Vec y, Vec z) { return Ops::bitXor(y, Ops::bitOr(x, Ops::bitNot(z))); }
+
+    template<int S>
+    static inline void step(Vec &a, Vec b, Vec f, Vec x, quint32 t)
+    {
+        a = Ops::add(b, Ops::template rotl<S>(Ops::add(Ops::add(a, f), Ops::add(x, Ops::set1(t)))));
+    }
+
+    // Processes one 64-byte block of every lane, see RFC 1321
+    static void compress(quint32 *state, const uchar *const *blocks)
+    {
+        Vec x[16];
+        for (int i = 0; i < 16; ++i) {
+            x[i] = Ops::word(blocks, i);
+        }
+
+        const Vec a0 = Ops::load(state);
+        const Vec b0 = Ops::load(state + Ops::Lanes);
+        const Vec c0 = Ops::load(state + 2 * Ops::Lanes);
+        const Vec d0 = Ops::load(state + 3 * Ops::Lanes);
+        Vec a = a0, b = b0, c = c0, d = d0;
+
+        step<7>(a, b, F(b, c, d), x[0], 0xd76aa478);
+        step<12>(d, a, F(a, b, c), x[1], 0xe8c7b756);
+        step<17>(c, d, F(d, a, b), x[2], 0x242070db);
+        step<22>(b, c, F(c, d, a), x[3], 0xc1bdceee);
+        step<7>(a, b, F(b, c, d), x[4], 0xf57c0faf);
+        step<12>(d, a, F(a, b, c), x[5], 0x4787c62a);
+        step<17>(c, d, F(d, a, b), x[6], 0xa8304613);
+        step<22>(b, c, F(c, d, a), x[7], 0xfd469501);
+        step<7>(a, b, F(b, c, d), x[8], 0x698098d8);
+        step<12>(d, a, F(a, b, c), x[9], 0x8b44f7af);
+        step<17>(c, d, F(d, a, b), x[10], 0xffff5bb1);
+        step<22>(b, c, F(c, d, a), x[11], 0x895cd7be);
+        step<7>(a, b, F(b, c, d), x[12], 0x6b901122);
+        step<12>(d, a, F(a, b, c), x[13], 0xfd987193);
+        step<17>(c, d, F(d, a, b), x[14], 0xa679438e);
+        step<22>(b, c, F(c, d, a), x[15], 0x49b40821);
+
+        step<5>(a, b, G(b, c, d), x[1], 0xf61e2562);
+        step<9>(d, a, G(a, b, c), x[6], 0xc040b340);
+        step<14>(c, d, G(d, a, b), x[11], 0x265e5a51);
+        step<20>(b, c, G(c, d, a), x[0], 0xe9b6c7aa);
+        step<5>(a, b, G(b, c, d), x[5], 0xd62f105d);
+        step<9>(d, a, G(a, b, c), x[10], 0x02441453);
+        step<14>(c, d, G(d, a, b), x[15], 0xd8a1e681);
+        step<20>(b, c, G(c, d, a), x[4], 0xe7d3fbc8);
+        step<5>(a, b, G(b, c, d), x[9], 0x21e1cde6);
+        step<9>(d, a, G(a, b, c), x[14], 0xc33707d6);
+        step<14>(c, d, G(d, a, b), x[3], 0xf4d50d87);
+        step<20>(b, c, G(c, d, a), x[8], 0x455a14ed);
+        step<5>(a, b, G(b, c, d), x[13], 0xa9e3e905);
+        step<9>(d, a, G(a, b, c), x[2], 0xfcefa3f8);
+        step<14>(c, d, G(d, a, b), x[7], 0x676f02d9);
+        step<20>(b, c, G(c, d, a), x[12], 0x8d2a4c8a);
+
+        step<4>(a, b, H(b, c, d), x[5], 0xfffa3942);
+        step<11>(d, a, H(a, b, c), x[8], 0x8771f681);
+        step<16>(c, d, H(d, a, b), x[11], 0x6d9d6122);
+        step<23>(b, c, H(c, d, a), x[14], 0xfde5380c);
+        step<4>(a, b, H(b, c, d), x[1], 0xa4beea44);
+        step<11>(d, a, H(a, b, c), x[4], 0x4bdecfa9);
+        step<16>(c, d, H(d, a, b), x[7], 0xf6bb4b60);
+        step<23>(b, c, H(c, d, a), x[10], 0xbebfbc70);
+        step<4>(a, b, H(b, c, d), x[13], 0x289b7ec6);
+        step<11>(d, a, H(a, b, c), x[0], 0xeaa127fa);
+        step<16>(c, d, H(d, a, b), x[3], 0xd4ef3085);
+        step<23>(b, c, H(c, d, a), x[6], 0x04881d05);
+        step<4>(a, b, H(b, c, d), x[9], 0xd9d4d039);
+        step<11>(d, a, H(a, b, c), x[12], 0xe6db99e5);
+        step<16>(c, d, H(d, a, b), x[15], 0x1fa27cf8);
+        step<23>(b, c, H(c, d, a), x[2], 0xc4ac5665);
+
+        step<6>(a, b, I(b, c, d), x[0], 0xf4292244);
+        step<10>(d, a, I(a, b, c), x[7], 0x432aff97);
+        step<15>(c, d, I(d, a, b), x[14], 0xab9423a7);
+        step<21>(b, c, I(c, d, a), x[5], 0xfc93a039);
+        step<6>(a, b, I(b, c, d), x[12], 0x655b59c3);
+        step<10>(d, a, I(a, b, c), x[3], 0x8f0ccc92);
+        step<15>(c, d, I(d, a, b), x[10], 0xffeff47d);
+        step<21>(b, c, I(c, d, a), x[1], 0x85845dd1);
+        step<6>(a, b, I(b, c, d), x[8], 0x6fa87e4f);
+        step<10>(d, a, I(a, b, c), x[15], 0xfe2ce6e0);
+        step<15>(c, d, I(d, a, b), x[6], 0xa3014314);
+        step<21>(b, c, I(c, d, a), x[13], 0x4e0811a1);
+        step<6>(a, b, I(b, c, d), x[4], 0xf7537e82);
+        step<10>(d, a, I(a, b, c), x[11], 0xbd3af235);
+        step<15>(c, d, I(d, a, b), x[2], 0x2ad7d2bb);
+        step<21>(b, c, I(c, d, a), x[9], 0xeb86d391);
+
+        Ops::store(state, Ops::add(a, a0));
+        Ops::store(state + Ops::Lanes, Ops::add(b, b0));
+        Ops::store(state + 2 * Ops::Lanes, Ops::add(c, c0));
+        Ops::store(state + 3 * Ops::Lanes, Ops::add(d, d0));
+    }
+};
+
+/**
+ * Feeds the buffers through the lanes of Ops. Whenever a lane finishes its
+ * buffer, the next pending buffer is scheduled on it, so all lanes are busy
+ * until the very end, no matter how the sizes of the buffers vary.
+ *
+ * @p digests must have room for 16 bytes per buffer.
+ */
+template<typename Ops>
+void md5HashBuffers(const KMGraph2::MultiBufferMd5::Buffer *buffers, int count, uchar *digests)
+{
+    enum { Lanes = Ops::Lanes };
+
+    struct Lane {
+        int buffer;               // index of the buffer, or -1 when the lane is idle
+        const uchar *data;
+        qint64 fullBlocks;        // blocks still to be read directly from data
+        int tailBlocks;           // padded blocks still to be read from tail
+        int tailOffset;           // offset of the next padded block in tail
+        uchar tail[128];
+    };
+
+    static const uchar idleBlock[64] = { 0 };
+
+    // Lane-major state: all A words, then all B words, ...
+    quint32 state[4 * Lanes];
+    Lane lanes[Lanes];
+    const uchar *blocks[Lanes];
+
+    int next = 0;
+    const auto schedule = [&](int l) {
+        Lane &lane = lanes[l];
+        if (next >= count) {
+            lane.buffer = -1;
+            return false;
+        }
+
+        const KMGraph2::MultiBufferMd5::Buffer &buffer = buffers[next];
+        lane.buffer = next++;
+        lane.data = reinterpret_cast<const uchar *>(buffer.data);
+        lane.fullBlocks = buffer.size / 64;
+
+        const int rest = int(buffer.size % 64);
+        lane.tailBlocks = rest < 56 ? 1 : 2;
+        lane.tailOffset = 0;
+        std::memset(lane.tail, 0, sizeof(lane.tail));
+        if (rest > 0) {
+            std::memcpy(lane.tail, lane.data + lane.fullBlocks * 64, rest);
+        }
+        lane.tail[rest] = 0x80;
+        storeLittleEndian64(quint64(buffer.size) * 8, lane.tail + lane.tailBlocks * 64 - 8);
+
+        state[l] = 0x67452301;
+        state[Lanes + l] = 0xefcdab89;
+        state[2 * Lanes + l] = 0x98badcfe;
+        state[3 * Lanes + l] = 0x10325476;
+        return true;
+    };
+
+    int active = 0;
+    for (int l = 0; l < Lanes; ++l) {
+        if (schedule(l)) {
+            ++active;
+        }
+    }
+
+    while (active > 0) {
+        for (int l = 0; l < Lanes; ++l) {
+            const Lane &lane = lanes[l];
+            if (lane.buffer < 0) {
+                blocks[l] = idleBlock;
+            } else if (lane.fullBlocks > 0) {
+                blocks[l] = lane.data;
+            } else {
+                blocks[l] = lane.tail + lane.tailOffset;
+            }
+        }
+
+        Md5Rounds<Ops>::compress(state, blocks);
+
+        for (int l = 0; l < Lanes; ++l) {
+            Lane &lane = lanes[l];
+            if (lane.buffer < 0) {
+                continue;
+            }
+
+            if (lane.fullBlocks > 0) {
+                lane.data += 64;
+                --lane.fullBlocks;
+                continue;
+            }
+
+            lane.tailOffset += 64;
+            if (--lane.tailBlocks > 0) {
+                continue;
+            }
+
+            uchar *digest = digests + lane.buffer * 16;
+            for (int i = 0; i < 4; ++i) {
+                storeLittleEndian32(state[i * Lanes + l], digest + i * 4);
+            }
+
+            if (!schedule(l)) {
+                --active;
+            }
+        }
+    }
+}
+
+} // namespace
+
+#endif // LIBKMGRAPH2_MULTIBUFFERMD5_P_H
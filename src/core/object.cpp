@@ -21,12 +21,15 @@
  */
 
 #include "object.h"
+#include "objectpool.h"
 
 using namespace KMGraph2;
 
-class Q_DECL_HIDDEN Object::Private
+class Q_DECL_HIDDEN Object::Private : public QSharedData
 {
   public:
+    KMGRAPH_POOLED_ALLOCATION
+
     Private();
     Private(const Private& other);
 
@@ -48,13 +51,18 @@ Object::Object():
 }
 
 Object::Object(const Object& other):
-    d(new Private(*(other.d)))
+    d(other.d)
 {
 }
 
 Object::~Object()
 {
-    delete d;
+}
+
+Object &Object::operator=(const Object &other)
+{
+    d = other.d;
+    return *this;
 }
 
 void Object::setEtag(const QString& etag)
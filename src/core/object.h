@@ -25,6 +25,7 @@
 
 #include <QString>
 #include <QSharedPointer>
+#include <QSharedDataPointer>
 
 #include "types.h"
 #include "kmgraphcore_export.h"
@@ -54,6 +55,7 @@ class KMGRAPHCORE_EXPORT Object
      * @brief Copy constructor
      */
     Object(const Object &other);
+    Object &operator=(const Object &other);
 
     /**
      * @brief Destructor
@@ -79,7 +81,7 @@ class KMGRAPHCORE_EXPORT Object
 
   private:
     class Private;
-    Private * const d;
+    QSharedDataPointer<Private> d;
     friend class Private;
 
 };
@@ -0,0 +1,140 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "objectpool.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <cstdlib>
+
+using namespace KMGraph2;
+
+namespace {
+
+constexpr std::size_t Granularity = 16;
+constexpr std::size_t MaxObjectSize = 1024;
+constexpr std::size_t SizeClassCount = MaxObjectSize / Granularity;
+constexpr std::size_t ChunkSize = 64 * 1024;
+
+struct FreeNode {
+    FreeNode *next;
+};
+
+// Shared by all threads, objects may be freed elsewhere than allocated
+struct SizeClass {
+    QBasicMutex mutex;
+    FreeNode *freeList;
+    char *chunkPos;
+    char *chunkEnd;
+    quint64 allocations;
+    quint64 deallocations;
+    quint64 chunks;
+};
+
+// Zero-initialized before any dynamic initialization takes place
+SizeClass sizeClasses[SizeClassCount];
+
+inline std::size_t sizeClassIndex(std::size_t size)
+{
+    return (size + Granularity - 1) / Granularity - 1;
+}
+
+bool poolEnabled()
+{
+    static const bool enabled = qEnvironmentVariableIsEmpty("KMGRAPH_NO_OBJECT_POOL");
+    return enabled;
+}
+
+}
+
+void *ObjectPool::allocate(std::size_t size)
+{
+    if (size == 0 || size > MaxObjectSize || !poolEnabled()) {
+        return ::operator new(size);
+    }
+
+    const std::size_t index = sizeClassIndex(size);
+    SizeClass &sizeClass = sizeClasses[index];
+
+    QMutexLocker locker(&sizeClass.mutex);
+    ++sizeClass.allocations;
+    if (FreeNode *node = sizeClass.freeList) {
+        sizeClass.freeList = node->next;
+        return node;
+    }
+
+    const std::size_t objectSize = (index + 1) * Granularity;
+    if (!sizeClass.chunkPos || std::size_t(sizeClass.chunkEnd - sizeClass.chunkPos) < objectSize) {
+        // The rest of the previous chunk is too small and is left unused
+        char *chunk = static_cast<char *>(std::malloc(ChunkSize));
+        Q_CHECK_PTR(chunk);
+        sizeClass.chunkPos = chunk;
+        sizeClass.chunkEnd = chunk + ChunkSize;
+        ++sizeClass.chunks;
+    }
+
+    void *ptr = sizeClass.chunkPos;
+    sizeClass.chunkPos += objectSize;
+    return ptr;
+}
+
+void ObjectPool::deallocate(void *ptr, std::size_t size)
+{
+    if (!ptr) {
+        return;
+    }
+    if (size == 0 || size > MaxObjectSize || !poolEnabled()) {
+        ::operator delete(ptr);
+        return;
+    }
+
+    SizeClass &sizeClass = sizeClasses[sizeClassIndex(size)];
+
+    QMutexLocker locker(&sizeClass.mutex);
+    ++sizeClass.deallocations;
+    FreeNode *node = static_cast<FreeNode *>(ptr);
+    node->next = sizeClass.freeList;
+    sizeClass.freeList = node;
+}
+
+bool ObjectPool::isEnabled()
+{
+    return poolEnabled();
+}
+
+std::size_t ObjectPool::maxObjectSize()
+{
+    return MaxObjectSize;
+}
+
+ObjectPool::Stats ObjectPool::stats()
+{
+    Stats stats = { 0, 0, 0, 0 };
+    for (SizeClass &sizeClass : sizeClasses) {
+        QMutexLocker locker(&sizeClass.mutex);
+        stats.allocations += sizeClass.allocations;
+        stats.deallocations += sizeClass.deallocations;
+        stats.chunks += sizeClass.chunks;
+    }
+    stats.chunkSize = stats.chunks * ChunkSize;
+    return stats;
+}
@@ -0,0 +1,85 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBKMGRAPH2_OBJECTPOOL_H
+#define LIBKMGRAPH2_OBJECTPOOL_H
+
+#include "kmgraphcore_export.h"
+
+#include <QtGlobal>
+
+#include <cstddef>
+
+namespace KMGraph2
+{
+
+/**
+ * @brief Pool of memory for small, frequently allocated objects
+ *
+ * Parsing a single file from a feed allocates dozens of small private
+ * objects. The pool serves them from large chunks, keeping a free list for
+ * every size class, which is cheaper than going to malloc every time and keeps
+ * objects parsed together close to each other in memory.
+ *
+ * Chunks are never returned to the system: the pool stays at the size of
+ * the largest number of objects alive at once, and freed objects are only
+ * reused for new objects of the same size class. Objects larger than
+ * maxObjectSize() are allocated normally.
+ *
+ * Every size class has a single free list guarded by a mutex, so each
+ * allocation and deallocation takes a lock. Objects are often parsed in one
+ * thread and released in another one, which per-thread free lists would
+ * have to hand memory back for. Parsing usually happens in a single thread,
+ * where the lock is never contended, but many threads allocating objects
+ * of the same size at once will serialize on it.
+ *
+ * Set KMGRAPH_NO_OBJECT_POOL environment variable to bypass the pool, e.g.
+ * when looking for memory errors with valgrind or sanitizers.
+ *
+ * Classes opt in by adding KMGRAPH_POOLED_ALLOCATION to their declaration.
+ *
+ * @internal
+ */
+class KMGRAPHCORE_EXPORT ObjectPool
+{
+  public:
+    struct Stats {
+        quint64 allocations;     ///< Number of objects allocated from the pool
+        quint64 deallocations;   ///< Number of objects returned to the pool
+        quint64 chunks;          ///< Number of chunks allocated by the pool
+        quint64 chunkSize;       ///< Total size of all chunks, in bytes
+    };
+
+    static void *allocate(std::size_t size);
+    static void deallocate(void *ptr, std::size_t size);
+
+    static bool isEnabled();
+    static std::size_t maxObjectSize();
+    static Stats stats();
+};
+
+} // namespace KMGraph2
+
+#define KMGRAPH_POOLED_ALLOCATION \
+    static void *operator new(std::size_t size) { return KMGraph2::ObjectPool::allocate(size); } \
+    static void operator delete(void *ptr, std::size_t size) { KMGraph2::ObjectPool::deallocate(ptr, size); }
+
+#endif // LIBKMGRAPH2_OBJECTPOOL_H
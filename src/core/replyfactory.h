@@ -0,0 +1,69 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBKMGRAPH2_REPLYFACTORY_H
+#define LIBKMGRAPH2_REPLYFACTORY_H
+
+#include "kmgraphcore_export.h"
+
+#include <QNetworkAccessManager>
+
+#include <functional>
+
+class QIODevice;
+class QNetworkReply;
+class QNetworkRequest;
+
+namespace KMGraph2
+{
+
+/**
+ * @brief Creates network replies of jobs instead of KIO
+ *
+ * Jobs send their requests through KIO. Tests install a factory that
+ * answers the requests without talking to a server, so that retries,
+ * timeouts and the like can be exercised on real jobs.
+ *
+ * Every thread has its own factory.
+ *
+ * @internal
+ */
+class KMGRAPHCORE_EXPORT ReplyFactory
+{
+  public:
+    typedef std::function<QNetworkReply*(QNetworkAccessManager::Operation op,
+                                         const QNetworkRequest &request,
+                                         QIODevice *outgoingData)> Factory;
+
+    /**
+     * @brief Makes jobs in the calling thread create their replies with
+     *        @p factory, or through KIO again when @p factory is empty.
+     */
+    static void setFactory(const Factory &factory);
+
+    /**
+     * @brief Returns factory of the calling thread, empty when jobs use KIO.
+     */
+    static Factory factory();
+};
+
+} // namespace KMGraph2
+
+#endif // LIBKMGRAPH2_REPLYFACTORY_H
@@ -0,0 +1,434 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "requestcoalescer.h"
+
+#include <QHash>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QPointer>
+#include <QThreadStorage>
+
+#include <algorithm>
+#include <cstring>
+
+namespace KMGraph2
+{
+
+class SharedRequest;
+typedef QHash<QByteArray, SharedRequest*> SharedRequests;
+
+/**
+ * Reply handed to a single requester, mirrors the shared reply
+ */
+class Q_DECL_HIDDEN CoalescedReply : public QNetworkReply
+{
+    Q_OBJECT
+
+  public:
+    CoalescedReply(SharedRequest *shared, const QNetworkRequest &request, QObject *parent);
+    ~CoalescedReply() override;
+
+    void abort() override;
+    bool isSequential() const override;
+    qint64 bytesAvailable() const override;
+
+    void copyMetaData(const QNetworkReply *reply);
+    void appendData(const QByteArray &data);
+    void finish(QNetworkReply::NetworkError error, const QString &errorString);
+
+    SharedRequest *shared;
+    bool duplicate;
+
+  protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+
+  private:
+    QByteArray mBuffer;
+};
+
+/**
+ * The request that has actually been sent, and replies attached to it
+ */
+class Q_DECL_HIDDEN SharedRequest : public QObject
+{
+    Q_OBJECT
+
+  public:
+    SharedRequest(SharedRequests *requests, const QByteArray &key, QNetworkReply *reply);
+
+    void attach(CoalescedReply *reply);
+    void detach(CoalescedReply *reply);
+    bool hasResponded() const;
+    void forgetRequests();
+
+  private:
+    void onMetaDataChanged();
+    void onReadyRead();
+    void onDownloadProgress(qint64 received, qint64 total);
+    void onFinished();
+    void onDestroyed();
+
+    void release();
+    QList<QPointer<CoalescedReply> > attachedReplies() const;
+
+    SharedRequests *mRequests;
+    QByteArray mKey;
+    QNetworkReply *mReply;
+    QList<CoalescedReply*> mAttached;
+    bool mResponded;
+};
+
+}
+
+using namespace KMGraph2;
+
+namespace {
+
+const QNetworkRequest::Attribute CopiedAttributes[] = {
+    QNetworkRequest::HttpStatusCodeAttribute,
+    QNetworkRequest::HttpReasonPhraseAttribute,
+    QNetworkRequest::RedirectionTargetAttribute,
+    QNetworkRequest::ConnectionEncryptedAttribute,
+    QNetworkRequest::SourceIsFromCacheAttribute,
+    // KIO stores its meta data and error code here
+    QNetworkRequest::User,
+    QNetworkRequest::Attribute(QNetworkRequest::User + 1)
+};
+
+// Requests with the same URL and headers (including Authorization, i.e. the
+// account) are considered identical
+QByteArray requestKey(const QNetworkRequest &request)
+{
+    QList<QByteArray> headers = request.rawHeaderList();
+    std::sort(headers.begin(), headers.end());
+
+    QByteArray key = request.url().toEncoded();
+    for (const QByteArray &header : qAsConst(headers)) {
+        key += '\n' + header + ": " + request.rawHeader(header);
+    }
+    return key;
+}
+
+}
+
+CoalescedReply::CoalescedReply(SharedRequest *shared, const QNetworkRequest &request, QObject *parent):
+    QNetworkReply(parent),
+    shared(shared),
+    duplicate(false)
+{
+    setRequest(request);
+    setUrl(request.url());
+    setOperation(QNetworkAccessManager::GetOperation);
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+CoalescedReply::~CoalescedReply()
+{
+    if (shared) {
+        shared->detach(this);
+    }
+}
+
+void CoalescedReply::abort()
+{
+    if (isFinished()) {
+        return;
+    }
+
+    if (shared) {
+        shared->detach(this);
+        shared = nullptr;
+    }
+    finish(QNetworkReply::OperationCanceledError, tr("Operation canceled"));
+}
+
+bool CoalescedReply::isSequential() const
+{
+    return true;
+}
+
+qint64 CoalescedReply::bytesAvailable() const
+{
+    return mBuffer.size() + QNetworkReply::bytesAvailable();
+}
+
+void CoalescedReply::copyMetaData(const QNetworkReply *reply)
+{
+    setUrl(reply->url());
+    for (const QNetworkRequest::Attribute attribute : CopiedAttributes) {
+        setAttribute(attribute, reply->attribute(attribute));
+    }
+    const auto headers = reply->rawHeaderPairs();
+    for (const QNetworkReply::RawHeaderPair &header : headers) {
+        setRawHeader(header.first, header.second);
+    }
+}
+
+void CoalescedReply::appendData(const QByteArray &data)
+{
+    mBuffer.append(data);
+}
+
+void CoalescedReply::finish(QNetworkReply::NetworkError error, const QString &errorString)
+{
+    shared = nullptr;
+    if (error != QNetworkReply::NoError) {
+        setError(error, errorString);
+    }
+    setFinished(true);
+
+    if (!mBuffer.isEmpty()) {
+        Q_EMIT readyRead();
+    }
+    Q_EMIT finished();
+}
+
+qint64 CoalescedReply::readData(char *data, qint64 maxSize)
+{
+    if (mBuffer.isEmpty()) {
+        return isFinished() ? -1 : 0;
+    }
+
+    const int size = int(qMin<qint64>(maxSize, mBuffer.size()));
+    memcpy(data, mBuffer.constData(), size);
+    mBuffer.remove(0, size);
+    return size;
+}
+
+
+SharedRequest::SharedRequest(SharedRequests *requests, const QByteArray &key, QNetworkReply *reply):
+    mRequests(requests),
+    mKey(key),
+    mReply(reply),
+    mResponded(false)
+{
+    connect(reply, &QNetworkReply::metaDataChanged, this, &SharedRequest::onMetaDataChanged);
+    connect(reply, &QNetworkReply::readyRead, this, &SharedRequest::onReadyRead);
+    connect(reply, &QNetworkReply::downloadProgress, this, &SharedRequest::onDownloadProgress);
+    connect(reply, &QNetworkReply::finished, this, &SharedRequest::onFinished);
+    connect(reply, &QObject::destroyed, this, &SharedRequest::onDestroyed);
+}
+
+void SharedRequest::attach(CoalescedReply *reply)
+{
+    mAttached << reply;
+}
+
+void SharedRequest::detach(CoalescedReply *reply)
+{
+    mAttached.removeOne(reply);
+    if (!mAttached.isEmpty() || !mReply) {
+        return;
+    }
+
+    // Nobody is interested anymore
+    QNetworkReply *networkReply = mReply;
+    release();
+    networkReply->abort();
+    networkReply->deleteLater();
+    deleteLater();
+}
+
+bool SharedRequest::hasResponded() const
+{
+    return mResponded;
+}
+
+void SharedRequest::forgetRequests()
+{
+    mRequests = nullptr;
+}
+
+void SharedRequest::onMetaDataChanged()
+{
+    mResponded = true;
+    for (const QPointer<CoalescedReply> &reply : attachedReplies()) {
+        if (reply && reply->shared == this) {
+            reply->copyMetaData(mReply);
+            Q_EMIT reply->metaDataChanged();
+        }
+    }
+}
+
+void SharedRequest::onReadyRead()
+{
+    mResponded = true;
+    const QByteArray data = mReply->readAll();
+    if (data.isEmpty()) {
+        return;
+    }
+
+    for (const QPointer<CoalescedReply> &reply : attachedReplies()) {
+        if (reply && reply->shared == this) {
+            reply->appendData(data);
+            Q_EMIT reply->readyRead();
+        }
+    }
+}
+
+void SharedRequest::onDownloadProgress(qint64 received, qint64 total)
+{
+    for (const QPointer<CoalescedReply> &reply : attachedReplies()) {
+        if (reply && reply->shared == this) {
+            Q_EMIT reply->downloadProgress(received, total);
+        }
+    }
+}
+
+void SharedRequest::onFinished()
+{
+    QNetworkReply *networkReply = mReply;
+    const QList<QPointer<CoalescedReply> > replies = attachedReplies();
+    // Requests sent from now on must not join this one
+    release();
+
+    const QByteArray data = networkReply->readAll();
+    bool delivered = false;
+    for (const QPointer<CoalescedReply> &reply : replies) {
+        if (reply && reply->shared == this) {
+            reply->duplicate = delivered;
+            delivered = true;
+            reply->copyMetaData(networkReply);
+            reply->appendData(data);
+            reply->finish(networkReply->error(), networkReply->errorString());
+        }
+    }
+
+    networkReply->deleteLater();
+    deleteLater();
+}
+
+void SharedRequest::onDestroyed()
+{
+    // The reply has been deleted together with the manager that sent it
+    mReply = nullptr;
+    const QList<QPointer<CoalescedReply> > replies = attachedReplies();
+    release();
+
+    for (const QPointer<CoalescedReply> &reply : replies) {
+        if (reply && reply->shared == this) {
+            reply->finish(QNetworkReply::OperationCanceledError, tr("Operation canceled"));
+        }
+    }
+    deleteLater();
+}
+
+void SharedRequest::release()
+{
+    if (mRequests && mRequests->value(mKey) == this) {
+        mRequests->remove(mKey);
+    }
+    if (mReply) {
+        disconnect(mReply, nullptr, this, nullptr);
+        mReply = nullptr;
+    }
+}
+
+QList<QPointer<CoalescedReply> > SharedRequest::attachedReplies() const
+{
+    // Replies may be detached by whoever reacts to their signals
+    QList<QPointer<CoalescedReply> > replies;
+    replies.reserve(mAttached.size());
+    for (CoalescedReply *reply : mAttached) {
+        replies << reply;
+    }
+    return replies;
+}
+
+
+class Q_DECL_HIDDEN RequestCoalescer::Private
+{
+  public:
+    SharedRequests requests;
+    bool enabled;
+};
+
+RequestCoalescer::RequestCoalescer():
+    d(new Private)
+{
+    d->enabled = true;
+}
+
+RequestCoalescer::~RequestCoalescer()
+{
+    for (SharedRequest *request : qAsConst(d->requests)) {
+        request->forgetRequests();
+    }
+    delete d;
+}
+
+RequestCoalescer *RequestCoalescer::instance()
+{
+    static QThreadStorage<RequestCoalescer*> coalescers;
+    if (!coalescers.hasLocalData()) {
+        coalescers.setLocalData(new RequestCoalescer);
+    }
+    return coalescers.localData();
+}
+
+QNetworkReply *RequestCoalescer::get(const QNetworkRequest &request, const Sender &send, QObject *parent)
+{
+    if (!d->enabled) {
+        return send();
+    }
+
+    const QByteArray key = requestKey(request);
+    SharedRequest *shared = d->requests.value(key);
+    // Data that have already been delivered are gone, start over
+    if (!shared || shared->hasResponded()) {
+        QNetworkReply *networkReply = send();
+        if (!networkReply) {
+            return nullptr;
+        }
+        shared = new SharedRequest(&d->requests, key, networkReply);
+        // The requester that sent it may go away long before the others
+        networkReply->setParent(shared);
+        d->requests.insert(key, shared);
+    }
+
+    CoalescedReply *reply = new CoalescedReply(shared, request, parent);
+    shared->attach(reply);
+    return reply;
+}
+
+bool RequestCoalescer::isDuplicate(const QNetworkReply *reply)
+{
+    const CoalescedReply *coalesced = qobject_cast<const CoalescedReply*>(reply);
+    return coalesced && coalesced->duplicate;
+}
+
+int RequestCoalescer::inFlightCount() const
+{
+    return d->requests.count();
+}
+
+void RequestCoalescer::setEnabled(bool enabled)
+{
+    d->enabled = enabled;
+}
+
+bool RequestCoalescer::isEnabled() const
+{
+    return d->enabled;
+}
+
+#include "requestcoalescer.moc"
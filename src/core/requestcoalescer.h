@@ -0,0 +1,111 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBKMGRAPH2_REQUESTCOALESCER_H
+#define LIBKMGRAPH2_REQUESTCOALESCER_H
+
+#include "kmgraphcore_export.h"
+
+#include <QByteArray>
+
+#include <functional>
+
+class QNetworkReply;
+class QNetworkRequest;
+class QObject;
+
+namespace KMGraph2
+{
+
+/**
+ * @brief Shares identical GET requests that are on the way at the same time
+ *
+ * Independent jobs often ask for the same resource at almost the same
+ * moment. Instead of sending every request to the server, get() attaches
+ * later requests for the same URL and headers (and therefore the same
+ * account) to the request that has already been sent. Every requester gets
+ * its own QNetworkReply, which receives a copy of the shared reply.
+ *
+ * A request only joins a shared request that has not received anything
+ * from the server yet, data that already have been delivered are not kept
+ * around. Aborting a reply only detaches it, the shared request is aborted
+ * once no reply is attached to it anymore. The request that has actually
+ * been sent belongs to the coalescer, so it outlives the requester that
+ * sent it.
+ *
+ * Every thread has its own instance(), requests are only shared within
+ * a thread.
+ *
+ * @internal
+ */
+class KMGRAPHCORE_EXPORT RequestCoalescer
+{
+  public:
+    typedef std::function<QNetworkReply*()> Sender;
+
+    RequestCoalescer();
+    ~RequestCoalescer();
+
+    static RequestCoalescer *instance();
+
+    /**
+     * @brief Returns a reply for GET @p request
+     *
+     * When no identical request is on the way, @p send is called to send
+     * the request to the server.
+     *
+     * @param parent Parent of the returned reply
+     */
+    QNetworkReply *get(const QNetworkRequest &request, const Sender &send, QObject *parent);
+
+    /**
+     * @brief Returns whether @p reply is a copy of a reply that has been
+     *        delivered to another requester as well
+     *
+     * Exactly one of the replies attached to a shared request is not a
+     * duplicate, so that the outcome of the request is only counted once,
+     * e.g. by CircuitBreaker.
+     */
+    static bool isDuplicate(const QNetworkReply *reply);
+
+    /**
+     * @brief Returns number of requests that are currently being shared
+     */
+    int inFlightCount() const;
+
+    /**
+     * @brief Enables or disables sharing, get() always sends the request
+     *        when disabled. Enabled by default.
+     */
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+  private:
+    Q_DISABLE_COPY(RequestCoalescer)
+
+    class Private;
+    Private * const d;
+    friend class Private;
+};
+
+} // namespace KMGraph2
+
+#endif // LIBKMGRAPH2_REQUESTCOALESCER_H
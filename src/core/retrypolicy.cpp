@@ -0,0 +1,208 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "retrypolicy.h"
+
+#include <QtMath>
+
+#include <random>
+
+using namespace KMGraph2;
+
+class Q_DECL_HIDDEN RetryPolicy::Private : public QSharedData
+{
+  public:
+    Private();
+
+    int maxAttempts;
+    int initialDelay;
+    int maxDelay;
+    qreal multiplier;
+    qreal jitter;
+    QList<int> statusCodes;
+    bool retryNetworkErrors;
+    bool retryNonIdempotent;
+};
+
+RetryPolicy::Private::Private():
+    maxAttempts(4),
+    initialDelay(500),
+    maxDelay(30 * 1000),
+    multiplier(2.0),
+    jitter(0.5),
+    statusCodes({ 429, 500, 502, 503, 504 }),
+    retryNetworkErrors(true),
+    retryNonIdempotent(false)
+{
+}
+
+RetryPolicy::RetryPolicy():
+    d(new Private)
+{
+}
+
+RetryPolicy::RetryPolicy(const RetryPolicy &other):
+    d(other.d)
+{
+}
+
+RetryPolicy &RetryPolicy::operator=(const RetryPolicy &other)
+{
+    d = other.d;
+    return *this;
+}
+
+RetryPolicy::~RetryPolicy()
+{
+}
+
+RetryPolicy RetryPolicy::noRetry()
+{
+    RetryPolicy policy;
+    policy.setMaxAttempts(1);
+    return policy;
+}
+
+void RetryPolicy::setMaxAttempts(int maxAttempts)
+{
+    d->maxAttempts = qMax(1, maxAttempts);
+}
+
+int RetryPolicy::maxAttempts() const
+{
+    return d->maxAttempts;
+}
+
+void RetryPolicy::setInitialDelay(int msecs)
+{
+    d->initialDelay = qMax(0, msecs);
+}
+
+int RetryPolicy::initialDelay() const
+{
+    return d->initialDelay;
+}
+
+void RetryPolicy::setMaxDelay(int msecs)
+{
+    d->maxDelay = qMax(0, msecs);
+}
+
+int RetryPolicy::maxDelay() const
+{
+    return d->maxDelay;
+}
+
+void RetryPolicy::setBackoffMultiplier(qreal multiplier)
+{
+    d->multiplier = qMax<qreal>(1.0, multiplier);
+}
+
+qreal RetryPolicy::backoffMultiplier() const
+{
+    return d->multiplier;
+}
+
+void RetryPolicy::setJitter(qreal jitter)
+{
+    d->jitter = qBound<qreal>(0.0, jitter, 1.0);
+}
+
+qreal RetryPolicy::jitter() const
+{
+    return d->jitter;
+}
+
+void RetryPolicy::setRetryableStatusCodes(const QList<int> &statusCodes)
+{
+    d->statusCodes = statusCodes;
+}
+
+QList<int> RetryPolicy::retryableStatusCodes() const
+{
+    return d->statusCodes;
+}
+
+void RetryPolicy::setRetryNetworkErrors(bool retry)
+{
+    d->retryNetworkErrors = retry;
+}
+
+bool RetryPolicy::retryNetworkErrors() const
+{
+    return d->retryNetworkErrors;
+}
+
+void RetryPolicy::setRetryNonIdempotent(bool retry)
+{
+    d->retryNonIdempotent = retry;
+}
+
+bool RetryPolicy::retryNonIdempotent() const
+{
+    return d->retryNonIdempotent;
+}
+
+bool RetryPolicy::isRetryable(int statusCode, QNetworkReply::NetworkError error) const
+{
+    if (statusCode != 0) {
+        return d->statusCodes.contains(statusCode);
+    }
+
+    if (!d->retryNetworkErrors) {
+        return false;
+    }
+
+    switch (error) {
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::HostNotFoundError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::UnknownNetworkError:
+    case QNetworkReply::ProxyConnectionRefusedError:
+    case QNetworkReply::ProxyConnectionClosedError:
+    case QNetworkReply::ProxyNotFoundError:
+    case QNetworkReply::ProxyTimeoutError:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool RetryPolicy::canRetry(int attempt) const
+{
+    return attempt < d->maxAttempts;
+}
+
+int RetryPolicy::delay(int attempt) const
+{
+    const qreal exponential = d->initialDelay * qPow(d->multiplier, qMax(0, attempt - 1));
+    const qreal delay = qMin<qreal>(exponential, d->maxDelay);
+    if (d->jitter <= 0.0 || delay <= 0.0) {
+        return qRound(delay);
+    }
+
+    static thread_local std::mt19937 generator(std::random_device{}());
+    std::uniform_real_distribution<qreal> distribution(delay * (1.0 - d->jitter), delay);
+    return qRound(distribution(generator));
+}
@@ -0,0 +1,151 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBKMGRAPH2_RETRYPOLICY_H
+#define LIBKMGRAPH2_RETRYPOLICY_H
+
+#include "kmgraphcore_export.h"
+
+#include <QList>
+#include <QNetworkReply>
+#include <QSharedDataPointer>
+
+namespace KMGraph2
+{
+
+/**
+ * @headerfile RetryPolicy
+ * @brief Describes when and how often Job sends a failed request again
+ *
+ * A request that fails with a transient error (a retryable HTTP status, a
+ * network failure or a timeout) is sent again after a delay that grows
+ * exponentially with every attempt. Part of the delay is random, so that
+ * many jobs failing at the same moment don't hit the server at the same
+ * moment again. The job resumes exactly at the failed request, nothing that
+ * has been fetched before is thrown away.
+ *
+ * The default policy makes up to 4 attempts, waiting 0.5, 1 and 2 seconds
+ * (minus jitter) in between, and retries HTTP statuses 429, 500, 502, 503 and 504
+ * and transient network errors.
+ *
+ * @see Job::setRetryPolicy
+ */
+class KMGRAPHCORE_EXPORT RetryPolicy
+{
+  public:
+    RetryPolicy();
+    RetryPolicy(const RetryPolicy &other);
+    RetryPolicy &operator=(const RetryPolicy &other);
+    ~RetryPolicy();
+
+    /**
+     * @brief Returns a policy that never retries.
+     */
+    static RetryPolicy noRetry();
+
+    /**
+     * @brief Sets maximum number of attempts, including the first one.
+     *
+     * @p 1 disables retrying.
+     */
+    void setMaxAttempts(int maxAttempts);
+    int maxAttempts() const;
+
+    /**
+     * @brief Sets delay (in milliseconds) before the first retry.
+     */
+    void setInitialDelay(int msecs);
+    int initialDelay() const;
+
+    /**
+     * @brief Sets upper bound (in milliseconds) of the delay between attempts.
+     */
+    void setMaxDelay(int msecs);
+    int maxDelay() const;
+
+    /**
+     * @brief Sets factor by which the delay grows with every attempt.
+     */
+    void setBackoffMultiplier(qreal multiplier);
+    qreal backoffMultiplier() const;
+
+    /**
+     * @brief Sets fraction (0.0 - 1.0) of the delay that is random.
+     *
+     * With jitter @p j, the delay is picked uniformly from
+     * <tt>[delay * (1 - j), delay]</tt>. Defaults to @p 0.5.
+     */
+    void setJitter(qreal jitter);
+    qreal jitter() const;
+
+    /**
+     * @brief Sets HTTP status codes that are considered transient.
+     */
+    void setRetryableStatusCodes(const QList<int> &statusCodes);
+    QList<int> retryableStatusCodes() const;
+
+    /**
+     * @brief Sets whether transient network errors (connection refused or
+     *        closed, host lookup or proxy failures, ...) are retried.
+     */
+    void setRetryNetworkErrors(bool retry);
+    bool retryNetworkErrors() const;
+
+    /**
+     * @brief Sets whether requests other than GET, HEAD, PUT and DELETE are
+     *        retried after a server or network failure.
+     *
+     * The server may already have carried out a POST whose reply got lost,
+     * sending it again could e.g. create the same file twice. Only enable this
+     * for jobs whose requests are safe to repeat. Requests that the server
+     * turned down because of throttling are retried regardless.
+     *
+     * Defaults to @p false.
+     */
+    void setRetryNonIdempotent(bool retry);
+    bool retryNonIdempotent() const;
+
+    /**
+     * @brief Returns whether a reply with @p statusCode and network @p error
+     *        failed for a transient reason.
+     */
+    bool isRetryable(int statusCode, QNetworkReply::NetworkError error) const;
+
+    /**
+     * @brief Returns whether another attempt can be made after @p attempt
+     *        attempts (counting from 1) have failed.
+     */
+    bool canRetry(int attempt) const;
+
+    /**
+     * @brief Returns delay (in milliseconds) to wait after @p attempt attempts
+     *        have failed, including jitter.
+     */
+    int delay(int attempt) const;
+
+  private:
+    class Private;
+    QSharedDataPointer<Private> d;
+};
+
+} // namespace KMGraph2
+
+#endif // LIBKMGRAPH2_RETRYPOLICY_H
@@ -0,0 +1,159 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "stringinterner.h"
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+
+using namespace KMGraph2;
+
+class Q_DECL_HIDDEN StringInterner::Private
+{
+  public:
+    void checkSize();
+
+    int maxSize;
+    QAtomicInt enabled;
+    mutable QMutex mutex;
+    QSet<QString> strings;
+    QSet<QUrl> urls;
+    quint64 lookups;
+    quint64 hits;
+};
+
+void StringInterner::Private::checkSize()
+{
+    // Starting over is cheap and keeps the memory bounded when the interned
+    // values turn out not to repeat much
+    if (strings.size() + urls.size() >= maxSize) {
+        strings.clear();
+        urls.clear();
+    }
+}
+
+StringInterner::StringInterner(int maxSize):
+    d(new Private)
+{
+    d->maxSize = maxSize;
+    d->enabled = 1;
+    d->lookups = 0;
+    d->hits = 0;
+}
+
+StringInterner::~StringInterner()
+{
+    delete d;
+}
+
+StringInterner *StringInterner::global()
+{
+    static StringInterner interner;
+    return &interner;
+}
+
+QString StringInterner::intern(const QString &string)
+{
+    if (string.isEmpty() || !d->enabled.load()) {
+        return string;
+    }
+
+    QMutexLocker locker(&d->mutex);
+    ++d->lookups;
+    const auto it = d->strings.constFind(string);
+    if (it != d->strings.constEnd()) {
+        ++d->hits;
+        return *it;
+    }
+
+    d->checkSize();
+    d->strings.insert(string);
+    return string;
+}
+
+QStringList StringInterner::intern(const QStringList &strings)
+{
+    QStringList result;
+    result.reserve(strings.size());
+    for (const QString &string : strings) {
+        result.append(intern(string));
+    }
+    return result;
+}
+
+QUrl StringInterner::intern(const QUrl &url)
+{
+    if (url.isEmpty() || !d->enabled.load()) {
+        return url;
+    }
+
+    QMutexLocker locker(&d->mutex);
+    ++d->lookups;
+    const auto it = d->urls.constFind(url);
+    if (it != d->urls.constEnd()) {
+        ++d->hits;
+        return *it;
+    }
+
+    d->checkSize();
+    d->urls.insert(url);
+    return url;
+}
+
+void StringInterner::setEnabled(bool enabled)
+{
+    d->enabled = enabled ? 1 : 0;
+    if (!enabled) {
+        clear();
+    }
+}
+
+bool StringInterner::isEnabled() const
+{
+    return d->enabled.load();
+}
+
+int StringInterner::maxSize() const
+{
+    return d->maxSize;
+}
+
+StringInterner::Stats StringInterner::stats() const
+{
+    QMutexLocker locker(&d->mutex);
+    Stats stats;
+    stats.strings = d->strings.size();
+    stats.urls = d->urls.size();
+    stats.lookups = d->lookups;
+    stats.hits = d->hits;
+    return stats;
+}
+
+void StringInterner::clear()
+{
+    QMutexLocker locker(&d->mutex);
+    d->strings.clear();
+    d->urls.clear();
+    d->lookups = 0;
+    d->hits = 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBKMGRAPH2_STRINGINTERNER_H
+#define LIBKMGRAPH2_STRINGINTERNER_H
+
+#include "kmgraphcore_export.h"
+
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+
+namespace KMGraph2
+{
+
+/**
+ * @brief Table of shared string and URL values
+ *
+ * Large feeds contain the same values (MIME types, user names, links to
+ * parent folders, ...) over and over again. intern() returns a previously
+ * stored equal value, so that all parsed objects share a single implicitly
+ * shared buffer and the copy read from the JSON is freed right away.
+ *
+ * This reduces the memory held by the parsed objects, not the number of
+ * allocations or the peak usage while parsing: the JSON parser has already
+ * allocated every value by the time it is interned.
+ *
+ * Only use it for values that repeat often, unique values (IDs, etags) only
+ * make the table bigger. The table is dropped when it grows over
+ * maxSize() entries.
+ *
+ * The global() instance is used by all fromJSON() methods and is
+ * thread-safe.
+ *
+ * @internal
+ */
+class KMGRAPHCORE_EXPORT StringInterner
+{
+  public:
+    struct Stats {
+        int strings;       ///< Number of distinct strings in the table
+        int urls;          ///< Number of distinct URLs in the table
+        quint64 lookups;   ///< Total number of intern() calls
+        quint64 hits;      ///< Number of intern() calls that returned a shared value
+    };
+
+    explicit StringInterner(int maxSize = 65536);
+    ~StringInterner();
+
+    static StringInterner *global();
+
+    QString intern(const QString &string);
+    QStringList intern(const QStringList &strings);
+    QUrl intern(const QUrl &url);
+
+    /**
+     * @brief Enables or disables interning, intern() returns its argument
+     *        unchanged when disabled. Enabled by default.
+     */
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    int maxSize() const;
+    Stats stats() const;
+    void clear();
+
+  private:
+    Q_DISABLE_COPY(StringInterner)
+
+    class Private;
+    Private * const d;
+};
+
+} // namespace KMGraph2
+
+#endif // LIBKMGRAPH2_STRINGINTERNER_H
@@ -0,0 +1,95 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "tokenprovider.h"
+#include "account.h"
+#include "../debug.h"
+
+#include <QDateTime>
+#include <QHash>
+
+using namespace KMGraph2;
+
+class Q_DECL_HIDDEN TokenProvider::Private
+{
+  public:
+    // All Account instances waiting for a refresh, by account name
+    QHash<QString, AccountsList> waiting;
+};
+
+TokenProvider::TokenProvider(QObject *parent):
+    QObject(parent),
+    d(new Private)
+{
+}
+
+TokenProvider::~TokenProvider()
+{
+    delete d;
+}
+
+void TokenProvider::refreshTokens(const AccountPtr &account)
+{
+    if (!account) {
+        return;
+    }
+
+    const QString name = account->accountName();
+    auto it = d->waiting.find(name);
+    if (it != d->waiting.end()) {
+        if (!it->contains(account)) {
+            it->append(account);
+        }
+        qCDebug(KMGraphDebug) << "Tokens of" << name << "are already being refreshed";
+        return;
+    }
+
+    qCDebug(KMGraphDebug) << "Refreshing tokens of" << name;
+    d->waiting.insert(name, AccountsList() << account);
+    doRefreshTokens(account);
+}
+
+bool TokenProvider::isRefreshing(const AccountPtr &account) const
+{
+    return account && d->waiting.contains(account->accountName());
+}
+
+void TokenProvider::finishRefresh(const AccountPtr &account, bool success)
+{
+    if (!account) {
+        return;
+    }
+
+    const AccountsList accounts = d->waiting.take(account->accountName());
+    if (success) {
+        for (const AccountPtr &other : accounts) {
+            if (other != account) {
+                other->setAccessToken(account->accessToken());
+                other->setRefreshToken(account->refreshToken());
+                other->setExpireDateTime(account->expireDateTime());
+            }
+        }
+    } else {
+        qCWarning(KMGraphDebug) << "Failed to refresh tokens of" << account->accountName();
+    }
+
+    Q_EMIT tokensRefreshed(account, success);
+}
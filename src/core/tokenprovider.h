@@ -0,0 +1,106 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBKMGRAPH2_TOKENPROVIDER_H
+#define LIBKMGRAPH2_TOKENPROVIDER_H
+
+#include "types.h"
+#include "kmgraphcore_export.h"
+
+#include <QObject>
+
+namespace KMGraph2
+{
+
+/**
+ * @headerfile TokenProvider
+ * @brief Obtains new tokens for an Account whose access token has expired
+ *
+ * Set the provider on an Account using Account::setTokenProvider(). Jobs
+ * then ask for new tokens shortly before Account::expireDateTime and when
+ * the server rejects the access token, and send the affected request again
+ * once the tokens have been refreshed, instead of failing with
+ * KMGraph2::Unauthorized. Each request causes at most one refresh ahead of
+ * time, even when the new tokens expire soon as well.
+ *
+ * Refreshes are single-flight: while tokens of an account are being
+ * refreshed, further requests for the same account (identified by
+ * Account::accountName) only wait for the running refresh. All waiting
+ * Account instances receive the new tokens.
+ *
+ * Subclasses implement doRefreshTokens() and report the result using
+ * finishRefresh().
+ */
+class KMGRAPHCORE_EXPORT TokenProvider : public QObject
+{
+    Q_OBJECT
+
+  public:
+    explicit TokenProvider(QObject *parent = nullptr);
+    ~TokenProvider() override;
+
+    /**
+     * @brief Refreshes tokens of @p account, unless a refresh of the
+     *        account is already running.
+     *
+     * tokensRefreshed() is emitted once the refresh has finished.
+     */
+    void refreshTokens(const KMGraph2::AccountPtr &account);
+
+    /**
+     * @brief Returns whether tokens of @p account are being refreshed.
+     */
+    bool isRefreshing(const KMGraph2::AccountPtr &account) const;
+
+  Q_SIGNALS:
+    /**
+     * @brief Emitted when refresh of tokens of @p account has finished.
+     *
+     * @param account The account that has been refreshed. Other Account
+     *        instances with the same name have been updated, too.
+     * @param success Whether new tokens have been obtained
+     */
+    void tokensRefreshed(const KMGraph2::AccountPtr &account, bool success);
+
+  protected:
+    /**
+     * @brief Obtains new tokens for @p account.
+     *
+     * Implementations store the new access token (and expiration date and
+     * refresh token, if they have changed) in @p account and call
+     * finishRefresh(). This may happen synchronously or later.
+     */
+    virtual void doRefreshTokens(const KMGraph2::AccountPtr &account) = 0;
+
+    /**
+     * @brief Finishes refresh of @p account started by doRefreshTokens().
+     */
+    void finishRefresh(const KMGraph2::AccountPtr &account, bool success);
+
+  private:
+    class Private;
+    Private * const d;
+    friend class Private;
+};
+
+} // namespace KMGraph2
+
+#endif // LIBKMGRAPH2_TOKENPROVIDER_H
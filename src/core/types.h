@@ -130,6 +130,10 @@ enum Error {
     InvalidAccount = 7,      ///< LibKMGraph error - the KMGraph2::Account object is invalid.
     NetworkError = 8,        ///< LibKMGraph error - standard network request returned other code then 200.
     AuthCancelled = 9,       ///< LibKMGraph error - when authentication dialog is canceled
+    ChecksumMismatch = 10,   ///< LibKMGraph error - downloaded data don't match the expected checksum
+    Timeout = 11,            ///< LibKMGraph error - no reply arrived within Job::requestTimeout, not even after retrying
+    CircuitOpen = 12,        ///< LibKMGraph error - too many requests to the service failed recently, see KMGraph2::CircuitBreaker
+    Cancelled = 13,          ///< LibKMGraph error - the job has been aborted, see KMGraph2::Job::abort()
 
     /* Following error codes identify Microsoft Graph errors */
     OK = 200,                ///< Request successfully executed.
@@ -138,11 +142,12 @@ enum Error {
     TemporarilyMoved = 302,  ///< The object is located on a different URL provided in reply.
     NotModified = 304,       ///< Request was successful, but no data were updated.
     BadRequest = 400,        ///< Invalid (malformed) request.
-    Unauthorized = 401,      ///< Invalid or expired token. See KMGraph2::Account::refreshTokens(). TODO: which function takes care of token refresh in KAccounts?
+    Unauthorized = 401,      ///< Invalid or expired token, and the account's KMGraph2::TokenProvider could not refresh it.
     Forbidden = 403,         ///< The requested data are not accessible to this account
     NotFound = 404,          ///< Requested object was not found on the remote side
     Conflict = 409,          ///< Object on the remote site differs from the submitted one. @see KMGraph2::Object::setEtag.
     Gone = 410,              ///< The requested does not exist anymore on the remote site
+    TooManyRequests = 429,   ///< Too many requests were sent, the request should be sent again later.
     InternalError = 500,     ///< An unexpected error on the Microsoft Graph service occurred
     QuotaExceeded = 503      ///< User quota has been exceeded, the request should be send again later.
 };
@@ -48,8 +48,145 @@ QString Utils::ts2Str(quint64 ts)
     return QDateTime::fromTime_t(ts).toUTC().toString(Qt::ISODate);
 }
 
+namespace {
+
+// Parses exactly @p count ASCII digits starting at @p pos
+inline bool parseDigits(const QChar *str, int pos, int count, int &value)
+{
+    value = 0;
+    for (int i = pos; i < pos + count; ++i) {
+        const ushort c = str[i].unicode() - '0';
+        if (c > 9) {
+            return false;
+        }
+        value = value * 10 + c;
+    }
+    return true;
+}
+
+// Number of days since 1970-01-01 of given date in proleptic Gregorian calendar
+inline qint64 daysFromCivil(int year, int month, int day)
+{
+    year -= month <= 2;
+    const qint64 era = (year >= 0 ? year : year - 399) / 400;
+    const int yoe = year - era * 400;
+    const int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+inline int daysInMonth(int year, int month)
+{
+    static const int days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    if (month == 2 && (year % 4 == 0) && (year % 100 != 0 || year % 400 == 0)) {
+        return 29;
+    }
+    return days[month - 1];
+}
+
+// Parses "YYYY-MM-DDTHH:MM:SS[.fraction](Z|+HH:MM|-HH:MM)", which is the only
+// format the server ever sends, without allocating anything. Returns false
+// when the string is in any other format.
+bool parseRfc3339(const QString &string, qint64 &msecs, int &offset, bool &isUtc)
+{
+    const int length = string.size();
+    if (length < 20) {
+        return false;
+    }
+
+    const QChar *str = string.constData();
+    int year, month, day, hour, minute, second;
+    if (!parseDigits(str, 0, 4, year) || str[4] != QLatin1Char('-')
+            || !parseDigits(str, 5, 2, month) || str[7] != QLatin1Char('-')
+            || !parseDigits(str, 8, 2, day)
+            || (str[10] != QLatin1Char('T') && str[10] != QLatin1Char('t'))
+            || !parseDigits(str, 11, 2, hour) || str[13] != QLatin1Char(':')
+            || !parseDigits(str, 14, 2, minute) || str[16] != QLatin1Char(':')
+            || !parseDigits(str, 17, 2, second)) {
+        return false;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month)
+            || hour > 23 || minute > 59 || second > 59) {
+        return false;
+    }
+
+    int pos = 19;
+    int msec = 0;
+    if (str[pos] == QLatin1Char('.')) {
+        ++pos;
+        int digits = 0;
+        while (pos < length) {
+            const ushort c = str[pos].unicode() - '0';
+            if (c > 9) {
+                break;
+            }
+            // Anything beyond millisecond precision is truncated
+            if (digits < 3) {
+                msec = msec * 10 + c;
+            }
+            ++digits;
+            ++pos;
+        }
+        if (digits == 0) {
+            return false;
+        }
+        for (; digits < 3; ++digits) {
+            msec *= 10;
+        }
+    }
+
+    if (pos >= length) {
+        return false;
+    }
+
+    offset = 0;
+    isUtc = false;
+    const QChar designator = str[pos];
+    if (designator == QLatin1Char('Z') || designator == QLatin1Char('z')) {
+        isUtc = true;
+        ++pos;
+    } else if (designator == QLatin1Char('+') || designator == QLatin1Char('-')) {
+        int offsetHours, offsetMinutes;
+        if (pos + 6 != length || !parseDigits(str, pos + 1, 2, offsetHours)
+                || str[pos + 3] != QLatin1Char(':')
+                || !parseDigits(str, pos + 4, 2, offsetMinutes)
+                || offsetHours > 23 || offsetMinutes > 59) {
+            return false;
+        }
+        offset = offsetHours * 3600 + offsetMinutes * 60;
+        if (designator == QLatin1Char('-')) {
+            offset = -offset;
+        }
+        pos += 6;
+    } else {
+        return false;
+    }
+
+    if (pos != length) {
+        return false;
+    }
+
+    const qint64 seconds = daysFromCivil(year, month, day) * 86400
+                           + hour * 3600 + minute * 60 + second - offset;
+    msecs = seconds * 1000 + msec;
+    return true;
+}
+
+} // namespace
+
 QDateTime Utils::rfc3339DateFromString(const QString &string)
 {
+    qint64 msecs;
+    int offset;
+    bool isUtc;
+    if (parseRfc3339(string, msecs, offset, isUtc)) {
+        if (isUtc || offset == 0) {
+            return QDateTime::fromMSecsSinceEpoch(msecs, Qt::UTC);
+        }
+        return QDateTime::fromMSecsSinceEpoch(msecs, Qt::OffsetFromUTC, offset);
+    }
+
+    // Not a full RFC3339 timestamp (e.g. just a date), let Qt deal with it
     return QDateTime::fromString(string, Qt::ISODate);
 }
 
@@ -57,6 +57,11 @@ namespace Utils
 
     /**
      * @brief Converts given string in RFC3339 format into QDateTime
+     *
+     * Timestamps in the "YYYY-MM-DDTHH:MM:SS[.fraction](Z|+HH:MM)" format
+     * used by the server are parsed directly without any allocations, which
+     * is much faster than QDateTime::fromString(). Any other input is passed
+     * to QDateTime::fromString() with Qt::ISODate.
      */
     KMGRAPHCORE_EXPORT QDateTime rfc3339DateFromString(const QString &string);
 
@@ -25,6 +25,7 @@
 #include "account.h"
 #include "../debug.h"
 #include "onedriveservice.h"
+#include "userregistry.h"
 #include "utils.h"
 
 
@@ -128,6 +129,8 @@ void AboutFetchJob::start()
 KMGraph2::ObjectsList AboutFetchJob::handleReplyWithItems(const QNetworkReply *reply,
                                                         const QByteArray &rawData)
 {
+    const UserRegistry::Scope userScope(account());
+
     ObjectsList items;
 
     const QString contentType = reply->header(QNetworkRequest::ContentTypeHeader).toString();
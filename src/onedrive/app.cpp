@@ -19,6 +19,7 @@
 */
 
 #include "app.h"
+#include "jsonparser.h"
 
 #include <QVariantMap>
 #include <QJsonDocument>
@@ -288,12 +289,11 @@ AppPtr App::fromJSON(const QByteArray &jsonData)
 
 AppsList App::fromJSONFeed(const QByteArray &jsonData)
 {
-    QJsonDocument document = QJsonDocument::fromJson(jsonData);
-    if (document.isNull()) {
+    bool ok = false;
+    const QVariantMap map = JsonParser::parseObject(jsonData, &ok);
+    if (!ok) {
         return AppsList();
     }
-    const QVariant data = document.toVariant();
-    const QVariantMap map = data.toMap();
     if (!map.contains(QStringLiteral("kind")) ||
             map[QStringLiteral("kind")].toString() != QLatin1String("drive#appList")) {
         return AppsList();
@@ -19,7 +19,9 @@
 */
 
 #include "change.h"
+#include "jsonparser.h"
 #include "file_p.h"
+#include "objectpool.h"
 
 #include <QVariantMap>
 #include <QJsonDocument>
@@ -30,6 +32,8 @@ using namespace KMGraph2::OneDrive;
 class Q_DECL_HIDDEN Change::Private
 {
   public:
+    KMGRAPH_POOLED_ALLOCATION
+
     Private();
     Private(const Private &other);
 
@@ -64,7 +68,7 @@ ChangePtr Change::Private::fromJSON(const QVariantMap &map)
         return ChangePtr();
     }
 
-    ChangePtr change(new Change);
+    ChangePtr change = ChangePtr::create();
     change->d->id = map[QStringLiteral("id")].toLongLong();
     change->d->fileId = map[QStringLiteral("fileId")].toString();
     change->d->selfLink = map[QStringLiteral("selfLink")].toUrl();
@@ -129,13 +133,11 @@ ChangePtr Change::fromJSON(const QByteArray &jsonData)
 
 ChangesList Change::fromJSONFeed(const QByteArray &jsonData, FeedData &feedData)
 {
-    QJsonDocument document = QJsonDocument::fromJson(jsonData);
-    if (document.isNull()) {
+    bool ok = false;
+    const QVariantMap map = JsonParser::parseObject(jsonData, &ok);
+    if (!ok) {
         return ChangesList();
     }
-
-    const QVariant data = document.toVariant();
-    const QVariantMap map = data.toMap();
     if (!map.contains(QStringLiteral("kind")) ||
             map[QStringLiteral("kind")].toString() != QLatin1String("drive#changeList")) {
         return ChangesList();
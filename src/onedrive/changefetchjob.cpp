@@ -23,8 +23,10 @@
 #include "changefetchjob.h"
 #include "account.h"
 #include "change.h"
+#include "filetable.h"
 #include "../debug.h"
 #include "onedriveservice.h"
+#include "userregistry.h"
 #include "utils.h"
 
 #include <QNetworkReply>
@@ -37,52 +39,41 @@ using namespace KMGraph2::OneDrive;
 class Q_DECL_HIDDEN ChangeFetchJob::Private
 {
   public:
-    Private(ChangeFetchJob *parent);
-    QNetworkRequest createRequest(const QUrl &url);
+    Private();
 
     QString changeId;
 
     bool includeDeleted;
     bool includeSubscribed;
-    int maxResults;
     qlonglong startChangeId;
 
-  private:
-    ChangeFetchJob *q;
+    FileTable *fileTable;
 };
 
-ChangeFetchJob::Private::Private(ChangeFetchJob *parent):
+ChangeFetchJob::Private::Private():
     includeDeleted(true),
     includeSubscribed(true),
-    maxResults(0),
     startChangeId(0),
-    q(parent)
+    fileTable(nullptr)
 {
 }
 
-QNetworkRequest ChangeFetchJob::Private::createRequest(const QUrl &url)
-{
-    QNetworkRequest request;
-    request.setRawHeader("Authorization", "Bearer " + q->account()->accessToken().toLatin1());
-    request.setUrl(url);
-
-    return request;
-}
-
 
 ChangeFetchJob::ChangeFetchJob(const QString &changeId,
                                const AccountPtr &account,
                                QObject *parent):
-    FetchJob(account, parent),
-    d(new Private(this))
+    FeedFetchJob(account, parent),
+    d(new Private)
 {
     d->changeId = changeId;
 }
 
 ChangeFetchJob::ChangeFetchJob(const AccountPtr &account, QObject *parent):
-    FetchJob(account, parent),
-    d(new Private(this))
+    FeedFetchJob(account, parent),
+    d(new Private)
 {
+    // Callers continue from the largest change ID they received
+    setWholePages(true);
 }
 
 ChangeFetchJob::~ChangeFetchJob()
@@ -122,17 +113,12 @@ bool ChangeFetchJob::includeSubscribed() const
 
 void ChangeFetchJob::setMaxResults(int maxResults)
 {
-    if (isRunning()) {
-        qCWarning(KMGraphDebug) << "Can't modify maxResults property when job is running";
-        return;
-    }
-
-    d->maxResults = maxResults;
+    setPageSize(maxResults);
 }
 
 int ChangeFetchJob::maxResults() const
 {
-    return d->maxResults;
+    return pageSize();
 }
 
 void ChangeFetchJob::setStartChangeId(qlonglong startChangeId)
@@ -149,41 +135,52 @@ qlonglong ChangeFetchJob::startChangeId() const
     return d->startChangeId;
 }
 
+void ChangeFetchJob::setFileTable(FileTable *table)
+{
+    if (isRunning()) {
+        qCWarning(KMGraphDebug) << "Can't modify fileTable property when job is running";
+        return;
+    }
+
+    d->fileTable = table;
+}
+
+FileTable *ChangeFetchJob::fileTable() const
+{
+    return d->fileTable;
+}
+
 void ChangeFetchJob::start()
 {
-    QUrl url;
     if (d->changeId.isEmpty()) {
-        url = OneDriveService::fetchChangesUrl();
+        QUrl url = OneDriveService::fetchChangesUrl();
         url.addQueryItem(QStringLiteral("includeDeleted"), Utils::bool2Str(d->includeDeleted));
         url.addQueryItem(QStringLiteral("includeSubscribed"), Utils::bool2Str(d->includeSubscribed));
-        if (d->maxResults > 0) {
-            url.addQueryItem(QStringLiteral("maxResults"), QString::number(d->maxResults));
-        }
         if (d->startChangeId > 0) {
             url.addQueryItem(QStringLiteral("startChangeId"), QString::number(d->startChangeId));
         }
+        enqueueFeedRequest(url);
     } else {
-        url = OneDriveService::fetchChangeUrl(d->changeId);
+        enqueueRequest(createRequest(OneDriveService::fetchChangeUrl(d->changeId)));
     }
-
-    const QNetworkRequest request = d->createRequest(url);
-    enqueueRequest(request);
 }
 
 
-ObjectsList ChangeFetchJob::handleReplyWithItems(const QNetworkReply *reply,
-        const QByteArray &rawData)
+ObjectsList ChangeFetchJob::handleFeedReply(const QNetworkReply *reply,
+        const QByteArray &rawData, FeedData &feedData)
 {
-    FeedData feedData;
+    const UserRegistry::Scope userScope(account());
+
     feedData.requestUrl = reply->request().url();
 
     ObjectsList items;
-    QString itemId;
 
     const QString contentType = reply->header(QNetworkRequest::ContentTypeHeader).toString();
     ContentType ct = Utils::stringToContentType(contentType);
     if (ct == KMGraph2::JSON) {
-        if (d->changeId.isEmpty()) {
+        if (d->fileTable) {
+            addFetchedItemsCount(qMax(0, d->fileTable->insertJSON(rawData, feedData)));
+        } else if (d->changeId.isEmpty()) {
             items << Change::fromJSONFeed(rawData, feedData);
         } else {
             items << Change::fromJSON(rawData);
@@ -192,12 +189,6 @@ ObjectsList ChangeFetchJob::handleReplyWithItems(const QNetworkReply *reply,
         setError(KMGraph2::InvalidResponse);
         setErrorString(tr("Invalid response content type"));
         emitFinished();
-        return items;
-    }
-
-    if (feedData.nextPageUrl.isValid()) {
-        const QNetworkRequest request = d->createRequest(feedData.nextPageUrl);
-        enqueueRequest(request);
     }
 
     return items;
@@ -23,7 +23,7 @@
 #ifndef KMGRAPH2_ONEDRIVECHANGEFETCHJOB_H
 #define KMGRAPH2_ONEDRIVECHANGEFETCHJOB_H
 
-#include "fetchjob.h"
+#include "feedfetchjob.h"
 #include "kmgraphonedrive_export.h"
 
 namespace KMGraph2
@@ -32,7 +32,9 @@ namespace KMGraph2
 namespace OneDrive
 {
 
-class KMGRAPHONEDRIVE_EXPORT ChangeFetchJob : public KMGraph2::FetchJob
+class FileTable;
+
+class KMGRAPHONEDRIVE_EXPORT ChangeFetchJob : public KMGraph2::FeedFetchJob
 {
     Q_OBJECT
 
@@ -63,9 +65,13 @@ class KMGRAPHONEDRIVE_EXPORT ChangeFetchJob : public KMGraph2::FetchJob
                WRITE setIncludeSubscribed)
 
     /**
-     * Maximum number of changes to return.
+     * Maximum number of changes to return in a single page.
+     *
+     * This is the same as FeedFetchJob::pageSize, use maxItems to limit
+     * the total number of changes. The job never drops changes from a page,
+     * so fetching can be resumed after the largest change ID received.
      *
-     * Default value is 0, i.e. no limit.
+     * Default value is 0, i.e. the page size is chosen by the server.
      *
      * This property does not have any effect when fetching a specific event and
      * can be modified only when the job is not running.
@@ -104,10 +110,20 @@ class KMGRAPHONEDRIVE_EXPORT ChangeFetchJob : public KMGraph2::FetchJob
     qlonglong startChangeId() const;
     void setStartChangeId(qlonglong startChangeId);
 
+    /**
+     * @brief Sets a table to apply the fetched changes to.
+     *
+     * When set, changed files are updated in @p table and deleted files are
+     * removed from it, without creating Change and File objects. items()
+     * stays empty. The job does not take ownership of the table.
+     */
+    void setFileTable(FileTable *table);
+    FileTable *fileTable() const;
+
   protected:
     void start() override;
-    KMGraph2::ObjectsList handleReplyWithItems(const QNetworkReply *reply,
-            const QByteArray &rawData) override;
+    KMGraph2::ObjectsList handleFeedReply(const QNetworkReply *reply,
+            const QByteArray &rawData, KMGraph2::FeedData &feedData) override;
 
   private:
     class Private;
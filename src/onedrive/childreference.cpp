@@ -19,6 +19,9 @@
 */
 
 #include "childreference.h"
+#include "jsonparser.h"
+#include "jsonwriter.h"
+#include "objectpool.h"
 
 #include <QVariantMap>
 #include <QJsonDocument>
@@ -26,9 +29,11 @@
 using namespace KMGraph2;
 using namespace KMGraph2::OneDrive;
 
-class Q_DECL_HIDDEN ChildReference::Private
+class Q_DECL_HIDDEN ChildReference::Private : public QSharedData
 {
   public:
+    KMGRAPH_POOLED_ALLOCATION
+
     Private();
     Private(const Private &other);
 
@@ -57,7 +62,7 @@ ChildReferencePtr ChildReference::Private::fromJSON(const QVariantMap &map)
         return ChildReferencePtr();
     }
 
-    ChildReferencePtr reference(new ChildReference(map[QStringLiteral("id")].toString()));
+    ChildReferencePtr reference = ChildReferencePtr::create(map[QStringLiteral("id")].toString());
     reference->d->selfLink = map[QStringLiteral("selfLink")].toUrl();
     reference->d->childLink = map[QStringLiteral("childLink")].toUrl();
 
@@ -73,13 +78,19 @@ ChildReference::ChildReference(const QString &id):
 
 ChildReference::ChildReference(const ChildReference &other):
     KMGraph2::Object(other),
-    d(new Private(*(other.d)))
+    d(other.d)
 {
 }
 
 ChildReference::~ChildReference()
 {
-    delete d;
+}
+
+ChildReference &ChildReference::operator=(const ChildReference &other)
+{
+    KMGraph2::Object::operator=(other);
+    d = other.d;
+    return *this;
 }
 
 QString ChildReference::id() const
@@ -111,13 +122,11 @@ ChildReferencePtr ChildReference::fromJSON(const QByteArray &jsonData)
 ChildReferencesList ChildReference::fromJSONFeed(const QByteArray &jsonData,
                                                  FeedData &feedData)
 {
-    QJsonDocument document = QJsonDocument::fromJson(jsonData);
-    if (document.isNull()) {
+    bool ok = false;
+    const QVariantMap map = JsonParser::parseObject(jsonData, &ok);
+    if (!ok) {
         return ChildReferencesList();
     }
-
-    const QVariant data = document.toVariant();
-    const QVariantMap map = data.toMap();
     if (!map.contains(QStringLiteral("kind")) ||
             map[QStringLiteral("kind")].toString() != QLatin1String("drive#childList")) {
         return ChildReferencesList();
@@ -142,10 +151,9 @@ ChildReferencesList ChildReference::fromJSONFeed(const QByteArray &jsonData,
 
 QByteArray ChildReference::toJSON(const ChildReferencePtr &reference)
 {
-    QVariantMap map;
-
-    map[QStringLiteral("id")] = reference->id();
-
-    QJsonDocument document = QJsonDocument::fromVariant(map);
-    return document.toJson(QJsonDocument::Compact);
+    JsonWriter writer(64);
+    writer.beginObject();
+    writer.write("id", reference->id());
+    writer.endObject();
+    return writer.data();
 }
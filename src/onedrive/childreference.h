@@ -50,6 +50,7 @@ class KMGRAPHONEDRIVE_EXPORT ChildReference: public KMGraph2::Object
   public:
     explicit ChildReference(const QString &id);
     explicit ChildReference(const ChildReference &other);
+    ChildReference &operator=(const ChildReference &other);
     ~ChildReference() override;
 
     /**
@@ -74,7 +75,7 @@ class KMGRAPHONEDRIVE_EXPORT ChildReference: public KMGraph2::Object
 
   private:
     class Private;
-    Private * const d;
+    QSharedDataPointer<Private> d;
     friend class Private;
 };
 
@@ -36,35 +36,15 @@ using namespace KMGraph2::OneDrive;
 class Q_DECL_HIDDEN ChildReferenceFetchJob::Private
 {
   public:
-    Private(ChildReferenceFetchJob *parent);
-    QNetworkRequest createRequest(const QUrl &url);
-
     QString folderId;
     QString childId;
-
-  private:
-    ChildReferenceFetchJob *q;
 };
 
-ChildReferenceFetchJob::Private::Private(ChildReferenceFetchJob *parent):
-    q(parent)
-{
-}
-
-QNetworkRequest ChildReferenceFetchJob::Private::createRequest(const QUrl &url)
-{
-    QNetworkRequest request;
-    request.setRawHeader("Authorization", "Bearer " + q->account()->accessToken().toLatin1());
-    request.setUrl(url);
-
-    return request;
-}
-
 ChildReferenceFetchJob::ChildReferenceFetchJob(const QString &folderId,
                                                const AccountPtr &account,
                                                QObject *parent):
-    FetchJob(account, parent),
-    d(new Private(this))
+    FeedFetchJob(account, parent),
+    d(new Private)
 {
     d->folderId = folderId;
 }
@@ -73,8 +53,8 @@ ChildReferenceFetchJob::ChildReferenceFetchJob(const QString &folderId,
                                                const QString &childId,
                                                const AccountPtr &account,
                                                QObject *parent):
-    FetchJob(account, parent),
-    d(new Private(this))
+    FeedFetchJob(account, parent),
+    d(new Private)
 {
     d->folderId = folderId;
     d->childId = childId;
@@ -87,22 +67,18 @@ ChildReferenceFetchJob::~ChildReferenceFetchJob()
 
 void ChildReferenceFetchJob::start()
 {
-    QUrl url;
     if (d->childId.isEmpty()) {
-        url = OneDriveService::fetchChildReferences(d->folderId);
+        enqueueFeedRequest(OneDriveService::fetchChildReferences(d->folderId));
     } else {
-        url = OneDriveService::fetchParentReferenceUrl(d->folderId, d->childId);
+        enqueueRequest(createRequest(OneDriveService::fetchParentReferenceUrl(d->folderId, d->childId)));
     }
-
-    const QNetworkRequest request = d->createRequest(url);
-    enqueueRequest(request);
 }
 
-ObjectsList ChildReferenceFetchJob::handleReplyWithItems(const QNetworkReply *reply,
-                                                         const QByteArray &rawData)
+ObjectsList ChildReferenceFetchJob::handleFeedReply(const QNetworkReply *reply,
+                                                    const QByteArray &rawData,
+                                                    FeedData &feedData)
 {
     ObjectsList items;
-    FeedData feedData;
 
     const QString contentType = reply->header(QNetworkRequest::ContentTypeHeader).toString();
     ContentType ct = Utils::stringToContentType(contentType);
@@ -116,13 +92,6 @@ ObjectsList ChildReferenceFetchJob::handleReplyWithItems(const QNetworkReply *re
         setError(KMGraph2::InvalidResponse);
         setErrorString(tr("Invalid response content type"));
         emitFinished();
-        return items;
-    }
-
-
-    if (feedData.nextPageUrl.isValid()) {
-        const QNetworkRequest request = d->createRequest(feedData.nextPageUrl);
-        enqueueRequest(request);
     }
 
     return items;
@@ -21,11 +21,18 @@
 
 #include "file.h"
 #include "file_p.h"
+#include "filefields_p.h"
+#include "jsonparser.h"
+#include "jsonwriter.h"
 #include "permission_p.h"
 #include "parentreference_p.h"
+#include "stringinterner.h"
+#include "utils.h"
 #include "user.h"
 
 #include <QJsonDocument>
+#include <QMutex>
+#include <QMutexLocker>
 
 using namespace KMGraph2;
 using namespace KMGraph2::OneDrive;
@@ -35,6 +42,8 @@ using namespace KMGraph2::OneDrive;
 class Q_DECL_HIDDEN File::Labels::Private
 {
   public:
+    KMGRAPH_POOLED_ALLOCATION
+
     Private();
     Private(const Private &other);
 
@@ -132,6 +141,8 @@ void File::Labels::setViewed(bool viewed)
 class Q_DECL_HIDDEN File::IndexableText::Private
 {
   public:
+    KMGRAPH_POOLED_ALLOCATION
+
     Private();
     Private(const Private &other);
 
@@ -177,6 +188,8 @@ void File::IndexableText::setText(const QString &text)
 class Q_DECL_HIDDEN File::ImageMediaMetadata::Location::Private
 {
   public:
+    KMGRAPH_POOLED_ALLOCATION
+
     Private();
     Private(const Private &other);
 
@@ -234,6 +247,8 @@ qreal File::ImageMediaMetadata::Location::altitude() const
 class Q_DECL_HIDDEN File::ImageMediaMetadata::Private
 {
   public:
+    KMGRAPH_POOLED_ALLOCATION
+
     Private();
     Private(const Private &other);
 
@@ -452,28 +467,39 @@ QString File::ImageMediaMetadata::lens() const
 class Q_DECL_HIDDEN File::Thumbnail::Private
 {
   public:
+    KMGRAPH_POOLED_ALLOCATION
+
     Private();
     Private(const Private &other);
 
-    QImage image;
+    // The image is kept base64-encoded as received, most thumbnails are never
+    // displayed, so they are only decoded when image() is called. The same
+    // thumbnail is shared by copies of the File, possibly in other threads.
+    QByteArray encodedData;
+    mutable QMutex mutex;
+    mutable QImage image;
+    mutable bool decoded;
     QString mimeType;
 };
 
-File::Thumbnail::Private::Private()
+File::Thumbnail::Private::Private():
+    decoded(false)
 {
 }
 
 File::Thumbnail::Private::Private(const Private &other):
-    image(other.image),
+    encodedData(other.encodedData),
     mimeType(other.mimeType)
 {
+    QMutexLocker locker(&other.mutex);
+    image = other.image;
+    decoded = other.decoded;
 }
 
 File::Thumbnail::Thumbnail(const QVariantMap &map):
     d(new Private)
 {
-    const QByteArray ba = QByteArray::fromBase64(map[QStringLiteral("image")].toByteArray());
-    d->image = QImage::fromData(ba);
+    d->encodedData = map[QStringLiteral("image")].toByteArray();
     d->mimeType = map[QStringLiteral("mimeType")].toString();
 }
 
@@ -489,9 +515,20 @@ File::Thumbnail::~Thumbnail()
 
 QImage File::Thumbnail::image() const
 {
+    QMutexLocker locker(&d->mutex);
+    if (!d->decoded) {
+        d->image = QImage::fromData(imageData());
+        d->decoded = true;
+    }
+
     return d->image;
 }
 
+QByteArray File::Thumbnail::imageData() const
+{
+    return QByteArray::fromBase64(d->encodedData);
+}
+
 QString File::Thumbnail::mimeType() const
 {
     return d->mimeType;
@@ -558,86 +595,176 @@ FilePtr File::Private::fromJSON(const QVariantMap &map)
         return FilePtr();
     }
 
-    FilePtr file(new File());
-    file->setEtag(map[QStringLiteral("etag")].toString());
-    file->d->id = map[QStringLiteral("id")].toString();
-    file->d->selfLink = map[QStringLiteral("selfLink")].toUrl();
-    file->d->title = map[QStringLiteral("title")].toString();
-    file->d->mimeType = map[QStringLiteral("mimeType")].toString();
-    file->d->description = map[QStringLiteral("description")].toString();
-
-    const QVariantMap labelsData =  map[QStringLiteral("labels")].toMap();
-    File::LabelsPtr labels(new File::Labels());
-    labels->d->starred = labelsData[QStringLiteral("starred")].toBool();
-    labels->d->hidden = labelsData[QStringLiteral("hidden")].toBool();
-    labels->d->trashed = labelsData[QStringLiteral("trashed")].toBool();
-    labels->d->restricted = labelsData[QStringLiteral("restricted")].toBool();
-    labels->d->viewed = labelsData[QStringLiteral("viewed")].toBool();
-    file->d->labels = labels;
-
-    // FIXME FIXME FIXME Verify the date format
-    file->d->createdDate = QDateTime::fromString(map[QStringLiteral("createdDate")].toString(), Qt::ISODate);
-    file->d->modifiedDate = QDateTime::fromString(map[QStringLiteral("modifiedDate")].toString(), Qt::ISODate);
-    file->d->modifiedByMeDate = QDateTime::fromString(map[QStringLiteral("modifiedByMeDate")].toString(), Qt::ISODate);
-    file->d->downloadUrl = map[QStringLiteral("downloadUrl")].toUrl();
-
-    const QVariantMap indexableTextData = map[QStringLiteral("indexableText")].toMap();
-    File::IndexableTextPtr indexableText(new File::IndexableText());
-    indexableText->d->text = indexableTextData[QStringLiteral("text")].toString();
-    file->d->indexableText = indexableText;
-
-    const QVariantMap userPermissionData = map[QStringLiteral("userPermission")].toMap();
-    file->d->userPermission = Permission::Private::fromJSON(userPermissionData);
-
-    file->d->fileExtension = map[QStringLiteral("fileExtension")].toString();
-    file->d->md5Checksum = map[QStringLiteral("md5Checksum")].toString();
-    file->d->fileSize = map[QStringLiteral("fileSize")].toLongLong();
-    file->d->alternateLink = map[QStringLiteral("alternateLink")].toUrl();
-    file->d->embedLink = map[QStringLiteral("embedLink")].toUrl();
-    file->d->sharedWithMeDate = QDateTime::fromString(map[QStringLiteral("sharedWithMeDate")].toString(), Qt::ISODate);
-
-    const QVariantList parents = map[QStringLiteral("parents")].toList();
-    for (const QVariant &parent : parents)
-    {
-        file->d->parents << ParentReference::Private::fromJSON(parent.toMap());
+    StringInterner *interner = StringInterner::global();
+
+    FilePtr file = FilePtr::create();
+    file->d->fileSize = 0;
+    file->d->quotaBytesUsed = 0;
+
+    // Walk the map only once and dispatch every key through FileFields
+    // instead of looking up each property separately
+    for (auto it = map.cbegin(), end = map.cend(); it != end; ++it) {
+        const QVariant &value = it.value();
+        switch (FileFields::fromName(it.key())) {
+        case FileFields::Etag:
+            file->setEtag(value.toString());
+            break;
+        case FileFields::Id:
+            file->d->id = value.toString();
+            break;
+        case FileFields::SelfLink:
+            file->d->selfLink = value.toUrl();
+            break;
+        case FileFields::Title:
+            file->d->title = value.toString();
+            break;
+        case FileFields::MimeType:
+            file->d->mimeType = interner->intern(value.toString());
+            break;
+        case FileFields::Description:
+            file->d->description = value.toString();
+            break;
+        case FileFields::Labels: {
+            const QVariantMap labelsData = value.toMap();
+            File::LabelsPtr labels = File::LabelsPtr::create();
+            labels->d->starred = labelsData[QStringLiteral("starred")].toBool();
+            labels->d->hidden = labelsData[QStringLiteral("hidden")].toBool();
+            labels->d->trashed = labelsData[QStringLiteral("trashed")].toBool();
+            labels->d->restricted = labelsData[QStringLiteral("restricted")].toBool();
+            labels->d->viewed = labelsData[QStringLiteral("viewed")].toBool();
+            file->d->labels = labels;
+            break;
+        }
+        case FileFields::CreatedDate:
+            file->d->createdDate = Utils::rfc3339DateFromString(value.toString());
+            break;
+        case FileFields::ModifiedDate:
+            file->d->modifiedDate = Utils::rfc3339DateFromString(value.toString());
+            break;
+        case FileFields::ModifiedByMeDate:
+            file->d->modifiedByMeDate = Utils::rfc3339DateFromString(value.toString());
+            break;
+        case FileFields::DownloadUrl:
+            file->d->downloadUrl = value.toUrl();
+            break;
+        case FileFields::IndexableText: {
+            File::IndexableTextPtr indexableText(new File::IndexableText());
+            indexableText->d->text = value.toMap()[QStringLiteral("text")].toString();
+            file->d->indexableText = indexableText;
+            break;
+        }
+        case FileFields::UserPermission:
+            file->d->userPermission = Permission::Private::fromJSON(value.toMap());
+            break;
+        case FileFields::FileExtension:
+            file->d->fileExtension = interner->intern(value.toString());
+            break;
+        case FileFields::MD5Checksum:
+            file->d->md5Checksum = value.toString();
+            break;
+        case FileFields::FileSize:
+            file->d->fileSize = value.toLongLong();
+            break;
+        case FileFields::AlternateLink:
+            file->d->alternateLink = value.toUrl();
+            break;
+        case FileFields::EmbedLink:
+            file->d->embedLink = value.toUrl();
+            break;
+        case FileFields::SharedWithMeDate:
+            file->d->sharedWithMeDate = Utils::rfc3339DateFromString(value.toString());
+            break;
+        case FileFields::Parents: {
+            const QVariantList parents = value.toList();
+            file->d->parents.reserve(parents.size());
+            for (const QVariant &parent : parents) {
+                file->d->parents << ParentReference::Private::fromJSON(parent.toMap());
+            }
+            break;
+        }
+        case FileFields::ExportLinks: {
+            const QVariantMap exportLinksData = value.toMap();
+            QVariantMap::ConstIterator iter = exportLinksData.constBegin();
+            for ( ; iter != exportLinksData.constEnd(); ++iter) {
+                file->d->exportLinks.insert(interner->intern(iter.key()), iter.value().toUrl());
+            }
+            break;
+        }
+        case FileFields::OriginalFilename:
+            file->d->originalFileName = value.toString();
+            break;
+        case FileFields::QuotaBytesUsed:
+            file->d->quotaBytesUsed = value.toLongLong();
+            break;
+        case FileFields::OwnerNames:
+            file->d->ownerNames = interner->intern(value.toStringList());
+            break;
+        case FileFields::LastModifyingUserName:
+            file->d->lastModifyingUserName = interner->intern(value.toString());
+            break;
+        case FileFields::Editable:
+            file->d->editable = value.toBool();
+            break;
+        case FileFields::WritersCanShare:
+            file->d->writersCanShare = value.toBool();
+            break;
+        case FileFields::ThumbnailLink:
+            file->d->thumbnailLink = value.toUrl();
+            break;
+        case FileFields::LastViewedByMeDate:
+            file->d->lastViewedByMeDate = Utils::rfc3339DateFromString(value.toString());
+            break;
+        case FileFields::WebContentLink:
+            file->d->webContentLink = value.toUrl();
+            break;
+        case FileFields::ExplicitlyTrashed:
+            file->d->explicitlyTrashed = value.toBool();
+            break;
+        case FileFields::ImageMediaMetadata:
+            file->d->imageMediaMetadata =
+                File::ImageMediaMetadataPtr(new File::ImageMediaMetadata(value.toMap()));
+            break;
+        case FileFields::Thumbnail:
+            file->d->thumbnail = File::ThumbnailPtr(new File::Thumbnail(value.toMap()));
+            break;
+        case FileFields::WebViewLink:
+            file->d->webViewLink = value.toUrl();
+            break;
+        case FileFields::IconLink:
+            file->d->iconLink = interner->intern(value.toUrl());
+            break;
+        case FileFields::Shared:
+            file->d->shared = value.toBool();
+            break;
+        case FileFields::Owners: {
+            const QVariantList ownersList = value.toList();
+            for (const QVariant &owner : ownersList) {
+                file->d->owners << User::fromJSON(owner.toMap());
+            }
+            break;
+        }
+        case FileFields::LastModifyingUser:
+            file->d->lastModifyingUser = User::fromJSON(value.toMap());
+            break;
+        default:
+            // Kind was checked above, the rest is not stored in File
+            break;
+        }
     }
 
-    const QVariantMap exportLinksData = map[QStringLiteral("exportLinks")].toMap();
-    QVariantMap::ConstIterator iter = exportLinksData.constBegin();
-    for ( ; iter != exportLinksData.constEnd(); ++iter) {
-        file->d->exportLinks.insert(iter.key(), iter.value().toUrl());
+    // Missing properties behave as if they were sent empty
+    if (!file->d->labels) {
+        file->d->labels = File::LabelsPtr::create();
     }
-
-    file->d->originalFileName = map[QStringLiteral("originalFileName")].toString();
-    file->d->quotaBytesUsed = map[QStringLiteral("quotaBytesUsed")].toLongLong();
-    file->d->ownerNames = map[QStringLiteral("ownerNames")].toStringList();
-    file->d->lastModifyingUserName = map[QStringLiteral("lastModifyingUserName")].toString();
-    file->d->editable = map[QStringLiteral("editable")].toBool();
-    file->d->writersCanShare = map[QStringLiteral("writersCanShare")].toBool();
-    file->d->thumbnailLink = map[QStringLiteral("thumbnailLink")].toUrl();
-    file->d->lastViewedByMeDate = QDateTime::fromString(map[QStringLiteral("lastViewedByMeDate")].toString(), Qt::ISODate);
-    file->d->webContentLink = map[QStringLiteral("webContentLink")].toUrl();
-    file->d->explicitlyTrashed = map[QStringLiteral("explicitlyTrashed")].toBool();
-
-    const QVariantMap imageMetaData = map[QStringLiteral("imageMediaMetadata")].toMap();
-    file->d->imageMediaMetadata =
-        File::ImageMediaMetadataPtr(new File::ImageMediaMetadata(imageMetaData));
-
-    const QVariantMap thumbnailData = map[QStringLiteral("thumbnail")].toMap();
-    File::ThumbnailPtr thumbnail(new File::Thumbnail(thumbnailData));
-    file->d->thumbnail = thumbnail;
-
-    file->d->webViewLink = map[QStringLiteral("webViewLink")].toUrl();
-    file->d->iconLink = map[QStringLiteral("iconLink")].toUrl();
-    file->d->shared = map[QStringLiteral("shared")].toBool();
-
-    const QVariantList ownersList = map[QStringLiteral("owners")].toList();
-    for (const QVariant &owner : ownersList) {
-        file->d->owners << User::fromJSON(owner.toMap());
+    if (!file->d->indexableText) {
+        file->d->indexableText = File::IndexableTextPtr(new File::IndexableText());
+    }
+    if (!file->d->imageMediaMetadata) {
+        file->d->imageMediaMetadata = File::ImageMediaMetadataPtr(new File::ImageMediaMetadata(QVariantMap()));
+    }
+    if (!file->d->thumbnail) {
+        file->d->thumbnail = File::ThumbnailPtr(new File::Thumbnail(QVariantMap()));
     }
-
-    const QVariantMap lastModifyingUser = map[QStringLiteral("lastModifyingUser")].toMap();
-    file->d->lastModifyingUser = User::fromJSON(lastModifyingUser);
 
     return file;
 }
@@ -650,12 +777,18 @@ File::File():
 
 File::File(const File& other):
     KMGraph2::Object(other),
-    d(new Private(*(other.d)))
+    d(other.d)
 { }
 
 File::~File()
 {
-    delete d;
+}
+
+File &File::operator=(const File &other)
+{
+    KMGraph2::Object::operator=(other);
+    d = other.d;
+    return *this;
 }
 
 QString File::folderMimeType()
@@ -909,12 +1042,11 @@ FilePtr File::fromJSON(const QVariantMap &jsonData)
 
 FilesList File::fromJSONFeed(const QByteArray &jsonData, FeedData &feedData)
 {
-    QJsonDocument document = QJsonDocument::fromJson(jsonData);
-    if (document.isNull()) {
+    bool ok = false;
+    const QVariantMap map = JsonParser::parseObject(jsonData, &ok);
+    if (!ok) {
         return FilesList();
     }
-    const QVariant data = document.toVariant();
-    const QVariantMap map = data.toMap();
     if (!map.contains(QStringLiteral("kind")) ||
         map[QStringLiteral("kind")].toString() != QLatin1String("drive#fileList"))
     {
@@ -940,173 +1072,203 @@ FilesList File::fromJSONFeed(const QByteArray &jsonData, FeedData &feedData)
 
 QByteArray File::toJSON(const FilePtr &file, SerializationOptions options)
 {
-    QVariantMap map;
-
-    map[QStringLiteral("kind")] = QLatin1String("drive#file");
-    if (!file->description().isEmpty()) {
-        map[QStringLiteral("description")] = file->description();
-    }
-
-    if (file->indexableText() && !file->indexableText()->text().isEmpty()) {
-        QVariantMap indexableText;
-        indexableText[QStringLiteral("text")] = file->indexableText()->text();
-        map[QStringLiteral("indexableText")] = indexableText;
-    }
-
-    if (file->labels()) {
-        QVariantMap labels;
-        labels[QStringLiteral("hidden")] = file->labels()->hidden();
-        labels[QStringLiteral("restricted")] = file->labels()->restricted();
-        labels[QStringLiteral("starred")] = file->labels()->starred();
-        labels[QStringLiteral("trashed")] = file->labels()->trashed();
-        labels[QStringLiteral("viewed")] = file->labels()->viewed();
-        map[QStringLiteral("labels")] = labels;
-    }
-
-    if (file->lastViewedByMeDate().isValid()) {
-        map[QStringLiteral("lastViewedByMeDate")] = file->lastViewedByMeDate().toString(Qt::ISODate);
-    }
-
-    if (!file->mimeType().isEmpty()) {
-        map[QStringLiteral("mimeType")] = file->mimeType();
-    }
-
-    if (file->modifiedDate().isValid()) {
-        map[QStringLiteral("modifiedDate")] = file->modifiedDate().toString(Qt::ISODate);
-    }
-    if (file->createdDate().isValid() && !(options & ExcludeCreationDate)) {
-        map[QStringLiteral("createdDate")] = file->createdDate().toString(Qt::ISODate);
-    }
-    if (file->modifiedByMeDate().isValid()) {
-        map[QStringLiteral("modifiedByMeDate")] = file->modifiedByMeDate().toString(Qt::ISODate);
-    }
-
-    if (file->fileSize() > 0) {
-        map[QStringLiteral("fileSize")] = file->fileSize();
-    }
-
-    if (!file->title().isEmpty()) {
-        map[QStringLiteral("title")] = file->title();
-    }
-
-    QVariantList parents;
-    const auto parentReferences = file->parents();
-    parents.reserve(parentReferences.size());
-    for (const ParentReferencePtr &parent : parentReferences) {
-        parents << ParentReference::Private::toJSON(parent);
-    }
-    if (!parents.isEmpty()) {
-        map[QStringLiteral("parents")] = parents;
-    }
-    if (!file->etag().isEmpty()) {
-        map[QStringLiteral("etag")] = file->etag();
-    }
-    if (!file->d->id.isEmpty()) {
-        map[QStringLiteral("id")] = file->d->id;
-    }
-    if (!file->d->selfLink.isEmpty()) {
-        map[QStringLiteral("selfLink")] = file->d->selfLink;
-    }
-    if (!file->d->downloadUrl.isEmpty()) {
-        map[QStringLiteral("downloadUrl")] = file->d->downloadUrl;
-    }
-
-    if (!file->d->fileExtension.isEmpty()) {
-        map[QStringLiteral("fileExtension")] = file->d->fileExtension;
-    }
-    if (!file->d->md5Checksum.isEmpty()) {
-        map[QStringLiteral("md5Checksum")] = file->d->md5Checksum;
-    }
-    if (!file->d->alternateLink.isEmpty()) {
-        map[QStringLiteral("alternateLink")] = file->d->alternateLink;
-    }
-    if (!file->d->embedLink.isEmpty()) {
-        map[QStringLiteral("embedLink")] = file->d->embedLink;
-    }
-    if (!file->d->sharedWithMeDate.isNull()) {
-        map[QStringLiteral("sharedWithMeDate")] = file->d->sharedWithMeDate.toString(Qt::ISODate);
-    }
-
-
-    if (!file->d->originalFileName.isEmpty()) {
-        map[QStringLiteral("originalFileName")] = file->d->originalFileName;
-    }
-    if (file->d->quotaBytesUsed > 0) {
-        map[QStringLiteral("quotaBytesUsed")] = file->d->quotaBytesUsed;
-    }
-    if (!file->d->ownerNames.isEmpty()) {
-        map[QStringLiteral("ownerNames")] = QVariant(file->d->ownerNames);
-    }
-    if (!file->d->lastModifyingUserName.isEmpty()) {
-        map[QStringLiteral("lastModifyingUserName")] = file->d->lastModifyingUserName;
-    }
-    if (!file->d->editable) { // default is true
-        map[QStringLiteral("editable")] = file->d->editable;
-    }
-    if (file->d->writersCanShare) { // default is false
-        map[QStringLiteral("writersCanShare")] = file->d->writersCanShare;
-    }
-    if (!file->d->thumbnailLink.isEmpty()) {
-        map[QStringLiteral("thumbnailLink")] = file->d->thumbnailLink;
-    }
-    if (!file->d->lastViewedByMeDate.isNull()) {
-        map[QStringLiteral("lastViewedByMeDate")] = file->d->lastViewedByMeDate.toString(Qt::ISODate);
-    }
-    if (!file->d->webContentLink.isEmpty()) {
-        map[QStringLiteral("webContentLink")] = file->d->webContentLink;
-    }
-    if (file->d->explicitlyTrashed) {
-        map[QStringLiteral("explicitlyTrashed")] = file->d->explicitlyTrashed;
-    }
-
-    if (!file->d->webViewLink.isEmpty()) {
-        map[QStringLiteral("webViewLink")] = file->d->webViewLink;
-    }
-    if (!file->d->iconLink.isEmpty()) {
-        map[QStringLiteral("iconLink")] = file->d->iconLink;
-    }
-    if (file->d->shared) {
-        map[QStringLiteral("shared")] = file->d->shared;
-    }
-
-#if 0
-    const QVariantMap userPermissionData = map[QLatin1String("userPermission")].toMap();
-    file->d->userPermission = Permission::Private::fromJSON(userPermissionData);
-
-    const QVariantList parents = map[QLatin1String("parents")].toList();
-    for (const QVariant &parent : parents)
-    {
-        file->d->parents << ParentReference::Private::fromJSON(parent.toMap());
-    }
-
-    const QVariantMap exportLinksData = map[QLatin1String("exportLinks")].toMap();
-    QVariantMap::ConstIterator iter = exportLinksData.constBegin();
-    for ( ; iter != exportLinksData.constEnd(); ++iter) {
-        file->d->exportLinks.insert(iter.key(), iter.value().toUrl());
-    }
-
-
-    const QVariantMap imageMetaData = map[QLatin1String("imageMediaMetadata")].toMap();
-    file->d->imageMediaMetadata =
-        File::ImageMediaMetadataPtr(new File::ImageMediaMetadata(imageMetaData));
-
-    const QVariantMap thumbnailData = map[QLatin1String("thumbnail")].toMap();
-    File::ThumbnailPtr thumbnail(new File::Thumbnail(thumbnailData));
-    file->d->thumbnail = thumbnail;
-
-
-    const QVariantList ownersList = map[QLatin1String("owners")].toList();
-    for (const QVariant &owner : ownersList) {
-        file->d->owners << User::fromJSON(owner.toMap());
+    JsonWriter writer(1024);
+    writer.beginObject();
+
+    for (int i = 0; i < FileFields::FieldCount; ++i) {
+        const FileFields::Field field = static_cast<FileFields::Field>(i);
+        const char *key = FileFields::name(field);
+
+        switch (field) {
+        case FileFields::Kind:
+            writer.write(key, QLatin1String("drive#file"));
+            break;
+        case FileFields::Etag:
+            if (!file->etag().isEmpty()) {
+                writer.write(key, file->etag());
+            }
+            break;
+        case FileFields::Id:
+            if (!file->d->id.isEmpty()) {
+                writer.write(key, file->d->id);
+            }
+            break;
+        case FileFields::SelfLink:
+            if (!file->d->selfLink.isEmpty()) {
+                writer.write(key, file->d->selfLink);
+            }
+            break;
+        case FileFields::Title:
+            if (!file->d->title.isEmpty()) {
+                writer.write(key, file->d->title);
+            }
+            break;
+        case FileFields::MimeType:
+            if (!file->d->mimeType.isEmpty()) {
+                writer.write(key, file->d->mimeType);
+            }
+            break;
+        case FileFields::Description:
+            if (!file->d->description.isEmpty()) {
+                writer.write(key, file->d->description);
+            }
+            break;
+        case FileFields::Labels:
+            if (file->d->labels) {
+                writer.beginObject(key);
+                writer.write("hidden", file->d->labels->hidden());
+                writer.write("restricted", file->d->labels->restricted());
+                writer.write("starred", file->d->labels->starred());
+                writer.write("trashed", file->d->labels->trashed());
+                writer.write("viewed", file->d->labels->viewed());
+                writer.endObject();
+            }
+            break;
+        case FileFields::CreatedDate:
+            if (file->d->createdDate.isValid() && !(options & ExcludeCreationDate)) {
+                writer.write(key, file->d->createdDate);
+            }
+            break;
+        case FileFields::ModifiedDate:
+            if (file->d->modifiedDate.isValid()) {
+                writer.write(key, file->d->modifiedDate);
+            }
+            break;
+        case FileFields::ModifiedByMeDate:
+            if (file->d->modifiedByMeDate.isValid()) {
+                writer.write(key, file->d->modifiedByMeDate);
+            }
+            break;
+        case FileFields::DownloadUrl:
+            if (!file->d->downloadUrl.isEmpty()) {
+                writer.write(key, file->d->downloadUrl);
+            }
+            break;
+        case FileFields::IndexableText:
+            if (file->d->indexableText && !file->d->indexableText->text().isEmpty()) {
+                writer.beginObject(key);
+                writer.write("text", file->d->indexableText->text());
+                writer.endObject();
+            }
+            break;
+        case FileFields::FileExtension:
+            if (!file->d->fileExtension.isEmpty()) {
+                writer.write(key, file->d->fileExtension);
+            }
+            break;
+        case FileFields::MD5Checksum:
+            if (!file->d->md5Checksum.isEmpty()) {
+                writer.write(key, file->d->md5Checksum);
+            }
+            break;
+        case FileFields::FileSize:
+            if (file->d->fileSize > 0) {
+                writer.write(key, file->d->fileSize);
+            }
+            break;
+        case FileFields::AlternateLink:
+            if (!file->d->alternateLink.isEmpty()) {
+                writer.write(key, file->d->alternateLink);
+            }
+            break;
+        case FileFields::EmbedLink:
+            if (!file->d->embedLink.isEmpty()) {
+                writer.write(key, file->d->embedLink);
+            }
+            break;
+        case FileFields::SharedWithMeDate:
+            if (file->d->sharedWithMeDate.isValid()) {
+                writer.write(key, file->d->sharedWithMeDate);
+            }
+            break;
+        case FileFields::Parents:
+            if (!file->d->parents.isEmpty()) {
+                writer.beginArray(key);
+                for (const ParentReferencePtr &parent : qAsConst(file->d->parents)) {
+                    writer.beginObject();
+                    ParentReference::Private::toJSON(writer, parent);
+                    writer.endObject();
+                }
+                writer.endArray();
+            }
+            break;
+        case FileFields::OriginalFilename:
+            if (!file->d->originalFileName.isEmpty()) {
+                writer.write(key, file->d->originalFileName);
+            }
+            break;
+        case FileFields::QuotaBytesUsed:
+            if (file->d->quotaBytesUsed > 0) {
+                writer.write(key, file->d->quotaBytesUsed);
+            }
+            break;
+        case FileFields::OwnerNames:
+            if (!file->d->ownerNames.isEmpty()) {
+                writer.beginArray(key);
+                for (const QString &ownerName : qAsConst(file->d->ownerNames)) {
+                    writer.write(ownerName);
+                }
+                writer.endArray();
+            }
+            break;
+        case FileFields::LastModifyingUserName:
+            if (!file->d->lastModifyingUserName.isEmpty()) {
+                writer.write(key, file->d->lastModifyingUserName);
+            }
+            break;
+        case FileFields::Editable:
+            if (!file->d->editable) { // default is true
+                writer.write(key, file->d->editable);
+            }
+            break;
+        case FileFields::WritersCanShare:
+            if (file->d->writersCanShare) { // default is false
+                writer.write(key, file->d->writersCanShare);
+            }
+            break;
+        case FileFields::ThumbnailLink:
+            if (!file->d->thumbnailLink.isEmpty()) {
+                writer.write(key, file->d->thumbnailLink);
+            }
+            break;
+        case FileFields::LastViewedByMeDate:
+            if (file->d->lastViewedByMeDate.isValid()) {
+                writer.write(key, file->d->lastViewedByMeDate);
+            }
+            break;
+        case FileFields::WebContentLink:
+            if (!file->d->webContentLink.isEmpty()) {
+                writer.write(key, file->d->webContentLink);
+            }
+            break;
+        case FileFields::ExplicitlyTrashed:
+            if (file->d->explicitlyTrashed) {
+                writer.write(key, file->d->explicitlyTrashed);
+            }
+            break;
+        case FileFields::WebViewLink:
+            if (!file->d->webViewLink.isEmpty()) {
+                writer.write(key, file->d->webViewLink);
+            }
+            break;
+        case FileFields::IconLink:
+            if (!file->d->iconLink.isEmpty()) {
+                writer.write(key, file->d->iconLink);
+            }
+            break;
+        case FileFields::Shared:
+            if (file->d->shared) {
+                writer.write(key, file->d->shared);
+            }
+            break;
+        default:
+            // Read-only properties, or ones that are not stored in File
+            break;
+        }
     }
 
-    const QVariantMap lastModifyingUser = map[QLatin1String("lastModifyingUser")].toMap();
-    file->d->lastModifyingUser = User::fromJSON(lastModifyingUser);
-
-#endif
-
-    QJsonDocument document = QJsonDocument::fromVariant(map);
-    return document.toJson(QJsonDocument::Compact);
+    writer.endObject();
+    return writer.data();
 }
 
 
@@ -288,8 +288,22 @@ class KMGRAPHONEDRIVE_EXPORT File: public KMGraph2::Object
         explicit Thumbnail(const Thumbnail &other);
         virtual ~Thumbnail();
 
+        /**
+         * @brief Returns the decoded thumbnail.
+         *
+         * The image is decoded on first call.
+         */
         QImage image() const;
 
+        /**
+         * @brief Returns the thumbnail in its compressed form, i.e. as
+         *        encoded in mimeType().
+         *
+         * These are the bytes sent by the server, also after image() has
+         * decoded them.
+         */
+        QByteArray imageData() const;
+
         QString mimeType() const;
 
       private:
@@ -315,6 +329,7 @@ class KMGRAPHONEDRIVE_EXPORT File: public KMGraph2::Object
 
     explicit File();
     explicit File(const File &other);
+    File &operator=(const File &other);
     virtual ~File();
 
     /**
@@ -597,7 +612,7 @@ class KMGRAPHONEDRIVE_EXPORT File: public KMGraph2::Object
     static FilePtr fromJSON(const QVariantMap &jsonData);
 
 private:
-    Private * const d;
+    QSharedDataPointer<Private> d;
     friend class Private;
     friend class Change::Private;
     friend class ParentReference;
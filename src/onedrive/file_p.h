@@ -22,6 +22,7 @@
 #define LIBKMGRAPH2_ONEDRIVEFILE_P_H
 
 #include "file.h"
+#include "objectpool.h"
 
 #include <QVariantMap>
 
@@ -31,9 +32,11 @@ namespace KMGraph2
 namespace OneDrive
 {
 
-class Q_DECL_HIDDEN File::Private
+class Q_DECL_HIDDEN File::Private : public QSharedData
 {
   public:
+    KMGRAPH_POOLED_ALLOCATION
+
     Private();
     Private(const Private &other);
 
@@ -24,6 +24,7 @@
 #include "account.h"
 #include "onedriveservice.h"
 #include "file.h"
+#include "userregistry.h"
 #include "utils.h"
 
 #include <QNetworkReply>
@@ -119,6 +120,8 @@ void FileAbstractModifyJob::start()
 ObjectsList FileAbstractModifyJob::handleReplyWithItems(const QNetworkReply *reply,
                                                         const QByteArray &rawData)
 {
+    const UserRegistry::Scope userScope(account());
+
     const QString contentType = reply->header(QNetworkRequest::ContentTypeHeader).toString();
     ContentType ct = Utils::stringToContentType(contentType);
     ObjectsList items;
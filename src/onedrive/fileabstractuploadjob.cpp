@@ -26,6 +26,7 @@
 #include "../debug.h"
 #include "onedriveservice.h"
 #include "file.h"
+#include "userregistry.h"
 #include "utils.h"
 
 #include <QNetworkRequest>
@@ -311,6 +312,8 @@ void FileAbstractUploadJob::dispatchRequest(QNetworkAccessManager *accessManager
 void FileAbstractUploadJob::handleReply(const QNetworkReply *reply,
                                         const QByteArray &rawData)
 {
+    const UserRegistry::Scope userScope(account());
+
     const QString contentType = reply->header(QNetworkRequest::ContentTypeHeader).toString();
     ContentType ct = Utils::stringToContentType(contentType);
     if (ct == KMGraph2::JSON) {
@@ -23,6 +23,7 @@
 #include "account.h"
 #include "onedriveservice.h"
 #include "file.h"
+#include "userregistry.h"
 #include "utils.h"
 
 #include <QNetworkReply>
@@ -144,6 +145,8 @@ void FileCopyJob::dispatchRequest(QNetworkAccessManager *accessManager,
 void FileCopyJob::handleReply(const QNetworkReply *reply,
                               const QByteArray &rawData)
 {
+    const UserRegistry::Scope userScope(account());
+
     const QString contentType = reply->header(QNetworkRequest::ContentTypeHeader).toString();
     ContentType ct = Utils::stringToContentType(contentType);
     if (ct == KMGraph2::JSON) {
@@ -24,28 +24,46 @@
 #include "filefetchcontentjob.h"
 #include "account.h"
 #include "file.h"
+#include "../debug.h"
 
+#include <QCryptographicHash>
 #include <QNetworkRequest>
 #include <QNetworkReply>
 
 using namespace KMGraph2;
 using namespace KMGraph2::OneDrive;
 
+namespace {
+
+// Job treats a missing status code as success, too
+bool isSuccess(const QNetworkReply *reply)
+{
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    return status == 0 || (status >= 200 && status < 300);
+}
+
+}
+
 class Q_DECL_HIDDEN FileFetchContentJob::Private
 {
   public:
     Private(FileFetchContentJob *parent);
 
     void _k_downloadProgress(qint64 downloaded, qint64 total);
+    void _k_readyRead(QNetworkReply *reply);
 
     QUrl url;
     QByteArray fileData;
+    QString expectedMd5Checksum;
+    QString md5Checksum;
+    QCryptographicHash hash;
 
   private:
     FileFetchContentJob * const q;
 };
 
 FileFetchContentJob::Private::Private(FileFetchContentJob *parent):
+    hash(QCryptographicHash::Md5),
     q(parent)
 {
 }
@@ -55,13 +73,27 @@ void FileFetchContentJob::Private::_k_downloadProgress(qint64 downloaded, qint64
     q->emitProgress(downloaded, total);
 }
 
+void FileFetchContentJob::Private::_k_readyRead(QNetworkReply *reply)
+{
+    // Only consume the content, errors and redirects are handled by Job
+    if (!isSuccess(reply)) {
+        return;
+    }
+
+    const QByteArray chunk = reply->readAll();
+    hash.addData(chunk);
+    fileData.append(chunk);
+}
+
 FileFetchContentJob::FileFetchContentJob(const FilePtr &file,
                                          const AccountPtr &account,
                                          QObject *parent):
     FetchJob(account, parent),
     d(new Private(this))
 {
+    setHedgingEnabled(true);
     d->url = file->downloadUrl();
+    d->expectedMd5Checksum = file->md5Checksum();
 }
 
 FileFetchContentJob::FileFetchContentJob(const QUrl &url,
@@ -70,6 +102,7 @@ FileFetchContentJob::FileFetchContentJob(const QUrl &url,
     FetchJob(account, parent),
     d(new Private(this))
 {
+    setHedgingEnabled(true);
     d->url = url;
 }
 
@@ -83,14 +116,47 @@ QByteArray FileFetchContentJob::data() const
     return d->fileData;
 }
 
+void FileFetchContentJob::setExpectedMd5Checksum(const QString &md5Checksum)
+{
+    if (isRunning()) {
+        qCWarning(KMGraphDebug) << "Called setExpectedMd5Checksum() on running job. Ignoring.";
+        return;
+    }
+
+    d->expectedMd5Checksum = md5Checksum;
+}
+
+QString FileFetchContentJob::expectedMd5Checksum() const
+{
+    return d->expectedMd5Checksum;
+}
+
+QString FileFetchContentJob::md5Checksum() const
+{
+    return d->md5Checksum;
+}
+
 void FileFetchContentJob::start()
 {
+    d->fileData.clear();
+    d->md5Checksum.clear();
+
     QNetworkRequest request(d->url);
     request.setRawHeader("Authorization", "Bearer " + account()->accessToken().toLatin1());
 
     enqueueRequest(request);
 }
 
+void FileFetchContentJob::aboutToAbort()
+{
+    // Partially downloaded data are of no use to anyone
+    d->fileData.clear();
+    d->md5Checksum.clear();
+    d->hash.reset();
+
+    FetchJob::aboutToAbort();
+}
+
 void FileFetchContentJob::dispatchRequest(QNetworkAccessManager *accessManager,
                                           const QNetworkRequest &request,
                                           const QByteArray &data,
@@ -99,17 +165,38 @@ void FileFetchContentJob::dispatchRequest(QNetworkAccessManager *accessManager,
     Q_UNUSED(data)
     Q_UNUSED(contentType)
 
+    // Every request (including redirects) delivers the whole content again
+    d->fileData.clear();
+    d->hash.reset();
+
     QNetworkReply *reply = accessManager->get(request);
     connect(reply, &QNetworkReply::downloadProgress,
             this, [this](qint64 downloaded, qint64 total) { d->_k_downloadProgress(downloaded, total); });
+    connect(reply, &QNetworkReply::readyRead,
+            this, [this, reply]() { d->_k_readyRead(reply); });
 }
 
 void FileFetchContentJob::handleReply(const QNetworkReply *reply,
                                       const QByteArray &rawData)
 {
-    Q_UNUSED(reply)
-
-    d->fileData = rawData;
+    // Job passes 404 replies here too, there's nothing to verify in those
+    if (!isSuccess(reply)) {
+        return;
+    }
+
+    // rawData only holds what has not been consumed by _k_readyRead() yet
+    d->hash.addData(rawData);
+    d->fileData.append(rawData);
+    d->md5Checksum = QString::fromLatin1(d->hash.result().toHex());
+
+    if (!d->expectedMd5Checksum.isEmpty()
+            && d->md5Checksum.compare(d->expectedMd5Checksum, Qt::CaseInsensitive) != 0) {
+        qCWarning(KMGraphDebug) << "Checksum mismatch, expected" << d->expectedMd5Checksum
+                                << "got" << d->md5Checksum;
+        setError(KMGraph2::ChecksumMismatch);
+        setErrorString(tr("Downloaded data are corrupted, checksum does not match."));
+        emitFinished();
+    }
 }
 
 ObjectsList FileFetchContentJob::handleReplyWithItems(const QNetworkReply *reply,
@@ -45,8 +45,27 @@ class KMGRAPHONEDRIVE_EXPORT FileFetchContentJob : public KMGraph2::FetchJob
 
     QByteArray data() const;
 
+    /**
+     * @brief Sets hex-encoded MD5 checksum the downloaded data must match.
+     *
+     * The checksum is computed incrementally while the data are being
+     * received. When it does not match, the job finishes with
+     * KMGraph2::ChecksumMismatch error.
+     *
+     * When the job is constructed from a File, File::md5Checksum() is used.
+     * Set an empty string to disable the verification.
+     */
+    void setExpectedMd5Checksum(const QString &md5Checksum);
+    QString expectedMd5Checksum() const;
+
+    /**
+     * @brief Returns hex-encoded MD5 checksum of the downloaded data.
+     */
+    QString md5Checksum() const;
+
   protected:
     void start() override;
+    void aboutToAbort() override;
     void handleReply(const QNetworkReply *reply, const QByteArray &rawData) override;
     void dispatchRequest(QNetworkAccessManager *accessManager,
                                  const QNetworkRequest &request,
@@ -26,6 +26,9 @@
 #include "../debug.h"
 #include "onedriveservice.h"
 #include "file.h"
+#include "filefields_p.h"
+#include "filetable.h"
+#include "userregistry.h"
 #include "utils.h"
 
 #include <QNetworkRequest>
@@ -39,8 +42,6 @@ class Q_DECL_HIDDEN FileFetchJob::Private
   public:
     Private(FileFetchJob *parent);
     void processNext();
-    QNetworkRequest createRequest(const QUrl &url);
-    QStringList fieldsToStrings(qulonglong fields);
 
     FileSearchQuery searchQuery;
     QStringList filesIDs;
@@ -49,6 +50,10 @@ class Q_DECL_HIDDEN FileFetchJob::Private
     bool updateViewedDate;
 
     qulonglong fields;
+    // Value of the "fields" query parameter, built on first use
+    QString fieldsParameter;
+
+    FileTable *fileTable;
 
   private:
     FileFetchJob *const q;
@@ -58,170 +63,11 @@ FileFetchJob::Private::Private(FileFetchJob *parent):
     isFeed(false),
     updateViewedDate(false),
     fields(FileFetchJob::AllFields),
+    fileTable(nullptr),
     q(parent)
 {
 }
 
-QNetworkRequest FileFetchJob::Private::createRequest(const QUrl &url)
-{
-    QNetworkRequest request;
-    request.setUrl(url);
-    request.setRawHeader("Authorization", "Bearer " + q->account()->accessToken().toLatin1());
-
-    return request;
-}
-
-QStringList FileFetchJob::Private::fieldsToStrings(qulonglong fields)
-{
-    if (fields & AllFields) {
-        return QStringList();
-    }
-
-    QStringList fieldsStrings;
-    // Always fetch kind
-    fieldsStrings << QStringLiteral("kind");
-
-    // FIXME: Use QMetaEnum once it supports enums larger than int
-    if (fields & Id) {
-        fieldsStrings << QStringLiteral("id");
-    }
-    if (fields & Title) {
-        fieldsStrings << QStringLiteral("title");
-    }
-    if (fields & MimeType) {
-        fieldsStrings << QStringLiteral("mimeType");
-    }
-    if (fields & Description) {
-        fieldsStrings << QStringLiteral("description");
-    }
-    if (fields & Labels) {
-        fieldsStrings << QStringLiteral("labels");
-    }
-    if (fields & CreatedDate) {
-        fieldsStrings << QStringLiteral("createdDate");
-    }
-    if (fields & ModifiedDate) {
-        fieldsStrings << QStringLiteral("modifiedDate");
-    }
-    if (fields & ModifiedByMeDate) {
-        fieldsStrings << QStringLiteral("modifiedByMeDate");
-    }
-    if (fields & DownloadUrl) {
-        fieldsStrings << QStringLiteral("downloadUrl");
-    }
-    if (fields & IndexableText) {
-        fieldsStrings << QStringLiteral("indexableText");
-    }
-    if (fields & UserPermission) {
-        fieldsStrings << QStringLiteral("userPermission");
-    }
-    if (fields & FileExtension) {
-        fieldsStrings << QStringLiteral("fileExtension");
-    }
-    if (fields & MD5Checksum) {
-        fieldsStrings << QStringLiteral("md5Checksum");
-    }
-    if (fields & FileSize) {
-        fieldsStrings << QStringLiteral("fileSize");
-    }
-    if (fields & AlternateLink) {
-        fieldsStrings << QStringLiteral("alternateLink");
-    }
-    if (fields & EmbedLink) {
-        fieldsStrings << QStringLiteral("embedLink");
-    }
-    if (fields & SharedWithMeDate) {
-        fieldsStrings << QStringLiteral("sharedWithMeDate");
-    }
-    if (fields & Parents) {
-        fieldsStrings << QStringLiteral("parents");
-    }
-    if (fields & ExportLinks) {
-        fieldsStrings << QStringLiteral("exportLinks");
-    }
-    if (fields & OriginalFilename) {
-        fieldsStrings << QStringLiteral("originalFilename");
-    }
-    if (fields & OwnerNames) {
-        fieldsStrings << QStringLiteral("ownerNames");
-    }
-    if (fields & LastModifiedByMeDate) {
-        fieldsStrings << QStringLiteral("lastModifiedByMeDate");
-    }
-    if (fields & Editable) {
-        fieldsStrings << QStringLiteral("editable");
-    }
-    if (fields & WritersCanShare) {
-        fieldsStrings << QStringLiteral("writersCanShare");
-    }
-    if (fields & ThumbnailLink) {
-        fieldsStrings << QStringLiteral("thumbnailLink");
-    }
-    if (fields & LastViewedByMeDate) {
-        fieldsStrings << QStringLiteral("lastViewedByMeDate");
-    }
-    if (fields & WebContentLink) {
-        fieldsStrings << QStringLiteral("webContentLink");
-    }
-    if (fields & ExplicitlyTrashed) {
-        fieldsStrings << QStringLiteral("explicitlyTrashed");
-    }
-    if (fields & ImageMediaMetadata) {
-        fieldsStrings << QStringLiteral("imageMediaMetadata");
-    }
-    if (fields & Thumbnail) {
-        fieldsStrings << QStringLiteral("thumbnail");
-    }
-    if (fields & WebViewLink) {
-        fieldsStrings << QStringLiteral("webViewLink");
-    }
-    if (fields & IconLink) {
-        fieldsStrings << QStringLiteral("iconLink");
-    }
-    if (fields & Shared) {
-        fieldsStrings << QStringLiteral("shared");
-    }
-    if (fields & Owners) {
-        fieldsStrings << QStringLiteral("owners");
-    }
-    if (fields & LastModifyingUser) {
-        fieldsStrings << QStringLiteral("lastModifyingUser");
-    }
-    if (fields & AppDataContents) {
-        fieldsStrings << QStringLiteral("appDataContents");
-    }
-    if (fields & OpenWithLinks) {
-        fieldsStrings << QStringLiteral("openWithLinks");
-    }
-    if (fields & DefaultOpenWithLink) {
-        fieldsStrings << QStringLiteral("defaultOpenWithLink");
-    }
-    if (fields & HeadRevisionId) {
-        fieldsStrings << QStringLiteral("headRevisionId");
-    }
-    if (fields & Copyable) {
-        fieldsStrings << QStringLiteral("copyable");
-    }
-    if (fields & Properties) {
-        fieldsStrings << QStringLiteral("properties");
-    }
-    if (fields & MarkedViewedByMeDate) {
-        fieldsStrings << QStringLiteral("markedViewedByMeDate");
-    }
-    if (fields & Version) {
-        fieldsStrings << QStringLiteral("version");
-    }
-    if (fields & SharingUser) {
-        fieldsStrings << QStringLiteral("sharingUser");
-    }
-    if (fields & Permissions) {
-        fieldsStrings << QStringLiteral("permissions");
-    }
-
-    return fieldsStrings;
-}
-
-
 void FileFetchJob::Private::processNext()
 {
     QUrl url;
@@ -232,10 +78,13 @@ void FileFetchJob::Private::processNext()
             url.addQueryItem(QStringLiteral("q"), searchQuery.serialize());
         }
         if (fields != FileFetchJob::AllFields) {
-            const QStringList fieldsStrings = fieldsToStrings(fields);
-            url.addQueryItem(QStringLiteral("fields"),
-                             QStringLiteral("etag,kind,nextLink,nextPageToken,selfLink,items(%1)").arg(fieldsStrings.join(QStringLiteral(","))));
+            if (fieldsParameter.isEmpty()) {
+                fieldsParameter = QStringLiteral("etag,kind,nextLink,nextPageToken,selfLink,items(%1)").arg(FileFields::projection(fields));
+            }
+            url.addQueryItem(QStringLiteral("fields"), fieldsParameter);
         }
+
+        q->enqueueFeedRequest(url);
     } else {
         if (filesIDs.isEmpty()) {
             q->emitFinished();
@@ -246,42 +95,48 @@ void FileFetchJob::Private::processNext()
         url = OneDriveService::fetchFileUrl(fileId);
 
         if (fields != FileFetchJob::AllFields) {
-            const QStringList fieldsStrings = fieldsToStrings(fields);
-            url.addQueryItem(QStringLiteral("fields"), fieldsStrings.join(QStringLiteral(",")));
+            if (fieldsParameter.isEmpty()) {
+                fieldsParameter = FileFields::projection(fields);
+            }
+            url.addQueryItem(QStringLiteral("fields"), fieldsParameter);
         }
-    }
 
-    q->enqueueRequest(createRequest(url));
+        q->enqueueRequest(q->createRequest(url));
+    }
 }
 
 FileFetchJob::FileFetchJob(const QString &fileId,
                            const AccountPtr &account, QObject *parent):
-    FetchJob(account, parent),
+    FeedFetchJob(account, parent),
     d(new Private(this))
 {
+    setHedgingEnabled(true);
     d->filesIDs << fileId;
 }
 
 FileFetchJob::FileFetchJob(const QStringList &filesIds,
                            const AccountPtr &account, QObject *parent):
-    FetchJob(account, parent),
+    FeedFetchJob(account, parent),
     d(new Private(this))
 {
+    setHedgingEnabled(true);
     d->filesIDs << filesIds;
 }
 
 FileFetchJob::FileFetchJob(const AccountPtr &account, QObject *parent):
-    FetchJob(account, parent),
+    FeedFetchJob(account, parent),
     d(new Private(this))
 {
+    setHedgingEnabled(true);
     d->isFeed = true;
 }
 
 FileFetchJob::FileFetchJob(const FileSearchQuery &query,
                            const AccountPtr &account, QObject *parent):
-    FetchJob(account, parent),
+    FeedFetchJob(account, parent),
     d(new Private(this))
 {
+    setHedgingEnabled(true);
     d->isFeed = true;
     d->searchQuery = query;
 }
@@ -315,6 +170,7 @@ void FileFetchJob::start()
 void FileFetchJob::setFields(qulonglong fields)
 {
     d->fields = fields;
+    d->fieldsParameter.clear();
 }
 
 qulonglong FileFetchJob::fields() const
@@ -322,27 +178,45 @@ qulonglong FileFetchJob::fields() const
     return d->fields;
 }
 
+void FileFetchJob::setFileTable(FileTable *table)
+{
+    if (isRunning()) {
+        qCWarning(KMGraphDebug) << "Can't modify fileTable property when job is running.";
+        return;
+    }
+
+    d->fileTable = table;
+}
 
-ObjectsList FileFetchJob::handleReplyWithItems(const QNetworkReply *reply,
-                                               const QByteArray &rawData)
+FileTable *FileFetchJob::fileTable() const
 {
+    return d->fileTable;
+}
+
+
+ObjectsList FileFetchJob::handleFeedReply(const QNetworkReply *reply,
+                                          const QByteArray &rawData,
+                                          FeedData &feedData)
+{
+    const UserRegistry::Scope userScope(account());
+
     ObjectsList items;
 
     const QString contentType = reply->header(QNetworkRequest::ContentTypeHeader).toString();
     ContentType ct = Utils::stringToContentType(contentType);
     if (ct == KMGraph2::JSON) {
         if (d->isFeed) {
-            FeedData feedData;
-
-            items << File::fromJSONFeed(rawData, feedData);
-
-            if (feedData.nextPageUrl.isValid()) {
-                const QNetworkRequest request = d->createRequest(feedData.nextPageUrl);
-                enqueueRequest(request);
+            if (d->fileTable) {
+                addFetchedItemsCount(qMax(0, d->fileTable->insertJSON(rawData, feedData)));
+            } else {
+                items << File::fromJSONFeed(rawData, feedData);
             }
-
         } else {
-            items << File::fromJSON(rawData);
+            if (d->fileTable) {
+                addFetchedItemsCount(qMax(0, d->fileTable->insertJSON(rawData, feedData)));
+            } else {
+                items << File::fromJSON(rawData);
+            }
 
             d->processNext();
         }
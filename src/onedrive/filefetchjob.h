@@ -23,7 +23,7 @@
 #ifndef KMGRAPH2_ONEDRIVEFILEFETCHJOB_H
 #define KMGRAPH2_ONEDRIVEFILEFETCHJOB_H
 
-#include "fetchjob.h"
+#include "feedfetchjob.h"
 #include "kmgraphonedrive_export.h"
 
 #include <QStringList>
@@ -35,7 +35,8 @@ namespace OneDrive
 {
 
 class FileSearchQuery;
-class KMGRAPHONEDRIVE_EXPORT FileFetchJob : public KMGraph2::FetchJob
+class FileTable;
+class KMGRAPHONEDRIVE_EXPORT FileFetchJob : public KMGraph2::FeedFetchJob
 {
     Q_OBJECT
 
@@ -120,10 +121,20 @@ class KMGRAPHONEDRIVE_EXPORT FileFetchJob : public KMGraph2::FetchJob
     void setFields(qulonglong fields);
     qulonglong fields() const;
 
+    /**
+     * @brief Sets a table to store the fetched files in.
+     *
+     * When set, the received files are stored directly in @p table, which
+     * is much cheaper for very large listings, and items() stays empty.
+     * The job does not take ownership of the table.
+     */
+    void setFileTable(FileTable *table);
+    FileTable *fileTable() const;
+
   protected:
     void start() override;
-    KMGraph2::ObjectsList handleReplyWithItems(const QNetworkReply *reply,
-            const QByteArray &rawData) override;
+    KMGraph2::ObjectsList handleFeedReply(const QNetworkReply *reply,
+            const QByteArray &rawData, KMGraph2::FeedData &feedData) override;
 
   private:
     class Private;
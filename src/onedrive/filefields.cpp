@@ -0,0 +1,197 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "filefields_p.h"
+#include "filefetchjob.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <algorithm>
+
+using namespace KMGraph2;
+using namespace KMGraph2::OneDrive;
+
+namespace {
+
+#define FIELD(name, fetchField) { name, sizeof(name) - 1, fetchField }
+
+constexpr FileFields::Descriptor descriptors[] = {
+    FIELD("kind",                 0),
+    FIELD("id",                   FileFetchJob::Id),
+    FIELD("title",                FileFetchJob::Title),
+    FIELD("mimeType",             FileFetchJob::MimeType),
+    FIELD("description",          FileFetchJob::Description),
+    FIELD("labels",               FileFetchJob::Labels),
+    FIELD("createdDate",          FileFetchJob::CreatedDate),
+    FIELD("modifiedDate",         FileFetchJob::ModifiedDate),
+    FIELD("modifiedByMeDate",     FileFetchJob::ModifiedByMeDate),
+    FIELD("downloadUrl",          FileFetchJob::DownloadUrl),
+    FIELD("indexableText",        FileFetchJob::IndexableText),
+    FIELD("userPermission",       FileFetchJob::UserPermission),
+    FIELD("fileExtension",        FileFetchJob::FileExtension),
+    FIELD("md5Checksum",          FileFetchJob::MD5Checksum),
+    FIELD("fileSize",             FileFetchJob::FileSize),
+    FIELD("alternateLink",        FileFetchJob::AlternateLink),
+    FIELD("embedLink",            FileFetchJob::EmbedLink),
+    FIELD("sharedWithMeDate",     FileFetchJob::SharedWithMeDate),
+    FIELD("parents",              FileFetchJob::Parents),
+    FIELD("exportLinks",          FileFetchJob::ExportLinks),
+    FIELD("originalFilename",     FileFetchJob::OriginalFilename),
+    FIELD("ownerNames",           FileFetchJob::OwnerNames),
+    FIELD("lastModifiedByMeDate", FileFetchJob::LastModifiedByMeDate),
+    FIELD("editable",             FileFetchJob::Editable),
+    FIELD("writersCanShare",      FileFetchJob::WritersCanShare),
+    FIELD("thumbnailLink",        FileFetchJob::ThumbnailLink),
+    FIELD("lastViewedByMeDate",   FileFetchJob::LastViewedByMeDate),
+    FIELD("webContentLink",       FileFetchJob::WebContentLink),
+    FIELD("explicitlyTrashed",    FileFetchJob::ExplicitlyTrashed),
+    FIELD("imageMediaMetadata",   FileFetchJob::ImageMediaMetadata),
+    FIELD("thumbnail",            FileFetchJob::Thumbnail),
+    FIELD("webViewLink",          FileFetchJob::WebViewLink),
+    FIELD("iconLink",             FileFetchJob::IconLink),
+    FIELD("shared",               FileFetchJob::Shared),
+    FIELD("owners",               FileFetchJob::Owners),
+    FIELD("lastModifyingUser",    FileFetchJob::LastModifyingUser),
+    FIELD("appDataContents",      FileFetchJob::AppDataContents),
+    FIELD("openWithLinks",        FileFetchJob::OpenWithLinks),
+    FIELD("defaultOpenWithLink",  FileFetchJob::DefaultOpenWithLink),
+    FIELD("headRevisionId",       FileFetchJob::HeadRevisionId),
+    FIELD("copyable",             FileFetchJob::Copyable),
+    FIELD("properties",           FileFetchJob::Properties),
+    FIELD("markedViewedByMeDate", FileFetchJob::MarkedViewedByMeDate),
+    FIELD("version",              FileFetchJob::Version),
+    FIELD("sharingUser",          FileFetchJob::SharingUser),
+    FIELD("permissions",          FileFetchJob::Permissions),
+    FIELD("etag",                 0),
+    FIELD("selfLink",             0),
+    FIELD("quotaBytesUsed",       0),
+    FIELD("lastModifyingUserName", 0)
+};
+
+#undef FIELD
+
+static_assert(sizeof(descriptors) / sizeof(descriptors[0]) == FileFields::FieldCount,
+              "FileFields::Field and the descriptor table are out of sync");
+
+constexpr int HashSize = 256;
+
+inline uint hashKey(const ushort *key, int size, uint seed)
+{
+    uint h = seed;
+    for (int i = 0; i < size; ++i) {
+        h = (h ^ key[i]) * 16777619U;
+    }
+    return (h ^ (h >> 16)) % HashSize;
+}
+
+inline uint hashKey(const char *key, int size, uint seed)
+{
+    uint h = seed;
+    for (int i = 0; i < size; ++i) {
+        h = (h ^ uchar(key[i])) * 16777619U;
+    }
+    return (h ^ (h >> 16)) % HashSize;
+}
+
+// Slot table of a perfect hash of all keys in the descriptor table. The seed
+// is searched for once, so the table needs no maintenance when fields are added.
+struct PerfectHash {
+    PerfectHash()
+    {
+        for (seed = 1; ; ++seed) {
+            std::fill(slots, slots + HashSize, FileFields::Unknown);
+            bool collision = false;
+            for (int field = 0; field < FileFields::FieldCount && !collision; ++field) {
+                const uint slot = hashKey(descriptors[field].name, descriptors[field].nameSize, seed);
+                collision = slots[slot] != FileFields::Unknown;
+                slots[slot] = static_cast<FileFields::Field>(field);
+            }
+            if (!collision) {
+                break;
+            }
+        }
+    }
+
+    uint seed;
+    FileFields::Field slots[HashSize];
+};
+
+const PerfectHash &perfectHash()
+{
+    static const PerfectHash hash;
+    return hash;
+}
+
+}
+
+const FileFields::Descriptor &FileFields::descriptor(Field field)
+{
+    Q_ASSERT(field > Unknown && field < FieldCount);
+    return descriptors[field];
+}
+
+FileFields::Field FileFields::fromName(const QString &key)
+{
+    const PerfectHash &hash = perfectHash();
+    const Field field = hash.slots[hashKey(key.utf16(), key.size(), hash.seed)];
+    if (field == Unknown) {
+        return Unknown;
+    }
+
+    const Descriptor &desc = descriptors[field];
+    if (key.size() != desc.nameSize) {
+        return Unknown;
+    }
+    const QChar *str = key.constData();
+    for (int i = 0; i < desc.nameSize; ++i) {
+        if (str[i].unicode() != ushort(uchar(desc.name[i]))) {
+            return Unknown;
+        }
+    }
+    return field;
+}
+
+QString FileFields::projection(qulonglong fetchFields)
+{
+    if (fetchFields == FileFetchJob::AllFields) {
+        return QString();
+    }
+
+    static QMutex mutex;
+    static QHash<qulonglong, QString> cache;
+
+    QMutexLocker locker(&mutex);
+    auto it = cache.constFind(fetchFields);
+    if (it != cache.constEnd()) {
+        return *it;
+    }
+
+    QString projection = QLatin1String(descriptors[Kind].name);
+    for (const Descriptor &desc : descriptors) {
+        if (desc.fetchField & fetchFields) {
+            projection += QLatin1Char(',') + QLatin1String(desc.name, desc.nameSize);
+        }
+    }
+    cache.insert(fetchFields, projection);
+    return projection;
+}
@@ -0,0 +1,145 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBKMGRAPH2_ONEDRIVEFILEFIELDS_P_H
+#define LIBKMGRAPH2_ONEDRIVEFILEFIELDS_P_H
+
+#include "kmgraphonedrive_export.h"
+
+#include <QString>
+
+namespace KMGraph2
+{
+
+namespace OneDrive
+{
+
+/**
+ * @brief Schema of the drive#file resource
+ *
+ * A single table describes every property of a file: its JSON key and the
+ * FileFetchJob::Fields flag that selects it in a partial response. It drives
+ * File::fromJSON(), File::toJSON() and the "fields" parameter of
+ * FileFetchJob, so that they can not get out of sync.
+ *
+ * @internal
+ */
+namespace FileFields
+{
+
+// Keep in sync with the descriptor table in filefields.cpp. Properties that
+// can be requested by FileFetchJob come first, in order of their flags.
+enum Field {
+    Unknown = -1,
+    Kind = 0,
+    Id,
+    Title,
+    MimeType,
+    Description,
+    Labels,
+    CreatedDate,
+    ModifiedDate,
+    ModifiedByMeDate,
+    DownloadUrl,
+    IndexableText,
+    UserPermission,
+    FileExtension,
+    MD5Checksum,
+    FileSize,
+    AlternateLink,
+    EmbedLink,
+    SharedWithMeDate,
+    Parents,
+    ExportLinks,
+    OriginalFilename,
+    OwnerNames,
+    LastModifiedByMeDate,
+    Editable,
+    WritersCanShare,
+    ThumbnailLink,
+    LastViewedByMeDate,
+    WebContentLink,
+    ExplicitlyTrashed,
+    ImageMediaMetadata,
+    Thumbnail,
+    WebViewLink,
+    IconLink,
+    Shared,
+    Owners,
+    LastModifyingUser,
+    AppDataContents,
+    OpenWithLinks,
+    DefaultOpenWithLink,
+    HeadRevisionId,
+    Copyable,
+    Properties,
+    MarkedViewedByMeDate,
+    Version,
+    SharingUser,
+    Permissions,
+    // Always part of the response
+    Etag,
+    SelfLink,
+    QuotaBytesUsed,
+    LastModifyingUserName,
+
+    FieldCount
+};
+
+struct Descriptor {
+    const char *name;
+    int nameSize;
+    qulonglong fetchField;  ///< FileFetchJob::Fields flag, 0 if it can't be selected
+};
+
+KMGRAPHONEDRIVE_EXPORT const Descriptor &descriptor(Field field);
+
+/**
+ * @brief Returns JSON key of @p field
+ */
+inline const char *name(Field field)
+{
+    return descriptor(field).name;
+}
+
+/**
+ * @brief Returns field with JSON key @p key, or Unknown
+ *
+ * Uses a perfect hash of all known keys, so every lookup costs a single
+ * hash computation and one string comparison.
+ */
+KMGRAPHONEDRIVE_EXPORT Field fromName(const QString &key);
+
+/**
+ * @brief Returns comma-separated list of properties selected by
+ *        FileFetchJob::Fields @p fetchFields
+ *
+ * The list is computed only once per distinct value of @p fetchFields.
+ */
+KMGRAPHONEDRIVE_EXPORT QString projection(qulonglong fetchFields);
+
+} // namespace FileFields
+
+} // namespace OneDrive
+
+} // namespace KMGraph2
+
+#endif // LIBKMGRAPH2_ONEDRIVEFILEFIELDS_P_H
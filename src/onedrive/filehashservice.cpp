@@ -0,0 +1,591 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "filehashservice.h"
+#include "multibuffermd5.h"
+#include "../debug.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QSemaphore>
+#include <QStandardPaths>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+
+#include <algorithm>
+#include <functional>
+
+#ifdef Q_OS_UNIX
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+using namespace KMGraph2;
+using namespace KMGraph2::OneDrive;
+
+namespace {
+
+static const quint32 CacheMagic = 0x4b4d4835; // "KMH5"
+static const quint32 CacheVersion = 2;
+// Smallest serialized cache entry: the FileKey, two empty arrays and lastUse
+static const qint64 MinCacheEntrySize = 4 * 8 + 2 * 4 + 8;
+
+// Files are hashed in chunks, because QCryptographicHash::addData() only
+// takes an int length.
+static const qint64 HashChunkSize = 64 * 1024 * 1024;
+
+// Files up to this size are read into memory and hashed in batches by
+// MultiBufferMd5, larger files are mapped and hashed one by one.
+static const qint64 SmallFileSize = 64 * 1024;
+static const int SmallFileBatchSize = 64;
+
+/**
+ * Identity of a file on disk. When any of the members changes, the cached
+ * checksum is considered stale.
+ */
+struct FileKey
+{
+    FileKey():
+        device(0),
+        inode(0),
+        size(-1),
+        mtime(0)
+    {
+    }
+
+    quint64 device;
+    quint64 inode;
+    qint64 size;
+    qint64 mtime; // nanoseconds since epoch, where the platform provides them
+};
+
+bool operator==(const FileKey &a, const FileKey &b)
+{
+    return a.device == b.device && a.inode == b.inode
+        && a.size == b.size && a.mtime == b.mtime;
+}
+
+uint qHash(const FileKey &key, uint seed = 0)
+{
+    return ::qHash(key.inode, seed) ^ ::qHash(key.device) ^ ::qHash(key.mtime) ^ ::qHash(key.size);
+}
+
+QDataStream &operator<<(QDataStream &stream, const FileKey &key)
+{
+    return stream << key.device << key.inode << key.size << key.mtime;
+}
+
+QDataStream &operator>>(QDataStream &stream, FileKey &key)
+{
+    return stream >> key.device >> key.inode >> key.size >> key.mtime;
+}
+
+struct CacheEntry
+{
+    QByteArray digest;
+    QString filePath;   // to find out whether the file has changed or is gone
+    qint64 lastUse;     // msecs since epoch
+};
+
+QDataStream &operator<<(QDataStream &stream, const CacheEntry &entry)
+{
+    return stream << entry.digest << entry.filePath << entry.lastUse;
+}
+
+QDataStream &operator>>(QDataStream &stream, CacheEntry &entry)
+{
+    return stream >> entry.digest >> entry.filePath >> entry.lastUse;
+}
+
+// Identifies the file regardless of its content
+typedef QPair<quint64 /* device */, quint64 /* inode */> FileId;
+
+class HashRunnable : public QRunnable
+{
+  public:
+    explicit HashRunnable(const std::function<void()> &func):
+        mFunc(func)
+    {
+    }
+
+    void run() override
+    {
+        mFunc();
+    }
+
+  private:
+    std::function<void()> mFunc;
+};
+
+}
+
+class Q_DECL_HIDDEN FileHashService::Private
+{
+  public:
+    Private();
+
+    static bool statFile(const QString &filePath, FileKey &key);
+    static QByteArray hashFile(const QString &filePath, qint64 size);
+    static QVector<QByteArray> hashSmallFiles(const QStringList &filePaths);
+
+    void insert(const FileKey &key, const CacheEntry &entry);
+    void remove(const FileKey &key);
+    void trim();
+
+    QString cachePath;
+    QThreadPool pool;
+
+    mutable QMutex mutex;
+    QHash<FileKey, CacheEntry> cache;
+    // Current version of every file in the cache, older versions are
+    // dropped as soon as a new one is hashed
+    QHash<FileId, FileKey> versions;
+    int maxCacheSize;
+    bool dirty;
+};
+
+FileHashService::Private::Private():
+    maxCacheSize(100000),
+    dirty(false)
+{
+}
+
+void FileHashService::Private::insert(const FileKey &key, const CacheEntry &entry)
+{
+    FileKey &current = versions[qMakePair(key.device, key.inode)];
+    if (current.size >= 0 && !(current == key)) {
+        cache.remove(current);
+    }
+    current = key;
+    cache.insert(key, entry);
+    dirty = true;
+
+    if (cache.size() > maxCacheSize) {
+        trim();
+    }
+}
+
+void FileHashService::Private::remove(const FileKey &key)
+{
+    cache.remove(key);
+    const auto it = versions.find(qMakePair(key.device, key.inode));
+    if (it != versions.end() && *it == key) {
+        versions.erase(it);
+    }
+    dirty = true;
+}
+
+void FileHashService::Private::trim()
+{
+    // Make some room at once, so that we don't have to sort the cache again
+    // on every insert
+    const int target = maxCacheSize - maxCacheSize / 10;
+
+    QVector<QPair<qint64 /* lastUse */, FileKey>> entries;
+    entries.reserve(cache.size());
+    for (auto it = cache.cbegin(), end = cache.cend(); it != end; ++it) {
+        entries.append(qMakePair(it->lastUse, it.key()));
+    }
+    // Least recently used first
+    std::sort(entries.begin(), entries.end(),
+              [](const QPair<qint64, FileKey> &a, const QPair<qint64, FileKey> &b) {
+                  return a.first < b.first;
+              });
+
+    for (int i = 0; i < entries.size() && cache.size() > target; ++i) {
+        remove(entries.at(i).second);
+    }
+}
+
+bool FileHashService::Private::statFile(const QString &filePath, FileKey &key)
+{
+#ifdef Q_OS_UNIX
+    struct stat st;
+    if (::stat(QFile::encodeName(filePath).constData(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+
+    key.device = st.st_dev;
+    key.inode = st.st_ino;
+    key.size = st.st_size;
+#if defined(Q_OS_LINUX)
+    key.mtime = qint64(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#elif defined(Q_OS_DARWIN)
+    key.mtime = qint64(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    key.mtime = qint64(st.st_mtime) * 1000000000;
+#endif
+    return true;
+#else
+    // No inode numbers here, the canonical path serves as the file identity
+    const QFileInfo info(filePath);
+    if (!info.isFile()) {
+        return false;
+    }
+
+    key.device = 0;
+    key.inode = qHash(info.canonicalFilePath());
+    key.size = info.size();
+    key.mtime = info.lastModified().toMSecsSinceEpoch() * 1000000;
+    return true;
+#endif
+}
+
+QByteArray FileHashService::Private::hashFile(const QString &filePath, qint64 size)
+{
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    if (size == 0) {
+        return hash.result();
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(KMGraphDebug) << "Failed to access" << filePath;
+        return QByteArray();
+    }
+
+    uchar *data = file.map(0, size);
+    if (data) {
+        for (qint64 offset = 0; offset < size; offset += HashChunkSize) {
+            const qint64 length = qMin(HashChunkSize, size - offset);
+            hash.addData(reinterpret_cast<const char *>(data + offset), static_cast<int>(length));
+        }
+        file.unmap(data);
+    } else {
+        // Some file systems don't support mmap, read the file the old way
+        if (!hash.addData(&file)) {
+            qCWarning(KMGraphDebug) << "Failed to read" << filePath;
+            return QByteArray();
+        }
+    }
+
+    return hash.result();
+}
+
+QVector<QByteArray> FileHashService::Private::hashSmallFiles(const QStringList &filePaths)
+{
+    QVector<QByteArray> contents;
+    contents.reserve(filePaths.size());
+    QVector<bool> valid(filePaths.size(), true);
+    for (int i = 0; i < filePaths.size(); ++i) {
+        QFile file(filePaths.at(i));
+        if (!file.open(QIODevice::ReadOnly)) {
+            qCWarning(KMGraphDebug) << "Failed to access" << filePaths.at(i);
+            valid[i] = false;
+        }
+        contents.append(file.readAll());
+    }
+
+    QVector<QByteArray> digests = MultiBufferMd5::hash(contents);
+    for (int i = 0; i < digests.size(); ++i) {
+        if (!valid.at(i)) {
+            digests[i].clear();
+        }
+    }
+    return digests;
+}
+
+FileHashService::FileHashService(const QString &cachePath, QObject *parent):
+    QObject(parent),
+    d(new Private)
+{
+    d->cachePath = cachePath;
+    d->pool.setMaxThreadCount(QThread::idealThreadCount());
+
+    if (!d->cachePath.isEmpty() && QFile::exists(d->cachePath)) {
+        load();
+    }
+}
+
+FileHashService::~FileHashService()
+{
+    d->pool.waitForDone();
+    if (d->dirty) {
+        save();
+    }
+
+    delete d;
+}
+
+QString FileHashService::defaultCachePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+            + QLatin1String("/libkmgraph/md5cache");
+}
+
+QString FileHashService::cachePath() const
+{
+    return d->cachePath;
+}
+
+void FileHashService::setMaxThreadCount(int maxThreadCount)
+{
+    d->pool.setMaxThreadCount(qMax(1, maxThreadCount));
+}
+
+int FileHashService::maxThreadCount() const
+{
+    return d->pool.maxThreadCount();
+}
+
+QString FileHashService::md5Checksum(const QString &filePath)
+{
+    return md5Checksums(QStringList() << filePath).value(filePath);
+}
+
+QHash<QString, QString> FileHashService::md5Checksums(const QStringList &filePaths)
+{
+    struct Pending {
+        QString filePath;
+        FileKey key;
+        QByteArray digest;
+    };
+
+    QHash<QString, QString> checksums;
+    QVector<Pending> pending;
+
+    {
+        QMutexLocker locker(&d->mutex);
+        for (const QString &filePath : filePaths) {
+            FileKey key;
+            if (!Private::statFile(filePath, key)) {
+                qCWarning(KMGraphDebug) << filePath << "is not a valid file path";
+                continue;
+            }
+
+            const auto it = d->cache.find(key);
+            if (it != d->cache.end()) {
+                it->lastUse = QDateTime::currentMSecsSinceEpoch();
+                checksums.insert(filePath, QString::fromLatin1(it->digest.toHex()));
+            } else {
+                pending.append({ filePath, key, QByteArray() });
+            }
+        }
+    }
+
+    if (pending.isEmpty()) {
+        return checksums;
+    }
+
+    // Each runnable only touches its own slots in pending, so no locking is
+    // needed until all of them are done.
+    QSemaphore done;
+    int runnables = 0;
+    QVector<Pending *> smallFiles;
+    for (int i = 0; i < pending.size(); ++i) {
+        Pending *p = &pending[i];
+        if (p->key.size <= SmallFileSize) {
+            smallFiles.append(p);
+            continue;
+        }
+
+        d->pool.start(new HashRunnable([p, &done]() {
+            p->digest = Private::hashFile(p->filePath, p->key.size);
+            done.release();
+        }));
+        ++runnables;
+    }
+
+    for (int i = 0; i < smallFiles.size(); i += SmallFileBatchSize) {
+        const QVector<Pending *> batch = smallFiles.mid(i, SmallFileBatchSize);
+        d->pool.start(new HashRunnable([batch, &done]() {
+            QStringList filePaths;
+            filePaths.reserve(batch.size());
+            for (const Pending *p : batch) {
+                filePaths.append(p->filePath);
+            }
+            const QVector<QByteArray> digests = Private::hashSmallFiles(filePaths);
+            for (int j = 0; j < batch.size(); ++j) {
+                batch[j]->digest = digests.at(j);
+            }
+            done.release();
+        }));
+        ++runnables;
+    }
+    done.acquire(runnables);
+
+    QMutexLocker locker(&d->mutex);
+    for (const Pending &p : qAsConst(pending)) {
+        if (p.digest.isEmpty()) {
+            continue;
+        }
+        checksums.insert(p.filePath, QString::fromLatin1(p.digest.toHex()));
+
+        // Don't cache the checksum if the file has changed while we were reading it
+        FileKey key;
+        if (Private::statFile(p.filePath, key) && key == p.key) {
+            d->insert(key, { p.digest, p.filePath, QDateTime::currentMSecsSinceEpoch() });
+        }
+    }
+
+    return checksums;
+}
+
+bool FileHashService::isCached(const QString &filePath) const
+{
+    FileKey key;
+    if (!Private::statFile(filePath, key)) {
+        return false;
+    }
+
+    QMutexLocker locker(&d->mutex);
+    return d->cache.contains(key);
+}
+
+int FileHashService::cacheSize() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->cache.size();
+}
+
+void FileHashService::setMaxCacheSize(int entries)
+{
+    QMutexLocker locker(&d->mutex);
+    d->maxCacheSize = qMax(1, entries);
+    if (d->cache.size() > d->maxCacheSize) {
+        d->trim();
+    }
+}
+
+int FileHashService::maxCacheSize() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->maxCacheSize;
+}
+
+int FileHashService::removeStale()
+{
+    QMutexLocker locker(&d->mutex);
+    const QHash<FileKey, CacheEntry> cache = d->cache;
+    locker.unlock();
+
+    // Stat the files without holding the lock, there may be many of them
+    QVector<FileKey> stale;
+    for (auto it = cache.cbegin(), end = cache.cend(); it != end; ++it) {
+        FileKey key;
+        if (!Private::statFile(it->filePath, key) || !(key == it.key())) {
+            stale.append(it.key());
+        }
+    }
+
+    locker.relock();
+    for (const FileKey &key : qAsConst(stale)) {
+        d->remove(key);
+    }
+    return stale.size();
+}
+
+void FileHashService::clear()
+{
+    QMutexLocker locker(&d->mutex);
+    d->dirty = d->dirty || !d->cache.isEmpty();
+    d->cache.clear();
+    d->versions.clear();
+}
+
+bool FileHashService::load()
+{
+    if (d->cachePath.isEmpty()) {
+        return false;
+    }
+
+    QFile file(d->cachePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(KMGraphDebug) << "Failed to open checksum cache" << d->cachePath;
+        return false;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic, version, count;
+    stream >> magic >> version >> count;
+    if (magic != CacheMagic || version != CacheVersion) {
+        qCWarning(KMGraphDebug) << d->cachePath << "is not a valid checksum cache";
+        return false;
+    }
+
+    QHash<FileKey, CacheEntry> cache;
+    // The count is not trusted, a corrupted one must not allocate more than
+    // the rest of the file can hold
+    cache.reserve(int(qMin<qint64>(count, file.bytesAvailable() / MinCacheEntrySize)));
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        FileKey key;
+        CacheEntry entry;
+        stream >> key >> entry;
+        cache.insert(key, entry);
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qCWarning(KMGraphDebug) << "Checksum cache" << d->cachePath << "is corrupted";
+        return false;
+    }
+
+    QMutexLocker locker(&d->mutex);
+    d->cache = cache;
+    d->versions.clear();
+    for (auto it = cache.cbegin(), end = cache.cend(); it != end; ++it) {
+        d->versions.insert(qMakePair(it.key().device, it.key().inode), it.key());
+    }
+    d->dirty = false;
+    if (d->cache.size() > d->maxCacheSize) {
+        d->trim();
+    }
+    return true;
+}
+
+bool FileHashService::save()
+{
+    if (d->cachePath.isEmpty()) {
+        return false;
+    }
+
+    QDir().mkpath(QFileInfo(d->cachePath).absolutePath());
+    QSaveFile file(d->cachePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(KMGraphDebug) << "Failed to write checksum cache" << d->cachePath;
+        return false;
+    }
+
+    QMutexLocker locker(&d->mutex);
+    QDataStream stream(&file);
+    stream << CacheMagic << CacheVersion << quint32(d->cache.size());
+    for (auto it = d->cache.constBegin(), end = d->cache.constEnd(); it != end; ++it) {
+        stream << it.key() << it.value();
+    }
+
+    if (!file.commit()) {
+        qCWarning(KMGraphDebug) << "Failed to write checksum cache" << d->cachePath;
+        return false;
+    }
+
+    d->dirty = false;
+    return true;
+}
+
+#include "moc_filehashservice.cpp"
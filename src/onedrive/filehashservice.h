@@ -0,0 +1,160 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KMGRAPH2_ONEDRIVEFILEHASHSERVICE_H
+#define KMGRAPH2_ONEDRIVEFILEHASHSERVICE_H
+
+#include "kmgraphonedrive_export.h"
+
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+
+namespace KMGraph2
+{
+
+namespace OneDrive
+{
+
+/**
+ * @brief Computes MD5 checksums of local files and caches them on disk.
+ *
+ * The checksums returned by FileHashService are in the same format as
+ * File::md5Checksum(), so local files can be compared with their remote
+ * counterparts without downloading them.
+ *
+ * Files are hashed on a private thread pool. Large files are memory-mapped,
+ * small files are hashed in batches using SIMD where the CPU supports it.
+ * Every result is cached under the identity of the file on disk, i.e. its
+ * device, inode, size and modification time, so a file is only hashed again
+ * once it has actually changed. The cache is loaded from cachePath() when the service is
+ * created and written back by save() or when the service is destroyed.
+ *
+ * When a file is hashed again after it has changed, the checksum of its old
+ * version is dropped. Checksums of deleted files are dropped by
+ * removeStale(), and the least recently used checksums when the cache
+ * grows over maxCacheSize().
+ */
+class KMGRAPHONEDRIVE_EXPORT FileHashService : public QObject
+{
+    Q_OBJECT
+
+  public:
+    /**
+     * @brief Constructs a new hash service
+     *
+     * @param cachePath Path of the persistent checksum cache. Pass an empty
+     *        string to keep the cache in memory only.
+     * @param parent
+     */
+    explicit FileHashService(const QString &cachePath = defaultCachePath(),
+                             QObject *parent = nullptr);
+    ~FileHashService() override;
+
+    /**
+     * @brief Returns the default location of the persistent checksum cache.
+     */
+    static QString defaultCachePath();
+
+    /**
+     * @brief Returns path of the persistent checksum cache.
+     */
+    QString cachePath() const;
+
+    /**
+     * @brief Sets maximum number of files to be hashed in parallel.
+     *
+     * Defaults to QThread::idealThreadCount().
+     */
+    void setMaxThreadCount(int maxThreadCount);
+    int maxThreadCount() const;
+
+    /**
+     * @brief Returns hex-encoded MD5 checksum of file at @p filePath.
+     *
+     * Returns an empty string when the file cannot be read.
+     */
+    QString md5Checksum(const QString &filePath);
+
+    /**
+     * @brief Returns hex-encoded MD5 checksums of all @p filePaths.
+     *
+     * Files that are not in the cache are hashed in parallel. The method
+     * blocks until all checksums are known. Files that cannot be read
+     * are not included in the result.
+     */
+    QHash<QString /* file path */, QString /* checksum */> md5Checksums(const QStringList &filePaths);
+
+    /**
+     * @brief Returns whether a valid checksum of @p filePath is cached.
+     */
+    bool isCached(const QString &filePath) const;
+
+    /**
+     * @brief Returns number of checksums in the cache.
+     */
+    int cacheSize() const;
+
+    /**
+     * @brief Sets maximum number of checksums in the cache.
+     *
+     * When the cache grows over the limit, the least recently used checksums
+     * are dropped. Defaults to 100000.
+     */
+    void setMaxCacheSize(int entries);
+    int maxCacheSize() const;
+
+    /**
+     * @brief Drops checksums of files that have been deleted or modified
+     *        since they were hashed.
+     *
+     * Every cached file is checked on disk, so this is meant to be called
+     * now and then, e.g. after a full sync, rather than before every lookup.
+     *
+     * Returns number of dropped checksums.
+     */
+    int removeStale();
+
+    /**
+     * @brief Drops all cached checksums.
+     */
+    void clear();
+
+    /**
+     * @brief Loads the cache from cachePath(), replacing current content.
+     */
+    bool load();
+
+    /**
+     * @brief Writes the cache to cachePath().
+     */
+    bool save();
+
+  private:
+    class Private;
+    Private *const d;
+    friend class Private;
+};
+
+} // namespace OneDrive
+
+} // namespace KMGraph2
+
+#endif // KMGRAPH2_ONEDRIVEFILEHASHSERVICE_H
@@ -19,6 +19,10 @@
  */
 
 #include "filesearchquery.h"
+#include "filesearchquery_p.h"
+#include "file.h"
+#include "parentreference.h"
+#include "user.h"
 
 #include <QString>
 #include <QDateTime>
@@ -38,6 +42,8 @@ public:
     static QString logicOperatorToString(LogicOperator op);
     static QString valueToString(Field field, const QVariant &var);
 
+    bool matchesComparison(const FilePtr &file) const;
+
     QList<FileSearchQuery> subqueries;
     QVariant value;
     Field field;
@@ -47,6 +53,9 @@ public:
 
 FileSearchQuery::Private::Private()
     : QSharedData()
+    , field(Title)
+    , compareOp(Contains)
+    , logicOp(And)
 {
 }
 
@@ -162,6 +171,111 @@ QString FileSearchQuery::Private::valueToString(FileSearchQuery::Field field, co
     return QString();
 }
 
+bool FileSearchQuery::Private::matchesComparison(const FilePtr &file) const
+{
+    switch (field) {
+    case Title:
+        return SearchComparison::compare(compareOp, file->title(), value.toString());
+    case FullText:
+        // Content of the file is not known locally
+        return SearchComparison::compare(compareOp, file->title(), value.toString())
+                || SearchComparison::compare(compareOp, file->description(), value.toString());
+    case MimeType:
+        return SearchComparison::compare(compareOp, file->mimeType(), value.toString());
+    case ModifiedDate:
+    case LastViewedByMeDate: {
+        const QDateTime date = (field == ModifiedDate) ? file->modifiedDate() : file->lastViewedByMeDate();
+        const QDateTime other = value.toDateTime();
+        return date.isValid() && other.isValid()
+                && SearchComparison::compare(compareOp, date.toMSecsSinceEpoch(), other.toMSecsSinceEpoch());
+    }
+    case Trashed:
+    case Starred: {
+        const File::LabelsPtr labels = file->labels();
+        const bool flag = labels && (field == Trashed ? labels->trashed() : labels->starred());
+        return SearchComparison::compare(compareOp, flag, value.toBool());
+    }
+    case SharedWithMe:
+        return SearchComparison::compare(compareOp, file->sharedWithMeDate().isValid(), value.toBool());
+    case Parents: {
+        const QString parentId = value.toString();
+        const ParentReferencesList parents = file->parents();
+        for (const ParentReferencePtr &parent : parents) {
+            if (parent->id() == parentId) {
+                return true;
+            }
+        }
+        return false;
+    }
+    case Owners: {
+        const QString owner = value.toString();
+        if (file->ownerNames().contains(owner)) {
+            return true;
+        }
+        const UsersList owners = file->owners();
+        for (const UserPtr &user : owners) {
+            if (user->permissionId() == owner || user->displayName() == owner) {
+                return true;
+            }
+        }
+        return false;
+    }
+    case Writers:
+    case Readers:
+        // Not available in File
+        return false;
+    }
+
+    Q_ASSERT(false);
+    return false;
+}
+
+bool SearchComparison::compare(FileSearchQuery::CompareOperator op, const QString &string, const QString &value)
+{
+    switch (op) {
+    case FileSearchQuery::Contains:
+        return string.contains(value, Qt::CaseInsensitive);
+    case FileSearchQuery::Equals:
+        return string == value;
+    case FileSearchQuery::NotEquals:
+        return string != value;
+    default:
+        return false;
+    }
+}
+
+bool SearchComparison::compare(FileSearchQuery::CompareOperator op, qint64 number, qint64 value)
+{
+    switch (op) {
+    case FileSearchQuery::Equals:
+        return number == value;
+    case FileSearchQuery::NotEquals:
+        return number != value;
+    case FileSearchQuery::Less:
+        return number < value;
+    case FileSearchQuery::LessOrEqual:
+        return number <= value;
+    case FileSearchQuery::Greater:
+        return number > value;
+    case FileSearchQuery::GreaterOrEqual:
+        return number >= value;
+    default:
+        return false;
+    }
+}
+
+bool SearchComparison::compare(FileSearchQuery::CompareOperator op, bool flag, bool value)
+{
+    switch (op) {
+    case FileSearchQuery::Equals:
+        return flag == value;
+    case FileSearchQuery::NotEquals:
+        return flag != value;
+    default:
+        return false;
+    }
+}
+
 FileSearchQuery::FileSearchQuery(FileSearchQuery::LogicOperator op)
     : d(new Private)
 {
@@ -233,6 +347,70 @@ bool FileSearchQuery::isEmpty() const
     return d->value.isNull() && d->subqueries.isEmpty();
 }
 
+bool FileSearchQuery::isComparison() const
+{
+    return d->subqueries.isEmpty() && !d->value.isNull();
+}
+
+FileSearchQuery::Field FileSearchQuery::field() const
+{
+    return d->field;
+}
+
+FileSearchQuery::CompareOperator FileSearchQuery::compareOperator() const
+{
+    return d->compareOp;
+}
+
+QVariant FileSearchQuery::value() const
+{
+    return d->value;
+}
+
+FileSearchQuery::LogicOperator FileSearchQuery::logicOperator() const
+{
+    return d->logicOp;
+}
+
+QList<FileSearchQuery> FileSearchQuery::subqueries() const
+{
+    return d->subqueries;
+}
+
+bool FileSearchQuery::canMatchLocally() const
+{
+    if (isComparison()) {
+        return d->field != Writers && d->field != Readers;
+    }
+
+    for (const FileSearchQuery &query : qAsConst(d->subqueries)) {
+        if (!query.canMatchLocally()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FileSearchQuery::matches(const FilePtr &file) const
+{
+    if (isComparison()) {
+        return d->matchesComparison(file);
+    }
+
+    // An empty group matches everything, like an empty query sent to the server
+    if (d->subqueries.isEmpty()) {
+        return true;
+    }
+
+    const bool any = (d->logicOp == Or);
+    for (const FileSearchQuery &query : qAsConst(d->subqueries)) {
+        if (query.matches(file) == any) {
+            return any;
+        }
+    }
+    return !any;
+}
+
 QString FileSearchQuery::serialize() const
 {
     if (isEmpty()) {
@@ -22,6 +22,7 @@
 #define KMGRAPH2_ONEDRIVE_FILESEARCHQUERY_H
 
 #include "kmgraphonedrive_export.h"
+#include "types.h"
 
 #include <QVariant>
 #include <QSharedDataPointer>
@@ -38,6 +39,9 @@ namespace OneDrive
  * See https://developer.microsoft.com/en-us/graph/docs/api-reference/v1.0/api/driveitem_search for allowed
  * combinations of fields, compare operators, and value types.
  *
+ * Besides being sent to the server, a query can be evaluated against files
+ * that are already known locally, see matches() and FileTable::select().
+ *
  * @since 2.3
  */
 class KMGRAPHONEDRIVE_EXPORT FileSearchQuery
@@ -86,8 +90,45 @@ public:
 
     bool isEmpty() const;
 
+    /**
+     * @brief Returns whether this is a single comparison rather than
+     *        a group of subqueries.
+     */
+    bool isComparison() const;
+
+    /**
+     * @brief Field, operator and value of a comparison.
+     */
+    Field field() const;
+    CompareOperator compareOperator() const;
+    QVariant value() const;
+
+    /**
+     * @brief Operator combining subqueries of a group.
+     */
+    LogicOperator logicOperator() const;
+    QList<FileSearchQuery> subqueries() const;
+
     QString serialize() const;
 
+    /**
+     * @brief Returns whether the query can be evaluated by matches().
+     *
+     * File does not carry the list of writers and readers of a file, so
+     * queries on Writers and Readers can only be answered by the server.
+     */
+    bool canMatchLocally() const;
+
+    /**
+     * @brief Evaluates the query against @p file without contacting the server.
+     *
+     * Strings are compared the same way as by the server: "contains" is
+     * case-insensitive, equality is exact. FullText is looked up in title and
+     * description only. An empty query matches all files. Comparisons that
+     * cannot be evaluated locally never match.
+     */
+    bool matches(const FilePtr &file) const;
+
   private:
     class Private;
     QSharedDataPointer<Private> d;
@@ -0,0 +1,1209 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "filetable.h"
+#include "file.h"
+#include "filesearchquery.h"
+#include "filesearchquery_p.h"
+#include "parentreference.h"
+#include "user.h"
+#include "utils.h"
+#include "../debug.h"
+
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+using namespace KMGraph2;
+using namespace KMGraph2::OneDrive;
+
+const qint64 FileTable::InvalidDate = std::numeric_limits<qint64>::min();
+
+namespace {
+
+struct Row
+{
+    quint32 id;
+    quint32 etag;
+    quint32 title;
+    quint32 mimeType;
+    quint32 md5Checksum;
+    quint32 parent;
+    quint32 owner;
+    QVector<quint32> otherParents;
+    QVector<quint32> otherOwners;
+    qint64 fileSize;
+    qint64 createdDate;
+    qint64 modifiedDate;
+    quint16 flags;
+};
+
+qint64 dateToMSecs(const QDateTime &dt)
+{
+    return dt.isValid() ? dt.toMSecsSinceEpoch() : FileTable::InvalidDate;
+}
+
+QDateTime msecsToDate(qint64 msecs)
+{
+    return msecs == FileTable::InvalidDate ? QDateTime() : QDateTime::fromMSecsSinceEpoch(msecs, Qt::UTC);
+}
+
+}
+
+class Q_DECL_HIDDEN FileTable::Private
+{
+  public:
+    Private();
+
+    quint32 intern(const QString &string);
+    void internValues(const QStringList &values, quint32 &first, QVector<quint32> &others);
+    void release(quint32 string);
+    void releaseRow(int row);
+    int upsert(const Row &row);
+    bool removeRow(int row);
+    int insertFileObject(const QJsonObject &object);
+    int insertChangeObject(const QJsonObject &object);
+    QVector<quint32> stringRanks(const QVector<quint32> &column, const QVector<int> &rows) const;
+
+    // Rows of every distinct value of a string column
+    struct StringIndex
+    {
+        const QVector<quint32> *column;
+        // Remaining values of multi-valued columns, or null
+        const QVector<QVector<quint32>> *others;
+        QHash<quint32 /* string */, QVector<int> /* rows */> rows;
+        bool valid;
+    };
+
+    void invalidateIndexes();
+    void addToIndexes(int row);
+    void removeFromIndexes(int row);
+    static void addToIndex(StringIndex &index, int row);
+    static void removeFromIndex(StringIndex &index, int row);
+    bool modifiedDateLess(int a, int b) const;
+    const StringIndex &stringIndex(StringIndex &index) const;
+    const QVector<int> &modifiedDateIndex() const;
+
+    QVector<int> allRows() const;
+    QVector<int> evaluate(const FileSearchQuery &query) const;
+    QVector<int> lookup(const FileSearchQuery &query) const;
+    bool matchesRow(const FileSearchQuery &query, int row) const;
+    static bool isIndexed(const FileSearchQuery &query);
+
+    template<typename Predicate>
+    QVector<int> select(Predicate predicate) const
+    {
+        QVector<int> result;
+        const int count = ids.size();
+        for (int i = 0; i < count; ++i) {
+            if (predicate(i)) {
+                result.append(i);
+            }
+        }
+        return result;
+    }
+
+    // Every row holds a reference to each of its strings. Strings no longer
+    // used by any row are dropped and their slots reused, so that renames and
+    // new etags from the change feed don't make the pool grow forever.
+    QVector<QString> strings;
+    QVector<quint32> stringRefs;
+    QVector<quint32> freeStrings;
+    QHash<QString, quint32> stringIndexes;
+
+    QVector<quint32> ids;
+    QVector<quint32> etags;
+    QVector<quint32> titles;
+    QVector<quint32> mimeTypes;
+    QVector<quint32> md5Checksums;
+    // First parent and first owner name, the rest of them (and the permission
+    // IDs and display names of the owners) are kept in per-row lists, which
+    // stay empty and don't allocate for the usual single-parent files
+    QVector<quint32> parents;
+    QVector<quint32> owners;
+    QVector<QVector<quint32>> otherParents;
+    QVector<QVector<quint32>> otherOwners;
+    QVector<qint64> fileSizes;
+    QVector<qint64> createdDates;
+    QVector<qint64> modifiedDates;
+    QVector<quint16> flags;
+
+    QHash<quint32 /* id */, int /* row */> rows;
+
+    // Built on first use, then kept up to date by upsert() and removeRow()
+    mutable StringIndex mimeTypeIndex;
+    mutable StringIndex parentIndex;
+    mutable StringIndex ownerIndex;
+    // All rows with valid modification date, sorted by the date and row
+    mutable QVector<int> sortedByModifiedDate;
+    mutable bool modifiedDateIndexValid;
+};
+
+FileTable::Private::Private()
+{
+    mimeTypeIndex.column = &mimeTypes;
+    mimeTypeIndex.others = nullptr;
+    parentIndex.column = &parents;
+    parentIndex.others = &otherParents;
+    ownerIndex.column = &owners;
+    ownerIndex.others = &otherOwners;
+    invalidateIndexes();
+}
+
+quint32 FileTable::Private::intern(const QString &string)
+{
+    if (string.isEmpty()) {
+        return NoString;
+    }
+
+    const auto it = stringIndexes.constFind(string);
+    if (it != stringIndexes.constEnd()) {
+        ++stringRefs[*it];
+        return *it;
+    }
+
+    quint32 index;
+    if (!freeStrings.isEmpty()) {
+        index = freeStrings.takeLast();
+        strings[index] = string;
+        stringRefs[index] = 1;
+    } else {
+        index = quint32(strings.size());
+        strings.append(string);
+        stringRefs.append(1);
+    }
+    stringIndexes.insert(string, index);
+    return index;
+}
+
+void FileTable::Private::release(quint32 string)
+{
+    if (string == NoString || --stringRefs[string] > 0) {
+        return;
+    }
+
+    stringIndexes.remove(strings.at(string));
+    strings[string] = QString();
+    freeStrings.append(string);
+}
+
+void FileTable::Private::releaseRow(int row)
+{
+    release(ids.at(row));
+    release(etags.at(row));
+    release(titles.at(row));
+    release(mimeTypes.at(row));
+    release(md5Checksums.at(row));
+    release(parents.at(row));
+    release(owners.at(row));
+    for (quint32 string : otherParents.at(row)) {
+        release(string);
+    }
+    for (quint32 string : otherOwners.at(row)) {
+        release(string);
+    }
+}
+
+void FileTable::Private::internValues(const QStringList &values, quint32 &first, QVector<quint32> &others)
+{
+    first = values.isEmpty() ? NoString : intern(values.first());
+    others.clear();
+    for (int i = 1; i < values.size(); ++i) {
+        const quint32 value = intern(values.at(i));
+        if (value != NoString && value != first && !others.contains(value)) {
+            others.append(value);
+        } else {
+            release(value);
+        }
+    }
+}
+
+int FileTable::Private::upsert(const Row &row)
+{
+    int r = rows.value(row.id, -1);
+    if (r < 0) {
+        r = ids.size();
+        rows.insert(row.id, r);
+        ids.append(row.id);
+        etags.append(row.etag);
+        titles.append(row.title);
+        mimeTypes.append(row.mimeType);
+        md5Checksums.append(row.md5Checksum);
+        parents.append(row.parent);
+        owners.append(row.owner);
+        otherParents.append(row.otherParents);
+        otherOwners.append(row.otherOwners);
+        fileSizes.append(row.fileSize);
+        createdDates.append(row.createdDate);
+        modifiedDates.append(row.modifiedDate);
+        flags.append(row.flags);
+        addToIndexes(r);
+        return r;
+    }
+
+    // The new values already hold their own references
+    removeFromIndexes(r);
+    releaseRow(r);
+    ids[r] = row.id;
+    etags[r] = row.etag;
+    titles[r] = row.title;
+    mimeTypes[r] = row.mimeType;
+    md5Checksums[r] = row.md5Checksum;
+    parents[r] = row.parent;
+    owners[r] = row.owner;
+    otherParents[r] = row.otherParents;
+    otherOwners[r] = row.otherOwners;
+    fileSizes[r] = row.fileSize;
+    createdDates[r] = row.createdDate;
+    modifiedDates[r] = row.modifiedDate;
+    flags[r] = row.flags;
+    addToIndexes(r);
+    return r;
+}
+
+bool FileTable::Private::removeRow(int row)
+{
+    if (row < 0 || row >= ids.size()) {
+        return false;
+    }
+
+    removeFromIndexes(row);
+    rows.remove(ids.at(row));
+    releaseRow(row);
+
+    const int last = ids.size() - 1;
+    if (row != last) {
+        removeFromIndexes(last);
+        ids[row] = ids.at(last);
+        etags[row] = etags.at(last);
+        titles[row] = titles.at(last);
+        mimeTypes[row] = mimeTypes.at(last);
+        md5Checksums[row] = md5Checksums.at(last);
+        parents[row] = parents.at(last);
+        owners[row] = owners.at(last);
+        otherParents[row] = otherParents.at(last);
+        otherOwners[row] = otherOwners.at(last);
+        fileSizes[row] = fileSizes.at(last);
+        createdDates[row] = createdDates.at(last);
+        modifiedDates[row] = modifiedDates.at(last);
+        flags[row] = flags.at(last);
+        rows.insert(ids.at(row), row);
+    }
+
+    ids.removeLast();
+    etags.removeLast();
+    titles.removeLast();
+    mimeTypes.removeLast();
+    md5Checksums.removeLast();
+    parents.removeLast();
+    owners.removeLast();
+    otherParents.removeLast();
+    otherOwners.removeLast();
+    fileSizes.removeLast();
+    createdDates.removeLast();
+    modifiedDates.removeLast();
+    flags.removeLast();
+
+    if (row != last) {
+        addToIndexes(row);
+    }
+    return true;
+}
+
+int FileTable::Private::insertFileObject(const QJsonObject &object)
+{
+    if (object.value(QStringLiteral("kind")).toString() != QLatin1String("drive#file")) {
+        return 0;
+    }
+
+    Row row;
+    row.id = intern(object.value(QStringLiteral("id")).toString());
+    if (row.id == NoString) {
+        return 0;
+    }
+    row.etag = intern(object.value(QStringLiteral("etag")).toString());
+    row.title = intern(object.value(QStringLiteral("title")).toString());
+    const QString mimeType = object.value(QStringLiteral("mimeType")).toString();
+    row.mimeType = intern(mimeType);
+    row.md5Checksum = intern(object.value(QStringLiteral("md5Checksum")).toString());
+
+    QStringList values;
+    const QJsonArray parentsArray = object.value(QStringLiteral("parents")).toArray();
+    for (const QJsonValue &parent : parentsArray) {
+        values.append(parent.toObject().value(QStringLiteral("id")).toString());
+    }
+    internValues(values, row.parent, row.otherParents);
+
+    // Owners are matched by name, permission ID and display name, see
+    // FileSearchQuery::matches()
+    values.clear();
+    const QJsonArray ownerNames = object.value(QStringLiteral("ownerNames")).toArray();
+    for (const QJsonValue &ownerName : ownerNames) {
+        values.append(ownerName.toString());
+    }
+    if (values.isEmpty()) {
+        values.append(QString());
+    }
+    const QJsonArray ownersArray = object.value(QStringLiteral("owners")).toArray();
+    for (const QJsonValue &owner : ownersArray) {
+        const QJsonObject user = owner.toObject();
+        values.append(user.value(QStringLiteral("permissionId")).toString());
+        values.append(user.value(QStringLiteral("displayName")).toString());
+    }
+    internValues(values, row.owner, row.otherOwners);
+
+    // fileSize is serialized as a string
+    const QJsonValue fileSize = object.value(QStringLiteral("fileSize"));
+    row.fileSize = fileSize.isString() ? fileSize.toString().toLongLong() : qint64(fileSize.toDouble(-1));
+    row.createdDate = dateToMSecs(Utils::rfc3339DateFromString(object.value(QStringLiteral("createdDate")).toString()));
+    row.modifiedDate = dateToMSecs(Utils::rfc3339DateFromString(object.value(QStringLiteral("modifiedDate")).toString()));
+
+    const QJsonObject labels = object.value(QStringLiteral("labels")).toObject();
+    quint16 f = 0;
+    f |= labels.value(QStringLiteral("starred")).toBool() ? Starred : 0;
+    f |= labels.value(QStringLiteral("hidden")).toBool() ? Hidden : 0;
+    f |= labels.value(QStringLiteral("trashed")).toBool() ? Trashed : 0;
+    f |= labels.value(QStringLiteral("restricted")).toBool() ? Restricted : 0;
+    f |= labels.value(QStringLiteral("viewed")).toBool() ? Viewed : 0;
+    f |= object.value(QStringLiteral("shared")).toBool() ? Shared : 0;
+    f |= object.value(QStringLiteral("editable")).toBool() ? Editable : 0;
+    f |= object.value(QStringLiteral("explicitlyTrashed")).toBool() ? ExplicitlyTrashed : 0;
+    f |= mimeType == File::folderMimeType() ? Folder : 0;
+    row.flags = f;
+
+    upsert(row);
+    return 1;
+}
+
+int FileTable::Private::insertChangeObject(const QJsonObject &object)
+{
+    if (object.value(QStringLiteral("kind")).toString() != QLatin1String("drive#change")) {
+        return 0;
+    }
+
+    if (object.value(QStringLiteral("deleted")).toBool()) {
+        const quint32 id = stringIndexes.value(object.value(QStringLiteral("fileId")).toString(), NoString);
+        return id != NoString && removeRow(rows.value(id, -1)) ? 1 : 0;
+    }
+
+    return insertFileObject(object.value(QStringLiteral("file")).toObject());
+}
+
+QVector<quint32> FileTable::Private::stringRanks(const QVector<quint32> &column, const QVector<int> &rows) const
+{
+    // Only the distinct strings of the sorted rows are compared, not the
+    // whole pool
+    QVector<quint32> order;
+    order.reserve(rows.size());
+    for (int row : rows) {
+        order.append(column.at(row));
+    }
+    std::sort(order.begin(), order.end());
+    order.erase(std::unique(order.begin(), order.end()), order.end());
+    std::sort(order.begin(), order.end(), [this](quint32 a, quint32 b) {
+        return strings.at(a).compare(strings.at(b), Qt::CaseInsensitive) < 0;
+    });
+
+    QVector<quint32> ranks(strings.size());
+    for (int i = 0; i < order.size(); ++i) {
+        ranks[order.at(i)] = quint32(i);
+    }
+    return ranks;
+}
+
+void FileTable::Private::invalidateIndexes()
+{
+    mimeTypeIndex.rows.clear();
+    mimeTypeIndex.valid = false;
+    parentIndex.rows.clear();
+    parentIndex.valid = false;
+    ownerIndex.rows.clear();
+    ownerIndex.valid = false;
+    sortedByModifiedDate.clear();
+    modifiedDateIndexValid = false;
+}
+
+void FileTable::Private::addToIndexes(int row)
+{
+    addToIndex(mimeTypeIndex, row);
+    addToIndex(parentIndex, row);
+    addToIndex(ownerIndex, row);
+
+    if (modifiedDateIndexValid && modifiedDates.at(row) != InvalidDate) {
+        const auto it = std::lower_bound(sortedByModifiedDate.begin(), sortedByModifiedDate.end(), row,
+                                         [this](int a, int b) { return modifiedDateLess(a, b); });
+        sortedByModifiedDate.insert(it, row);
+    }
+}
+
+void FileTable::Private::removeFromIndexes(int row)
+{
+    removeFromIndex(mimeTypeIndex, row);
+    removeFromIndex(parentIndex, row);
+    removeFromIndex(ownerIndex, row);
+
+    if (modifiedDateIndexValid && modifiedDates.at(row) != InvalidDate) {
+        const auto it = std::lower_bound(sortedByModifiedDate.begin(), sortedByModifiedDate.end(), row,
+                                         [this](int a, int b) { return modifiedDateLess(a, b); });
+        Q_ASSERT(it != sortedByModifiedDate.end() && *it == row);
+        sortedByModifiedDate.erase(it);
+    }
+}
+
+void FileTable::Private::addToIndex(StringIndex &index, int row)
+{
+    if (!index.valid) {
+        return;
+    }
+
+    const auto add = [&index, row](quint32 value) {
+        // Row lists are kept sorted, new rows are always the last ones
+        QVector<int> &rows = index.rows[value];
+        if (rows.isEmpty() || rows.last() < row) {
+            rows.append(row);
+        } else {
+            rows.insert(std::lower_bound(rows.begin(), rows.end(), row), row);
+        }
+    };
+    add(index.column->at(row));
+    if (index.others) {
+        for (quint32 value : index.others->at(row)) {
+            add(value);
+        }
+    }
+}
+
+void FileTable::Private::removeFromIndex(StringIndex &index, int row)
+{
+    if (!index.valid) {
+        return;
+    }
+
+    const auto remove = [&index, row](quint32 value) {
+        const auto it = index.rows.find(value);
+        if (it == index.rows.end()) {
+            return;
+        }
+        const auto pos = std::lower_bound(it->begin(), it->end(), row);
+        if (pos != it->end() && *pos == row) {
+            it->erase(pos);
+        }
+        if (it->isEmpty()) {
+            index.rows.erase(it);
+        }
+    };
+    remove(index.column->at(row));
+    if (index.others) {
+        for (quint32 value : index.others->at(row)) {
+            remove(value);
+        }
+    }
+}
+
+bool FileTable::Private::modifiedDateLess(int a, int b) const
+{
+    const qint64 dateA = modifiedDates.at(a);
+    const qint64 dateB = modifiedDates.at(b);
+    return dateA < dateB || (dateA == dateB && a < b);
+}
+
+const FileTable::Private::StringIndex &FileTable::Private::stringIndex(StringIndex &index) const
+{
+    if (!index.valid) {
+        index.rows.clear();
+        index.valid = true;
+        const int count = index.column->size();
+        for (int i = 0; i < count; ++i) {
+            addToIndex(index, i);
+        }
+    }
+    return index;
+}
+
+const QVector<int> &FileTable::Private::modifiedDateIndex() const
+{
+    if (!modifiedDateIndexValid) {
+        sortedByModifiedDate.clear();
+        sortedByModifiedDate.reserve(modifiedDates.size());
+        for (int i = 0; i < modifiedDates.size(); ++i) {
+            if (modifiedDates.at(i) != InvalidDate) {
+                sortedByModifiedDate.append(i);
+            }
+        }
+        std::sort(sortedByModifiedDate.begin(), sortedByModifiedDate.end(),
+                  [this](int a, int b) { return modifiedDateLess(a, b); });
+        modifiedDateIndexValid = true;
+    }
+    return sortedByModifiedDate;
+}
+
+QVector<int> FileTable::Private::allRows() const
+{
+    QVector<int> result(ids.size());
+    for (int i = 0; i < result.size(); ++i) {
+        result[i] = i;
+    }
+    return result;
+}
+
+bool FileTable::Private::isIndexed(const FileSearchQuery &query)
+{
+    switch (query.field()) {
+    case FileSearchQuery::MimeType:
+        return query.compareOperator() == FileSearchQuery::Equals;
+    case FileSearchQuery::Parents:
+    case FileSearchQuery::Owners:
+        return true;
+    case FileSearchQuery::ModifiedDate:
+        return query.compareOperator() != FileSearchQuery::NotEquals;
+    default:
+        return false;
+    }
+}
+
+QVector<int> FileTable::Private::lookup(const FileSearchQuery &query) const
+{
+    const FileSearchQuery::CompareOperator op = query.compareOperator();
+
+    switch (query.field()) {
+    case FileSearchQuery::MimeType:
+    case FileSearchQuery::Parents:
+    case FileSearchQuery::Owners: {
+        if (!isIndexed(query)) {
+            break;
+        }
+        const QString value = query.value().toString();
+        const quint32 string = stringIndexes.value(value, NoString);
+        if (string == NoString && (!value.isEmpty() || query.field() != FileSearchQuery::MimeType)) {
+            // Files without parents or owners don't match an empty ID either
+            return QVector<int>();
+        }
+        const StringIndex &index = query.field() == FileSearchQuery::MimeType ? stringIndex(mimeTypeIndex)
+                                 : query.field() == FileSearchQuery::Parents ? stringIndex(parentIndex)
+                                 : stringIndex(ownerIndex);
+        return index.rows.value(string);
+    }
+    case FileSearchQuery::ModifiedDate: {
+        const QDateTime dt = query.value().toDateTime();
+        if (!isIndexed(query) || !dt.isValid()) {
+            break;
+        }
+        const qint64 value = dt.toMSecsSinceEpoch();
+        const QVector<int> &sorted = modifiedDateIndex();
+        const qint64 *dates = modifiedDates.constData();
+        const auto lower = std::lower_bound(sorted.constBegin(), sorted.constEnd(), value,
+                                            [dates](int row, qint64 v) { return dates[row] < v; });
+        const auto upper = std::upper_bound(lower, sorted.constEnd(), value,
+                                            [dates](qint64 v, int row) { return v < dates[row]; });
+        QVector<int>::const_iterator from = sorted.constBegin();
+        QVector<int>::const_iterator to = sorted.constEnd();
+        switch (op) {
+        case FileSearchQuery::Equals:
+            from = lower;
+            to = upper;
+            break;
+        case FileSearchQuery::Less:
+            to = lower;
+            break;
+        case FileSearchQuery::LessOrEqual:
+            to = upper;
+            break;
+        case FileSearchQuery::Greater:
+            from = upper;
+            break;
+        case FileSearchQuery::GreaterOrEqual:
+            from = lower;
+            break;
+        default:
+            return QVector<int>();
+        }
+        QVector<int> result;
+        result.reserve(int(to - from));
+        std::copy(from, to, std::back_inserter(result));
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+    default:
+        break;
+    }
+
+    if (query.field() == FileSearchQuery::Title || query.field() == FileSearchQuery::MimeType) {
+        // Every distinct string is compared only once
+        const QVector<quint32> &column = query.field() == FileSearchQuery::Title ? titles : mimeTypes;
+        const QString value = query.value().toString();
+        QVector<qint8> matching(strings.size(), -1);
+        return select([&](int i) {
+            qint8 &m = matching[column.at(i)];
+            if (m < 0) {
+                m = SearchComparison::compare(op, strings.at(column.at(i)), value) ? 1 : 0;
+            }
+            return m == 1;
+        });
+    }
+
+    return select([this, &query](int i) { return matchesRow(query, i); });
+}
+
+bool FileTable::Private::matchesRow(const FileSearchQuery &query, int row) const
+{
+    if (!query.isComparison()) {
+        const QList<FileSearchQuery> subqueries = query.subqueries();
+        if (subqueries.isEmpty()) {
+            return true;
+        }
+        const bool any = (query.logicOperator() == FileSearchQuery::Or);
+        for (const FileSearchQuery &subquery : subqueries) {
+            if (matchesRow(subquery, row) == any) {
+                return any;
+            }
+        }
+        return !any;
+    }
+
+    const FileSearchQuery::CompareOperator op = query.compareOperator();
+    switch (query.field()) {
+    case FileSearchQuery::Title:
+        return SearchComparison::compare(op, strings.at(titles.at(row)), query.value().toString());
+    case FileSearchQuery::MimeType:
+        return SearchComparison::compare(op, strings.at(mimeTypes.at(row)), query.value().toString());
+    case FileSearchQuery::ModifiedDate: {
+        const QDateTime dt = query.value().toDateTime();
+        return modifiedDates.at(row) != InvalidDate && dt.isValid()
+                && SearchComparison::compare(op, modifiedDates.at(row), dt.toMSecsSinceEpoch());
+    }
+    case FileSearchQuery::Trashed:
+        return SearchComparison::compare(op, bool(flags.at(row) & FileTable::Trashed), query.value().toBool());
+    case FileSearchQuery::Starred:
+        return SearchComparison::compare(op, bool(flags.at(row) & FileTable::Starred), query.value().toBool());
+    case FileSearchQuery::Parents:
+    case FileSearchQuery::Owners: {
+        const quint32 string = stringIndexes.value(query.value().toString(), NoString);
+        if (string == NoString) {
+            return false;
+        }
+        return query.field() == FileSearchQuery::Parents
+                ? parents.at(row) == string || otherParents.at(row).contains(string)
+                : owners.at(row) == string || otherOwners.at(row).contains(string);
+    }
+    default:
+        // Not stored in the table
+        return false;
+    }
+}
+
+QVector<int> FileTable::Private::evaluate(const FileSearchQuery &query) const
+{
+    if (query.isEmpty()) {
+        return allRows();
+    }
+    if (query.isComparison()) {
+        return lookup(query);
+    }
+
+    const QList<FileSearchQuery> subqueries = query.subqueries();
+    QVector<int> result;
+
+    if (query.logicOperator() == FileSearchQuery::Or) {
+        for (const FileSearchQuery &subquery : subqueries) {
+            const QVector<int> rows = evaluate(subquery);
+            QVector<int> merged;
+            merged.reserve(result.size() + rows.size());
+            std::set_union(result.constBegin(), result.constEnd(), rows.constBegin(), rows.constEnd(),
+                           std::back_inserter(merged));
+            result = merged;
+        }
+        return result;
+    }
+
+    // Narrow down the rows using the indexes first, then check only those
+    QList<FileSearchQuery> remaining;
+    bool hasCandidates = false;
+    for (const FileSearchQuery &subquery : subqueries) {
+        if (subquery.isComparison() && isIndexed(subquery)) {
+            result = hasCandidates ? FileTable::intersect(result, lookup(subquery)) : lookup(subquery);
+            hasCandidates = true;
+        } else {
+            remaining.append(subquery);
+        }
+    }
+    if (!hasCandidates) {
+        result = evaluate(remaining.takeFirst());
+    }
+
+    for (const FileSearchQuery &subquery : qAsConst(remaining)) {
+        if (result.isEmpty()) {
+            break;
+        }
+        QVector<int> filtered;
+        filtered.reserve(result.size());
+        for (int row : qAsConst(result)) {
+            if (matchesRow(subquery, row)) {
+                filtered.append(row);
+            }
+        }
+        result = filtered;
+    }
+
+    return result;
+}
+
+FileTable::FileTable():
+    d(new Private)
+{
+    clear();
+}
+
+FileTable::~FileTable()
+{
+    delete d;
+}
+
+int FileTable::rowCount() const
+{
+    return d->ids.size();
+}
+
+void FileTable::reserve(int rows)
+{
+    d->ids.reserve(rows);
+    d->etags.reserve(rows);
+    d->titles.reserve(rows);
+    d->mimeTypes.reserve(rows);
+    d->md5Checksums.reserve(rows);
+    d->parents.reserve(rows);
+    d->owners.reserve(rows);
+    d->otherParents.reserve(rows);
+    d->otherOwners.reserve(rows);
+    d->fileSizes.reserve(rows);
+    d->createdDates.reserve(rows);
+    d->modifiedDates.reserve(rows);
+    d->flags.reserve(rows);
+    d->rows.reserve(rows);
+}
+
+void FileTable::clear()
+{
+    d->strings.clear();
+    d->stringRefs.clear();
+    d->freeStrings.clear();
+    d->stringIndexes.clear();
+    d->strings.append(QString()); // NoString
+    d->stringRefs.append(0);
+
+    d->ids.clear();
+    d->etags.clear();
+    d->titles.clear();
+    d->mimeTypes.clear();
+    d->md5Checksums.clear();
+    d->parents.clear();
+    d->owners.clear();
+    d->otherParents.clear();
+    d->otherOwners.clear();
+    d->fileSizes.clear();
+    d->createdDates.clear();
+    d->modifiedDates.clear();
+    d->flags.clear();
+    d->rows.clear();
+    d->invalidateIndexes();
+}
+
+int FileTable::row(const QString &fileId) const
+{
+    const quint32 id = stringIndex(fileId);
+    return id == NoString ? -1 : d->rows.value(id, -1);
+}
+
+int FileTable::insert(const FilePtr &file)
+{
+    Row row;
+    row.id = d->intern(file->id());
+    row.etag = d->intern(file->etag());
+    row.title = d->intern(file->title());
+    row.mimeType = d->intern(file->mimeType());
+    row.md5Checksum = d->intern(file->md5Checksum());
+
+    QStringList values;
+    const ParentReferencesList parents = file->parents();
+    for (const ParentReferencePtr &parent : parents) {
+        values.append(parent->id());
+    }
+    d->internValues(values, row.parent, row.otherParents);
+
+    values = file->ownerNames();
+    if (values.isEmpty()) {
+        values.append(QString());
+    }
+    const UsersList owners = file->owners();
+    for (const UserPtr &owner : owners) {
+        values.append(owner->permissionId());
+        values.append(owner->displayName());
+    }
+    d->internValues(values, row.owner, row.otherOwners);
+
+    row.fileSize = file->fileSize();
+    row.createdDate = dateToMSecs(file->createdDate());
+    row.modifiedDate = dateToMSecs(file->modifiedDate());
+
+    quint16 f = 0;
+    if (const File::LabelsPtr labels = file->labels()) {
+        f |= labels->starred() ? Starred : 0;
+        // Deprecated, but insertJSON() stores it too and toJSON() writes it back
+        f |= labels->hidden() ? Hidden : 0;
+        f |= labels->trashed() ? Trashed : 0;
+        f |= labels->restricted() ? Restricted : 0;
+        f |= labels->viewed() ? Viewed : 0;
+    }
+    f |= file->shared() ? Shared : 0;
+    f |= file->editable() ? Editable : 0;
+    f |= file->explicitlyTrashed() ? ExplicitlyTrashed : 0;
+    f |= file->isFolder() ? Folder : 0;
+    row.flags = f;
+
+    return d->upsert(row);
+}
+
+bool FileTable::remove(const QString &fileId)
+{
+    return d->removeRow(row(fileId));
+}
+
+int FileTable::insertJSON(const QByteArray &jsonData, FeedData &feedData)
+{
+    const QJsonDocument document = QJsonDocument::fromJson(jsonData);
+    if (!document.isObject()) {
+        return -1;
+    }
+
+    const QJsonObject object = document.object();
+    const QString kind = object.value(QStringLiteral("kind")).toString();
+    if (kind == QLatin1String("drive#file")) {
+        return d->insertFileObject(object);
+    } else if (kind == QLatin1String("drive#change")) {
+        return d->insertChangeObject(object);
+    }
+
+    const bool isFileList = (kind == QLatin1String("drive#fileList"));
+    if (!isFileList && kind != QLatin1String("drive#changeList")) {
+        return -1;
+    }
+
+    int affected = 0;
+    const QJsonArray items = object.value(QStringLiteral("items")).toArray();
+    reserve(rowCount() + items.size());
+    for (const QJsonValue &item : items) {
+        affected += isFileList ? d->insertFileObject(item.toObject())
+                               : d->insertChangeObject(item.toObject());
+    }
+
+    if (object.contains(QStringLiteral("nextLink"))) {
+        feedData.nextPageUrl = QUrl(object.value(QStringLiteral("nextLink")).toString());
+    }
+
+    return affected;
+}
+
+FilePtr FileTable::file(int row) const
+{
+    if (row < 0 || row >= rowCount()) {
+        return FilePtr();
+    }
+
+    QVariantMap map;
+    map[QStringLiteral("kind")] = QStringLiteral("drive#file");
+    map[QStringLiteral("id")] = id(row);
+    map[QStringLiteral("etag")] = etag(row);
+    map[QStringLiteral("title")] = title(row);
+    map[QStringLiteral("mimeType")] = mimeType(row);
+    map[QStringLiteral("md5Checksum")] = md5Checksum(row);
+    map[QStringLiteral("fileSize")] = fileSize(row);
+    map[QStringLiteral("createdDate")] = Utils::rfc3339DateToString(createdDate(row));
+    map[QStringLiteral("modifiedDate")] = Utils::rfc3339DateToString(modifiedDate(row));
+
+    const Flags f = flags(row);
+    QVariantMap labels;
+    labels[QStringLiteral("starred")] = bool(f & Starred);
+    labels[QStringLiteral("hidden")] = bool(f & Hidden);
+    labels[QStringLiteral("trashed")] = bool(f & Trashed);
+    labels[QStringLiteral("restricted")] = bool(f & Restricted);
+    labels[QStringLiteral("viewed")] = bool(f & Viewed);
+    map[QStringLiteral("labels")] = labels;
+    map[QStringLiteral("shared")] = bool(f & Shared);
+    map[QStringLiteral("editable")] = bool(f & Editable);
+    map[QStringLiteral("explicitlyTrashed")] = bool(f & ExplicitlyTrashed);
+
+    if (d->parents.at(row) != NoString) {
+        QVariantList parents;
+        QVector<quint32> ids = d->otherParents.at(row);
+        ids.prepend(d->parents.at(row));
+        for (quint32 id : qAsConst(ids)) {
+            QVariantMap parent;
+            parent[QStringLiteral("kind")] = QStringLiteral("drive#parentReference");
+            parent[QStringLiteral("id")] = d->strings.at(id);
+            parents << parent;
+        }
+        map[QStringLiteral("parents")] = parents;
+    }
+    if (d->owners.at(row) != NoString) {
+        map[QStringLiteral("ownerNames")] = QStringList() << ownerName(row);
+    }
+
+    return File::fromJSON(map);
+}
+
+QString FileTable::id(int row) const
+{
+    return d->strings.at(d->ids.at(row));
+}
+
+QString FileTable::etag(int row) const
+{
+    return d->strings.at(d->etags.at(row));
+}
+
+QString FileTable::title(int row) const
+{
+    return d->strings.at(d->titles.at(row));
+}
+
+QString FileTable::mimeType(int row) const
+{
+    return d->strings.at(d->mimeTypes.at(row));
+}
+
+QString FileTable::md5Checksum(int row) const
+{
+    return d->strings.at(d->md5Checksums.at(row));
+}
+
+QString FileTable::parentId(int row) const
+{
+    return d->strings.at(d->parents.at(row));
+}
+
+QString FileTable::ownerName(int row) const
+{
+    return d->strings.at(d->owners.at(row));
+}
+
+qint64 FileTable::fileSize(int row) const
+{
+    return d->fileSizes.at(row);
+}
+
+QDateTime FileTable::createdDate(int row) const
+{
+    return msecsToDate(d->createdDates.at(row));
+}
+
+QDateTime FileTable::modifiedDate(int row) const
+{
+    return msecsToDate(d->modifiedDates.at(row));
+}
+
+FileTable::Flags FileTable::flags(int row) const
+{
+    return Flags(d->flags.at(row));
+}
+
+quint32 FileTable::stringIndex(const QString &string) const
+{
+    return d->stringIndexes.value(string, NoString);
+}
+
+QString FileTable::string(quint32 index) const
+{
+    return d->strings.value(int(index));
+}
+
+const quint32 *FileTable::titleColumn() const
+{
+    return d->titles.constData();
+}
+
+const quint32 *FileTable::mimeTypeColumn() const
+{
+    return d->mimeTypes.constData();
+}
+
+const quint32 *FileTable::parentColumn() const
+{
+    return d->parents.constData();
+}
+
+const qint64 *FileTable::fileSizeColumn() const
+{
+    return d->fileSizes.constData();
+}
+
+const qint64 *FileTable::createdDateColumn() const
+{
+    return d->createdDates.constData();
+}
+
+const qint64 *FileTable::modifiedDateColumn() const
+{
+    return d->modifiedDates.constData();
+}
+
+const quint16 *FileTable::flagsColumn() const
+{
+    return d->flags.constData();
+}
+
+QVector<int> FileTable::selectByFlags(Flags required, Flags excluded) const
+{
+    const quint16 mask = quint16(required | excluded);
+    const quint16 value = quint16(required);
+    const quint16 *column = d->flags.constData();
+    return d->select([column, mask, value](int i) { return (column[i] & mask) == value; });
+}
+
+QVector<int> FileTable::selectByMimeType(const QString &mimeType) const
+{
+    const quint32 index = stringIndex(mimeType);
+    if (index == NoString && !mimeType.isEmpty()) {
+        return QVector<int>();
+    }
+
+    const quint32 *column = d->mimeTypes.constData();
+    return d->select([column, index](int i) { return column[i] == index; });
+}
+
+QVector<int> FileTable::selectByParent(const QString &parentId) const
+{
+    const quint32 index = stringIndex(parentId);
+    if (index == NoString && !parentId.isEmpty()) {
+        return QVector<int>();
+    }
+
+    const quint32 *column = d->parents.constData();
+    const QVector<quint32> *others = d->otherParents.constData();
+    return d->select([column, others, index](int i) {
+        return column[i] == index || (index != NoString && others[i].contains(index));
+    });
+}
+
+QVector<int> FileTable::selectBySize(qint64 minSize, qint64 maxSize) const
+{
+    const qint64 *column = d->fileSizes.constData();
+    return d->select([column, minSize, maxSize](int i) { return column[i] >= minSize && column[i] <= maxSize; });
+}
+
+QVector<int> FileTable::selectModifiedBetween(const QDateTime &from, const QDateTime &to) const
+{
+    const qint64 min = from.isValid() ? from.toMSecsSinceEpoch() : InvalidDate + 1;
+    const qint64 max = to.isValid() ? to.toMSecsSinceEpoch() : std::numeric_limits<qint64>::max();
+    const qint64 *column = d->modifiedDates.constData();
+    return d->select([column, min, max](int i) { return column[i] >= min && column[i] <= max; });
+}
+
+QVector<int> FileTable::select(const FileSearchQuery &query) const
+{
+    return d->evaluate(query);
+}
+
+bool FileTable::canSelect(const FileSearchQuery &query)
+{
+    if (query.isComparison()) {
+        switch (query.field()) {
+        case FileSearchQuery::Title:
+        case FileSearchQuery::MimeType:
+        case FileSearchQuery::ModifiedDate:
+        case FileSearchQuery::Trashed:
+        case FileSearchQuery::Starred:
+        case FileSearchQuery::Parents:
+        case FileSearchQuery::Owners:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    const QList<FileSearchQuery> subqueries = query.subqueries();
+    for (const FileSearchQuery &subquery : subqueries) {
+        if (!canSelect(subquery)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QVector<int> FileTable::intersect(const QVector<int> &a, const QVector<int> &b)
+{
+    QVector<int> result;
+    result.reserve(qMin(a.size(), b.size()));
+    std::set_intersection(a.constBegin(), a.constEnd(), b.constBegin(), b.constEnd(),
+                          std::back_inserter(result));
+    return result;
+}
+
+QVector<int> FileTable::sorted(Column column, Qt::SortOrder order) const
+{
+    QVector<int> rows(rowCount());
+    for (int i = 0; i < rows.size(); ++i) {
+        rows[i] = i;
+    }
+    sort(rows, column, order);
+    return rows;
+}
+
+void FileTable::sort(QVector<int> &rows, Column column, Qt::SortOrder order) const
+{
+    // Strings are replaced by their rank among the strings of the rows, so
+    // every column is sorted as a plain integer key
+    QVector<qint64> keys;
+    switch (column) {
+    case IdColumn:
+    case TitleColumn:
+    case MimeTypeColumn: {
+        const QVector<quint32> &strings = column == IdColumn ? d->ids
+                                        : column == TitleColumn ? d->titles
+                                        : d->mimeTypes;
+        const QVector<quint32> ranks = d->stringRanks(strings, rows);
+        keys.resize(rowCount());
+        for (int row : qAsConst(rows)) {
+            keys[row] = ranks.at(strings.at(row));
+        }
+        break;
+    }
+    case FileSizeColumn:
+        keys = d->fileSizes;
+        break;
+    case CreatedDateColumn:
+        keys = d->createdDates;
+        break;
+    case ModifiedDateColumn:
+        keys = d->modifiedDates;
+        break;
+    }
+
+    const qint64 *k = keys.constData();
+    if (order == Qt::AscendingOrder) {
+        std::stable_sort(rows.begin(), rows.end(), [k](int a, int b) { return k[a] < k[b]; });
+    } else {
+        std::stable_sort(rows.begin(), rows.end(), [k](int a, int b) { return k[a] > k[b]; });
+    }
+}
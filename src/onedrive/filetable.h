@@ -0,0 +1,244 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef KMGRAPH2_ONEDRIVEFILETABLE_H
+#define KMGRAPH2_ONEDRIVEFILETABLE_H
+
+#include "types.h"
+#include "kmgraphonedrive_export.h"
+
+#include <QDateTime>
+#include <QString>
+#include <QVector>
+
+namespace KMGraph2
+{
+
+namespace OneDrive
+{
+
+class FileSearchQuery;
+
+/**
+ * @brief Compact columnar storage for very large file listings.
+ *
+ * Holding hundreds of thousands of File objects is expensive, every one of
+ * them is a separate heap object with dozens of members. FileTable instead
+ * stores only the most commonly used properties, one array per property:
+ *
+ * - strings (ID, etag, title, MIME type, MD5 checksum, parents and owners)
+ *   are interned into a shared pool and stored as 32-bit indexes, the columns
+ *   hold the first parent and the first owner name, the others are kept
+ *   aside,
+ * - dates are stored as milliseconds since epoch (UTC),
+ * - sizes as 64-bit integers,
+ * - labels and boolean properties as bits of a single 16-bit word.
+ *
+ * FileFetchJob and ChangeFetchJob can fill a FileTable directly from the
+ * received JSON, without creating File objects (see FileFetchJob::setFileTable()
+ * and ChangeFetchJob::setFileTable()).
+ *
+ * The select*() methods return row numbers matching given criteria and are
+ * implemented as simple loops over a single column. select() evaluates
+ * a whole FileSearchQuery with help of indexes. The row numbers are only
+ * valid until the table is modified.
+ */
+class KMGRAPHONEDRIVE_EXPORT FileTable
+{
+  public:
+    enum Flag {
+        Starred           = 1 << 0,
+        Hidden            = 1 << 1,
+        Trashed           = 1 << 2,
+        Restricted        = 1 << 3,
+        Viewed            = 1 << 4,
+        Shared            = 1 << 5,
+        Editable          = 1 << 6,
+        ExplicitlyTrashed = 1 << 7,
+        Folder            = 1 << 8
+    };
+    Q_DECLARE_FLAGS(Flags, Flag)
+
+    enum Column {
+        IdColumn,
+        TitleColumn,
+        MimeTypeColumn,
+        FileSizeColumn,
+        CreatedDateColumn,
+        ModifiedDateColumn
+    };
+
+    /**
+     * Index of the empty string in the string pool.
+     */
+    static const quint32 NoString = 0;
+
+    /**
+     * Stored instead of dates that are missing or invalid.
+     */
+    static const qint64 InvalidDate;
+
+    explicit FileTable();
+    virtual ~FileTable();
+
+    int rowCount() const;
+    void reserve(int rows);
+    void clear();
+
+    /**
+     * @brief Returns row of file @p fileId, or -1.
+     */
+    int row(const QString &fileId) const;
+
+    /**
+     * @brief Inserts @p file, or updates the row when the file is already
+     *        present. Returns the row.
+     *
+     * Stores the same values as insertJSON() would for the file's JSON,
+     * including the Hidden flag of the deprecated 'hidden' label.
+     */
+    int insert(const FilePtr &file);
+
+    /**
+     * @brief Removes file @p fileId. The last row is moved into its place.
+     */
+    bool remove(const QString &fileId);
+
+    /**
+     * @brief Inserts, updates or removes files based on a JSON reply.
+     *
+     * Accepts a single file, a file list, a single change and a change list.
+     * Deleted changes remove the file from the table. When the reply is a
+     * feed, URL of next page is stored in @p feedData.
+     *
+     * Returns number of affected rows, or -1 when @p jsonData are invalid.
+     */
+    int insertJSON(const QByteArray &jsonData, FeedData &feedData);
+
+    /**
+     * @brief Creates a File for given @p row.
+     *
+     * The File only has the properties stored in the table, of the owners
+     * only the first owner name.
+     */
+    FilePtr file(int row) const;
+
+    QString id(int row) const;
+    QString etag(int row) const;
+    QString title(int row) const;
+    QString mimeType(int row) const;
+    QString md5Checksum(int row) const;
+    QString parentId(int row) const;
+    QString ownerName(int row) const;
+    qint64 fileSize(int row) const;
+    QDateTime createdDate(int row) const;
+    QDateTime modifiedDate(int row) const;
+    Flags flags(int row) const;
+
+    /**
+     * @brief Returns index of @p string in the string pool, or NoString.
+     *
+     * Strings no longer used by any row are dropped from the pool and their
+     * indexes are reused, so indexes are only valid until the table is
+     * modified.
+     */
+    quint32 stringIndex(const QString &string) const;
+
+    /**
+     * @brief Returns string at @p index in the string pool.
+     */
+    QString string(quint32 index) const;
+
+    /**
+     * @brief Raw columns, @p rowCount() items each.
+     */
+    const quint32 *titleColumn() const;
+    const quint32 *mimeTypeColumn() const;
+    const quint32 *parentColumn() const;
+    const qint64 *fileSizeColumn() const;
+    const qint64 *createdDateColumn() const;
+    const qint64 *modifiedDateColumn() const;
+    const quint16 *flagsColumn() const;
+
+    /**
+     * @brief Returns rows that have all @p required flags and none of
+     *        the @p excluded ones.
+     */
+    QVector<int> selectByFlags(Flags required, Flags excluded = Flags()) const;
+    QVector<int> selectByMimeType(const QString &mimeType) const;
+    QVector<int> selectByParent(const QString &parentId) const;
+    QVector<int> selectBySize(qint64 minSize, qint64 maxSize) const;
+    QVector<int> selectModifiedBetween(const QDateTime &from, const QDateTime &to) const;
+
+    /**
+     * @brief Returns rows of files matching @p query, in ascending order.
+     *
+     * Equality of MIME type, parent and owner and comparisons of the
+     * modification date are answered from indexes, which are built on first
+     * use and then updated together with the rows. Within an "and" group,
+     * the other comparisons only check the rows found through the indexes.
+     *
+     * Like FileSearchQuery::matches(), parents match any parent of a file
+     * and owners match owner names, permission IDs and display names.
+     * Comparisons of fields the table does not store never match, see
+     * canSelect().
+     */
+    QVector<int> select(const FileSearchQuery &query) const;
+
+    /**
+     * @brief Returns whether select() can evaluate @p query.
+     *
+     * When it can't, the query has to be sent to the server instead.
+     */
+    static bool canSelect(const FileSearchQuery &query);
+
+    /**
+     * @brief Returns rows present in both sorted row lists.
+     */
+    static QVector<int> intersect(const QVector<int> &a, const QVector<int> &b);
+
+    /**
+     * @brief Returns all rows, sorted by @p column.
+     *
+     * Strings are compared case-insensitively.
+     */
+    QVector<int> sorted(Column column, Qt::SortOrder order = Qt::AscendingOrder) const;
+
+    /**
+     * @brief Sorts @p rows by @p column.
+     */
+    void sort(QVector<int> &rows, Column column, Qt::SortOrder order = Qt::AscendingOrder) const;
+
+  private:
+    Q_DISABLE_COPY(FileTable)
+
+    class Private;
+    Private *const d;
+    friend class Private;
+};
+
+} // namespace OneDrive
+
+} // namespace KMGraph2
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(KMGraph2::OneDrive::FileTable::Flags)
+
+#endif // KMGRAPH2_ONEDRIVEFILETABLE_H
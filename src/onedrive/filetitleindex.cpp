@@ -0,0 +1,318 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "filetitleindex.h"
+#include "change.h"
+#include "file.h"
+
+#include <QHash>
+#include <QVector>
+
+#include <algorithm>
+
+using namespace KMGraph2;
+using namespace KMGraph2::OneDrive;
+
+// Removed documents are only dropped from the posting lists, the document
+// table is compacted once it consists mostly of removed documents
+static const int MinCompactedDocuments = 1024;
+
+namespace {
+
+typedef quint64 Trigram;
+
+// Characters that separate words are indexed as spaces and a space is put
+// in front of the title, so that prefixes of words have trigrams of their own
+QString normalized(const QString &folded, bool wordPrefix)
+{
+    const int offset = wordPrefix ? 1 : 0;
+    QString result(folded.size() + offset, QLatin1Char(' '));
+    QChar *out = result.data() + offset;
+    for (int i = 0; i < folded.size(); ++i) {
+        const QChar c = folded.at(i);
+        out[i] = c.isLetterOrNumber() ? c : QLatin1Char(' ');
+    }
+    return result;
+}
+
+QVector<Trigram> trigrams(const QString &text)
+{
+    QVector<Trigram> result;
+    const ushort *s = text.utf16();
+    const int count = text.size() - 2;
+    if (count <= 0) {
+        return result;
+    }
+
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        result.append(Trigram(s[i]) << 32 | Trigram(s[i + 1]) << 16 | Trigram(s[i + 2]));
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+}
+
+class Q_DECL_HIDDEN FileTitleIndex::Private
+{
+  public:
+    struct Document
+    {
+        QString fileId;
+        QString title; // case-folded
+        bool removed;
+    };
+
+    Private();
+
+    void addDocument(const QString &fileId, const QString &title);
+    void removeDocument(int document);
+    void compact();
+    static bool verify(const QString &title, const QString &text, MatchMode mode);
+
+    QVector<Document> documents;
+    QHash<QString /* file ID */, int /* document */> documentIds;
+    QHash<Trigram, QVector<int> /* sorted documents */> postings;
+    int removedCount;
+    bool complete;
+};
+
+FileTitleIndex::Private::Private():
+    removedCount(0),
+    complete(false)
+{
+}
+
+void FileTitleIndex::Private::addDocument(const QString &fileId, const QString &title)
+{
+    // Documents are numbered in ascending order, so appending keeps
+    // the posting lists sorted
+    const int document = documents.size();
+    documents.append({ fileId, title, false });
+    documentIds.insert(fileId, document);
+
+    const QVector<Trigram> grams = trigrams(normalized(title, true));
+    for (Trigram gram : grams) {
+        postings[gram].append(document);
+    }
+}
+
+void FileTitleIndex::Private::removeDocument(int document)
+{
+    Document &doc = documents[document];
+    const QVector<Trigram> grams = trigrams(normalized(doc.title, true));
+    for (Trigram gram : grams) {
+        auto it = postings.find(gram);
+        if (it == postings.end()) {
+            continue;
+        }
+        QVector<int> &list = *it;
+        const auto pos = std::lower_bound(list.begin(), list.end(), document);
+        if (pos != list.end() && *pos == document) {
+            list.erase(pos);
+        }
+        if (list.isEmpty()) {
+            postings.erase(it);
+        }
+    }
+
+    documentIds.remove(doc.fileId);
+    doc.fileId.clear();
+    doc.title.clear();
+    doc.removed = true;
+    ++removedCount;
+
+    if (removedCount > MinCompactedDocuments && removedCount > documents.size() / 2) {
+        compact();
+    }
+}
+
+void FileTitleIndex::Private::compact()
+{
+    const QVector<Document> old = documents;
+    documents.clear();
+    documents.reserve(old.size() - removedCount);
+    documentIds.clear();
+    postings.clear();
+    removedCount = 0;
+
+    for (const Document &doc : old) {
+        if (!doc.removed) {
+            addDocument(doc.fileId, doc.title);
+        }
+    }
+}
+
+bool FileTitleIndex::Private::verify(const QString &title, const QString &text, MatchMode mode)
+{
+    if (mode == Contains) {
+        return title.contains(text);
+    }
+
+    int pos = 0;
+    while ((pos = title.indexOf(text, pos)) >= 0) {
+        if (pos == 0 || !title.at(pos - 1).isLetterOrNumber()) {
+            return true;
+        }
+        ++pos;
+    }
+    return false;
+}
+
+FileTitleIndex::FileTitleIndex():
+    d(new Private)
+{
+}
+
+FileTitleIndex::~FileTitleIndex()
+{
+    delete d;
+}
+
+int FileTitleIndex::count() const
+{
+    return d->documentIds.size();
+}
+
+void FileTitleIndex::clear()
+{
+    d->documents.clear();
+    d->documentIds.clear();
+    d->postings.clear();
+    d->removedCount = 0;
+    d->complete = false;
+}
+
+void FileTitleIndex::insert(const QString &fileId, const QString &title)
+{
+    if (fileId.isEmpty()) {
+        return;
+    }
+
+    const QString folded = title.toCaseFolded();
+    const auto it = d->documentIds.constFind(fileId);
+    if (it != d->documentIds.constEnd()) {
+        if (d->documents.at(*it).title == folded) {
+            return;
+        }
+        d->removeDocument(*it);
+    }
+
+    d->addDocument(fileId, folded);
+}
+
+void FileTitleIndex::insert(const FilePtr &file)
+{
+    insert(file->id(), file->title());
+}
+
+bool FileTitleIndex::remove(const QString &fileId)
+{
+    const auto it = d->documentIds.constFind(fileId);
+    if (it == d->documentIds.constEnd()) {
+        return false;
+    }
+
+    d->removeDocument(*it);
+    return true;
+}
+
+void FileTitleIndex::applyChanges(const ChangesList &changes)
+{
+    for (const ChangePtr &change : changes) {
+        if (change->deleted()) {
+            remove(change->fileId());
+        } else if (const FilePtr file = change->file()) {
+            insert(file);
+        }
+    }
+}
+
+bool FileTitleIndex::contains(const QString &fileId) const
+{
+    return d->documentIds.contains(fileId);
+}
+
+bool FileTitleIndex::isComplete() const
+{
+    return d->complete;
+}
+
+void FileTitleIndex::setComplete(bool complete)
+{
+    d->complete = complete;
+}
+
+QStringList FileTitleIndex::search(const QString &text, MatchMode mode, int limit) const
+{
+    QStringList result;
+    if (text.isEmpty() || limit == 0) {
+        return result;
+    }
+
+    const QString folded = text.toCaseFolded();
+    // Returns false once enough results have been found
+    const auto accept = [&](int document) {
+        const Private::Document &doc = d->documents.at(document);
+        if (!doc.removed && Private::verify(doc.title, folded, mode)) {
+            result.append(doc.fileId);
+        }
+        return limit < 0 || result.size() < limit;
+    };
+
+    const QVector<Trigram> grams = trigrams(normalized(folded, mode == WordPrefix));
+    if (grams.isEmpty()) {
+        // Too short to be looked up in the index
+        for (int document = 0; document < d->documents.size(); ++document) {
+            if (!accept(document)) {
+                break;
+            }
+        }
+        return result;
+    }
+
+    QVector<const QVector<int> *> lists;
+    lists.reserve(grams.size());
+    for (Trigram gram : grams) {
+        const auto it = d->postings.constFind(gram);
+        if (it == d->postings.constEnd()) {
+            return result;
+        }
+        lists.append(&*it);
+    }
+    std::sort(lists.begin(), lists.end(), [](const QVector<int> *a, const QVector<int> *b) {
+        return a->size() < b->size();
+    });
+
+    // Walk the shortest list and look the documents up in the others
+    for (int document : *lists.first()) {
+        bool inAll = true;
+        for (int i = 1; i < lists.size() && inAll; ++i) {
+            inAll = std::binary_search(lists.at(i)->constBegin(), lists.at(i)->constEnd(), document);
+        }
+        if (inAll && !accept(document)) {
+            break;
+        }
+    }
+
+    return result;
+}
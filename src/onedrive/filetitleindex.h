@@ -0,0 +1,122 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KMGRAPH2_ONEDRIVEFILETITLEINDEX_H
+#define KMGRAPH2_ONEDRIVEFILETITLEINDEX_H
+
+#include "types.h"
+#include "kmgraphonedrive_export.h"
+
+#include <QString>
+#include <QStringList>
+
+namespace KMGraph2
+{
+
+namespace OneDrive
+{
+
+/**
+ * @brief Index for type-ahead search in titles of locally known files.
+ *
+ * Sending a "title contains" FileSearchQuery to the server for every
+ * keystroke is slow. FileTitleIndex answers such searches locally: titles
+ * are split into trigrams (three consecutive characters) and every trigram
+ * keeps a sorted list of files whose title contains it. A search only
+ * verifies files present in the lists of all trigrams of the searched
+ * text, and stops once enough results have been found.
+ *
+ * Matching is case-insensitive. Searches for text shorter than the trigram
+ * length fall back to scanning the titles.
+ *
+ * The index is updated incrementally by insert(), remove() and by
+ * applyChanges() with results of ChangeFetchJob. It only knows the files it
+ * has been given. Until a full listing of the drive has been inserted and
+ * setComplete() has been called, callers should also ask the server.
+ */
+class KMGRAPHONEDRIVE_EXPORT FileTitleIndex
+{
+  public:
+    enum MatchMode {
+        Contains,  ///< The text appears anywhere in the title.
+        WordPrefix ///< A word of the title starts with the text.
+    };
+
+    explicit FileTitleIndex();
+    virtual ~FileTitleIndex();
+
+    /**
+     * @brief Returns number of indexed files.
+     */
+    int count() const;
+    void clear();
+
+    /**
+     * @brief Indexes @p title of file @p fileId, replacing its previous title.
+     */
+    void insert(const QString &fileId, const QString &title);
+    void insert(const FilePtr &file);
+
+    /**
+     * @brief Removes file @p fileId from the index.
+     */
+    bool remove(const QString &fileId);
+
+    /**
+     * @brief Updates the index from a change feed.
+     *
+     * Deleted files are removed, other changed files are (re)indexed.
+     */
+    void applyChanges(const ChangesList &changes);
+
+    /**
+     * @brief Returns whether file @p fileId is indexed.
+     */
+    bool contains(const QString &fileId) const;
+
+    /**
+     * @brief Returns whether all files of the drive have been indexed.
+     *
+     * Set by the caller once a full listing has been inserted. Search
+     * results of an incomplete index may miss files.
+     */
+    bool isComplete() const;
+    void setComplete(bool complete);
+
+    /**
+     * @brief Returns IDs of files whose title matches @p text.
+     *
+     * @param limit Maximum number of results, -1 for no limit.
+     */
+    QStringList search(const QString &text, MatchMode mode = Contains, int limit = -1) const;
+
+  private:
+    Q_DISABLE_COPY(FileTitleIndex)
+
+    class Private;
+    Private *const d;
+    friend class Private;
+};
+
+} // namespace OneDrive
+
+} // namespace KMGraph2
+
+#endif // KMGRAPH2_ONEDRIVEFILETITLEINDEX_H
@@ -19,7 +19,9 @@
 */
 
 #include "parentreference.h"
+#include "jsonparser.h"
 #include "parentreference_p.h"
+#include "stringinterner.h"
 
 #include <QVariantMap>
 #include <QJsonDocument>
@@ -47,31 +49,31 @@ ParentReferencePtr ParentReference::Private::fromJSON(const QVariantMap &map)
         return ParentReferencePtr();
     }
 
-    ParentReferencePtr reference(new ParentReference(map[QStringLiteral("id")].toString()));
+    // Many files share the same parent folder
+    StringInterner *interner = StringInterner::global();
+
+    ParentReferencePtr reference = ParentReferencePtr::create(interner->intern(map[QStringLiteral("id")].toString()));
     reference->d->selfLink = map[QStringLiteral("selfLink")].toUrl();
-    reference->d->parentLink = map[QStringLiteral("parentLink")].toUrl();
+    reference->d->parentLink = interner->intern(map[QStringLiteral("parentLink")].toUrl());
     reference->d->isRoot = map[QStringLiteral("isRoot")].toBool();
 
     return reference;
 }
 
-QVariantMap ParentReference::Private::toJSON(const ParentReferencePtr &reference)
+void ParentReference::Private::toJSON(JsonWriter &writer, const ParentReferencePtr &reference)
 {
-    QVariantMap map;
     if (!reference->d->id.isEmpty()) {
-        map[QStringLiteral("id")] = reference->id();
+        writer.write("id", reference->id());
     }
     if (!reference->d->selfLink.isEmpty()) {
-        map[QStringLiteral("selfLink")] = reference->d->selfLink;
+        writer.write("selfLink", reference->d->selfLink);
     }
     if (!reference->d->parentLink.isEmpty()) {
-        map[QStringLiteral("parentLink")] = reference->d->parentLink;
+        writer.write("parentLink", reference->d->parentLink);
     }
     if (reference->d->isRoot) { // default is false
-        map[QStringLiteral("isRoot")] = reference->d->isRoot;
+        writer.write("isRoot", reference->d->isRoot);
     }
-
-    return map;
 }
 
 ParentReference::ParentReference(const QString &id):
@@ -83,13 +85,19 @@ ParentReference::ParentReference(const QString &id):
 
 ParentReference::ParentReference(const ParentReference &other):
     KMGraph2::Object(other),
-    d(new Private(*(other.d)))
+    d(other.d)
 {
 }
 
 ParentReference::~ParentReference()
 {
-    delete d;
+}
+
+ParentReference &ParentReference::operator=(const ParentReference &other)
+{
+    KMGraph2::Object::operator=(other);
+    d = other.d;
+    return *this;
 }
 
 QString ParentReference::id() const
@@ -125,13 +133,11 @@ ParentReferencePtr ParentReference::fromJSON(const QByteArray &jsonData)
 
 ParentReferencesList ParentReference::fromJSONFeed(const QByteArray &jsonData)
 {
-    QJsonDocument document = QJsonDocument::fromJson(jsonData);
-    if (document.isNull()) {
+    bool ok = false;
+    const QVariantMap map = JsonParser::parseObject(jsonData, &ok);
+    if (!ok) {
         return ParentReferencesList();
     }
-
-    const QVariant data = document.toVariant();
-    const QVariantMap map = data.toMap();
     if (!map.contains(QStringLiteral("kind")) ||
             map[QStringLiteral("kind")].toString() != QLatin1String("drive#parentList")) {
         return ParentReferencesList();
@@ -152,8 +158,9 @@ ParentReferencesList ParentReference::fromJSONFeed(const QByteArray &jsonData)
 
 QByteArray ParentReference::toJSON(const ParentReferencePtr &reference)
 {
-    const QVariantMap map = Private::toJSON(reference);
-
-    QJsonDocument document = QJsonDocument::fromVariant(map);
-    return document.toJson(QJsonDocument::Compact);
+    JsonWriter writer;
+    writer.beginObject();
+    Private::toJSON(writer, reference);
+    writer.endObject();
+    return writer.data();
 }
@@ -51,6 +51,7 @@ class KMGRAPHONEDRIVE_EXPORT ParentReference: public KMGraph2::Object
   public:
     explicit ParentReference(const QString &id);
     explicit ParentReference(const ParentReference &other);
+    ParentReference &operator=(const ParentReference &other);
     ~ParentReference() override;
 
     /**
@@ -79,7 +80,7 @@ class KMGRAPHONEDRIVE_EXPORT ParentReference: public KMGraph2::Object
 
   private:
     class Private;
-    Private *const d;
+    QSharedDataPointer<Private> d;
     friend class Private;
     friend class File;
     friend class File::Private;
@@ -24,6 +24,8 @@
 #define LIBKMGRAPH2_ONEDRIVEPARENTREFERENCE_P_H
 
 #include "parentreference.h"
+#include "jsonwriter.h"
+#include "objectpool.h"
 
 #include <QVariantMap>
 
@@ -33,9 +35,11 @@ namespace KMGraph2
 namespace OneDrive
 {
 
-class Q_DECL_HIDDEN ParentReference::Private
+class Q_DECL_HIDDEN ParentReference::Private : public QSharedData
 {
   public:
+    KMGRAPH_POOLED_ALLOCATION
+
     Private();
     Private(const Private &other);
 
@@ -45,7 +49,7 @@ class Q_DECL_HIDDEN ParentReference::Private
     bool isRoot;
 
     static ParentReferencePtr fromJSON(const QVariantMap &map);
-    static QVariantMap toJSON(const ParentReferencePtr &reference);
+    static void toJSON(JsonWriter &writer, const ParentReferencePtr &reference);
 };
 
 } // namespace OneDrive
@@ -20,6 +20,9 @@
 
 #include "permission.h"
 #include "permission_p.h"
+#include "jsonparser.h"
+#include "jsonwriter.h"
+#include "stringinterner.h"
 
 #include <QJsonDocument>
 
@@ -95,11 +98,11 @@ PermissionPtr Permission::Private::fromJSON(const QVariantMap &map)
         return PermissionPtr();
     }
 
-    PermissionPtr permission(new Permission());
+    PermissionPtr permission = PermissionPtr::create();
     permission->setEtag(map[QStringLiteral("etag")].toString());
     permission->d->id = map[QStringLiteral("id")].toString();
     permission->d->selfLink = map[QStringLiteral("selfLink")].toUrl();
-    permission->d->name = map[QStringLiteral("name")].toString();
+    permission->d->name = StringInterner::global()->intern(map[QStringLiteral("name")].toString());
 
     permission->d->role = Private::roleFromName(map[QStringLiteral("role")].toString());
 
@@ -111,8 +114,8 @@ PermissionPtr Permission::Private::fromJSON(const QVariantMap &map)
     permission->d->type = Private::typeFromName(map[QStringLiteral("type")].toString());
     permission->d->authKey = map[QStringLiteral("authKey")].toString();
     permission->d->withLink = map[QStringLiteral("withLink")].toBool();
-    permission->d->photoLink = map[QStringLiteral("photoLink")].toUrl();
-    permission->d->value = map[QStringLiteral("value")].toString();
+    permission->d->photoLink = StringInterner::global()->intern(map[QStringLiteral("photoLink")].toUrl());
+    permission->d->value = StringInterner::global()->intern(map[QStringLiteral("value")].toString());
 
     return permission;
 }
@@ -147,12 +150,18 @@ Permission::Permission():
 
 Permission::Permission(const Permission &other):
     KMGraph2::Object(other),
-    d(new Private(*(other.d)))
+    d(other.d)
 { }
 
 Permission::~Permission()
 {
-    delete d;
+}
+
+Permission &Permission::operator=(const Permission &other)
+{
+    KMGraph2::Object::operator=(other);
+    d = other.d;
+    return *this;
 }
 
 QString Permission::id() const
@@ -249,17 +258,26 @@ PermissionPtr Permission::fromJSON(const QByteArray &jsonData)
 
 PermissionsList Permission::fromJSONFeed(const QByteArray &jsonData)
 {
-    QJsonDocument document = QJsonDocument::fromJson(jsonData);
-    if (document.isNull()) {
+    FeedData feedData;
+    return fromJSONFeed(jsonData, feedData);
+}
+
+PermissionsList Permission::fromJSONFeed(const QByteArray &jsonData, FeedData &feedData)
+{
+    bool ok = false;
+    const QVariantMap map = JsonParser::parseObject(jsonData, &ok);
+    if (!ok) {
         return PermissionsList();
     }
-    const QVariant json = document.toVariant();
-    const QVariantMap map = json.toMap();
     if (!map.contains(QStringLiteral("kind")) ||
             map[QStringLiteral("kind")].toString() != QLatin1String("drive#permissionList")) {
         return PermissionsList();
     }
 
+    if (map.contains(QStringLiteral("nextLink"))) {
+        feedData.nextPageUrl = map[QStringLiteral("nextLink")].toUrl();
+    }
+
     PermissionsList permissions;
     const QVariantList items = map[QStringLiteral("items")].toList();
     for (const QVariant & item : items) {
@@ -273,31 +291,31 @@ PermissionsList Permission::fromJSONFeed(const QByteArray &jsonData)
 
 QByteArray Permission::toJSON(const PermissionPtr &permission)
 {
-    QVariantMap map;
+    JsonWriter writer;
+    writer.beginObject();
 
     if (permission->role() != Permission::UndefinedRole) {
-        map[QStringLiteral("role")] = Private::roleToName(permission->role());
+        writer.write("role", Private::roleToName(permission->role()));
     }
     if (permission->type() != Permission::UndefinedType) {
-        map[QStringLiteral("type")] = Private::typeToName(permission->type());
+        writer.write("type", Private::typeToName(permission->type()));
     }
 
-    QVariantList additionalRoles;
     const auto roles = permission->additionalRoles();
-    additionalRoles.reserve(roles.size());
-    for (Permission::Role additionalRole : roles) {
-        additionalRoles << Private::roleToName(additionalRole);
-    }
-    if (!additionalRoles.isEmpty()) {
-        map[QStringLiteral("additionalRoles")] = additionalRoles;
+    if (!roles.isEmpty()) {
+        writer.beginArray("additionalRoles");
+        for (Permission::Role additionalRole : roles) {
+            writer.write(Private::roleToName(additionalRole));
+        }
+        writer.endArray();
     }
 
-    map[QStringLiteral("withLink")] = permission->withLink();
+    writer.write("withLink", permission->withLink());
 
     if (!permission->value().isEmpty()) {
-        map[QStringLiteral("value")] = permission->value();
+        writer.write("value", permission->value());
     }
 
-    QJsonDocument document = QJsonDocument::fromVariant(map);
-    return document.toJson(QJsonDocument::Compact);
+    writer.endObject();
+    return writer.data();
 }
@@ -67,6 +67,7 @@ class KMGRAPHONEDRIVE_EXPORT Permission: public KMGraph2::Object
 
     explicit Permission();
     explicit Permission(const Permission &other);
+    Permission &operator=(const Permission &other);
     ~Permission() override;
 
     /**
@@ -169,11 +170,12 @@ class KMGRAPHONEDRIVE_EXPORT Permission: public KMGraph2::Object
 
     static PermissionPtr fromJSON(const QByteArray &jsonData);
     static PermissionsList fromJSONFeed(const QByteArray &jsonData);
+    static PermissionsList fromJSONFeed(const QByteArray &jsonData, FeedData &feedData);
     static QByteArray toJSON(const PermissionPtr &permission);
 
   private:
     class Private;
-    Private *const d;
+    QSharedDataPointer<Private> d;
     friend class Private;
     friend class File::Private;
 };
@@ -22,6 +22,7 @@
 #define LIBKMGRAPH2_ONEDRIVEPERMISSION_P_H
 
 #include "permission.h"
+#include "objectpool.h"
 
 namespace KMGraph2
 {
@@ -29,9 +30,11 @@ namespace KMGraph2
 namespace OneDrive
 {
 
-class Q_DECL_HIDDEN Permission::Private
+class Q_DECL_HIDDEN Permission::Private : public QSharedData
 {
   public:
+    KMGRAPH_POOLED_ALLOCATION
+
     Private();
     Private(const Private &other);
 
@@ -45,7 +45,7 @@ class Q_DECL_HIDDEN PermissionFetchJob::Private
 PermissionFetchJob::PermissionFetchJob(const QString &fileId,
                                        const AccountPtr &account,
                                        QObject *parent):
-    FetchJob(account, parent),
+    FeedFetchJob(account, parent),
     d(new Private)
 {
     d->fileId = fileId;
@@ -54,7 +54,7 @@ PermissionFetchJob::PermissionFetchJob(const QString &fileId,
 PermissionFetchJob::PermissionFetchJob(const FilePtr &file,
                                        const AccountPtr &account,
                                        QObject *parent):
-    FetchJob(account, parent),
+    FeedFetchJob(account, parent),
     d(new Private)
 {
     d->fileId = file->id();
@@ -64,7 +64,7 @@ PermissionFetchJob::PermissionFetchJob(const QString &fileId,
                                        const QString &permissionId,
                                        const AccountPtr &account,
                                        QObject *parent):
-    FetchJob(account, parent),
+    FeedFetchJob(account, parent),
     d(new Private)
 {
     d->fileId = fileId;
@@ -75,7 +75,7 @@ PermissionFetchJob::PermissionFetchJob(const FilePtr &file,
                                        const QString &permissionId,
                                        const AccountPtr &account,
                                        QObject *parent):
-    FetchJob(account, parent),
+    FeedFetchJob(account, parent),
     d(new Private)
 {
     d->fileId = file->id();
@@ -89,19 +89,15 @@ PermissionFetchJob::~PermissionFetchJob()
 
 void PermissionFetchJob::start()
 {
-    QNetworkRequest request;
     if (d->permissionId.isEmpty()) {
-        request.setUrl(OneDriveService::fetchPermissionsUrl(d->fileId));
+        enqueueFeedRequest(OneDriveService::fetchPermissionsUrl(d->fileId));
     } else {
-        request.setUrl(OneDriveService::fetchPermissionUrl(d->fileId, d->permissionId));
+        enqueueRequest(createRequest(OneDriveService::fetchPermissionUrl(d->fileId, d->permissionId)));
     }
-    request.setRawHeader("Authorization", "Bearer " + account()->accessToken().toLatin1());
-
-    enqueueRequest(request);
 }
 
-ObjectsList PermissionFetchJob::handleReplyWithItems(const QNetworkReply *reply,
-        const QByteArray &rawData)
+ObjectsList PermissionFetchJob::handleFeedReply(const QNetworkReply *reply,
+        const QByteArray &rawData, FeedData &feedData)
 {
     ObjectsList items;
 
@@ -109,16 +105,16 @@ ObjectsList PermissionFetchJob::handleReplyWithItems(const QNetworkReply *reply,
     ContentType ct = Utils::stringToContentType(contentType);
     if (ct == KMGraph2::JSON) {
         if (d->permissionId.isEmpty()) {
-            items << Permission::fromJSONFeed(rawData);
+            items << Permission::fromJSONFeed(rawData, feedData);
         } else {
             items << Permission::fromJSON(rawData);
         }
     } else {
         setError(KMGraph2::InvalidResponse);
         setErrorString(tr("Invalid response content type"));
+        emitFinished();
     }
 
-    emitFinished();
     return items;
 }
 
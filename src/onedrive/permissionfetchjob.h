@@ -23,7 +23,7 @@
 #ifndef KMGRAPH2_ONEDRIVEPERMISSIONFETCHJOB_H
 #define KMGRAPH2_ONEDRIVEPERMISSIONFETCHJOB_H
 
-#include "fetchjob.h"
+#include "feedfetchjob.h"
 #include "kmgraphonedrive_export.h"
 
 namespace KMGraph2
@@ -32,7 +32,7 @@ namespace KMGraph2
 namespace OneDrive
 {
 
-class KMGRAPHONEDRIVE_EXPORT PermissionFetchJob : public KMGraph2::FetchJob
+class KMGRAPHONEDRIVE_EXPORT PermissionFetchJob : public KMGraph2::FeedFetchJob
 {
 
     Q_OBJECT
@@ -50,8 +50,8 @@ class KMGRAPHONEDRIVE_EXPORT PermissionFetchJob : public KMGraph2::FetchJob
 
   protected:
     void start() override;
-    KMGraph2::ObjectsList handleReplyWithItems(const QNetworkReply *reply,
-            const QByteArray &rawData) override;
+    KMGraph2::ObjectsList handleFeedReply(const QNetworkReply *reply,
+            const QByteArray &rawData, KMGraph2::FeedData &feedData) override;
 
   private:
     class Private;
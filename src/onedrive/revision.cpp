@@ -19,16 +19,23 @@
 */
 
 #include "revision.h"
+#include "jsonparser.h"
+#include "jsonwriter.h"
+#include "objectpool.h"
 #include "user.h"
+#include "stringinterner.h"
+#include "utils.h"
 
 #include <QJsonDocument>
 
 using namespace KMGraph2;
 using namespace KMGraph2::OneDrive;
 
-class Q_DECL_HIDDEN Revision::Private
+class Q_DECL_HIDDEN Revision::Private : public QSharedData
 {
   public:
+    KMGRAPH_POOLED_ALLOCATION
+
     Private();
     Private(const Private& other);
 
@@ -89,19 +96,19 @@ RevisionPtr Revision::Private::fromJSON(const QVariantMap &map)
         return RevisionPtr();
     }
 
-    RevisionPtr revision(new Revision);
+    RevisionPtr revision = RevisionPtr::create();
     revision->setEtag(map[QStringLiteral("etag")].toString());
     revision->d->id = map[QStringLiteral("id")].toString();
     revision->d->selfLink = map[QStringLiteral("selfLink")].toUrl();
-    revision->d->mimeType = map[QStringLiteral("mimeType")].toString();
-    revision->d->modifiedDate = QDateTime::fromString(map[QStringLiteral("modifiedDate")].toString(), Qt::ISODate);
+    revision->d->mimeType = StringInterner::global()->intern(map[QStringLiteral("mimeType")].toString());
+    revision->d->modifiedDate = Utils::rfc3339DateFromString(map[QStringLiteral("modifiedDate")].toString());
     revision->d->pinned = map[QStringLiteral("pinned")].toBool();
     revision->d->published = map[QStringLiteral("published")].toBool();
     revision->d->publishedLink = map[QStringLiteral("publishedLink")].toUrl();
     revision->d->publishAuto = map[QStringLiteral("publishAuto")].toBool();
     revision->d->publishedOutsideDomain = map[QStringLiteral("publishedOutsideDomain")].toBool();
     revision->d->downloadUrl = map[QStringLiteral("downloadUrl")].toUrl();
-    revision->d->lastModifyingUserName = map[QStringLiteral("lastModifyingUserName")].toString();
+    revision->d->lastModifyingUserName = StringInterner::global()->intern(map[QStringLiteral("lastModifyingUserName")].toString());
     revision->d->lastModifyingUser = User::fromJSON(map[QStringLiteral("lastModifyingUser")].toMap());
     revision->d->originalFilename = map[QStringLiteral("originalFilename")].toString();
     revision->d->md5Checksum = map[QStringLiteral("md5Checksum")].toString();
@@ -124,13 +131,19 @@ Revision::Revision():
 
 Revision::Revision(const Revision& other):
     KMGraph2::Object(other),
-    d(new Private(*(other.d)))
+    d(other.d)
 {
 }
 
 Revision::~Revision()
 {
-    delete d;
+}
+
+Revision &Revision::operator=(const Revision &other)
+{
+    KMGraph2::Object::operator=(other);
+    d = other.d;
+    return *this;
 }
 
 QString Revision::id() const
@@ -246,20 +259,28 @@ RevisionPtr Revision::fromJSON(const QByteArray &jsonData)
 
 RevisionsList Revision::fromJSONFeed(const QByteArray &jsonData)
 {
-    QJsonDocument document = QJsonDocument::fromJson(jsonData);
-    if (document.isNull()) {
+    FeedData feedData;
+    return fromJSONFeed(jsonData, feedData);
+}
+
+RevisionsList Revision::fromJSONFeed(const QByteArray &jsonData, FeedData &feedData)
+{
+    bool ok = false;
+    const QVariantMap map = JsonParser::parseObject(jsonData, &ok);
+    if (!ok) {
         return RevisionsList();
     }
 
-    const QVariant data = document.toVariant();
-    const QVariantMap map = data.toMap();
-
     if (!map.contains(QStringLiteral("kind")) ||
         map[QStringLiteral("kind")].toString() != QLatin1String("drive#revisionList"))
     {
         return RevisionsList();
     }
 
+    if (map.contains(QStringLiteral("nextLink"))) {
+        feedData.nextPageUrl = map[QStringLiteral("nextLink")].toUrl();
+    }
+
     RevisionsList list;
     const QVariantList items = map[QStringLiteral("items")].toList();
     for (const QVariant &item : qAsConst(items)) {
@@ -275,13 +296,12 @@ RevisionsList Revision::fromJSONFeed(const QByteArray &jsonData)
 
 QByteArray Revision::toJSON(const RevisionPtr &revision)
 {
-    QVariantMap map;
-
-    map[QStringLiteral("pinned")] = revision->pinned();
-    map[QStringLiteral("published")] = revision->published();
-    map[QStringLiteral("publishAuto")] = revision->publishAuto();
-    map[QStringLiteral("publishedOutsideDomain")] = revision->publishedOutsideDomain();
-
-    QJsonDocument document = QJsonDocument::fromVariant(map);
-    return document.toJson(QJsonDocument::Compact);
+    JsonWriter writer(128);
+    writer.beginObject();
+    writer.write("pinned", revision->pinned());
+    writer.write("published", revision->published());
+    writer.write("publishAuto", revision->publishAuto());
+    writer.write("publishedOutsideDomain", revision->publishedOutsideDomain());
+    writer.endObject();
+    return writer.data();
 }
@@ -52,6 +52,7 @@ class KMGRAPHONEDRIVE_EXPORT Revision: public KMGraph2::Object
   public:
     explicit Revision();
     explicit Revision(const Revision &other);
+    Revision &operator=(const Revision &other);
     ~Revision() override;
 
     /**
@@ -196,11 +197,12 @@ class KMGRAPHONEDRIVE_EXPORT Revision: public KMGraph2::Object
 
     static RevisionPtr fromJSON(const QByteArray &jsonData);
     static RevisionsList fromJSONFeed(const QByteArray &jsonData);
+    static RevisionsList fromJSONFeed(const QByteArray &jsonData, FeedData &feedData);
     static QByteArray toJSON(const RevisionPtr &revision);
 
   private:
     class Private;
-    Private *const d;
+    QSharedDataPointer<Private> d;
     friend class Private;
 };
 
@@ -23,6 +23,7 @@
 #include "account.h"
 #include "onedriveservice.h"
 #include "revision.h"
+#include "userregistry.h"
 #include "utils.h"
 
 #include <QNetworkReply>
@@ -42,7 +43,7 @@ class Q_DECL_HIDDEN RevisionFetchJob::Private
 RevisionFetchJob::RevisionFetchJob(const QString &fileId,
                                    const AccountPtr &account,
                                    QObject *parent):
-    FetchJob(account, parent),
+    FeedFetchJob(account, parent),
     d(new Private)
 {
     d->fileId = fileId;
@@ -52,7 +53,7 @@ RevisionFetchJob::RevisionFetchJob(const QString &fileId,
                                    const QString &revisionId,
                                    const AccountPtr &account,
                                    QObject *parent):
-    FetchJob(account, parent),
+    FeedFetchJob(account, parent),
     d(new Private)
 {
     d->fileId = fileId;
@@ -66,36 +67,34 @@ RevisionFetchJob::~RevisionFetchJob()
 
 void RevisionFetchJob::start()
 {
-    QNetworkRequest request;
     if (d->revisionId.isEmpty()) {
-        request.setUrl(OneDriveService::fetchRevisionsUrl(d->fileId));
+        enqueueFeedRequest(OneDriveService::fetchRevisionsUrl(d->fileId));
     } else {
-        request.setUrl(OneDriveService::fetchRevisionUrl(d->fileId, d->revisionId));
+        enqueueRequest(createRequest(OneDriveService::fetchRevisionUrl(d->fileId, d->revisionId)));
     }
-    request.setRawHeader("Authorization", "Bearer " + account()->accessToken().toLatin1());
-
-    enqueueRequest(request);
 }
 
-ObjectsList RevisionFetchJob::handleReplyWithItems(const QNetworkReply *reply,
-        const QByteArray &rawData)
+ObjectsList RevisionFetchJob::handleFeedReply(const QNetworkReply *reply,
+        const QByteArray &rawData, FeedData &feedData)
 {
+    const UserRegistry::Scope userScope(account());
+
     ObjectsList items;
 
     const QString contentType = reply->header(QNetworkRequest::ContentTypeHeader).toString();
     ContentType ct = Utils::stringToContentType(contentType);
     if (ct == KMGraph2::JSON) {
         if (d->revisionId.isEmpty()) {
-            items << Revision::fromJSONFeed(rawData);
+            items << Revision::fromJSONFeed(rawData, feedData);
         } else {
             items << Revision::fromJSON(rawData);
         }
     } else {
         setError(KMGraph2::InvalidResponse);
         setErrorString(tr("Invalid response content type"));
+        emitFinished();
     }
 
-    emitFinished();
     return items;
 }
 
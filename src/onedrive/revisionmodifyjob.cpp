@@ -24,6 +24,7 @@
 #include "account.h"
 #include "onedriveservice.h"
 #include "revision.h"
+#include "userregistry.h"
 #include "utils.h"
 
 #include <QNetworkReply>
@@ -102,6 +103,8 @@ void RevisionModifyJob::start()
 ObjectsList RevisionModifyJob::handleReplyWithItems(const QNetworkReply *reply,
                                                     const QByteArray &rawData)
 {
+    const UserRegistry::Scope userScope(account());
+
     const QString contentType = reply->header(QNetworkRequest::ContentTypeHeader).toString();
     ContentType ct = Utils::stringToContentType(contentType);
     ObjectsList items;
@@ -0,0 +1,296 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "thumbnailcache.h"
+#include "../debug.h"
+
+#include <QCache>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+
+#include <algorithm>
+#include <limits>
+
+using namespace KMGraph2;
+using namespace KMGraph2::OneDrive;
+
+class Q_DECL_HIDDEN ThumbnailCache::Private
+{
+  public:
+    Private();
+
+    static QString key(const QString &fileId, const QString &etag);
+    static int imageCost(const QImage &image);
+
+    QString filePath(const QString &key) const;
+    void scanDisk();
+    QByteArray readFromDisk(const QString &key);
+    void writeToDisk(const QString &key, const QByteArray &data);
+    void trimDisk();
+
+    QString cacheDir;
+    qint64 maxDiskSize;
+    qint64 diskUsage;   // -1 until the cache directory has been scanned
+
+    struct DiskEntry
+    {
+        qint64 lastUse; // msecs since epoch
+        qint64 size;
+    };
+    // Every thumbnail on disk, so that the least recently used ones can be
+    // removed without scanning the directory. After a restart, the order is
+    // taken from the modification times, which hits update where Qt allows.
+    QHash<QString, DiskEntry> diskEntries;
+
+    mutable QMutex mutex;
+    QCache<QString, QImage> memory; // cost is in KiB
+};
+
+ThumbnailCache::Private::Private():
+    maxDiskSize(256 * 1024 * 1024),
+    diskUsage(-1)
+{
+    memory.setMaxCost(32 * 1024);
+}
+
+QString ThumbnailCache::Private::key(const QString &fileId, const QString &etag)
+{
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(fileId.toUtf8());
+    hash.addData("\n", 1);
+    hash.addData(etag.toUtf8());
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+int ThumbnailCache::Private::imageCost(const QImage &image)
+{
+    return qMax(1, int(qint64(image.bytesPerLine()) * image.height() / 1024));
+}
+
+QString ThumbnailCache::Private::filePath(const QString &key) const
+{
+    return cacheDir + QLatin1Char('/') + key;
+}
+
+void ThumbnailCache::Private::scanDisk()
+{
+    if (diskUsage >= 0) {
+        return;
+    }
+
+    QDir().mkpath(cacheDir);
+    diskUsage = 0;
+    diskEntries.clear();
+    const QFileInfoList entries = QDir(cacheDir).entryInfoList(QDir::Files);
+    for (const QFileInfo &entry : entries) {
+        diskEntries.insert(entry.fileName(), { entry.lastModified().toMSecsSinceEpoch(), entry.size() });
+        diskUsage += entry.size();
+    }
+}
+
+QByteArray ThumbnailCache::Private::readFromDisk(const QString &key)
+{
+    if (cacheDir.isEmpty()) {
+        return QByteArray();
+    }
+
+    QFile file(filePath(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+
+    scanDisk();
+    const auto it = diskEntries.find(key);
+    if (it != diskEntries.end()) {
+        it->lastUse = QDateTime::currentMSecsSinceEpoch();
+    }
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+#endif
+    return file.readAll();
+}
+
+void ThumbnailCache::Private::writeToDisk(const QString &key, const QByteArray &data)
+{
+    if (cacheDir.isEmpty() || data.size() > maxDiskSize) {
+        return;
+    }
+
+    scanDisk();
+
+    const QString path = filePath(key);
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        qCWarning(KMGraphDebug) << "Failed to write thumbnail to" << path;
+        return;
+    }
+
+    DiskEntry &entry = diskEntries[key];
+    diskUsage += data.size() - entry.size;
+    entry.lastUse = QDateTime::currentMSecsSinceEpoch();
+    entry.size = data.size();
+    if (diskUsage > maxDiskSize) {
+        trimDisk();
+    }
+}
+
+void ThumbnailCache::Private::trimDisk()
+{
+    // Make some room at once, so that we don't have to trim again on every
+    // insert
+    const qint64 target = maxDiskSize - maxDiskSize / 10;
+
+    QVector<QPair<qint64 /* lastUse */, QString>> entries;
+    entries.reserve(diskEntries.size());
+    for (auto it = diskEntries.cbegin(), end = diskEntries.cend(); it != end; ++it) {
+        entries.append(qMakePair(it->lastUse, it.key()));
+    }
+    // Least recently used first
+    std::sort(entries.begin(), entries.end());
+
+    for (int i = 0; i < entries.size() && diskUsage > target; ++i) {
+        const QString &key = entries.at(i).second;
+        if (QFile::remove(filePath(key)) || !QFile::exists(filePath(key))) {
+            diskUsage -= diskEntries.take(key).size;
+        }
+    }
+}
+
+ThumbnailCache::ThumbnailCache(const QString &cacheDir):
+    d(new Private)
+{
+    d->cacheDir = cacheDir;
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    delete d;
+}
+
+QString ThumbnailCache::defaultCacheDir()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+            + QLatin1String("/libkmgraph/thumbnails");
+}
+
+QString ThumbnailCache::cacheDir() const
+{
+    return d->cacheDir;
+}
+
+void ThumbnailCache::setMaxMemoryCost(qint64 bytes)
+{
+    QMutexLocker locker(&d->mutex);
+    d->memory.setMaxCost(int(qBound<qint64>(1, bytes / 1024, std::numeric_limits<int>::max())));
+}
+
+qint64 ThumbnailCache::maxMemoryCost() const
+{
+    QMutexLocker locker(&d->mutex);
+    return qint64(d->memory.maxCost()) * 1024;
+}
+
+void ThumbnailCache::setMaxDiskSize(qint64 bytes)
+{
+    QMutexLocker locker(&d->mutex);
+    d->maxDiskSize = qMax<qint64>(0, bytes);
+    if (d->diskUsage > d->maxDiskSize) {
+        d->trimDisk();
+    }
+}
+
+qint64 ThumbnailCache::maxDiskSize() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->maxDiskSize;
+}
+
+bool ThumbnailCache::contains(const QString &fileId, const QString &etag) const
+{
+    const QString key = Private::key(fileId, etag);
+
+    QMutexLocker locker(&d->mutex);
+    return d->memory.contains(key)
+        || (!d->cacheDir.isEmpty() && QFile::exists(d->filePath(key)));
+}
+
+QImage ThumbnailCache::image(const QString &fileId, const QString &etag)
+{
+    const QString key = Private::key(fileId, etag);
+
+    QMutexLocker locker(&d->mutex);
+    if (const QImage *image = d->memory.object(key)) {
+        return *image;
+    }
+
+    const QByteArray data = d->readFromDisk(key);
+    if (data.isEmpty()) {
+        return QImage();
+    }
+
+    const QImage image = QImage::fromData(data);
+    if (!image.isNull()) {
+        d->memory.insert(key, new QImage(image), Private::imageCost(image));
+    }
+    return image;
+}
+
+QImage ThumbnailCache::insert(const QString &fileId, const QString &etag, const QByteArray &data)
+{
+    const QImage image = QImage::fromData(data);
+    if (image.isNull()) {
+        qCWarning(KMGraphDebug) << "Invalid thumbnail for file" << fileId;
+        return image;
+    }
+
+    const QString key = Private::key(fileId, etag);
+
+    QMutexLocker locker(&d->mutex);
+    d->memory.insert(key, new QImage(image), Private::imageCost(image));
+    d->writeToDisk(key, data);
+    return image;
+}
+
+void ThumbnailCache::clear()
+{
+    QMutexLocker locker(&d->mutex);
+    d->memory.clear();
+
+    if (!d->cacheDir.isEmpty()) {
+        QDir dir(d->cacheDir);
+        const QStringList entries = dir.entryList(QDir::Files);
+        for (const QString &entry : entries) {
+            dir.remove(entry);
+        }
+        d->diskUsage = 0;
+        d->diskEntries.clear();
+    }
+}
@@ -0,0 +1,123 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef KMGRAPH2_ONEDRIVETHUMBNAILCACHE_H
+#define KMGRAPH2_ONEDRIVETHUMBNAILCACHE_H
+
+#include "kmgraphonedrive_export.h"
+
+#include <QImage>
+#include <QSharedPointer>
+#include <QString>
+
+namespace KMGraph2
+{
+
+namespace OneDrive
+{
+
+/**
+ * @brief A size-bounded cache of file thumbnails.
+ *
+ * Decoded thumbnails are kept in memory, least recently used ones are dropped
+ * when maxMemoryCost() is exceeded. The compressed thumbnails are also stored
+ * on disk in cacheDir(), so they survive restarts of the application.
+ *
+ * Thumbnails are identified by the ID and etag of the file they belong to,
+ * so a thumbnail of a modified file is never returned.
+ *
+ * The cache is thread-safe and is meant to be shared, for example between
+ * all ThumbnailFetchJobs of an application.
+ */
+class KMGRAPHONEDRIVE_EXPORT ThumbnailCache
+{
+  public:
+    /**
+     * @brief Constructs a new cache
+     *
+     * @param cacheDir Directory for the on-disk tier. Pass an empty string to
+     *        keep the thumbnails in memory only.
+     */
+    explicit ThumbnailCache(const QString &cacheDir = defaultCacheDir());
+    virtual ~ThumbnailCache();
+
+    /**
+     * @brief Returns the default location of the on-disk tier.
+     */
+    static QString defaultCacheDir();
+
+    QString cacheDir() const;
+
+    /**
+     * @brief Sets maximum amount of memory (in bytes) used by decoded thumbnails.
+     *
+     * Defaults to 32 MiB.
+     */
+    void setMaxMemoryCost(qint64 bytes);
+    qint64 maxMemoryCost() const;
+
+    /**
+     * @brief Sets maximum size (in bytes) of the on-disk tier.
+     *
+     * Defaults to 256 MiB. The least recently used thumbnails are removed
+     * first.
+     */
+    void setMaxDiskSize(qint64 bytes);
+    qint64 maxDiskSize() const;
+
+    /**
+     * @brief Returns whether thumbnail of given file version is cached.
+     */
+    bool contains(const QString &fileId, const QString &etag) const;
+
+    /**
+     * @brief Returns decoded thumbnail, or a null image if it's not cached.
+     */
+    QImage image(const QString &fileId, const QString &etag);
+
+    /**
+     * @brief Stores compressed thumbnail @p data of given file version.
+     *
+     * Returns the decoded thumbnail, or a null image when @p data could not
+     * be decoded, in which case nothing is stored.
+     */
+    QImage insert(const QString &fileId, const QString &etag, const QByteArray &data);
+
+    /**
+     * @brief Removes all thumbnails from memory and from disk.
+     */
+    void clear();
+
+  private:
+    Q_DISABLE_COPY(ThumbnailCache)
+
+    class Private;
+    Private *const d;
+    friend class Private;
+};
+
+typedef QSharedPointer<ThumbnailCache> ThumbnailCachePtr;
+
+} // namespace OneDrive
+
+} // namespace KMGraph2
+
+#endif // KMGRAPH2_ONEDRIVETHUMBNAILCACHE_H
@@ -0,0 +1,222 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "thumbnailfetchjob.h"
+#include "account.h"
+#include "file.h"
+#include "../debug.h"
+
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QQueue>
+
+using namespace KMGraph2;
+using namespace KMGraph2::OneDrive;
+
+namespace {
+
+// Identifies the file a thumbnail request belongs to. Attributes survive
+// redirects, because Job reuses the original request. KIO::AccessManager
+// keeps its meta data in the first user attributes, so stay clear of them.
+static const QNetworkRequest::Attribute FileIndexAttribute =
+    QNetworkRequest::Attribute(QNetworkRequest::User + 100);
+
+}
+
+class Q_DECL_HIDDEN ThumbnailFetchJob::Private
+{
+  public:
+    Private(ThumbnailFetchJob *parent);
+
+    void enqueueNext();
+
+    FilesList files;
+    ThumbnailCachePtr cache;
+    int maxConcurrentRequests;
+
+    QQueue<int> pending;   // indexes to files
+    int inFlight;
+    QHash<QString, QImage> thumbnails;
+
+  private:
+    ThumbnailFetchJob *const q;
+};
+
+ThumbnailFetchJob::Private::Private(ThumbnailFetchJob *parent):
+    maxConcurrentRequests(4),
+    inFlight(0),
+    q(parent)
+{
+}
+
+void ThumbnailFetchJob::Private::enqueueNext()
+{
+    while (inFlight < maxConcurrentRequests && !pending.isEmpty()) {
+        const int index = pending.dequeue();
+
+        QNetworkRequest request(files.at(index)->thumbnailLink());
+        request.setRawHeader("Authorization", "Bearer " + q->account()->accessToken().toLatin1());
+        request.setAttribute(FileIndexAttribute, index);
+
+        ++inFlight;
+        q->enqueueRequest(request);
+    }
+}
+
+ThumbnailFetchJob::ThumbnailFetchJob(const FilesList &files,
+                                     const AccountPtr &account,
+                                     QObject *parent):
+    FetchJob(account, parent),
+    d(new Private(this))
+{
+    d->files = files;
+}
+
+ThumbnailFetchJob::~ThumbnailFetchJob()
+{
+    delete d;
+}
+
+void ThumbnailFetchJob::setCache(const ThumbnailCachePtr &cache)
+{
+    if (isRunning()) {
+        qCWarning(KMGraphDebug) << "Called setCache() on running job. Ignoring.";
+        return;
+    }
+
+    d->cache = cache;
+}
+
+ThumbnailCachePtr ThumbnailFetchJob::cache() const
+{
+    return d->cache;
+}
+
+void ThumbnailFetchJob::setMaxConcurrentRequests(int maxConcurrentRequests)
+{
+    if (isRunning()) {
+        qCWarning(KMGraphDebug) << "Called setMaxConcurrentRequests() on running job. Ignoring.";
+        return;
+    }
+
+    d->maxConcurrentRequests = qMax(1, maxConcurrentRequests);
+}
+
+int ThumbnailFetchJob::maxConcurrentRequests() const
+{
+    return d->maxConcurrentRequests;
+}
+
+QHash<QString, QImage> ThumbnailFetchJob::thumbnails() const
+{
+    return d->thumbnails;
+}
+
+QImage ThumbnailFetchJob::thumbnail(const QString &fileId) const
+{
+    return d->thumbnails.value(fileId);
+}
+
+void ThumbnailFetchJob::start()
+{
+    if (!d->cache) {
+        static const ThumbnailCachePtr sharedCache(new ThumbnailCache);
+        d->cache = sharedCache;
+    }
+
+    d->thumbnails.clear();
+    d->pending.clear();
+    d->inFlight = 0;
+
+    for (int i = 0; i < d->files.size(); ++i) {
+        const FilePtr &file = d->files.at(i);
+
+        const QImage cached = d->cache->image(file->id(), file->etag());
+        if (!cached.isNull()) {
+            d->thumbnails.insert(file->id(), cached);
+            continue;
+        }
+
+        const File::ThumbnailPtr inlined = file->thumbnail();
+        if (inlined) {
+            const QByteArray data = inlined->imageData();
+            if (!data.isEmpty()) {
+                d->thumbnails.insert(file->id(), d->cache->insert(file->id(), file->etag(), data));
+                continue;
+            }
+        }
+
+        if (!file->thumbnailLink().isEmpty()) {
+            d->pending.enqueue(i);
+        }
+    }
+
+    if (d->pending.isEmpty()) {
+        emitFinished();
+        return;
+    }
+
+    d->enqueueNext();
+}
+
+void ThumbnailFetchJob::handleReply(const QNetworkReply *reply, const QByteArray &rawData)
+{
+    --d->inFlight;
+
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const int index = reply->request().attribute(FileIndexAttribute, -1).toInt();
+    if (status == KMGraph2::NotFound) {
+        // A single missing thumbnail must not fail the whole batch
+        setError(KMGraph2::NoError);
+        setErrorString(QString());
+    } else if (index >= 0 && index < d->files.size()) {
+        const FilePtr &file = d->files.at(index);
+        const QImage image = d->cache->insert(file->id(), file->etag(), rawData);
+        if (!image.isNull()) {
+            d->thumbnails.insert(file->id(), image);
+        }
+    }
+
+    emitProgress(d->thumbnails.size(), d->files.size());
+    d->enqueueNext();
+}
+
+bool ThumbnailFetchJob::skipFailedRequest(const QNetworkReply *reply)
+{
+    // A single thumbnail that could not be downloaded must not fail the whole batch
+    qCWarning(KMGraphDebug) << "Failed to download thumbnail from" << reply->url() << ":" << reply->errorString();
+    --d->inFlight;
+
+    emitProgress(d->thumbnails.size(), d->files.size());
+    d->enqueueNext();
+    return true;
+}
+
+ObjectsList ThumbnailFetchJob::handleReplyWithItems(const QNetworkReply *reply,
+                                                    const QByteArray &rawData)
+{
+    Q_UNUSED(reply)
+    Q_UNUSED(rawData)
+
+    return ObjectsList();
+}
+
+#include "moc_thumbnailfetchjob.cpp"
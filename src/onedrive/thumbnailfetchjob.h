@@ -0,0 +1,102 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef KMGRAPH2_ONEDRIVETHUMBNAILFETCHJOB_H
+#define KMGRAPH2_ONEDRIVETHUMBNAILFETCHJOB_H
+
+#include "fetchjob.h"
+#include "thumbnailcache.h"
+#include "kmgraphonedrive_export.h"
+
+#include <QHash>
+#include <QImage>
+
+namespace KMGraph2
+{
+
+namespace OneDrive
+{
+
+/**
+ * @brief Fetches thumbnails of many files at once, e.g. for a gallery view.
+ *
+ * Thumbnails already present in the cache, or inlined in the File (see
+ * File::thumbnail()) are used directly, the rest is downloaded from
+ * File::thumbnailLink(). At most maxConcurrentRequests() downloads run in
+ * parallel.
+ *
+ * Files without a thumbnail, or whose thumbnail could not be downloaded,
+ * are not included in the result.
+ */
+class KMGRAPHONEDRIVE_EXPORT ThumbnailFetchJob : public KMGraph2::FetchJob
+{
+    Q_OBJECT
+
+  public:
+    explicit ThumbnailFetchJob(const FilesList &files, const AccountPtr &account,
+                               QObject *parent = nullptr);
+    ~ThumbnailFetchJob() override;
+
+    /**
+     * @brief Sets cache to look the thumbnails up in and to store them to.
+     *
+     * By default a cache in ThumbnailCache::defaultCacheDir() shared by all
+     * jobs is used.
+     */
+    void setCache(const ThumbnailCachePtr &cache);
+    ThumbnailCachePtr cache() const;
+
+    /**
+     * @brief Sets maximum number of thumbnails downloaded in parallel.
+     *
+     * Defaults to 4.
+     */
+    void setMaxConcurrentRequests(int maxConcurrentRequests);
+    int maxConcurrentRequests() const;
+
+    /**
+     * @brief Returns fetched thumbnails, indexed by file ID.
+     */
+    QHash<QString /* file ID */, QImage> thumbnails() const;
+
+    /**
+     * @brief Returns thumbnail of file @p fileId, or a null image.
+     */
+    QImage thumbnail(const QString &fileId) const;
+
+  protected:
+    void start() override;
+    void handleReply(const QNetworkReply *reply, const QByteArray &rawData) override;
+    bool skipFailedRequest(const QNetworkReply *reply) override;
+    KMGraph2::ObjectsList handleReplyWithItems(const QNetworkReply *reply,
+                                               const QByteArray &rawData) override;
+
+  private:
+    class Private;
+    Private *const d;
+    friend class Private;
+};
+
+} // namespace OneDrive
+
+} // namespace KMGraph2
+
+#endif // KMGRAPH2_ONEDRIVETHUMBNAILFETCHJOB_H
@@ -21,13 +21,18 @@
  */
 
 #include "user.h"
+#include "objectpool.h"
+#include "userregistry.h"
+#include "stringinterner.h"
 
 using namespace KMGraph2;
 using namespace KMGraph2::OneDrive;
 
-class Q_DECL_HIDDEN User::Private
+class Q_DECL_HIDDEN User::Private : public QSharedData
 {
   public:
+    KMGRAPH_POOLED_ALLOCATION
+
     Private();
     Private(const Private &other);
 
@@ -56,13 +61,18 @@ User::User():
 }
 
 User::User(const User &other):
-    d(new Private(*(other.d)))
+    d(other.d)
 {
 }
 
 User::~User()
 {
-    delete d;
+}
+
+User &User::operator=(const User &other)
+{
+    d = other.d;
+    return *this;
 }
 
 QString User::displayName() const
@@ -93,12 +103,35 @@ UserPtr User::fromJSON(const QVariantMap &map)
         return UserPtr();
     }
 
-    UserPtr user(new User());
-    user->d->displayName = map[QStringLiteral("displayName")].toString();
+    StringInterner *interner = StringInterner::global();
+
+    const QString displayName = interner->intern(map[QStringLiteral("displayName")].toString());
     const QVariantMap picture = map[QStringLiteral("picture")].toMap();
-    user->d->pictureUrl = picture[QStringLiteral("url")].toUrl();
-    user->d->isAuthenticatedUser = map[QStringLiteral("isAuthenticatedUser")].toBool();
-    user->d->permissionId = map[QStringLiteral("permissionId")].toString();
+    const QUrl pictureUrl = interner->intern(picture[QStringLiteral("url")].toUrl());
+    const bool isAuthenticatedUser = map[QStringLiteral("isAuthenticatedUser")].toBool();
+    const QString permissionId = interner->intern(map[QStringLiteral("permissionId")].toString());
+
+    // Share a single User among all files referencing it
+    UserRegistry *registry = UserRegistry::Scope::current();
+    if (registry && !permissionId.isEmpty()) {
+        const UserPtr known = registry->user(permissionId);
+        if (known && known->d->displayName == displayName
+                && known->d->pictureUrl == pictureUrl
+                && known->d->isAuthenticatedUser == isAuthenticatedUser) {
+            return known;
+        }
+    }
+
+    UserPtr user(new User());
+    user->d->displayName = displayName;
+    user->d->pictureUrl = pictureUrl;
+    user->d->isAuthenticatedUser = isAuthenticatedUser;
+    user->d->permissionId = permissionId;
+
+    // The user has been modified since we have seen it last, or is new
+    if (registry) {
+        registry->insert(user);
+    }
 
     return user;
 }
@@ -28,6 +28,7 @@
 #include <QString>
 #include <QUrl>
 #include <QVariantMap>
+#include <QSharedDataPointer>
 
 namespace KMGraph2
 {
@@ -42,6 +43,7 @@ class KMGRAPHONEDRIVE_EXPORT User
 {
   public:
     explicit User(const User &other);
+    User &operator=(const User &other);
     virtual ~User();
 
     /**
@@ -71,7 +73,7 @@ class KMGRAPHONEDRIVE_EXPORT User
     explicit User();
 
     class Private;
-    Private *const d;
+    QSharedDataPointer<Private> d;
     friend class Private;
 };
 
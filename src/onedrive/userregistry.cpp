@@ -0,0 +1,117 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "userregistry.h"
+#include "account.h"
+#include "user.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+using namespace KMGraph2;
+using namespace KMGraph2::OneDrive;
+
+namespace {
+
+thread_local UserRegistry *currentRegistry = nullptr;
+
+}
+
+class Q_DECL_HIDDEN UserRegistry::Private
+{
+  public:
+    mutable QMutex mutex;
+    QHash<QString /* permissionId */, UserPtr> users;
+};
+
+UserRegistry::Scope::Scope(const AccountPtr &account):
+    mPrevious(currentRegistry)
+{
+    currentRegistry = account ? UserRegistry::forAccount(account) : nullptr;
+}
+
+UserRegistry::Scope::Scope(UserRegistry *registry):
+    mPrevious(currentRegistry)
+{
+    currentRegistry = registry;
+}
+
+UserRegistry::Scope::~Scope()
+{
+    currentRegistry = mPrevious;
+}
+
+UserRegistry *UserRegistry::Scope::current()
+{
+    return currentRegistry;
+}
+
+UserRegistry::UserRegistry():
+    d(new Private)
+{
+}
+
+UserRegistry::~UserRegistry()
+{
+    delete d;
+}
+
+UserRegistry *UserRegistry::forAccount(const AccountPtr &account)
+{
+    static QMutex mutex;
+    static QHash<QString, UserRegistry *> registries;
+
+    QMutexLocker locker(&mutex);
+    UserRegistry *&registry = registries[account->accountName()];
+    if (!registry) {
+        registry = new UserRegistry;
+    }
+    return registry;
+}
+
+UserPtr UserRegistry::user(const QString &permissionId) const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->users.value(permissionId);
+}
+
+void UserRegistry::insert(const UserPtr &user)
+{
+    if (!user || user->permissionId().isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&d->mutex);
+    d->users.insert(user->permissionId(), user);
+}
+
+int UserRegistry::size() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->users.size();
+}
+
+void UserRegistry::clear()
+{
+    QMutexLocker locker(&d->mutex);
+    d->users.clear();
+}
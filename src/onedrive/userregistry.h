@@ -0,0 +1,110 @@
+/*
+ * This file is part of LibKMGraph library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef KMGRAPH2_ONEDRIVEUSERREGISTRY_H
+#define KMGRAPH2_ONEDRIVEUSERREGISTRY_H
+
+#include "types.h"
+#include "kmgraphonedrive_export.h"
+
+#include <QString>
+
+namespace KMGraph2
+{
+
+namespace OneDrive
+{
+
+/**
+ * @brief Shared User objects of an account
+ *
+ * Files, revisions and changes reference their owners and last modifying
+ * users. A large drive has many files, but only few distinct users, so
+ * instead of creating a new User for every reference, User::fromJSON()
+ * returns the User already known to the registry when it has the same
+ * permission ID and properties.
+ *
+ * The registry is only consulted while a Scope is active in the current
+ * thread. All jobs that parse users open a scope for their account.
+ */
+class KMGRAPHONEDRIVE_EXPORT UserRegistry
+{
+  public:
+    /**
+     * @brief Makes the registry of @p account current for the calling
+     *        thread, for the lifetime of the Scope.
+     */
+    class KMGRAPHONEDRIVE_EXPORT Scope
+    {
+      public:
+        explicit Scope(const AccountPtr &account);
+        explicit Scope(UserRegistry *registry);
+        ~Scope();
+
+        /**
+         * @brief Returns registry of the innermost Scope of the calling
+         *        thread, or a null pointer.
+         */
+        static UserRegistry *current();
+
+      private:
+        Q_DISABLE_COPY(Scope)
+
+        UserRegistry *mPrevious;
+    };
+
+    explicit UserRegistry();
+    virtual ~UserRegistry();
+
+    /**
+     * @brief Returns the registry of @p account.
+     *
+     * Accounts are identified by Account::accountName(). The registry
+     * exists for the lifetime of the application.
+     */
+    static UserRegistry *forAccount(const AccountPtr &account);
+
+    /**
+     * @brief Returns user with given @p permissionId, or a null pointer.
+     */
+    UserPtr user(const QString &permissionId) const;
+
+    /**
+     * @brief Inserts @p user, replacing a user with the same permission ID.
+     */
+    void insert(const UserPtr &user);
+
+    int size() const;
+    void clear();
+
+  private:
+    Q_DISABLE_COPY(UserRegistry)
+
+    class Private;
+    Private *const d;
+    friend class Private;
+};
+
+} // namespace OneDrive
+
+} // namespace KMGraph2
+
+#endif // KMGRAPH2_ONEDRIVEUSERREGISTRY_H